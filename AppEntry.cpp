@@ -8,6 +8,8 @@
 ------------------------------------------------------------------------*/
 #include "AppEntry.h"
 #include "resource.h"
+#include "TextEncoding.h"
+#include "VirtualModemTransport.h"
 
 #include <algorithm>
 #include <array>
@@ -15,6 +17,7 @@
 #include <cwchar>
 #include <iterator>
 #include <sstream>
+#include <string_view>
 #include <vector>
 #include <Richedit.h>
 #include <Commctrl.h>
@@ -29,6 +32,11 @@ namespace
 {
     constexpr UINT WM_APP_LOGTEXT = WM_APP + 100;
     constexpr UINT WM_APP_SMS_TEXT = WM_APP + 101;
+    constexpr std::size_t kInboxSearchLimit = 50;
+    constexpr UINT_PTR kSignalTimerId = 1;
+    constexpr UINT kSignalRefreshMs = 5000;
+    /// <summary>状态栏中信号范围统计的时间窗。</summary>
+    constexpr std::int64_t kSignalSummarySeconds = 600;
 
     COLORREF AdjustColor(COLORREF color, int delta)
     {
@@ -68,10 +76,38 @@ namespace
         text.erase(std::find_if(text.rbegin(), text.rend(), notSpaceFront).base(), text.end());
         return text;
     }
+
+    /// <summary>按分号或逗号（含全角）拆分号码，去掉空项与重复项，保持输入顺序。</summary>
+    std::vector<std::wstring> SplitNumbers(const std::wstring& text)
+    {
+        constexpr std::wstring_view separators = L";,；，";
+        std::vector<std::wstring> numbers;
+        std::size_t start = 0;
+        while (start <= text.size())
+        {
+            auto end = text.find_first_of(separators.data(), start, separators.size());
+            end = end == std::wstring::npos ? text.size() : end;
+            std::wstring number = TrimCopy(text.substr(start, end - start));
+            if (!number.empty() && std::find(numbers.begin(), numbers.end(), number) == numbers.end())
+            {
+                numbers.push_back(std::move(number));
+            }
+            start = end + 1;
+        }
+        return numbers;
+    }
+
+    BulkSmsPolicy BulkPolicyFromProfile(const SmsProfile& profile)
+    {
+        BulkSmsPolicy policy;
+        policy.messagesPerMinute = profile.bulkRatePerMinute;
+        policy.maxAttempts = profile.bulkMaxAttempts;
+        return policy;
+    }
 }
 
 AppController::AppController()
-        : _instance(nullptr), _dialog(nullptr), _richEditModule(nullptr),
+        : _instance(nullptr), _dialog(nullptr), _bulkSms(_session), _scriptRunner(_session), _richEditModule(nullptr),
             _themeMode(ThemeMode::Light), _palette{}, _dialogBrush(nullptr), _controlBrush(nullptr), _logBrush(nullptr),
             _compactFont(nullptr)
 {
@@ -81,7 +117,14 @@ AppController::~AppController()
 {
     _session.SetLogCallback(nullptr);
     _session.SetSmsCallback(nullptr);
+    _scriptRunner.SetLogCallback(nullptr);
     _session.Disconnect();
+    _scriptRunner.Cancel();
+    _signalSampler.Stop();
+    _signalSampler.Remove(_session);
+    _bulkSms.SetProgressCallback(nullptr);
+    _bulkSms.Close();
+    _inbox.Close();
     if (_richEditModule != nullptr)
     {
         FreeLibrary(_richEditModule);
@@ -133,6 +176,7 @@ bool AppController::Initialize(HINSTANCE instance)
     _commands = _config.GetCommands();
     _smsProfile = _config.GetSmsProfile();
     _session.SetSmsProfile(_smsProfile);
+    _bulkSms.SetPolicy(BulkPolicyFromProfile(_smsProfile));
     _themeMode = _config.GetTheme();
     ApplyTheme(_themeMode);
     return true;
@@ -168,6 +212,30 @@ INT_PTR AppController::OnInitDialog(HWND hWnd)
 {
     CenterWindow(hWnd);
     ResetSessionCallbacks();
+    // 上次退出时未发完的群发任务从日志恢复，连接串口后继续发送。
+    if (!_bulkSms.Open(_configPath.parent_path() / L"sms-queue.journal"))
+    {
+        AppendLog(L"群发任务日志无法写入，未发送的任务不会在重启后保留");
+    }
+    if (const auto restored = _bulkSms.GetStatistics().pending; restored != 0)
+    {
+        AppendLog(L"已恢复 " + std::to_wstring(restored) + L" 条未发送的群发短信，连接串口后继续发送");
+    }
+    if (!_inbox.Open(_configPath.parent_path() / L"sms-inbox.log"))
+    {
+        AppendLog(L"收件箱文件无法打开，收到的短信只显示在日志中");
+    }
+    // 模块型号、固件与专用初始化指令按 IMEI 缓存，再次连接同一模块时不再逐项查询。
+    if (!_modemCache.Open(_configPath.parent_path() / L"modem-cache.ini"))
+    {
+        AppendLog(L"模块信息缓存无法读取，每次连接都将重新查询模块信息");
+    }
+    _session.SetModemCache(&_modemCache);
+    // 信号与注册状态由后台采样，只在模块空闲时查询，状态栏定时刷新。
+    _signalSeries = _signalSampler.Add(_session);
+    _signalSampler.Start();
+    SetTimer(hWnd, kSignalTimerId, kSignalRefreshMs, nullptr);
+    ReportScriptErrors();
 
     HWND logEdit = GetDlgItem(hWnd, IDC_EDIT_LOG);
     if (logEdit)
@@ -186,16 +254,16 @@ INT_PTR AppController::OnInitDialog(HWND hWnd)
     ApplyCompactControlMetrics();
 
     HWND baudCombo = GetDlgItem(hWnd, IDC_COMBO_BAUD);
-    const std::array<unsigned long, 5> baudRates{9600, 19200, 38400, 57600, 115200};
+    const std::array<unsigned long, 11> baudRates{9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 2000000, 3000000, 4000000};
     for (unsigned long rate : baudRates)
     {
         std::wstring text = std::to_wstring(rate);
         SendMessageW(baudCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(text.c_str()));
     }
-    SendMessageW(baudCombo, CB_SETCURSEL, static_cast<WPARAM>(baudRates.size() - 1), 0);
 
     RefreshCommandList();
     RefreshPortList();
+    SelectSavedBaud();
     SetStatus(L"未连接");
     return TRUE;
 }
@@ -207,7 +275,15 @@ INT_PTR AppController::HandleDialogMessage(HWND, UINT message, WPARAM wParam, LP
     case WM_COMMAND:
         HandleCommand(wParam, lParam);
         return TRUE;
+    case WM_TIMER:
+        if (wParam == kSignalTimerId)
+        {
+            RefreshStatus();
+            return TRUE;
+        }
+        break;
     case WM_CLOSE:
+        KillTimer(_dialog, kSignalTimerId);
         DisconnectPort();
         EndDialog(_dialog, 0);
         return TRUE;
@@ -265,33 +341,19 @@ void AppController::HandleCommand(WPARAM wParam, LPARAM lParam)
     case IDC_BUTTON_SEND_SMS:
         if (notify == BN_CLICKED)
         {
-            wchar_t numberBuffer[64]{};
+            wchar_t numberBuffer[4096]{};
             GetDlgItemTextW(_dialog, IDC_EDIT_SMS_NUMBER, numberBuffer, static_cast<int>(std::size(numberBuffer)));
-            std::wstring targetNumber = TrimCopy(numberBuffer);
             wchar_t buffer[512]{};
             GetDlgItemTextW(_dialog, IDC_EDIT_SMS_TEXT, buffer, static_cast<int>(std::size(buffer)));
-            if (targetNumber.empty())
-            {
-                MessageBoxW(_dialog, L"请填写短信号码", L"AT Helper", MB_OK | MB_ICONINFORMATION);
-                return;
-            }
-            if (!_session.IsConnected())
-            {
-                MessageBoxW(_dialog, L"请先连接串口", L"AT Helper", MB_OK | MB_ICONINFORMATION);
-                return;
-            }
-            SmsProfile profile = _smsProfile;
-            profile.targetNumber = targetNumber;
-            _session.SetSmsProfile(profile);
-            _smsProfile.targetNumber = targetNumber;
-            if (_session.SendSms(buffer))
-            {
-                SetDlgItemTextW(_dialog, IDC_EDIT_SMS_TEXT, L"");
-            }
-            else
-            {
-                MessageBoxW(_dialog, L"发送短信失败", L"AT Helper", MB_OK | MB_ICONWARNING);
-            }
+            SendSmsToNumbers(TrimCopy(numberBuffer), buffer);
+        }
+        break;
+    case IDC_BUTTON_SEARCH_INBOX:
+        if (notify == BN_CLICKED)
+        {
+            wchar_t buffer[256]{};
+            GetDlgItemTextW(_dialog, IDC_EDIT_INBOX_QUERY, buffer, static_cast<int>(std::size(buffer)));
+            SearchInbox(buffer);
         }
         break;
     case IDC_BUTTON_CLEAR_LOG:
@@ -312,6 +374,12 @@ void AppController::HandleCommand(WPARAM wParam, LPARAM lParam)
             OnThemeSelectionChanged();
         }
         break;
+    case IDC_COMBO_PORT:
+        if (notify == CBN_SELCHANGE)
+        {
+            SelectSavedBaud();
+        }
+        break;
     case IDC_COMMAND_LIST:
         if (notify == LBN_DBLCLK)
         {
@@ -323,6 +391,87 @@ void AppController::HandleCommand(WPARAM wParam, LPARAM lParam)
     }
 }
 
+void AppController::SendSmsToNumbers(const std::wstring& numbers, const std::wstring& text)
+{
+    const auto targets = SplitNumbers(numbers);
+    if (targets.empty())
+    {
+        MessageBoxW(_dialog, L"请填写短信号码", L"AT Helper", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    if (targets.size() == 1 && !_session.IsConnected())
+    {
+        MessageBoxW(_dialog, L"请先连接串口", L"AT Helper", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    SmsProfile profile = _smsProfile;
+    profile.targetNumber = targets.front();
+    _session.SetSmsProfile(profile);
+    _smsProfile.targetNumber = numbers;
+    if (targets.size() == 1)
+    {
+        if (_session.SendSms(text))
+        {
+            SetDlgItemTextW(_dialog, IDC_EDIT_SMS_TEXT, L"");
+        }
+        else
+        {
+            MessageBoxW(_dialog, L"发送短信失败", L"AT Helper", MB_OK | MB_ICONWARNING);
+        }
+        return;
+    }
+    if (TrimCopy(text).empty())
+    {
+        return;
+    }
+    // 群发任务先写入日志再排队，未连接时也可受理，连接后开始发送。
+    std::vector<BulkSmsJob> jobs;
+    jobs.reserve(targets.size());
+    for (const auto& target : targets)
+    {
+        jobs.push_back(BulkSmsJob{target, text});
+    }
+    const auto accepted = _bulkSms.Enqueue(jobs);
+    AppendLog(L"已加入群发队列: " + std::to_wstring(accepted) + L" 条");
+    SetDlgItemTextW(_dialog, IDC_EDIT_SMS_TEXT, L"");
+}
+
+void AppController::SearchInbox(const std::wstring& text)
+{
+    if (!_inbox.IsOpen())
+    {
+        AppendLog(L"收件箱未打开");
+        return;
+    }
+    const std::wstring trimmed = TrimCopy(text);
+    const std::string pattern = WideToUtf8(trimmed);
+    SmsInboxQuery query;
+    query.limit = kInboxSearchLimit;
+    if (!pattern.empty() && pattern.find_first_not_of("+0123456789") == std::string::npos)
+    {
+        query.sender = pattern;
+        query.senderPrefix = true;
+    }
+    else
+    {
+        query.text = pattern;
+    }
+    // 查询回调持有收件箱的锁，先收集结果再写日志。
+    std::vector<std::wstring> lines;
+    _inbox.Find(query, [&lines](const SmsInboxEntry& entry)
+    {
+        lines.push_back(Utf8ToWide(FormatModemTime(ModemTimeFromUnix(entry.timestamp, entry.quarterHours))) + L" " + Utf8ToWide(entry.sender)
+            + L": " + Utf8ToWide(entry.body));
+        return true;
+    });
+    AppendLog(L"收件箱查找 \"" + trimmed + L"\": " + std::to_wstring(lines.size()) + L" 条（最多显示 " + std::to_wstring(kInboxSearchLimit)
+        + L" 条，从新到旧），共 " + std::to_wstring(_inbox.Size()) + L" 条");
+    for (const auto& line : lines)
+    {
+        AppendLog(line);
+    }
+}
+
 void AppController::HandleLogPayload(std::wstring* payload)
 {
     if (payload != nullptr)
@@ -361,6 +510,16 @@ void AppController::RefreshCommandList()
         }
         SendMessageW(list, LB_ADDSTRING, 0, reinterpret_cast<LPARAM>(display.c_str()));
     }
+    _scripts = _config.GetScripts();
+    for (const auto& script : _scripts)
+    {
+        std::wstring display = L"▶ " + script->Name();
+        if (!script->Summary().empty())
+        {
+            display.append(L" — ").append(script->Summary());
+        }
+        SendMessageW(list, LB_ADDSTRING, 0, reinterpret_cast<LPARAM>(display.c_str()));
+    }
 }
 
 void AppController::RefreshPortList()
@@ -369,25 +528,9 @@ void AppController::RefreshPortList()
     SendMessageW(combo, CB_RESETCONTENT, 0, 0);
 
     std::vector<std::wstring> ports;
-    std::vector<wchar_t> buffer(4096);
-    DWORD length = QueryDosDeviceW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
-    if (length == 0 && GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+    for (auto& info : EnumerateSerialPorts())
     {
-        buffer.resize(32768);
-        length = QueryDosDeviceW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
-    }
-    if (length != 0)
-    {
-        wchar_t* current = buffer.data();
-        while (*current != L'\0')
-        {
-            std::wstring name = current;
-            if (name.rfind(L"COM", 0) == 0)
-            {
-                ports.push_back(name);
-            }
-            current += name.size() + 1;
-        }
+        ports.push_back(std::move(info.name));
     }
     if (ports.empty())
     {
@@ -398,6 +541,10 @@ void AppController::RefreshPortList()
             ports.push_back(std::move(name));
         }
     }
+#ifdef _DEBUG
+    // 调试版附带一个虚拟模块端口，无硬件时也能联调整个会话流程。
+    ports.push_back(std::wstring(VirtualModemTransport::kPortPrefix) + L"1");
+#endif
     std::sort(ports.begin(), ports.end());
     for (const auto& port : ports)
     {
@@ -469,6 +616,42 @@ void AppController::SetStatus(const std::wstring& text)
     {
         return;
     }
+    _connectionStatus = text;
+    RefreshStatus();
+}
+
+void AppController::RefreshStatus()
+{
+    if (_dialog == nullptr)
+    {
+        return;
+    }
+    std::wstring text = _connectionStatus;
+    const auto latest = _signalSeries ? _signalSeries->Latest() : std::nullopt;
+    if (_session.IsConnected() && latest && latest->rssi != SignalSample::kUnknown)
+    {
+        const auto summary = _signalSeries->Summarize(latest->time - kSignalSummarySeconds);
+        SignalSample low;
+        low.rssi = summary.rssi.min;
+        SignalSample high;
+        high.rssi = summary.rssi.max;
+        std::wstringstream status;
+        status << text << L"  |  信号 " << latest->RssiDbm() << L" dBm（10 分钟内 " << low.RssiDbm() << L" ~ " << high.RssiDbm() << L"）";
+        if (latest->rsrp != SignalSample::kUnknown)
+        {
+            status << L"  RSRP " << latest->RsrpDbm() << L" dBm";
+        }
+        const auto operatorName = _signalSeries->OperatorName();
+        if (!operatorName.empty())
+        {
+            status << L"  " << operatorName;
+        }
+        if (latest->registration != SignalSample::kUnknown)
+        {
+            status << (latest->IsRegistered() ? L" 已注册" : L" 未注册");
+        }
+        text = status.str();
+    }
     SetDlgItemTextW(_dialog, IDC_STATUS_TEXT, text.c_str());
 }
 
@@ -481,11 +664,15 @@ bool AppController::TryConnectSelectedPort()
         MessageBoxW(_dialog, L"请选择串口与波特率", L"AT Helper", MB_OK | MB_ICONINFORMATION);
         return false;
     }
-    if (!_session.Connect(port, baud))
+    SerialSettings settings = _config.GetPortSettings(port);
+    settings.baudRate = baud;
+    if (!_session.Connect(port, settings))
     {
         MessageBoxW(_dialog, L"连接失败，请检查串口", L"AT Helper", MB_OK | MB_ICONERROR);
         return false;
     }
+    _config.SetPortSettings(port, settings);
+    _config.Save(_configPath);
     std::wstringstream status;
     status << L"已连接 " << port << L" @ " << baud;
     SetStatus(status.str());
@@ -499,6 +686,8 @@ void AppController::DisconnectPort()
     {
         _session.Disconnect();
     }
+    // 在途指令已随断开取消，脚本随即结束。
+    _scriptRunner.Cancel();
     SetDlgItemTextW(_dialog, IDC_BUTTON_CONNECT, L"连接");
     SetStatus(L"未连接");
 }
@@ -524,12 +713,39 @@ void AppController::SendSelectedCommand()
 {
     HWND list = GetDlgItem(_dialog, IDC_COMMAND_LIST);
     const int index = static_cast<int>(SendMessageW(list, LB_GETCURSEL, 0, 0));
-    if (index >= 0 && static_cast<std::size_t>(index) < _commands.size())
+    if (index < 0)
+    {
+        return;
+    }
+    const auto position = static_cast<std::size_t>(index);
+    if (position < _commands.size())
+    {
+        SendCommandText(_commands[position].text);
+    }
+    else if (position - _commands.size() < _scripts.size())
     {
-        SendCommandText(_commands[static_cast<std::size_t>(index)].text);
+        RunScript(_scripts[position - _commands.size()]);
     }
 }
 
+void AppController::RunScript(const std::shared_ptr<const AtScript>& script)
+{
+    if (!_session.IsConnected())
+    {
+        MessageBoxW(_dialog, L"请先连接串口", L"AT Helper", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    const std::wstring name = script->Name();
+    const bool started = _scriptRunner.Start(script, [this, name](const AtScriptResult& result)
+    {
+        const auto elapsed = std::to_wstring(result.elapsed.count()) + L" ms";
+        PostLog(result.succeeded
+            ? L"脚本「" + name + L"」执行完成，" + std::to_wstring(result.steps) + L" 步，用时 " + elapsed
+            : L"脚本「" + name + L"」执行失败: " + result.message + L"（用时 " + elapsed + L"）");
+    });
+    AppendLog(started ? L"开始执行脚本「" + name + L"」" : L"已有脚本在执行，请等待其结束");
+}
+
 std::wstring AppController::GetSelectedPort() const
 {
     HWND combo = GetDlgItem(_dialog, IDC_COMBO_PORT);
@@ -553,6 +769,22 @@ std::wstring AppController::GetSelectedPort() const
     return text;
 }
 
+void AppController::SelectSavedBaud()
+{
+    HWND combo = GetDlgItem(_dialog, IDC_COMBO_BAUD);
+    if (!combo)
+    {
+        return;
+    }
+    const std::wstring text = std::to_wstring(_config.GetPortSettings(GetSelectedPort()).baudRate);
+    LRESULT index = SendMessageW(combo, CB_FINDSTRINGEXACT, static_cast<WPARAM>(-1), reinterpret_cast<LPARAM>(text.c_str()));
+    if (index == CB_ERR)
+    {
+        index = SendMessageW(combo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(text.c_str()));
+    }
+    SendMessageW(combo, CB_SETCURSEL, static_cast<WPARAM>(index), 0);
+}
+
 unsigned long AppController::GetSelectedBaud() const
 {
     HWND combo = GetDlgItem(_dialog, IDC_COMBO_BAUD);
@@ -583,38 +815,77 @@ void AppController::ReloadConfiguration()
         MessageBoxW(_dialog, L"重新加载配置失败", L"AT Helper", MB_OK | MB_ICONWARNING);
     }
     _smsProfile = _config.GetSmsProfile();
+    _bulkSms.SetPolicy(BulkPolicyFromProfile(_smsProfile));
     _themeMode = _config.GetTheme();
     ApplyTheme(_themeMode);
     RefreshCommandList();
     AppendLog(L"已重新加载指令配置");
+    ReportScriptErrors();
+}
+
+void AppController::ReportScriptErrors()
+{
+    for (const auto& error : _config.GetScriptErrors())
+    {
+        AppendLog(error);
+    }
 }
 
 void AppController::ResetSessionCallbacks()
 {
     _session.SetLogCallback([this](const std::wstring& text)
     {
-        if (_dialog == nullptr)
-        {
-            return;
-        }
-        auto* payload = new std::wstring(text);
-        if (PostMessageW(_dialog, WM_APP_LOGTEXT, reinterpret_cast<WPARAM>(payload), 0) == 0)
-        {
-            delete payload;
-        }
+        PostLog(text);
     });
-    _session.SetSmsCallback([this](const std::wstring& header, const std::wstring& content)
+    _scriptRunner.SetLogCallback([this](const std::wstring& text)
     {
+        PostLog(text);
+    });
+    _session.SetSmsCallback([this](const ReceivedSms& sms)
+    {
+        // 日志控件超过 60000 字会截掉开头，收到的短信以收件箱为准；重复列出的存储短信只存一份。
+        SmsInboxEntry entry;
+        entry.modem = sms.modem;
+        entry.sender = sms.sender;
+        entry.body = sms.body;
+        entry.storageIndex = sms.storageIndex;
+        if (sms.timestamp)
+        {
+            entry.timestamp = ModemTimeToUnix(*sms.timestamp);
+            entry.quarterHours = sms.timestamp->quarterHours;
+        }
+        // 保存失败时不算已保存，模块存储中的原件不会被删除。
+        const bool saved = _inbox.Append(entry) != SmsInboxWrite::Failed;
         if (_dialog == nullptr)
         {
-            return;
+            return saved;
         }
-        auto* payload = new std::wstring(L"收到短信\r\n" + header + L"\r\n" + content);
+        auto* payload = new std::wstring((sms.complete ? L"收到短信\r\n" : L"收到短信（长短信未收齐）\r\n") + Utf8ToWide(sms.header) + L"\r\n" + Utf8ToWide(sms.body));
         if (PostMessageW(_dialog, WM_APP_SMS_TEXT, reinterpret_cast<WPARAM>(payload), 0) == 0)
         {
             delete payload;
         }
+        return saved;
     });
+    _bulkSms.SetProgressCallback([this](const BulkSmsStatistics& statistics)
+    {
+        PostLog(L"群发进度: 已发送 " + std::to_wstring(statistics.sent) + L" 条，失败 "
+            + std::to_wstring(statistics.failed) + L" 条（其中超时未知是否发出 " + std::to_wstring(statistics.uncertain) + L" 条），待发 " + std::to_wstring(statistics.pending + statistics.inFlight)
+            + L" 条，速率 " + std::to_wstring(static_cast<long long>(statistics.messagesPerMinute + 0.5)) + L" 条/分钟");
+    });
+}
+
+void AppController::PostLog(const std::wstring& text)
+{
+    if (_dialog == nullptr)
+    {
+        return;
+    }
+    auto* payload = new std::wstring(text);
+    if (PostMessageW(_dialog, WM_APP_LOGTEXT, reinterpret_cast<WPARAM>(payload), 0) == 0)
+    {
+        delete payload;
+    }
 }
 
 void AppController::InitializeThemeSelector()
@@ -682,8 +953,9 @@ void AppController::ApplyTheme(ThemeMode mode)
         InvalidateRect(logEdit, nullptr, TRUE);
     }
 
-    const std::array<int, 12> themedControls{
+    const std::array<int, 14> themedControls{
         IDC_COMMAND_LIST,
+        IDC_EDIT_INBOX_QUERY,
         IDC_EDIT_COMMAND,
         IDC_EDIT_SMS_NUMBER,
         IDC_EDIT_SMS_TEXT,
@@ -694,7 +966,8 @@ void AppController::ApplyTheme(ThemeMode mode)
         IDC_BUTTON_CONNECT,
         IDC_BUTTON_CLEAR_LOG,
         IDC_BUTTON_SEND_COMMAND,
-        IDC_BUTTON_SEND_SMS
+        IDC_BUTTON_SEND_SMS,
+        IDC_BUTTON_SEARCH_INBOX
     };
     for (int id : themedControls)
     {
@@ -827,8 +1100,9 @@ void AppController::ApplyFlatBorderToControls()
     {
         return;
     }
-    const std::array<int, 8> borderControls{
+    const std::array<int, 9> borderControls{
         IDC_COMMAND_LIST,
+        IDC_EDIT_INBOX_QUERY,
         IDC_EDIT_LOG,
         IDC_EDIT_COMMAND,
         IDC_EDIT_SMS_NUMBER,
@@ -909,11 +1183,12 @@ void AppController::ApplyCompactControlMetrics()
             }
         }
     }
-    const std::array<int, 4> buttonIds{
+    const std::array<int, 5> buttonIds{
         IDC_BUTTON_CONNECT,
         IDC_BUTTON_CLEAR_LOG,
         IDC_BUTTON_SEND_COMMAND,
-        IDC_BUTTON_SEND_SMS
+        IDC_BUTTON_SEND_SMS,
+        IDC_BUTTON_SEARCH_INBOX
     };
     for (int id : buttonIds)
     {
@@ -998,11 +1273,12 @@ void AppController::DrawFlatBorder(HWND control) const
 
 bool AppController::DrawThemedButton(const DRAWITEMSTRUCT& dis) const
 {
-    static constexpr std::array<int, 4> kButtonIds{
+    static constexpr std::array<int, 5> kButtonIds{
         IDC_BUTTON_CONNECT,
         IDC_BUTTON_CLEAR_LOG,
         IDC_BUTTON_SEND_COMMAND,
-        IDC_BUTTON_SEND_SMS
+        IDC_BUTTON_SEND_SMS,
+        IDC_BUTTON_SEARCH_INBOX
     };
     if (std::find(kButtonIds.begin(), kButtonIds.end(), dis.CtlID) == kButtonIds.end())
     {
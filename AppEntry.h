@@ -8,10 +8,16 @@
 ------------------------------------------------------------------------*/
 #pragma once
 
+#include "AtScriptRunner.h"
 #include "AtSession.h"
+#include "BulkSmsEngine.h"
 #include "CommandConfig.h"
+#include "ModemProfileCache.h"
+#include "SignalSampler.h"
+#include "SmsInboxStore.h"
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 #include <windows.h>
@@ -62,14 +68,28 @@ private:
     void AppendLog(const std::wstring& text);
     COLORREF ResolveLogColor(const std::wstring& text) const;
     void SetStatus(const std::wstring& text);
+    /// <summary>以连接状态加上最近的信号采样刷新状态栏，由定时器每隔几秒调用。</summary>
+    void RefreshStatus();
     bool TryConnectSelectedPort();
     void DisconnectPort();
     void SendCommandText(const std::wstring& text);
     void SendSelectedCommand();
+    /// <summary>在后台执行脚本，结束时把结果写入日志；同一时刻只执行一个脚本。</summary>
+    void RunScript(const std::shared_ptr<const AtScript>& script);
+    /// <summary>发送短信：一个号码直接提交，多个号码（以分号或逗号分隔）交给群发队列。</summary>
+    void SendSmsToNumbers(const std::wstring& numbers, const std::wstring& text);
+    /// <summary>在收件箱中查找：只含号码字符时按号码前缀，否则按正文；结果从新到旧写入日志。</summary>
+    void SearchInbox(const std::wstring& text);
     std::wstring GetSelectedPort() const;
     unsigned long GetSelectedBaud() const;
+    /// <summary>按端口已保存的配置选中波特率。</summary>
+    void SelectSavedBaud();
     void ReloadConfiguration();
+    /// <summary>把配置中编译失败的脚本写入日志。</summary>
+    void ReportScriptErrors();
     void ResetSessionCallbacks();
+    /// <summary>从任意线程投递一行日志到界面线程。</summary>
+    void PostLog(const std::wstring& text);
     std::filesystem::path ResolveConfigPath() const;
     /// <summary>初始化主题下拉框。</summary>
     void InitializeThemeSelector();
@@ -121,8 +141,21 @@ private:
     AppController(const AppController&) = delete;
     AppController& operator=(const AppController&) = delete;
     std::vector<CommandItem> _commands;
+    /// <summary>列在指令列表中指令之后的脚本。</summary>
+    std::vector<std::shared_ptr<const AtScript>> _scripts;
     SmsProfile _smsProfile;
+    /// <summary>须先于 _session 构造、后于它析构，会话持有其指针。</summary>
+    ModemProfileCache _modemCache;
     AtSession _session;
+    BulkSmsEngine _bulkSms;
+    SmsInboxStore _inbox;
+    /// <summary>须在 _session 之后声明，先于会话析构。</summary>
+    SignalSampler _signalSampler;
+    std::shared_ptr<const SignalSeries> _signalSeries;
+    /// <summary>SetStatus 设置的连接状态，信号信息附加在其后。</summary>
+    std::wstring _connectionStatus;
+    /// <summary>须在 _session 之后声明，先于会话析构。</summary>
+    AtScriptRunner _scriptRunner;
     HMODULE _richEditModule;
     ThemeMode _themeMode;
     ThemePalette _palette;
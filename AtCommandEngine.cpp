@@ -0,0 +1,423 @@
+/*------------------------------------------------------------------------
+名称：AT 指令关联引擎实现
+说明：实现最终结果码识别、回显与主动上报区分以及超时处理
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：结果码按 3GPP TS 27.007 verbose 模式（V1）识别
+------------------------------------------------------------------------*/
+#include "AtCommandEngine.h"
+#include "AtResponseParser.h"
+#include "UrcDispatcher.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <optional>
+
+namespace
+{
+    constexpr auto kDefaultTimeout = std::chrono::seconds(5);
+    // 取消正文输入状态，否则模块会把之后的指令当作短信内容。
+    constexpr char kEscape = 0x1B;
+
+    /// <summary>慢指令的默认超时，按指令前缀匹配。</summary>
+    struct TimeoutRule
+    {
+        std::string_view prefix;
+        std::chrono::milliseconds timeout;
+    };
+
+    constexpr std::array<TimeoutRule, 6> kTimeoutRules{{
+        {"AT+COPS=?", std::chrono::seconds(180)},
+        {"AT+CMGS", std::chrono::seconds(60)},
+        {"AT+CMSS", std::chrono::seconds(60)},
+        {"AT+CMGL", std::chrono::seconds(30)},
+        {"AT+CUSD", std::chrono::seconds(30)},
+        {"AT+CFUN", std::chrono::seconds(15)}
+    }};
+
+    struct FinalCode
+    {
+        std::string_view text;
+        AtResultCode code;
+    };
+
+    constexpr std::array<FinalCode, 6> kFinalCodes{{
+        {"OK", AtResultCode::Ok},
+        {"ERROR", AtResultCode::Error},
+        {"NO CARRIER", AtResultCode::NoCarrier},
+        {"BUSY", AtResultCode::Busy},
+        {"NO ANSWER", AtResultCode::NoAnswer},
+        {"NO DIALTONE", AtResultCode::NoDialtone}
+    }};
+
+    bool StartsWith(std::string_view text, std::string_view prefix) noexcept
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    /// <summary>识别最终结果码。</summary>
+    std::optional<AtResultCode> ClassifyFinal(std::string_view line, int& errorCode) noexcept
+    {
+        errorCode = -1;
+        for (const auto& entry : kFinalCodes)
+        {
+            if (line == entry.text)
+            {
+                return entry.code;
+            }
+        }
+        if (const auto error = ParseAtError(line))
+        {
+            errorCode = error->code;
+            return error->source == AtErrorSource::MessageService ? AtResultCode::CmsError : AtResultCode::CmeError;
+        }
+        return std::nullopt;
+    }
+
+    /// <summary>扩展指令的应答前缀，例如 AT+CSQ → "+CSQ:"；基本指令返回空。</summary>
+    std::string ResponsePrefix(std::string_view command)
+    {
+        if (command.size() < 4 || std::toupper(static_cast<unsigned char>(command[0])) != 'A'
+            || std::toupper(static_cast<unsigned char>(command[1])) != 'T' || command[2] != '+')
+        {
+            return {};
+        }
+        std::string prefix;
+        for (std::size_t i = 2; i < command.size() && command[i] != '=' && command[i] != '?'; ++i)
+        {
+            prefix.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(command[i]))));
+        }
+        prefix.push_back(':');
+        return prefix;
+    }
+}
+
+AtCommandHandle::AtCommandHandle(std::shared_future<AtCommandResult> future, bool accepted)
+    : _future(std::move(future)), _accepted(accepted)
+{
+}
+
+AtCommandHandle::operator bool() const noexcept
+{
+    return _accepted;
+}
+
+bool AtCommandHandle::IsReady() const
+{
+    return _future.valid() && _future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+const AtCommandResult& AtCommandHandle::Wait() const
+{
+    return _future.get();
+}
+
+AtCommandEngine::AtCommandEngine(Writer writer)
+    : _writer(std::move(writer)), _stopping(false)
+{
+    _timeoutWorker = std::thread(&AtCommandEngine::TimeoutLoop, this);
+}
+
+AtCommandEngine::~AtCommandEngine()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stopping = true;
+    }
+    _timeoutSignal.notify_all();
+    if (_timeoutWorker.joinable())
+    {
+        _timeoutWorker.join();
+    }
+    CancelAll();
+}
+
+AtCommandHandle AtCommandEngine::Submit(std::string command, std::chrono::milliseconds timeout, CompletionCallback onComplete)
+{
+    return Submit(AtCommandRequest{std::move(command), {}, timeout}, std::move(onComplete));
+}
+
+AtCommandHandle AtCommandEngine::Submit(AtCommandRequest request, CompletionCallback onComplete)
+{
+    auto pending = std::make_shared<PendingCommand>();
+    pending->responsePrefix = ResponsePrefix(request.command);
+    pending->payload = std::move(request.payload);
+    pending->collectLines = request.collectLines;
+    pending->urgent = request.urgent;
+    pending->background = request.background;
+    pending->timeout = request.timeout.count() > 0 ? request.timeout : DefaultTimeout(request.command);
+    pending->result.command = std::move(request.command);
+    pending->onComplete = std::move(onComplete);
+    auto future = pending->promise.get_future().share();
+    if (pending->result.command.empty())
+    {
+        pending->result.code = AtResultCode::NotSent;
+        Complete(*pending);
+        return AtCommandHandle(std::move(future), false);
+    }
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (pending->background && (_active || !_queue.empty()))
+        {
+            pending->result.code = AtResultCode::NotSent;
+        }
+        else if (pending->urgent)
+        {
+            // 紧急指令之间仍按提交顺序。
+            const auto position = std::find_if(_queue.begin(), _queue.end(), [](const PendingPointer& queued)
+            {
+                return !queued->urgent;
+            });
+            _queue.insert(position, pending);
+        }
+        else
+        {
+            _queue.push_back(pending);
+        }
+    }
+    if (pending->result.code == AtResultCode::NotSent)
+    {
+        Complete(*pending);
+        return AtCommandHandle(std::move(future), false);
+    }
+    StartNext();
+    return AtCommandHandle(std::move(future), true);
+}
+
+AtCommandEngine::LineRole AtCommandEngine::OnLine(std::string_view line, bool* background)
+{
+    PendingPointer completed;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (!_active)
+        {
+            return LineRole::Unsolicited;
+        }
+        auto& active = *_active;
+        if (!active.echoed && line == active.result.command)
+        {
+            active.echoed = true;
+            if (background != nullptr)
+            {
+                *background = active.background;
+            }
+            return LineRole::Echo;
+        }
+        int errorCode = -1;
+        if (const auto finalCode = ClassifyFinal(line, errorCode))
+        {
+            active.result.code = *finalCode;
+            active.result.errorCode = errorCode;
+            active.result.finalLine.assign(line);
+            if (background != nullptr)
+            {
+                *background = active.background;
+            }
+            active.result.latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - active.sentAt);
+            completed = std::move(_active);
+            _active.reset();
+        }
+        else
+        {
+            // 与本指令应答前缀相同的行归本指令，例如 AT+CREG? 的 +CREG: 行。
+            const bool ownPrefix = !active.responsePrefix.empty() && StartsWith(line, active.responsePrefix);
+            if (!ownPrefix && UrcDispatcher::Match(line) != UrcKind::None)
+            {
+                return LineRole::Unsolicited;
+            }
+            if (background != nullptr)
+            {
+                *background = active.background;
+            }
+            if (active.collectLines)
+            {
+                active.result.lines.emplace_back(line);
+            }
+            return LineRole::Response;
+        }
+    }
+    Complete(*completed);
+    StartNext();
+    return LineRole::Final;
+}
+
+std::string AtCommandEngine::ActiveCommand() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _active ? _active->result.command : std::string();
+}
+
+bool AtCommandEngine::OnPrompt()
+{
+    PendingPointer active;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (!_active || _active->payload.empty() || _active->payloadSent)
+        {
+            return false;
+        }
+        _active->payloadSent = true;
+        active = _active;
+    }
+    if (!Write(active, active->payload))
+    {
+        StartNext();
+    }
+    return true;
+}
+
+bool AtCommandEngine::AwaitingPrompt() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _active && !_active->payload.empty() && !_active->payloadSent;
+}
+
+void AtCommandEngine::CancelAll()
+{
+    std::deque<PendingPointer> cancelled;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        cancelled.swap(_queue);
+        if (_active)
+        {
+            cancelled.push_front(std::move(_active));
+            _active.reset();
+        }
+    }
+    for (const auto& pending : cancelled)
+    {
+        pending->result.code = AtResultCode::Cancelled;
+        Complete(*pending);
+    }
+}
+
+std::chrono::milliseconds AtCommandEngine::DefaultTimeout(std::string_view command) noexcept
+{
+    for (const auto& rule : kTimeoutRules)
+    {
+        if (command.size() >= rule.prefix.size()
+            && std::equal(rule.prefix.begin(), rule.prefix.end(), command.begin(), [](char expected, char actual)
+            {
+                return expected == std::toupper(static_cast<unsigned char>(actual));
+            }))
+        {
+            return rule.timeout;
+        }
+    }
+    return kDefaultTimeout;
+}
+
+void AtCommandEngine::StartNext()
+{
+    while (true)
+    {
+        PendingPointer next;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_active || _queue.empty())
+            {
+                return;
+            }
+            next = std::move(_queue.front());
+            _queue.pop_front();
+            // 计时从写出开始，排队时间不计入超时与耗时。
+            next->sentAt = std::chrono::steady_clock::now();
+            next->deadline = next->sentAt + next->timeout;
+            _active = next;
+        }
+        _timeoutSignal.notify_one();
+        if (Write(next, next->result.command + '\r'))
+        {
+            return;
+        }
+        // 写入未能入队（例如端口已关闭），继续尝试下一条，让它们同样尽快失败。
+    }
+}
+
+bool AtCommandEngine::Write(const PendingPointer& pending, std::string data)
+{
+    std::weak_ptr<PendingCommand> weak = pending;
+    const bool queued = _writer(std::move(data), [this, weak](bool success)
+    {
+        if (const auto written = weak.lock(); written && !success)
+        {
+            Abandon(written, AtResultCode::NotSent);
+        }
+    });
+    if (!queued && Release(pending))
+    {
+        pending->result.code = AtResultCode::NotSent;
+        Complete(*pending);
+    }
+    return queued;
+}
+
+bool AtCommandEngine::Release(const PendingPointer& pending)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_active == pending)
+    {
+        _active.reset();
+        return true;
+    }
+    const auto found = std::find(_queue.begin(), _queue.end(), pending);
+    if (found == _queue.end())
+    {
+        return false;
+    }
+    _queue.erase(found);
+    return true;
+}
+
+void AtCommandEngine::Abandon(const PendingPointer& pending, AtResultCode code)
+{
+    if (!Release(pending))
+    {
+        return;
+    }
+    pending->result.code = code;
+    Complete(*pending);
+    StartNext();
+}
+
+void AtCommandEngine::Complete(PendingCommand& pending)
+{
+    if (pending.onComplete)
+    {
+        pending.onComplete(pending.result);
+    }
+    pending.promise.set_value(std::move(pending.result));
+}
+
+void AtCommandEngine::TimeoutLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        if (!_active)
+        {
+            _timeoutSignal.wait(lock);
+            continue;
+        }
+        const auto deadline = _active->deadline;
+        if (std::chrono::steady_clock::now() < deadline)
+        {
+            _timeoutSignal.wait_until(lock, deadline);
+            continue;
+        }
+        // 超时后迟到的结果码会被记到下一条指令上；模块通常在超时前已给出结果，这里只防止调用方永久等待。
+        auto expired = std::move(_active);
+        _active.reset();
+        lock.unlock();
+        if (!expired->payload.empty())
+        {
+            _writer(std::string(1, kEscape), [](bool) {});
+        }
+        expired->result.code = AtResultCode::Timeout;
+        Complete(*expired);
+        StartNext();
+        lock.lock();
+    }
+}
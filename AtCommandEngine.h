@@ -0,0 +1,191 @@
+/*------------------------------------------------------------------------
+名称：AT 指令关联引擎
+说明：排队写出 AT 指令，把模块应答行归属到对应的指令，并以句柄交付最终结果码、中间行与耗时
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：同一时刻只有一条指令在途，收到最终结果码后立即写出下一条；主动上报不会被计入任何指令
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// <summary>指令的最终结果。</summary>
+enum class AtResultCode
+{
+    Ok,
+    Error,
+    CmeError,
+    CmsError,
+    NoCarrier,
+    Busy,
+    NoAnswer,
+    NoDialtone,
+    /// <summary>超时仍未收到最终结果码。</summary>
+    Timeout,
+    /// <summary>断开或重连时被放弃。</summary>
+    Cancelled,
+    /// <summary>未能写入串口。</summary>
+    NotSent
+};
+
+/// <summary>一条指令的完整应答。</summary>
+struct AtCommandResult
+{
+    AtResultCode code = AtResultCode::Cancelled;
+    /// <summary>+CME ERROR / +CMS ERROR 的数字错误码，文本形式或其他结果为 -1。</summary>
+    int errorCode = -1;
+    std::string command;
+    /// <summary>最终结果行，超时、取消与未发送时为空。</summary>
+    std::string finalLine;
+    /// <summary>最终结果之前属于本指令的应答行（UTF-8），不含回显与主动上报。</summary>
+    std::vector<std::string> lines;
+    /// <summary>写出到收到最终结果的耗时。</summary>
+    std::chrono::microseconds latency{0};
+
+    bool Succeeded() const noexcept
+    {
+        return code == AtResultCode::Ok;
+    }
+};
+
+/// <summary>一条待提交的指令。</summary>
+struct AtCommandRequest
+{
+    /// <summary>指令文本，不含结尾 CR。</summary>
+    std::string command;
+    /// <summary>收到 "> " 提示符后写出的正文（例如短信内容加 Ctrl-Z），为空表示没有正文。超时时补发 ESC 退出输入状态。</summary>
+    std::string payload;
+    /// <summary>从写出到最终结果的时限，为零时按指令类型取默认值。</summary>
+    std::chrono::milliseconds timeout{0};
+    /// <summary>为 false 时中间行不保存到结果中，由调用方在分发线程上逐行处理，长列表不会整体驻留内存。</summary>
+    bool collectLines = true;
+    /// <summary>为 true 时插到队列中普通指令之前（仍等在途指令完成），用于 AT+CNMA 等须在网络时限内写出的应答。</summary>
+    bool urgent = false;
+    /// <summary>后台指令（例如定时查询信号）：只在没有在途与排队指令时受理，否则立即以 NotSent 完成，不让用户指令排在它后面。</summary>
+    bool background = false;
+};
+
+/// <summary>已提交指令的句柄，可等待或轮询结果，可复制。</summary>
+class AtCommandHandle
+{
+public:
+    AtCommandHandle() = default;
+    AtCommandHandle(std::shared_future<AtCommandResult> future, bool accepted);
+
+    /// <summary>指令是否已被受理（端口打开且内容非空）。未受理的句柄立即以 NotSent 完成。</summary>
+    explicit operator bool() const noexcept;
+
+    /// <summary>结果是否已可用，不阻塞。</summary>
+    bool IsReady() const;
+
+    /// <summary>阻塞至指令完成。不可在串口分发线程（日志或短信回调）中调用。</summary>
+    const AtCommandResult& Wait() const;
+
+private:
+    std::shared_future<AtCommandResult> _future;
+    bool _accepted = false;
+};
+
+/// <summary>逐条调度指令并关联应答的引擎，线程安全。</summary>
+class AtCommandEngine
+{
+public:
+    /// <summary>写出一段字节，回调报告写入结果；返回 false 表示未能入队。</summary>
+    using Writer = std::function<bool(std::string data, std::function<void(bool success)> onWritten)>;
+    /// <summary>完成回调，在分发线程、超时线程或调用 CancelAll 的线程上执行。</summary>
+    using CompletionCallback = std::function<void(const AtCommandResult& result)>;
+
+    /// <summary>应答行的归属。</summary>
+    enum class LineRole
+    {
+        /// <summary>在途指令的回显。</summary>
+        Echo,
+        /// <summary>在途指令的中间应答。</summary>
+        Response,
+        /// <summary>最终结果码，对应指令已完成。</summary>
+        Final,
+        /// <summary>不属于任何指令，例如主动上报。</summary>
+        Unsolicited
+    };
+
+    explicit AtCommandEngine(Writer writer);
+    ~AtCommandEngine();
+
+    AtCommandEngine(const AtCommandEngine&) = delete;
+    AtCommandEngine& operator=(const AtCommandEngine&) = delete;
+
+    /// <summary>提交一条指令并立即返回；前面的指令都完成后才会写出，紧急指令只排在其他紧急指令之后。</summary>
+    AtCommandHandle Submit(AtCommandRequest request, CompletionCallback onComplete = {});
+
+    /// <summary>提交一条没有正文的指令（不含结尾 CR）。</summary>
+    AtCommandHandle Submit(std::string command, std::chrono::milliseconds timeout = {}, CompletionCallback onComplete = {});
+
+    /// <summary>交给引擎一行已去除首尾空白的应答；background 非空时写入该行是否属于后台指令。</summary>
+    LineRole OnLine(std::string_view line, bool* background = nullptr);
+
+    /// <summary>收到 "> " 提示符：在途指令带有正文且尚未写出时写出正文并返回 true。</summary>
+    bool OnPrompt();
+
+    /// <summary>在途指令带有正文且尚未写出，即此时行首的 "> " 是输入提示符。</summary>
+    bool AwaitingPrompt() const;
+
+    /// <summary>在途指令的文本（不含结尾 CR），没有在途指令时为空。</summary>
+    std::string ActiveCommand() const;
+
+    /// <summary>以 Cancelled 完成在途与排队中的全部指令，例如断开或链路丢失之后。</summary>
+    void CancelAll();
+
+    /// <summary>指令的默认超时：短信发送与运营商搜索等慢指令更长。</summary>
+    static std::chrono::milliseconds DefaultTimeout(std::string_view command) noexcept;
+
+private:
+    /// <summary>一条排队或在途的指令。</summary>
+    struct PendingCommand
+    {
+        std::string responsePrefix;
+        std::string payload;
+        bool payloadSent = false;
+        bool collectLines = true;
+        bool urgent = false;
+        bool background = false;
+        std::chrono::milliseconds timeout{0};
+        std::chrono::steady_clock::time_point sentAt;
+        std::chrono::steady_clock::time_point deadline;
+        bool echoed = false;
+        AtCommandResult result;
+        std::promise<AtCommandResult> promise;
+        CompletionCallback onComplete;
+    };
+    using PendingPointer = std::shared_ptr<PendingCommand>;
+
+    /// <summary>在途位置空闲时写出队首指令。</summary>
+    void StartNext();
+    /// <summary>写出指令或正文，写入失败时以 NotSent 结束该指令。</summary>
+    bool Write(const PendingPointer& pending, std::string data);
+    /// <summary>把指令从在途位置或队列中移除，已经完成时返回 false。</summary>
+    bool Release(const PendingPointer& pending);
+    /// <summary>若指令尚未完成则以给定结果码结束，并调度下一条。</summary>
+    void Abandon(const PendingPointer& pending, AtResultCode code);
+    static void Complete(PendingCommand& pending);
+    void TimeoutLoop();
+
+private:
+    Writer _writer;
+    mutable std::mutex _mutex;
+    std::condition_variable _timeoutSignal;
+    PendingPointer _active;
+    std::deque<PendingPointer> _queue;
+    bool _stopping;
+    std::thread _timeoutWorker;
+};
@@ -0,0 +1,551 @@
+/*------------------------------------------------------------------------
+名称：AT 应答解析实现
+说明：按 3GPP TS 27.005 / 27.007 的参数顺序解析各类应答
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：字段缺失或不是数字时返回空，不抛出异常
+------------------------------------------------------------------------*/
+#include "AtResponseParser.h"
+
+#include <charconv>
+
+namespace
+{
+    /// <summary>短信状态的数字与文本形式（TS 27.005 3.1 节）。</summary>
+    struct MessageStatus
+    {
+        int code;
+        std::string_view text;
+    };
+
+    constexpr std::array<MessageStatus, 5> kMessageStatuses{{
+        {0, "REC UNREAD"},
+        {1, "REC READ"},
+        {2, "STO UNSENT"},
+        {3, "STO SENT"},
+        {4, "ALL"}
+    }};
+
+    struct RegistrationPrefix
+    {
+        std::string_view prefix;
+        RegistrationDomain domain;
+    };
+
+    constexpr std::array<RegistrationPrefix, 3> kRegistrationPrefixes{{
+        {"+CREG:", RegistrationDomain::Circuit},
+        {"+CGREG:", RegistrationDomain::Packet},
+        {"+CEREG:", RegistrationDomain::Eps}
+    }};
+
+    struct ErrorPrefix
+    {
+        std::string_view prefix;
+        AtErrorSource source;
+    };
+
+    constexpr std::array<ErrorPrefix, 2> kErrorPrefixes{{
+        {"+CME ERROR:", AtErrorSource::Equipment},
+        {"+CMS ERROR:", AtErrorSource::MessageService}
+    }};
+
+    /// <summary>整段都是数字时才成功，空字段返回 false。</summary>
+    template <typename Integer>
+    bool ParseInteger(std::string_view text, Integer& value, int base = 10) noexcept
+    {
+        if (text.empty())
+        {
+            return false;
+        }
+        Integer parsed{};
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), parsed, base);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+        {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    /// <summary>读取一个可选的数字字段：字段不存在或为空时保留原值，存在但不是数字时失败。</summary>
+    template <typename Integer>
+    bool ReadOptional(AtFieldReader& reader, Integer& value, int base = 10) noexcept
+    {
+        std::string_view field;
+        if (!reader.Next(field) || field.empty())
+        {
+            return true;
+        }
+        return ParseInteger(field, value, base);
+    }
+
+    bool ReadRequired(AtFieldReader& reader, int& value) noexcept
+    {
+        std::string_view field;
+        return reader.Next(field) && ParseInteger(field, value);
+    }
+
+    int StatusCode(std::string_view text) noexcept
+    {
+        for (const auto& status : kMessageStatuses)
+        {
+            if (status.text == text)
+            {
+                return status.code;
+            }
+        }
+        return -1;
+    }
+
+    std::string_view StatusText(int code) noexcept
+    {
+        for (const auto& status : kMessageStatuses)
+        {
+            if (status.code == code)
+            {
+                return status.text;
+            }
+        }
+        return {};
+    }
+
+    /// <summary>从状态字段开始解析短信头部；状态带引号为文本模式，否则为 PDU 模式。</summary>
+    bool ParseSmsHeader(AtFieldReader& reader, SmsHeaderResponse& header) noexcept
+    {
+        std::string_view field;
+        bool quoted = false;
+        if (!reader.Next(field, quoted))
+        {
+            return false;
+        }
+        if (quoted)
+        {
+            header.status = field;
+            header.statusCode = StatusCode(field);
+            // 文本模式：<stat>,<oa/da>,[<alpha>],[<scts>]，之后的类型与长度字段不需要。
+            reader.Next(header.address);
+            reader.Next(header.alpha);
+            reader.Next(header.timestamp);
+            return true;
+        }
+        // PDU 模式：<stat>,[<alpha>],<length>。
+        if (!ParseInteger(field, header.statusCode))
+        {
+            return false;
+        }
+        header.status = StatusText(header.statusCode);
+        reader.Next(header.alpha);
+        return ReadRequired(reader, header.length);
+    }
+
+    /// <summary>读取一段十进制数字（至多 4 位）并前移。</summary>
+    bool ReadDigits(std::string_view& text, int& value) noexcept
+    {
+        std::size_t length = 0;
+        while (length < text.size() && text[length] >= '0' && text[length] <= '9')
+        {
+            ++length;
+        }
+        if (length == 0 || length > 4 || !ParseInteger(text.substr(0, length), value))
+        {
+            return false;
+        }
+        text.remove_prefix(length);
+        return true;
+    }
+
+    bool Expect(std::string_view& text, char separator) noexcept
+    {
+        if (text.empty() || text.front() != separator)
+        {
+            return false;
+        }
+        text.remove_prefix(1);
+        return true;
+    }
+}
+
+int CsqResponse::RssiDbm() const noexcept
+{
+    if (rssi >= 0 && rssi <= 31)
+    {
+        return -113 + 2 * rssi;
+    }
+    // 100 到 191 为 TD-SCDMA 的扩展取值，1 dB 一档。
+    if (rssi >= 100 && rssi <= 191)
+    {
+        return -116 + (rssi - 100);
+    }
+    return 0;
+}
+
+int CesqResponse::RsrpDbm() const noexcept
+{
+    return rsrp >= 0 && rsrp <= 97 ? -141 + rsrp : 0;
+}
+
+std::optional<std::string_view> ResponsePayload(std::string_view line, std::string_view prefix) noexcept
+{
+    if (line.substr(0, prefix.size()) != prefix)
+    {
+        return std::nullopt;
+    }
+    line.remove_prefix(prefix.size());
+    while (!line.empty() && line.front() == ' ')
+    {
+        line.remove_prefix(1);
+    }
+    return line;
+}
+
+std::optional<CsqResponse> ParseCsq(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CSQ:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    CsqResponse response;
+    if (!ReadRequired(reader, response.rssi) || !ReadRequired(reader, response.ber))
+    {
+        return std::nullopt;
+    }
+    return response;
+}
+
+std::optional<CesqResponse> ParseCesq(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CESQ:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    CesqResponse response;
+    for (int* field : {&response.rxlev, &response.ber, &response.rscp, &response.ecno, &response.rsrq, &response.rsrp})
+    {
+        if (!ReadRequired(reader, *field))
+        {
+            return std::nullopt;
+        }
+    }
+    return response;
+}
+
+std::optional<RegistrationResponse> ParseRegistration(std::string_view line) noexcept
+{
+    for (const auto& entry : kRegistrationPrefixes)
+    {
+        const auto payload = ResponsePayload(line, entry.prefix);
+        if (!payload)
+        {
+            continue;
+        }
+        RegistrationResponse response;
+        response.domain = entry.domain;
+        // 查询应答为 <n>,<stat>[,...]，主动上报为 <stat>[,...]；第二个字段是不带引号的数字即为查询应答。
+        std::array<std::string_view, 5> fields{};
+        std::size_t count = 0;
+        std::string_view field;
+        bool quoted = false;
+        bool secondQuoted = false;
+        for (AtFieldReader reader(*payload); count < fields.size() && reader.Next(field, quoted); ++count)
+        {
+            fields[count] = field;
+            secondQuoted = count == 1 ? quoted : secondQuoted;
+        }
+        int value = 0;
+        const bool query = count >= 2 && !secondQuoted && ParseInteger(fields[1], value);
+        std::size_t next = 0;
+        if (query && !ParseInteger(fields[next++], response.mode))
+        {
+            return std::nullopt;
+        }
+        if (next >= count || !ParseInteger(fields[next++], response.status))
+        {
+            return std::nullopt;
+        }
+        if (next < count && !fields[next].empty() && !ParseInteger(fields[next], response.area, 16))
+        {
+            return std::nullopt;
+        }
+        ++next;
+        if (next < count && !fields[next].empty() && !ParseInteger(fields[next], response.cell, 16))
+        {
+            return std::nullopt;
+        }
+        ++next;
+        if (next < count && !fields[next].empty() && !ParseInteger(fields[next], response.accessTechnology))
+        {
+            return std::nullopt;
+        }
+        return response;
+    }
+    return std::nullopt;
+}
+
+std::optional<CopsResponse> ParseCops(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+COPS:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    CopsResponse response;
+    if (!ReadRequired(reader, response.mode) || !ReadOptional(reader, response.format))
+    {
+        return std::nullopt;
+    }
+    reader.Next(response.operatorName);
+    if (!ReadOptional(reader, response.accessTechnology))
+    {
+        return std::nullopt;
+    }
+    return response;
+}
+
+std::optional<CpmsResponse> ParseCpms(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CPMS:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    CpmsResponse response;
+    std::string_view field;
+    bool quoted = false;
+    while (response.count < response.memories.size() && reader.Next(field, quoted))
+    {
+        auto& memory = response.memories[response.count];
+        // 查询形式为 "<mem>",<used>,<total> 三元组，设置形式只有 <used>,<total>。
+        if (quoted)
+        {
+            memory.name = field;
+            if (!ReadRequired(reader, memory.used))
+            {
+                return std::nullopt;
+            }
+        }
+        else if (!ParseInteger(field, memory.used))
+        {
+            return std::nullopt;
+        }
+        if (!ReadRequired(reader, memory.total))
+        {
+            return std::nullopt;
+        }
+        ++response.count;
+    }
+    if (response.count == 0)
+    {
+        return std::nullopt;
+    }
+    return response;
+}
+
+std::optional<SmsHeaderResponse> ParseCmgl(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CMGL:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    SmsHeaderResponse header;
+    if (!ReadRequired(reader, header.index) || !ParseSmsHeader(reader, header))
+    {
+        return std::nullopt;
+    }
+    return header;
+}
+
+std::optional<SmsHeaderResponse> ParseCmgr(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CMGR:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    SmsHeaderResponse header;
+    if (!ParseSmsHeader(reader, header))
+    {
+        return std::nullopt;
+    }
+    return header;
+}
+
+std::optional<SmsHeaderResponse> ParseCmt(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CMT:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    // PDU 模式只有两个字段且最后一个是不带引号的长度；文本模式至少有号码、名称与时间戳三个字段。
+    std::array<std::string_view, 3> fields{};
+    std::size_t count = 0;
+    std::string_view field;
+    bool quoted = false;
+    bool lastQuoted = false;
+    for (AtFieldReader reader(*payload); count < fields.size() && reader.Next(field, quoted); ++count)
+    {
+        fields[count] = field;
+        lastQuoted = quoted;
+    }
+    SmsHeaderResponse header;
+    if (count == 2 && !lastQuoted && ParseInteger(fields[1], header.length))
+    {
+        header.alpha = fields[0];
+        return header;
+    }
+    if (count < 3)
+    {
+        return std::nullopt;
+    }
+    header.address = fields[0];
+    header.alpha = fields[1];
+    header.timestamp = fields[2];
+    return header;
+}
+
+std::optional<CmtiResponse> ParseCmti(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CMTI:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    AtFieldReader reader(*payload);
+    CmtiResponse response;
+    if (!reader.Next(response.storage) || !ReadRequired(reader, response.index))
+    {
+        return std::nullopt;
+    }
+    return response;
+}
+
+std::optional<AtErrorResponse> ParseAtError(std::string_view line) noexcept
+{
+    for (const auto& entry : kErrorPrefixes)
+    {
+        if (const auto payload = ResponsePayload(line, entry.prefix))
+        {
+            AtErrorResponse response;
+            response.source = entry.source;
+            response.text = *payload;
+            if (!ParseInteger(response.text, response.code))
+            {
+                response.code = -1;
+            }
+            return response;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<ModemTime> ParseCclk(std::string_view line) noexcept
+{
+    const auto payload = ResponsePayload(line, "+CCLK:");
+    if (!payload)
+    {
+        return std::nullopt;
+    }
+    return ParseModemTime(*payload);
+}
+
+std::optional<ModemTime> ParseModemTime(std::string_view text) noexcept
+{
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+    {
+        text = text.substr(1, text.size() - 2);
+    }
+    ModemTime time;
+    if (!ReadDigits(text, time.year) || !Expect(text, '/') || !ReadDigits(text, time.month) || !Expect(text, '/')
+        || !ReadDigits(text, time.day) || !Expect(text, ',') || !ReadDigits(text, time.hour) || !Expect(text, ':')
+        || !ReadDigits(text, time.minute) || !Expect(text, ':') || !ReadDigits(text, time.second))
+    {
+        return std::nullopt;
+    }
+    if (!text.empty())
+    {
+        const char sign = text.front();
+        text.remove_prefix(1);
+        if ((sign != '+' && sign != '-') || !ReadDigits(text, time.quarterHours) || !text.empty())
+        {
+            return std::nullopt;
+        }
+        time.quarterHours = sign == '-' ? -time.quarterHours : time.quarterHours;
+    }
+    if (time.year < 100)
+    {
+        time.year += 2000;
+    }
+    if (time.month < 1 || time.month > 12 || time.day < 1 || time.day > 31 || time.hour > 23 || time.minute > 59 || time.second > 60)
+    {
+        return std::nullopt;
+    }
+    return time;
+}
+
+std::string FormatModemTime(const ModemTime& time)
+{
+    const int zone = time.quarterHours < 0 ? -time.quarterHours : time.quarterHours;
+    const int values[] = {time.year % 100, time.month, time.day, time.hour, time.minute, time.second, zone};
+    constexpr char separators[] = {'/', '/', ',', ':', ':', '+', '\0'};
+    std::string text;
+    text.reserve(20);
+    for (std::size_t i = 0; i < std::size(values); ++i)
+    {
+        text.push_back(static_cast<char>('0' + values[i] / 10 % 10));
+        text.push_back(static_cast<char>('0' + values[i] % 10));
+        if (separators[i] != '\0')
+        {
+            text.push_back(i == 5 && time.quarterHours < 0 ? '-' : separators[i]);
+        }
+    }
+    return text;
+}
+
+std::int64_t ModemTimeToUnix(const ModemTime& time) noexcept
+{
+    // 公历日期到 1970-01-01 的天数，按 3 月起算的年份计算闰日。
+    const std::int64_t year = time.month <= 2 ? time.year - 1 : time.year;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const std::int64_t yearOfEra = year - era * 400;
+    const std::int64_t dayOfYear = (153 * (time.month > 2 ? time.month - 3 : time.month + 9) + 2) / 5 + time.day - 1;
+    const std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    const std::int64_t days = era * 146097 + dayOfEra - 719468;
+    return days * 86400 + time.hour * 3600 + time.minute * 60 + time.second - std::int64_t{time.quarterHours} * 900;
+}
+
+ModemTime ModemTimeFromUnix(std::int64_t seconds, int quarterHours) noexcept
+{
+    const std::int64_t local = seconds + std::int64_t{quarterHours} * 900;
+    std::int64_t days = local / 86400;
+    std::int64_t rest = local % 86400;
+    if (rest < 0)
+    {
+        rest += 86400;
+        --days;
+    }
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const std::int64_t dayOfEra = days - era * 146097;
+    const std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const std::int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    ModemTime time;
+    time.day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    time.month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    time.year = static_cast<int>(yearOfEra + era * 400 + (time.month <= 2 ? 1 : 0));
+    time.hour = static_cast<int>(rest / 3600);
+    time.minute = static_cast<int>(rest % 3600 / 60);
+    time.second = static_cast<int>(rest % 60);
+    time.quarterHours = quarterHours;
+    return time;
+}
@@ -0,0 +1,265 @@
+/*------------------------------------------------------------------------
+名称：AT 应答解析
+说明：把常见的信息应答与主动上报解析为结构体，供会话与各功能模块直接使用
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：只在传入的字节视图上解析，不分配内存；结构体中的视图指向原始行，仅在行有效期间可用
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/// <summary>按逗号拆分参数，引号内的逗号不作分隔，字段去掉两侧空格与引号。</summary>
+class AtFieldReader
+{
+public:
+    constexpr explicit AtFieldReader(std::string_view text) noexcept
+        : _text(text), _position(0), _done(false)
+    {
+    }
+
+    /// <summary>读取下一个字段，没有更多字段时返回 false。quoted 报告字段是否带引号。</summary>
+    constexpr bool Next(std::string_view& field, bool& quoted) noexcept
+    {
+        if (_done)
+        {
+            return false;
+        }
+        SkipSpaces();
+        quoted = _position < _text.size() && _text[_position] == '"';
+        std::size_t end = 0;
+        if (quoted)
+        {
+            const auto close = _text.find('"', _position + 1);
+            end = close == std::string_view::npos ? _text.size() : close;
+            field = _text.substr(_position + 1, end - _position - 1);
+            _position = end == _text.size() ? end : end + 1;
+            SkipSpaces();
+            end = _position;
+        }
+        else
+        {
+            end = _text.find(',', _position);
+            end = end == std::string_view::npos ? _text.size() : end;
+            field = _text.substr(_position, end - _position);
+            while (!field.empty() && field.back() == ' ')
+            {
+                field.remove_suffix(1);
+            }
+        }
+        // 引号字段之后只应是逗号或行尾，其余内容丢弃。
+        const auto comma = _text.find(',', end);
+        if (comma == std::string_view::npos)
+        {
+            _done = true;
+        }
+        else
+        {
+            _position = comma + 1;
+        }
+        return true;
+    }
+
+    /// <summary>读取下一个字段，忽略引号信息。</summary>
+    constexpr bool Next(std::string_view& field) noexcept
+    {
+        bool quoted = false;
+        return Next(field, quoted);
+    }
+
+private:
+    constexpr void SkipSpaces() noexcept
+    {
+        while (_position < _text.size() && _text[_position] == ' ')
+        {
+            ++_position;
+        }
+    }
+
+    std::string_view _text;
+    std::size_t _position;
+    bool _done;
+};
+
+/// <summary>+CSQ：接收信号强度与误码率，99 表示未知。</summary>
+struct CsqResponse
+{
+    int rssi = 99;
+    int ber = 99;
+
+    bool HasSignal() const noexcept
+    {
+        return rssi != 99 && rssi != 199;
+    }
+
+    /// <summary>换算为 dBm，未知时返回 0。</summary>
+    int RssiDbm() const noexcept;
+};
+
+/// <summary>+CESQ：扩展信号质量，各字段取值 99 或 255 表示未知或不适用。</summary>
+struct CesqResponse
+{
+    int rxlev = 99;
+    int ber = 99;
+    int rscp = 255;
+    int ecno = 255;
+    int rsrq = 255;
+    int rsrp = 255;
+
+    /// <summary>LTE 参考信号接收功率（dBm），未知时返回 0。</summary>
+    int RsrpDbm() const noexcept;
+};
+
+/// <summary>注册状态所属的域。</summary>
+enum class RegistrationDomain
+{
+    /// <summary>+CREG：电路域。</summary>
+    Circuit,
+    /// <summary>+CGREG：GPRS 分组域。</summary>
+    Packet,
+    /// <summary>+CEREG：EPS（LTE）。</summary>
+    Eps
+};
+
+/// <summary>+CREG / +CGREG / +CEREG 的查询应答或主动上报。</summary>
+struct RegistrationResponse
+{
+    RegistrationDomain domain = RegistrationDomain::Circuit;
+    /// <summary>上报模式 &lt;n&gt;，主动上报中没有该字段时为 -1。</summary>
+    int mode = -1;
+    /// <summary>注册状态 &lt;stat&gt;：0 未注册、1 本地、2 搜索中、3 被拒、4 未知、5 漫游等。</summary>
+    int status = 4;
+    /// <summary>位置区码或跟踪区码（十六进制字段），未给出时为 -1。</summary>
+    std::int64_t area = -1;
+    /// <summary>小区标识（十六进制字段），未给出时为 -1。</summary>
+    std::int64_t cell = -1;
+    /// <summary>接入技术 &lt;AcT&gt;，未给出时为 -1。</summary>
+    int accessTechnology = -1;
+
+    bool IsRegistered() const noexcept
+    {
+        return status == 1 || status == 5 || status == 6 || status == 7 || status == 9 || status == 10;
+    }
+};
+
+/// <summary>+COPS? 的应答：当前运营商。</summary>
+struct CopsResponse
+{
+    int mode = -1;
+    /// <summary>运营商名称格式：0 长名、1 短名、2 数字编码，未注册时为 -1。</summary>
+    int format = -1;
+    std::string_view operatorName;
+    int accessTechnology = -1;
+};
+
+/// <summary>+CPMS 的应答：查询形式带存储器名称，设置形式只有用量。</summary>
+struct CpmsResponse
+{
+    struct Memory
+    {
+        /// <summary>存储器名称，例如 SM、ME，设置形式的应答中为空。</summary>
+        std::string_view name;
+        int used = -1;
+        int total = -1;
+    };
+
+    std::array<Memory, 3> memories{};
+    std::size_t count = 0;
+};
+
+/// <summary>+CMGL 与 +CMGR 的短信头部，文本模式与 PDU 模式共用。</summary>
+struct SmsHeaderResponse
+{
+    /// <summary>存储索引，+CMGR 中没有该字段时为 -1。</summary>
+    int index = -1;
+    /// <summary>文本形式的状态，例如 REC UNREAD；PDU 模式下由数字状态换算。</summary>
+    std::string_view status;
+    /// <summary>数字形式的状态 0 到 4；文本模式下由文本状态换算，无法识别时为 -1。</summary>
+    int statusCode = -1;
+    /// <summary>发送方或接收方号码，PDU 模式下为空。</summary>
+    std::string_view address;
+    std::string_view alpha;
+    /// <summary>服务中心时间戳，格式 yy/MM/dd,hh:mm:ss±zz，PDU 模式下为空。</summary>
+    std::string_view timestamp;
+    /// <summary>PDU 模式下的 TPDU 长度（字节），文本模式为 -1。</summary>
+    int length = -1;
+
+    bool IsPdu() const noexcept
+    {
+        return length >= 0;
+    }
+};
+
+/// <summary>+CMTI：新短信已存储。</summary>
+struct CmtiResponse
+{
+    std::string_view storage;
+    int index = -1;
+};
+
+/// <summary>错误的来源。</summary>
+enum class AtErrorSource
+{
+    /// <summary>+CME ERROR：移动设备错误。</summary>
+    Equipment,
+    /// <summary>+CMS ERROR：短信服务错误。</summary>
+    MessageService
+};
+
+/// <summary>+CME ERROR / +CMS ERROR。</summary>
+struct AtErrorResponse
+{
+    AtErrorSource source = AtErrorSource::Equipment;
+    /// <summary>数字错误码，verbose 模式（AT+CMEE=2）的文本错误为 -1。</summary>
+    int code = -1;
+    /// <summary>冒号之后的原文。</summary>
+    std::string_view text;
+};
+
+/// <summary>模块时间（+CCLK 与短信时间戳），时区以 15 分钟为单位。</summary>
+struct ModemTime
+{
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int quarterHours = 0;
+};
+
+/// <summary>若 line 以 prefix（例如 "+CSQ:"）开头，返回其后去掉前导空格的参数部分。</summary>
+std::optional<std::string_view> ResponsePayload(std::string_view line, std::string_view prefix) noexcept;
+
+std::optional<CsqResponse> ParseCsq(std::string_view line) noexcept;
+std::optional<CesqResponse> ParseCesq(std::string_view line) noexcept;
+/// <summary>按前缀识别 +CREG、+CGREG、+CEREG，查询应答与主动上报均可。</summary>
+std::optional<RegistrationResponse> ParseRegistration(std::string_view line) noexcept;
+std::optional<CopsResponse> ParseCops(std::string_view line) noexcept;
+std::optional<CpmsResponse> ParseCpms(std::string_view line) noexcept;
+/// <summary>解析 +CMGL 的一条头部行，正文（文本或 PDU 十六进制）在下一行。</summary>
+std::optional<SmsHeaderResponse> ParseCmgl(std::string_view line) noexcept;
+/// <summary>解析 +CMGR 的头部行，正文在下一行。</summary>
+std::optional<SmsHeaderResponse> ParseCmgr(std::string_view line) noexcept;
+/// <summary>解析 +CMT 上报的头部行：文本模式为 "oa",[alpha],"scts"[,...]，PDU 模式为 [alpha],length。</summary>
+std::optional<SmsHeaderResponse> ParseCmt(std::string_view line) noexcept;
+std::optional<CmtiResponse> ParseCmti(std::string_view line) noexcept;
+std::optional<AtErrorResponse> ParseAtError(std::string_view line) noexcept;
+std::optional<ModemTime> ParseCclk(std::string_view line) noexcept;
+/// <summary>解析 yy/MM/dd,hh:mm:ss±zz 形式的时间，可带或不带引号。</summary>
+std::optional<ModemTime> ParseModemTime(std::string_view text) noexcept;
+
+/// <summary>格式化为 yy/MM/dd,hh:mm:ss±zz，与文本模式的时间戳一致。</summary>
+std::string FormatModemTime(const ModemTime& time);
+
+/// <summary>换算为 Unix 时间（UTC 秒），按时区扣除偏移。</summary>
+std::int64_t ModemTimeToUnix(const ModemTime& time) noexcept;
+
+/// <summary>由 Unix 时间与时区（15 分钟为单位）还原为模块时间。</summary>
+ModemTime ModemTimeFromUnix(std::int64_t seconds, int quarterHours) noexcept;
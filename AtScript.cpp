@@ -0,0 +1,721 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本编译
+说明：解析 <script> 元素中的自闭合子元素，生成指令、模板与常量池
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：只支持脚本用到的 XML 子集：自闭合元素、双引号或单引号属性、注释与五个预定义实体
+------------------------------------------------------------------------*/
+#include "AtScript.h"
+#include "TextEncoding.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cwchar>
+#include <cwctype>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    constexpr std::uint32_t kNoLiteral = 0xFFFFFFFF;
+    // 单条指令的超时与等待上限，防止配置笔误让脚本长时间挂起。
+    constexpr unsigned long kMaxWaitMilliseconds = 3600000;
+
+    /// <summary>一个子元素及其属性，属性值已解码实体。</summary>
+    struct Element
+    {
+        std::wstring name;
+        std::vector<std::pair<std::wstring, std::wstring>> attributes;
+
+        const std::wstring* Find(std::wstring_view attribute) const
+        {
+            for (const auto& [key, value] : attributes)
+            {
+                if (key == attribute)
+                {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    struct CompareName
+    {
+        std::wstring_view attribute;
+        AtScriptCompare compare;
+    };
+
+    constexpr std::array<CompareName, 6> kCompareNames{{
+        {L"eq", AtScriptCompare::Equal},
+        {L"ne", AtScriptCompare::NotEqual},
+        {L"lt", AtScriptCompare::Less},
+        {L"le", AtScriptCompare::LessEqual},
+        {L"gt", AtScriptCompare::Greater},
+        {L"ge", AtScriptCompare::GreaterEqual}
+    }};
+
+    /// <summary>编译错误，what() 为 UTF-8 的中文说明。</summary>
+    class CompileError : public std::runtime_error
+    {
+    public:
+        explicit CompileError(const std::wstring& message)
+            : std::runtime_error(WideToUtf8(message))
+        {
+        }
+    };
+
+    std::wstring DecodeEntities(std::wstring_view value)
+    {
+        struct Entity
+        {
+            std::wstring_view text;
+            wchar_t character;
+        };
+        constexpr std::array<Entity, 5> kEntities{{
+            {L"&amp;", L'&'},
+            {L"&lt;", L'<'},
+            {L"&gt;", L'>'},
+            {L"&quot;", L'\"'},
+            {L"&apos;", L'\''}
+        }};
+        std::wstring result;
+        result.reserve(value.size());
+        for (std::size_t i = 0; i < value.size(); ++i)
+        {
+            bool decoded = false;
+            if (value[i] == L'&')
+            {
+                for (const auto& entity : kEntities)
+                {
+                    if (value.substr(i, entity.text.size()) == entity.text)
+                    {
+                        result.push_back(entity.character);
+                        i += entity.text.size() - 1;
+                        decoded = true;
+                        break;
+                    }
+                }
+            }
+            if (!decoded)
+            {
+                result.push_back(value[i]);
+            }
+        }
+        return result;
+    }
+
+    bool IsNameCharacter(wchar_t ch) noexcept
+    {
+        return std::iswalnum(static_cast<wint_t>(ch)) != 0 || ch == L'_' || ch == L'-';
+    }
+
+    /// <summary>按顺序读取元素标签，跳过空白与注释。</summary>
+    class TagReader
+    {
+    public:
+        explicit TagReader(std::wstring_view text) noexcept
+            : _text(text), _position(0)
+        {
+        }
+
+        bool AtEnd()
+        {
+            SkipBlankAndComments();
+            return _position >= _text.size();
+        }
+
+        /// <summary>读取一个开始标签；selfClosing 报告是否以 "/>" 结尾。</summary>
+        Element ReadTag(bool& selfClosing)
+        {
+            SkipBlankAndComments();
+            if (_position >= _text.size() || _text[_position] != L'<')
+            {
+                throw CompileError(L"此处应为元素");
+            }
+            ++_position;
+            Element element;
+            element.name = ReadName();
+            if (element.name.empty())
+            {
+                throw CompileError(L"缺少元素名");
+            }
+            while (true)
+            {
+                SkipBlank();
+                if (_position >= _text.size())
+                {
+                    throw CompileError(L"<" + element.name + L"> 没有结束");
+                }
+                if (_text.substr(_position, 2) == L"/>")
+                {
+                    _position += 2;
+                    selfClosing = true;
+                    return element;
+                }
+                if (_text[_position] == L'>')
+                {
+                    ++_position;
+                    selfClosing = false;
+                    return element;
+                }
+                auto name = ReadName();
+                SkipBlank();
+                if (name.empty() || _position >= _text.size() || _text[_position] != L'=')
+                {
+                    throw CompileError(L"<" + element.name + L"> 的属性格式错误");
+                }
+                ++_position;
+                SkipBlank();
+                const wchar_t quote = _position < _text.size() ? _text[_position] : L'\0';
+                if (quote != L'\"' && quote != L'\'')
+                {
+                    throw CompileError(L"属性 " + name + L" 的值须加引号");
+                }
+                const auto close = _text.find(quote, _position + 1);
+                if (close == std::wstring_view::npos)
+                {
+                    throw CompileError(L"属性 " + name + L" 的引号未闭合");
+                }
+                if (element.Find(name) != nullptr)
+                {
+                    throw CompileError(L"属性 " + name + L" 重复");
+                }
+                element.attributes.emplace_back(std::move(name), DecodeEntities(_text.substr(_position + 1, close - _position - 1)));
+                _position = close + 1;
+            }
+        }
+
+    private:
+        void SkipBlank() noexcept
+        {
+            while (_position < _text.size() && std::iswspace(static_cast<wint_t>(_text[_position])) != 0)
+            {
+                ++_position;
+            }
+        }
+
+        void SkipBlankAndComments()
+        {
+            while (true)
+            {
+                SkipBlank();
+                if (_text.substr(_position, 4) != L"<!--")
+                {
+                    return;
+                }
+                const auto close = _text.find(L"-->", _position + 4);
+                if (close == std::wstring_view::npos)
+                {
+                    throw CompileError(L"注释未闭合");
+                }
+                _position = close + 3;
+            }
+        }
+
+        std::wstring ReadName()
+        {
+            const auto start = _position;
+            while (_position < _text.size() && IsNameCharacter(_text[_position]))
+            {
+                ++_position;
+            }
+            return std::wstring(_text.substr(start, _position - start));
+        }
+
+    private:
+        std::wstring_view _text;
+        std::size_t _position;
+    };
+
+    std::optional<long long> ParseInteger(const std::wstring& text)
+    {
+        if (text.empty())
+        {
+            return std::nullopt;
+        }
+        wchar_t* end = nullptr;
+        errno = 0;
+        const long long value = std::wcstoll(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != L'\0' || errno == ERANGE)
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    /// <summary>由指令文本推出应答前缀，例如 AT+CPIN? → "+CPIN:"；基本指令返回空。</summary>
+    std::wstring DefaultPrefix(const std::wstring& command)
+    {
+        if (command.size() < 4 || std::towupper(static_cast<wint_t>(command[0])) != L'A'
+            || std::towupper(static_cast<wint_t>(command[1])) != L'T' || command[2] != L'+')
+        {
+            return {};
+        }
+        std::wstring prefix;
+        for (std::size_t i = 2; i < command.size() && command[i] != L'=' && command[i] != L'?' && command[i] != L'$'; ++i)
+        {
+            prefix.push_back(static_cast<wchar_t>(std::towupper(static_cast<wint_t>(command[i]))));
+        }
+        prefix.push_back(L':');
+        return prefix;
+    }
+}
+
+/// <summary>单次编译的状态：名称表、未解析的标签引用与正在生成的脚本。</summary>
+class AtScriptCompiler
+{
+public:
+    explicit AtScriptCompiler(AtScript& script)
+        : _script(script)
+    {
+        _variables.emplace(L"result", AtScript::kResultSlot);
+        _assigned.insert(L"result");
+    }
+
+    void CompileElement(const Element& element)
+    {
+        const auto& name = element.name;
+        if (name == L"send")
+        {
+            CompileSend(element);
+        }
+        else if (name == L"sms")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Sms};
+            instruction.a = AddTemplate(Required(element, L"to"));
+            instruction.b = AddTemplate(Required(element, L"text"));
+            instruction.target = ResolveFailure(element, L"onError");
+            Emit(instruction);
+        }
+        else if (name == L"set")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Set};
+            instruction.slot = Assign(Required(element, L"var"));
+            instruction.a = AddTemplate(Optional(element, L"value"));
+            Emit(instruction);
+        }
+        else if (name == L"add")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Add};
+            const auto* value = element.Find(L"value");
+            const auto step = value == nullptr ? std::optional<long long>(1) : ParseInteger(*value);
+            if (!step || *step < std::numeric_limits<std::int32_t>::min() || *step > std::numeric_limits<std::int32_t>::max())
+            {
+                throw CompileError(L"value 须为整数");
+            }
+            // 先引用再赋值：add 读取变量原值。
+            Reference(Required(element, L"var"));
+            instruction.slot = Assign(Required(element, L"var"));
+            instruction.a = static_cast<std::uint32_t>(static_cast<std::int32_t>(*step));
+            Emit(instruction);
+        }
+        else if (name == L"if")
+        {
+            CompileIf(element);
+        }
+        else if (name == L"goto")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Jump};
+            instruction.target = LabelReference(Required(element, L"label"));
+            Emit(instruction);
+        }
+        else if (name == L"label")
+        {
+            const auto& label = Required(element, L"name");
+            if (!_labels.emplace(label, static_cast<std::uint32_t>(_script._code.size())).second)
+            {
+                throw CompileError(L"标签 " + label + L" 重复");
+            }
+        }
+        else if (name == L"loop")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Loop};
+            instruction.a = static_cast<std::uint32_t>(RequiredNumber(element, L"times", 1, 0xFFFFFFFF));
+            instruction.b = static_cast<std::uint32_t>(_script._counterCount++);
+            instruction.target = LabelReference(Required(element, L"goto"));
+            Emit(instruction);
+        }
+        else if (name == L"wait")
+        {
+            CompileWait(element);
+        }
+        else if (name == L"sleep")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Sleep};
+            instruction.b = static_cast<std::uint32_t>(RequiredNumber(element, L"ms", 0, kMaxWaitMilliseconds));
+            Emit(instruction);
+        }
+        else if (name == L"log")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Log};
+            instruction.a = AddTemplate(Required(element, L"text"));
+            Emit(instruction);
+        }
+        else if (name == L"fail")
+        {
+            AtScriptInstruction instruction{AtScriptOp::Fail};
+            instruction.a = AddTemplate(Optional(element, L"message"));
+            Emit(instruction);
+        }
+        else if (name == L"end")
+        {
+            Emit(AtScriptInstruction{AtScriptOp::End});
+        }
+        else
+        {
+            throw CompileError(L"不支持的元素 <" + name + L">");
+        }
+    }
+
+    /// <summary>解析标签引用并检查变量，末尾补一条 End。</summary>
+    void Finish()
+    {
+        Emit(AtScriptInstruction{AtScriptOp::End});
+        for (const auto& [index, label] : _pendingLabels)
+        {
+            const auto found = _labels.find(label);
+            if (found == _labels.end())
+            {
+                throw CompileError(L"标签 " + label + L" 不存在");
+            }
+            _script._code[index].target = found->second;
+        }
+        for (const auto& name : _referenced)
+        {
+            if (_assigned.count(name) == 0)
+            {
+                throw CompileError(L"变量 " + name + L" 从未赋值");
+            }
+        }
+        _script._variableCount = _variables.size();
+    }
+
+private:
+    void CompileSend(const Element& element)
+    {
+        const auto& text = Required(element, L"text");
+        AtScriptInstruction instruction{AtScriptOp::Send};
+        instruction.a = AddTemplate(text);
+        instruction.b = static_cast<std::uint32_t>(OptionalNumber(element, L"timeout", 0, kMaxWaitMilliseconds));
+        instruction.target = ResolveFailure(element, L"onError");
+        Emit(instruction);
+        const auto* capture = element.Find(L"capture");
+        if (capture == nullptr)
+        {
+            return;
+        }
+        AtScriptInstruction fetch{AtScriptOp::Capture};
+        fetch.slot = Assign(*capture);
+        const auto* prefix = element.Find(L"prefix");
+        fetch.a = static_cast<std::uint32_t>(_script._prefixes.size());
+        _script._prefixes.push_back(WideToUtf8(prefix != nullptr ? *prefix : DefaultPrefix(text)));
+        fetch.flag = element.Find(L"field") != nullptr
+            ? static_cast<std::uint8_t>(RequiredNumber(element, L"field", 0, AtScript::kWholeLine - 1))
+            : AtScript::kWholeLine;
+        Emit(fetch);
+    }
+
+    void CompileIf(const Element& element)
+    {
+        AtScriptInstruction instruction{AtScriptOp::JumpIf};
+        const auto& variable = Required(element, L"var");
+        Reference(variable);
+        instruction.slot = Slot(variable);
+        const std::wstring* operand = nullptr;
+        for (const auto& entry : kCompareNames)
+        {
+            if (const auto* value = element.Find(entry.attribute))
+            {
+                if (operand != nullptr)
+                {
+                    throw CompileError(L"只能有一个比较条件");
+                }
+                operand = value;
+                instruction.flag = static_cast<std::uint8_t>(entry.compare);
+            }
+        }
+        if (operand == nullptr)
+        {
+            throw CompileError(L"缺少比较条件 eq、ne、lt、le、gt 或 ge");
+        }
+        instruction.a = AddTemplate(*operand);
+        instruction.target = LabelReference(Required(element, L"goto"));
+        Emit(instruction);
+    }
+
+    void CompileWait(const Element& element)
+    {
+        const auto prefix = WideToUtf8(Required(element, L"urc"));
+        auto kind = UrcDispatcher::Match(prefix);
+        if (kind == UrcKind::None)
+        {
+            kind = UrcDispatcher::Match(prefix + ':');
+        }
+        if (kind == UrcKind::None)
+        {
+            throw CompileError(L"urc 不是已知的主动上报前缀");
+        }
+        AtScriptInstruction instruction{AtScriptOp::WaitUrc};
+        instruction.flag = static_cast<std::uint8_t>(kind);
+        instruction.b = static_cast<std::uint32_t>(RequiredNumber(element, L"timeout", 1, kMaxWaitMilliseconds));
+        instruction.target = ResolveFailure(element, L"onTimeout");
+        const auto* capture = element.Find(L"capture");
+        instruction.slot = capture != nullptr ? Assign(*capture) : AtScript::kNoSlot;
+        instruction.a = element.Find(L"field") != nullptr
+            ? static_cast<std::uint32_t>(RequiredNumber(element, L"field", 0, AtScript::kWholeLine - 1))
+            : AtScript::kWholeLine;
+        if (std::find(_script._urcKinds.begin(), _script._urcKinds.end(), kind) == _script._urcKinds.end())
+        {
+            _script._urcKinds.push_back(kind);
+        }
+        Emit(instruction);
+    }
+
+    static const std::wstring& Required(const Element& element, std::wstring_view attribute)
+    {
+        const auto* value = element.Find(attribute);
+        if (value == nullptr || value->empty())
+        {
+            throw CompileError(L"缺少属性 " + std::wstring(attribute));
+        }
+        return *value;
+    }
+
+    static std::wstring Optional(const Element& element, std::wstring_view attribute)
+    {
+        const auto* value = element.Find(attribute);
+        return value != nullptr ? *value : std::wstring();
+    }
+
+    static unsigned long long OptionalNumber(const Element& element, std::wstring_view attribute, unsigned long long minimum, unsigned long long maximum)
+    {
+        return element.Find(attribute) != nullptr ? RequiredNumber(element, attribute, minimum, maximum) : 0;
+    }
+
+    static unsigned long long RequiredNumber(const Element& element, std::wstring_view attribute, unsigned long long minimum, unsigned long long maximum)
+    {
+        const auto value = ParseInteger(Required(element, attribute));
+        if (!value || *value < 0 || static_cast<unsigned long long>(*value) < minimum || static_cast<unsigned long long>(*value) > maximum)
+        {
+            throw CompileError(L"属性 " + std::wstring(attribute) + L" 须为 " + std::to_wstring(minimum) + L" 到 "
+                + std::to_wstring(maximum) + L" 之间的整数");
+        }
+        return static_cast<unsigned long long>(*value);
+    }
+
+    /// <summary>onError / onTimeout：fail（默认）、continue 或标签名。</summary>
+    std::uint32_t ResolveFailure(const Element& element, std::wstring_view attribute)
+    {
+        const auto* value = element.Find(attribute);
+        if (value == nullptr || *value == L"fail")
+        {
+            return AtScript::kFail;
+        }
+        if (*value == L"continue")
+        {
+            return AtScript::kContinue;
+        }
+        return LabelReference(*value);
+    }
+
+    /// <summary>为下一条生成的指令记下待解析的标签，返回占位值；标签可以出现在引用之后。</summary>
+    std::uint32_t LabelReference(const std::wstring& label)
+    {
+        _pendingLabels.emplace_back(static_cast<std::uint32_t>(_script._code.size()), label);
+        return 0;
+    }
+
+    std::uint16_t Slot(const std::wstring& name)
+    {
+        const auto found = _variables.find(name);
+        if (found != _variables.end())
+        {
+            return found->second;
+        }
+        if (_variables.size() >= AtScript::kNoSlot)
+        {
+            throw CompileError(L"变量过多");
+        }
+        const auto slot = static_cast<std::uint16_t>(_variables.size());
+        _variables.emplace(name, slot);
+        return slot;
+    }
+
+    std::uint16_t Assign(const std::wstring& name)
+    {
+        _assigned.insert(name);
+        return Slot(name);
+    }
+
+    void Reference(const std::wstring& name)
+    {
+        _referenced.insert(name);
+    }
+
+    /// <summary>拆分 "${name}" 引用，常量段进入常量池，返回模板序号。</summary>
+    std::uint32_t AddTemplate(const std::wstring& text)
+    {
+        const auto first = static_cast<std::uint32_t>(_script._segments.size());
+        std::size_t position = 0;
+        while (position < text.size())
+        {
+            const auto open = text.find(L"${", position);
+            const auto literalEnd = open == std::wstring::npos ? text.size() : open;
+            if (literalEnd > position)
+            {
+                _script._segments.push_back({static_cast<std::uint32_t>(_script._literals.size()), AtScript::kNoSlot});
+                _script._literals.push_back(text.substr(position, literalEnd - position));
+            }
+            if (open == std::wstring::npos)
+            {
+                break;
+            }
+            const auto close = text.find(L'}', open + 2);
+            if (close == std::wstring::npos || close == open + 2)
+            {
+                throw CompileError(L"变量引用 ${...} 格式错误");
+            }
+            const auto name = text.substr(open + 2, close - open - 2);
+            Reference(name);
+            _script._segments.push_back({kNoLiteral, Slot(name)});
+            position = close + 1;
+        }
+        _script._templates.push_back({first, static_cast<std::uint32_t>(_script._segments.size() - first)});
+        return static_cast<std::uint32_t>(_script._templates.size() - 1);
+    }
+
+    void Emit(const AtScriptInstruction& instruction)
+    {
+        _script._code.push_back(instruction);
+    }
+
+private:
+    AtScript& _script;
+    std::map<std::wstring, std::uint16_t> _variables;
+    std::set<std::wstring> _assigned;
+    std::set<std::wstring> _referenced;
+    std::map<std::wstring, std::uint32_t> _labels;
+    /// <summary>(指令序号, 标签名)，在 Finish 中回填 target。</summary>
+    std::vector<std::pair<std::uint32_t, std::wstring>> _pendingLabels;
+};
+
+std::shared_ptr<const AtScript> AtScript::Compile(const std::wstring& element, std::wstring& error)
+{
+    auto script = std::make_shared<AtScript>();
+    script->_source = element;
+    std::size_t ordinal = 0;
+    try
+    {
+        const auto close = element.rfind(L"</script>");
+        if (close == std::wstring::npos)
+        {
+            throw CompileError(L"缺少 </script>");
+        }
+        TagReader reader(std::wstring_view(element).substr(0, close));
+        bool selfClosing = false;
+        const auto header = reader.ReadTag(selfClosing);
+        if (header.name != L"script" || selfClosing)
+        {
+            throw CompileError(L"应以 <script> 开始");
+        }
+        if (const auto* name = header.Find(L"name"); name != nullptr && !name->empty())
+        {
+            script->_name = *name;
+        }
+        else
+        {
+            throw CompileError(L"缺少属性 name");
+        }
+        if (const auto* summary = header.Find(L"summary"))
+        {
+            script->_summary = *summary;
+        }
+        AtScriptCompiler compiler(*script);
+        while (!reader.AtEnd())
+        {
+            ++ordinal;
+            const auto child = reader.ReadTag(selfClosing);
+            if (!selfClosing)
+            {
+                throw CompileError(L"<" + child.name + L"> 须写成自闭合元素");
+            }
+            compiler.CompileElement(child);
+        }
+        ordinal = 0;
+        compiler.Finish();
+    }
+    catch (const CompileError& failure)
+    {
+        error = L"脚本";
+        if (!script->_name.empty())
+        {
+            error += L"「" + script->_name + L"」";
+        }
+        if (ordinal != 0)
+        {
+            error += L"第 " + std::to_wstring(ordinal) + L" 个元素";
+        }
+        error += L": " + Utf8ToWide(failure.what());
+        return nullptr;
+    }
+    return script;
+}
+
+const std::wstring& AtScript::Name() const noexcept
+{
+    return _name;
+}
+
+const std::wstring& AtScript::Summary() const noexcept
+{
+    return _summary;
+}
+
+const std::wstring& AtScript::Source() const noexcept
+{
+    return _source;
+}
+
+std::span<const AtScriptInstruction> AtScript::Code() const noexcept
+{
+    return _code;
+}
+
+std::size_t AtScript::VariableCount() const noexcept
+{
+    return _variableCount;
+}
+
+std::size_t AtScript::CounterCount() const noexcept
+{
+    return _counterCount;
+}
+
+std::span<const UrcKind> AtScript::UrcKinds() const noexcept
+{
+    return _urcKinds;
+}
+
+const std::string& AtScript::Prefix(std::uint32_t index) const
+{
+    return _prefixes.at(index);
+}
+
+void AtScript::Expand(std::uint32_t index, const std::vector<std::wstring>& variables, std::wstring& out) const
+{
+    out.clear();
+    const auto& entry = _templates[index];
+    for (std::uint32_t i = 0; i < entry.count; ++i)
+    {
+        const auto& segment = _segments[entry.first + i];
+        out += segment.slot == kNoSlot ? _literals[segment.literal] : variables[segment.slot];
+    }
+}
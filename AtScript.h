@@ -0,0 +1,146 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本
+说明：把配置文件中的 <script> 元素编译为紧凑的指令序列，供 AtScriptRunner 逐条执行
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：变量、标签与上报类型都在编译时解析为槽位、指令序号与枚举，执行时不再查找名称或解析文本
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "UrcDispatcher.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/// <summary>脚本指令的操作码。</summary>
+enum class AtScriptOp : std::uint8_t
+{
+    /// <summary>发送模板 a 展开后的指令，超时 b 毫秒；结果写入 result 变量，失败时按 target 处理。</summary>
+    Send,
+    /// <summary>从上一条指令的应答中取出以前缀 a 开头的行，存入其第 flag 个字段（kWholeLine 为整行参数）到变量 slot。</summary>
+    Capture,
+    /// <summary>向模板 a 展开后的号码发送模板 b 展开后的短信，失败时按 target 处理。</summary>
+    Sms,
+    /// <summary>变量 slot 赋值为模板 a 展开后的文本。</summary>
+    Set,
+    /// <summary>变量 slot 按整数加上 a（有符号）。</summary>
+    Add,
+    /// <summary>变量 slot 与模板 a 按比较方式 flag 比较，成立时跳到 target。</summary>
+    JumpIf,
+    Jump,
+    /// <summary>计数器 b 未达到 a 次时加一并跳到 target，达到后清零并继续。</summary>
+    Loop,
+    /// <summary>等待 flag 类型的主动上报至多 b 毫秒，取第 a 个字段（kWholeLine 为整行参数）存入变量 slot；超时按 target 处理。</summary>
+    WaitUrc,
+    /// <summary>等待 b 毫秒。</summary>
+    Sleep,
+    /// <summary>输出模板 a 展开后的文本。</summary>
+    Log,
+    /// <summary>以模板 a 展开后的文本作为失败原因结束。</summary>
+    Fail,
+    End
+};
+
+/// <summary>JumpIf 的比较方式；两边都是整数时按数值比较，否则按文本比较。</summary>
+enum class AtScriptCompare : std::uint8_t
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+/// <summary>一条编译后的指令，各字段的含义见 AtScriptOp。</summary>
+struct AtScriptInstruction
+{
+    AtScriptOp op = AtScriptOp::End;
+    std::uint8_t flag = 0;
+    std::uint16_t slot = 0;
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+    std::uint32_t target = 0;
+};
+
+static_assert(sizeof(AtScriptInstruction) == 16, "脚本指令应保持 16 字节");
+
+/// <summary>编译后的脚本，构造后只读，可被多个执行线程共享。</summary>
+class AtScript
+{
+public:
+    /// <summary>失败时结束脚本。</summary>
+    static constexpr std::uint32_t kFail = 0xFFFFFFFF;
+    /// <summary>失败时继续下一条。</summary>
+    static constexpr std::uint32_t kContinue = 0xFFFFFFFE;
+    /// <summary>不保存捕获结果。</summary>
+    static constexpr std::uint16_t kNoSlot = 0xFFFF;
+    /// <summary>内置变量 result：最近一条指令或短信的结果（OK、ERROR、+CME ERROR: 10、TIMEOUT 等）。</summary>
+    static constexpr std::uint16_t kResultSlot = 0;
+    /// <summary>捕获前缀之后的全部参数而不是其中一个字段。</summary>
+    static constexpr std::uint8_t kWholeLine = 0xFF;
+
+    /// <summary>
+    /// 编译一个完整的 &lt;script name="..." summary="..."&gt;...&lt;/script&gt; 元素。
+    /// 失败时返回空，error 给出脚本名与出错元素的序号。
+    /// </summary>
+    static std::shared_ptr<const AtScript> Compile(const std::wstring& element, std::wstring& error);
+
+    const std::wstring& Name() const noexcept;
+    const std::wstring& Summary() const noexcept;
+
+    /// <summary>编译所用的原始元素文本，保存配置时原样写回。</summary>
+    const std::wstring& Source() const noexcept;
+
+    std::span<const AtScriptInstruction> Code() const noexcept;
+
+    /// <summary>变量槽位数，含内置的 result。</summary>
+    std::size_t VariableCount() const noexcept;
+
+    /// <summary>loop 计数器的个数。</summary>
+    std::size_t CounterCount() const noexcept;
+
+    /// <summary>脚本等待的上报类型，执行器在脚本开始时订阅，避免等待之前到达的上报丢失。</summary>
+    std::span<const UrcKind> UrcKinds() const noexcept;
+
+    /// <summary>Capture 的应答行前缀（UTF-8），为空时取第一行。</summary>
+    const std::string& Prefix(std::uint32_t index) const;
+
+    /// <summary>以当前变量值展开模板 index，写入 out（先清空）。</summary>
+    void Expand(std::uint32_t index, const std::vector<std::wstring>& variables, std::wstring& out) const;
+
+private:
+    /// <summary>模板的一段：常量池中的文本，或一个变量。</summary>
+    struct Segment
+    {
+        std::uint32_t literal;
+        std::uint16_t slot;
+    };
+
+    /// <summary>模板占 _segments 中从 first 开始的 count 段。</summary>
+    struct Template
+    {
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    friend class AtScriptCompiler;
+
+private:
+    std::wstring _name;
+    std::wstring _summary;
+    std::wstring _source;
+    std::vector<AtScriptInstruction> _code;
+    std::vector<std::wstring> _literals;
+    std::vector<std::string> _prefixes;
+    std::vector<Segment> _segments;
+    std::vector<Template> _templates;
+    std::vector<UrcKind> _urcKinds;
+    std::size_t _variableCount = 1;
+    std::size_t _counterCount = 0;
+};
@@ -0,0 +1,444 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本执行器实现
+说明：按指令序号逐条解释执行，收发与等待在执行线程上阻塞进行
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：变量以宽字符串保存；模板展开与赋值复用已有缓冲区，循环稳定后计算类指令不再分配内存
+------------------------------------------------------------------------*/
+#include "AtScriptRunner.h"
+#include "AtResponseParser.h"
+#include "TextEncoding.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cwchar>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // 脚本开始后、等待之前到达的上报至多保留的条数，超出时丢弃最早的。
+    constexpr std::size_t kUrcBacklog = 16;
+    // 连续这么多条指令既不收发也不等待即视为死循环。
+    constexpr std::uint64_t kMaxSilentSteps = 1000000;
+
+    std::optional<long long> ParseInteger(const std::wstring& text)
+    {
+        if (text.empty())
+        {
+            return std::nullopt;
+        }
+        wchar_t* end = nullptr;
+        errno = 0;
+        const long long value = std::wcstoll(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != L'\0' || errno == ERANGE)
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    bool Compare(const std::wstring& left, const std::wstring& right, AtScriptCompare compare)
+    {
+        int order = 0;
+        const auto leftNumber = ParseInteger(left);
+        const auto rightNumber = leftNumber ? ParseInteger(right) : std::nullopt;
+        if (leftNumber && rightNumber)
+        {
+            order = *leftNumber < *rightNumber ? -1 : (*leftNumber > *rightNumber ? 1 : 0);
+        }
+        else
+        {
+            const int compared = left.compare(right);
+            order = compared < 0 ? -1 : (compared > 0 ? 1 : 0);
+        }
+        switch (compare)
+        {
+        case AtScriptCompare::Equal:
+            return order == 0;
+        case AtScriptCompare::NotEqual:
+            return order != 0;
+        case AtScriptCompare::Less:
+            return order < 0;
+        case AtScriptCompare::LessEqual:
+            return order <= 0;
+        case AtScriptCompare::Greater:
+            return order > 0;
+        case AtScriptCompare::GreaterEqual:
+            return order >= 0;
+        }
+        return false;
+    }
+
+    /// <summary>参数部分的第 index 个字段，kWholeLine 时返回全部参数。</summary>
+    std::string_view Field(std::string_view payload, std::uint32_t index)
+    {
+        if (index == AtScript::kWholeLine)
+        {
+            return payload;
+        }
+        AtFieldReader reader(payload);
+        std::string_view field;
+        for (std::uint32_t i = 0; i <= index; ++i)
+        {
+            if (!reader.Next(field))
+            {
+                return {};
+            }
+        }
+        return field;
+    }
+
+    /// <summary>结果写入 result 变量的文本：有结果行时原样使用，否则以结果码命名。</summary>
+    std::wstring ResultText(AtResultCode code, int errorCode, const std::string& finalLine)
+    {
+        if (!finalLine.empty())
+        {
+            return Utf8ToWide(finalLine);
+        }
+        switch (code)
+        {
+        case AtResultCode::Ok:
+            return L"OK";
+        case AtResultCode::CmeError:
+            return L"+CME ERROR: " + std::to_wstring(errorCode);
+        case AtResultCode::CmsError:
+            return L"+CMS ERROR: " + std::to_wstring(errorCode);
+        case AtResultCode::Timeout:
+            return L"TIMEOUT";
+        case AtResultCode::Cancelled:
+            return L"CANCELLED";
+        case AtResultCode::NotSent:
+            return L"NOT SENT";
+        default:
+            return L"ERROR";
+        }
+    }
+}
+
+AtScriptRunner::AtScriptRunner(AtSession& session)
+    : _session(session), _busy(false), _cancelled(false)
+{
+}
+
+AtScriptRunner::~AtScriptRunner()
+{
+    Cancel();
+}
+
+void AtScriptRunner::SetLogCallback(LogCallback callback)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _logCallback = std::move(callback);
+}
+
+AtScriptResult AtScriptRunner::Run(const AtScript& script)
+{
+    if (!TryBegin())
+    {
+        AtScriptResult result;
+        result.message = L"已有脚本在执行";
+        return result;
+    }
+    auto result = Execute(script);
+    _busy.store(false);
+    return result;
+}
+
+bool AtScriptRunner::Start(std::shared_ptr<const AtScript> script, FinishedCallback onFinished)
+{
+    if (!script || !TryBegin())
+    {
+        return false;
+    }
+    // 上一个脚本已结束，线程随即退出。
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+    _worker = std::thread([this, script = std::move(script), onFinished = std::move(onFinished)]()
+    {
+        const auto result = Execute(*script);
+        _busy.store(false);
+        if (onFinished)
+        {
+            onFinished(result);
+        }
+    });
+    return true;
+}
+
+bool AtScriptRunner::IsRunning() const noexcept
+{
+    return _busy.load();
+}
+
+void AtScriptRunner::Cancel()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _cancelled.store(true);
+    }
+    _signal.notify_all();
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+bool AtScriptRunner::TryBegin()
+{
+    bool expected = false;
+    if (!_busy.compare_exchange_strong(expected, true))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(_mutex);
+    _urcs.clear();
+    _cancelled.store(false);
+    return true;
+}
+
+AtScriptResult AtScriptRunner::Execute(const AtScript& script)
+{
+    const auto started = Clock::now();
+    // 先订阅脚本用到的上报，例如发短信给自己之后等 +CMTI，上报可能在执行到等待之前就已到达。
+    auto& dispatcher = _session.GetUrcDispatcher();
+    std::vector<UrcDispatcher::SubscriptionId> subscriptions;
+    for (const auto kind : script.UrcKinds())
+    {
+        subscriptions.push_back(dispatcher.Subscribe(kind, [this](const UrcEvent& event)
+        {
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                if (_urcs.size() >= kUrcBacklog)
+                {
+                    _urcs.pop_front();
+                }
+                _urcs.push_back(PendingUrc{event.kind, std::string(event.payload)});
+            }
+            _signal.notify_all();
+        }));
+    }
+
+    AtScriptResult result;
+    std::vector<std::wstring> variables(script.VariableCount());
+    std::vector<std::uint32_t> counters(script.CounterCount(), 0);
+    std::wstring text;
+    std::wstring extra;
+    std::string payload;
+    AtCommandHandle last;
+    const auto code = script.Code();
+    std::uint32_t next = 0;
+    std::uint64_t silent = 0;
+    bool finished = false;
+    // 收发或等待失败：按 target 继续、跳转或以 message 结束。
+    const auto fail = [&](std::uint32_t target, std::wstring message)
+    {
+        if (target == AtScript::kContinue)
+        {
+            return;
+        }
+        if (target == AtScript::kFail)
+        {
+            result.message = std::move(message);
+            finished = true;
+            return;
+        }
+        next = target;
+    };
+
+    while (!finished)
+    {
+        if (_cancelled.load(std::memory_order_relaxed))
+        {
+            result.message = L"已取消";
+            break;
+        }
+        if (++silent > kMaxSilentSteps)
+        {
+            result.message = L"连续 " + std::to_wstring(kMaxSilentSteps) + L" 条指令没有收发或等待，疑为死循环";
+            break;
+        }
+        const auto& instruction = code[next++];
+        ++result.steps;
+        switch (instruction.op)
+        {
+        case AtScriptOp::Send:
+        {
+            silent = 0;
+            script.Expand(instruction.a, variables, text);
+            last = _session.SendCommand(text, std::chrono::milliseconds(instruction.b));
+            const auto& outcome = last.Wait();
+            variables[AtScript::kResultSlot] = ResultText(outcome.code, outcome.errorCode, outcome.finalLine);
+            if (!outcome.Succeeded())
+            {
+                fail(instruction.target, text + L" 失败: " + variables[AtScript::kResultSlot]);
+            }
+            break;
+        }
+        case AtScriptOp::Capture:
+        {
+            const auto& prefix = script.Prefix(instruction.a);
+            auto& value = variables[instruction.slot];
+            value.clear();
+            for (const auto& line : last.Wait().lines)
+            {
+                if (line.compare(0, prefix.size(), prefix) != 0)
+                {
+                    continue;
+                }
+                std::string_view rest(line);
+                rest.remove_prefix(prefix.size());
+                while (!rest.empty() && rest.front() == ' ')
+                {
+                    rest.remove_prefix(1);
+                }
+                value = Utf8ToWide(Field(rest, instruction.flag));
+                break;
+            }
+            break;
+        }
+        case AtScriptOp::Sms:
+        {
+            silent = 0;
+            script.Expand(instruction.a, variables, text);
+            script.Expand(instruction.b, variables, extra);
+            const auto outcome = _session.SubmitSms(text, extra).get();
+            variables[AtScript::kResultSlot] = ResultText(outcome.code, outcome.errorCode, {});
+            if (!outcome.Succeeded())
+            {
+                fail(instruction.target, L"短信发往 " + text + L" 失败: " + variables[AtScript::kResultSlot]);
+            }
+            break;
+        }
+        case AtScriptOp::Set:
+            script.Expand(instruction.a, variables, text);
+            variables[instruction.slot].swap(text);
+            break;
+        case AtScriptOp::Add:
+        {
+            auto& value = variables[instruction.slot];
+            const auto number = value.empty() ? std::optional<long long>(0) : ParseInteger(value);
+            if (!number)
+            {
+                result.message = L"第 " + std::to_wstring(next) + L" 条指令: 变量值 " + value + L" 不是整数";
+                finished = true;
+                break;
+            }
+            // 写回原缓冲区，循环计数不分配内存。
+            wchar_t digits[24];
+            std::swprintf(digits, std::size(digits), L"%lld", *number + static_cast<std::int32_t>(instruction.a));
+            value.assign(digits);
+            break;
+        }
+        case AtScriptOp::JumpIf:
+            script.Expand(instruction.a, variables, text);
+            if (Compare(variables[instruction.slot], text, static_cast<AtScriptCompare>(instruction.flag)))
+            {
+                next = instruction.target;
+            }
+            break;
+        case AtScriptOp::Jump:
+            next = instruction.target;
+            break;
+        case AtScriptOp::Loop:
+            if (++counters[instruction.b] < instruction.a)
+            {
+                next = instruction.target;
+            }
+            else
+            {
+                counters[instruction.b] = 0;
+            }
+            break;
+        case AtScriptOp::WaitUrc:
+            silent = 0;
+            if (WaitUrc(static_cast<UrcKind>(instruction.flag), Clock::now() + std::chrono::milliseconds(instruction.b), payload))
+            {
+                if (instruction.slot != AtScript::kNoSlot)
+                {
+                    variables[instruction.slot] = Utf8ToWide(Field(payload, instruction.a));
+                }
+            }
+            else if (!_cancelled.load())
+            {
+                fail(instruction.target, L"等待主动上报超时");
+            }
+            break;
+        case AtScriptOp::Sleep:
+            silent = 0;
+            SleepUntil(Clock::now() + std::chrono::milliseconds(instruction.b));
+            break;
+        case AtScriptOp::Log:
+            script.Expand(instruction.a, variables, text);
+            Log(L"[" + script.Name() + L"] " + text);
+            break;
+        case AtScriptOp::Fail:
+            script.Expand(instruction.a, variables, text);
+            result.message = text.empty() ? L"脚本执行 <fail>" : text;
+            finished = true;
+            break;
+        case AtScriptOp::End:
+            result.succeeded = true;
+            finished = true;
+            break;
+        }
+    }
+
+    for (const auto id : subscriptions)
+    {
+        dispatcher.Unsubscribe(id);
+    }
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started);
+    return result;
+}
+
+bool AtScriptRunner::WaitUrc(UrcKind kind, Clock::time_point deadline, std::string& payload)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        const auto found = std::find_if(_urcs.begin(), _urcs.end(), [kind](const PendingUrc& urc)
+        {
+            return urc.kind == kind;
+        });
+        if (found != _urcs.end())
+        {
+            payload = std::move(found->payload);
+            _urcs.erase(found);
+            return true;
+        }
+        if (_cancelled.load() || Clock::now() >= deadline)
+        {
+            return false;
+        }
+        _signal.wait_until(lock, deadline);
+    }
+}
+
+bool AtScriptRunner::SleepUntil(Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return !_signal.wait_until(lock, deadline, [this]()
+    {
+        return _cancelled.load();
+    });
+}
+
+void AtScriptRunner::Log(const std::wstring& text)
+{
+    LogCallback callback;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        callback = _logCallback;
+    }
+    if (callback)
+    {
+        callback(text);
+    }
+}
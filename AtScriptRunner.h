@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本执行器
+说明：在会话上逐条执行编译好的 AtScript，支持收发、分支、循环与等待主动上报
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：同一时刻只执行一个脚本；脚本发出的指令与手工发送的一样排队并写入日志
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtScript.h"
+#include "AtSession.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// <summary>一次执行的结果。</summary>
+struct AtScriptResult
+{
+    bool succeeded = false;
+    /// <summary>失败原因，成功时为空。</summary>
+    std::wstring message;
+    /// <summary>执行的指令条数。</summary>
+    std::uint64_t steps = 0;
+    std::chrono::milliseconds elapsed{0};
+};
+
+/// <summary>执行 AtScript 的解释器；Start 与 Cancel 须在同一线程（通常是界面线程）调用。</summary>
+class AtScriptRunner
+{
+public:
+    using LogCallback = std::function<void(const std::wstring& text)>;
+    using FinishedCallback = std::function<void(const AtScriptResult& result)>;
+
+    explicit AtScriptRunner(AtSession& session);
+    ~AtScriptRunner();
+
+    AtScriptRunner(const AtScriptRunner&) = delete;
+    AtScriptRunner& operator=(const AtScriptRunner&) = delete;
+
+    /// <summary>接收 &lt;log&gt; 的输出，在执行线程上调用。</summary>
+    void SetLogCallback(LogCallback callback);
+
+    /// <summary>在调用线程上执行至结束；已有脚本在执行时立即失败。不可在串口分发线程上调用。</summary>
+    AtScriptResult Run(const AtScript& script);
+
+    /// <summary>在后台线程上执行，结束时在该线程上调用 onFinished；已有脚本在执行时返回 false。</summary>
+    bool Start(std::shared_ptr<const AtScript> script, FinishedCallback onFinished);
+
+    bool IsRunning() const noexcept;
+
+    /// <summary>停止当前脚本并等待后台线程退出；等待与休眠立即结束，在途指令须等其完成，可先断开会话使其取消。</summary>
+    void Cancel();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// <summary>脚本开始后收到的一条上报，供之后的 &lt;wait&gt; 取用。</summary>
+    struct PendingUrc
+    {
+        UrcKind kind;
+        std::string payload;
+    };
+
+    /// <summary>占用执行器并清空上一次留下的上报与取消标志，已被占用时返回 false。</summary>
+    bool TryBegin();
+    AtScriptResult Execute(const AtScript& script);
+    /// <summary>等待 kind 类型的上报至 deadline，取出最早的一条；超时或取消时返回 false。</summary>
+    bool WaitUrc(UrcKind kind, Clock::time_point deadline, std::string& payload);
+    /// <summary>休眠至 deadline，取消时提前返回 false。</summary>
+    bool SleepUntil(Clock::time_point deadline);
+    void Log(const std::wstring& text);
+
+private:
+    AtSession& _session;
+    mutable std::mutex _mutex;
+    std::condition_variable _signal;
+    LogCallback _logCallback;
+    std::deque<PendingUrc> _urcs;
+    std::atomic<bool> _busy;
+    std::atomic<bool> _cancelled;
+    std::thread _worker;
+};
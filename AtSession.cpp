@@ -7,13 +7,19 @@
 备注：无
 ------------------------------------------------------------------------*/
 #include "AtSession.h"
+#include "AtResponseParser.h"
+#include "SmsListingParser.h"
+#include "SmsPdu.h"
+#include "TextEncoding.h"
+#include "VirtualModemTransport.h"
 
 #include <algorithm>
 #include <array>
+#include <charconv>
+#include <cctype>
 #include <chrono>
+#include <ctime>
 #include <cwctype>
-#include <thread>
-#include <windows.h>
 
 namespace
 {
@@ -31,11 +37,252 @@ namespace
         }
         return text.substr(start, end - start);
     }
+
+    std::string_view TrimBytes(std::string_view text)
+    {
+        constexpr std::string_view whitespace = " \t";
+        const auto start = text.find_first_not_of(whitespace);
+        if (start == std::string_view::npos)
+        {
+            return {};
+        }
+        return text.substr(start, text.find_last_not_of(whitespace) - start + 1);
+    }
+
+    /// <summary>取出应答中第一行长度在 [minimum, maximum] 之间的纯数字，没有时返回空。</summary>
+    std::string ExtractDigits(const AtCommandResult& result, std::size_t minimum, std::size_t maximum)
+    {
+        for (const auto& line : result.lines)
+        {
+            const bool digits = std::all_of(line.begin(), line.end(), [](char ch)
+            {
+                return ch >= '0' && ch <= '9';
+            });
+            if (digits && line.size() >= minimum && line.size() <= maximum)
+            {
+                return line;
+            }
+        }
+        return {};
+    }
+
+    /// <summary>从 AT+CGSN 的应答中取出 IMEI（一行 14 到 17 位数字），没有时返回空。</summary>
+    std::string ExtractImei(const AtCommandResult& result)
+    {
+        return ExtractDigits(result, 14, 17);
+    }
+
+    /// <summary>从 AT+CIMI 的应答中取出 IMSI（一行 6 到 15 位数字），未插卡时返回空。</summary>
+    std::string ExtractImsi(const AtCommandResult& result)
+    {
+        return ExtractDigits(result, 6, 15);
+    }
+
+    /// <summary>line 以 prefix 开头时返回其后去掉空白的部分。</summary>
+    std::optional<std::string_view> InfoValue(std::string_view line, std::string_view prefix)
+    {
+        if (line.substr(0, prefix.size()) != prefix)
+        {
+            return std::nullopt;
+        }
+        return TrimBytes(line.substr(prefix.size()));
+    }
+
+    /// <summary>取 AT+CGMM、AT+CGMR 应答的第一行，去掉部分模块加上的 "+CGMM:" 等前缀。</summary>
+    std::string FirstInfoLine(const AtCommandResult& result)
+    {
+        constexpr std::array<std::string_view, 4> prefixes{"+CGMM:", "+CGMR:", "Model:", "Revision:"};
+        for (const auto& line : result.lines)
+        {
+            std::string_view value = TrimBytes(line);
+            for (const auto prefix : prefixes)
+            {
+                if (const auto stripped = InfoValue(value, prefix))
+                {
+                    value = *stripped;
+                    break;
+                }
+            }
+            if (!value.empty())
+            {
+                return std::string(value);
+            }
+        }
+        return {};
+    }
+
+    /// <summary>
+    /// 解析 ATI：SIMCom、Quectel 输出 "Manufacturer: ..." 等带标签的行，
+    /// 其他模块常只输出厂商与型号两行，依次取用；已取得的字段不覆盖。
+    /// </summary>
+    void ParseAti(const AtCommandResult& result, ModemIdentity& identity)
+    {
+        int plainLines = 0;
+        for (const auto& line : result.lines)
+        {
+            const auto text = TrimBytes(line);
+            if (const auto value = InfoValue(text, "Manufacturer:"))
+            {
+                identity.manufacturer.assign(*value);
+            }
+            else if (const auto value = InfoValue(text, "Model:"))
+            {
+                identity.model.assign(*value);
+            }
+            else if (const auto value = InfoValue(text, "Revision:"))
+            {
+                identity.revision.assign(*value);
+            }
+            else if (!text.empty() && text.find(':') == std::string_view::npos)
+            {
+                auto& field = plainLines == 0 ? identity.manufacturer : identity.model;
+                if (plainLines < 2 && field.empty())
+                {
+                    field.assign(text);
+                }
+                ++plainLines;
+            }
+        }
+    }
+
+    /// <summary>从 +CSCS: ("IRA","GSM","UCS2") 中取出各字符集名。</summary>
+    std::vector<std::string> ParseCharsets(const AtCommandResult& result)
+    {
+        std::vector<std::string> charsets;
+        for (const auto& line : result.lines)
+        {
+            std::string_view rest = line;
+            if (!InfoValue(rest, "+CSCS:"))
+            {
+                continue;
+            }
+            while (true)
+            {
+                const auto open = rest.find('"');
+                const auto close = open == std::string_view::npos ? open : rest.find('"', open + 1);
+                if (close == std::string_view::npos)
+                {
+                    break;
+                }
+                charsets.emplace_back(rest.substr(open + 1, close - open - 1));
+                rest.remove_prefix(close + 1);
+            }
+        }
+        return charsets;
+    }
+
+    /// <summary>一条短信各段的汇总，最后一段完成时交付结果。</summary>
+    struct SmsSubmitProgress
+    {
+        std::mutex mutex;
+        std::size_t remaining = 0;
+        SmsSubmitResult result;
+        /// <summary>第一处失败的最终结果行。</summary>
+        std::string failure;
+    };
+
+    constexpr auto kImeiProbeTimeout = std::chrono::seconds(1);
+    /// <summary>执行后模块的短信格式可能改变的指令，之后提交短信时重新发送 AT+CMGF。</summary>
+    constexpr std::array<std::wstring_view, 4> kSmsFormatResetCommands{L"AT+CMGF", L"AT+CFUN", L"ATZ", L"AT&F"};
+
+    /// <summary>
+    /// 插到排队指令之前的指令：AT+CNMA 须在网络时限内确认；AT+CMGD 删除的都是已读已保存的短信，
+    /// 先于排队的 AT+CMGR 执行才能在新短信密集到达时及时腾出存储。
+    /// </summary>
+    constexpr std::array<std::wstring_view, 2> kUrgentCommands{L"AT+CNMA", L"AT+CMGD"};
+
+    /// <summary>指令是否以 prefix 开头，不区分大小写；prefix 须为大写。</summary>
+    bool HasCommandPrefix(std::wstring_view command, std::wstring_view prefix)
+    {
+        return command.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), command.begin(), [](wchar_t expected, wchar_t actual)
+        {
+            return expected == static_cast<wchar_t>(std::towupper(static_cast<wint_t>(actual)));
+        });
+    }
+
+    /// <summary>从 AT+CMGR=&lt;index&gt; 中取出存储索引，不是该指令时返回 -1。</summary>
+    int ReadIndexOf(std::string_view command)
+    {
+        constexpr std::string_view prefix = "AT+CMGR=";
+        const bool matches = command.size() > prefix.size() && std::equal(prefix.begin(), prefix.end(), command.begin(), [](char expected, char actual)
+        {
+            return expected == static_cast<char>(std::toupper(static_cast<unsigned char>(actual)));
+        });
+        if (!matches)
+        {
+            return -1;
+        }
+        const auto digits = TrimBytes(command.substr(prefix.size()));
+        int index = -1;
+        const auto parsed = std::from_chars(digits.data(), digits.data() + digits.size(), index);
+        return parsed.ec == std::errc() && parsed.ptr == digits.data() + digits.size() ? index : -1;
+    }
+
+    constexpr char kCtrlZ = 0x1A;
+    constexpr char kEscape = 0x1B;
+
+    /// <summary>一行串联的 AT+CMGD 条数上限，指令行保持在常见模块的 256 字节限制以内。</summary>
+    constexpr std::size_t kDeleteBatch = 8;
+    /// <summary>不满一批的删除最多推迟的时长，新短信稀疏时也能及时腾出存储。</summary>
+    constexpr auto kDeleteDelay = std::chrono::seconds(1);
+    /// <summary>重连线程在链路正常时做例行清理的间隔。</summary>
+    constexpr auto kHousekeepingInterval = std::chrono::seconds(1);
+
+    /// <summary>从 AT+CMGS 的应答中取出消息参考号，没有时返回 -1。</summary>
+    int ParseMessageReference(const AtCommandResult& result)
+    {
+        constexpr std::string_view prefix = "+CMGS:";
+        for (const auto& line : result.lines)
+        {
+            if (std::string_view(line).substr(0, prefix.size()) != prefix)
+            {
+                continue;
+            }
+            auto digits = TrimBytes(std::string_view(line).substr(prefix.size()));
+            int reference = -1;
+            const auto parsed = std::from_chars(digits.data(), digits.data() + digits.size(), reference);
+            return parsed.ec == std::errc() ? reference : -1;
+        }
+        return -1;
+    }
 }
 
 AtSession::AtSession()
-    : _waitingSmsContent(false)
+    : _commands([this](std::string data, std::function<void(bool)> onWritten)
+      {
+          return _port.WriteAsync(std::move(data), [onWritten = std::move(onWritten)](bool success, std::size_t)
+          {
+              onWritten(success);
+          });
+      }),
+      _waitingUrcBody(false), _readIndex(-1), _ackRequired(false), _pendingReads(0), _chainedDeletes(true), _nextConcatReference(0), _smsFormat(-1), _modemCache(nullptr), _linkLost(false), _stopReconnect(false), _lastRecoveryMs(0)
 {
+    _frameHandler = [this](const LineFrame& frame)
+    {
+        HandleFrame(frame);
+    };
+    // 只有待写正文的指令在途时才识别提示符，列表正文里以 "> " 开头的行（例如引用回复）照常成行。
+    _framer.SetPromptPredicate([this]
+    {
+        return _commands.AwaitingPrompt();
+    });
+    _recordHandler = [this](const SmsListingRecord& record)
+    {
+        DeliverSms(record.headerLine, record.header, record.body);
+    };
+    _messageHandler = [this](const ReceivedSms& sms)
+    {
+        EmitSms(sms);
+    };
+    _urcs.Subscribe(UrcKind::Cmti, [this](const UrcEvent& event)
+    {
+        HandleCmtiNotification(event);
+    });
+    _urcs.Subscribe(UrcKind::Cmt, [this](const UrcEvent& event)
+    {
+        _lastSmsHeader.assign(event.line);
+        _waitingUrcBody = true;
+    });
 }
 
 AtSession::~AtSession()
@@ -43,21 +290,78 @@ AtSession::~AtSession()
     Disconnect();
 }
 
+void AtSession::SetModemCache(ModemProfileCache* cache) noexcept
+{
+    _modemCache = cache;
+}
+
+std::optional<ModemIdentity> AtSession::GetModemIdentity() const
+{
+    std::lock_guard<std::mutex> guard(_linkMutex);
+    return _identity;
+}
+
 bool AtSession::Connect(const std::wstring& portName, unsigned long baudRate)
+{
+    SerialSettings settings;
+    settings.baudRate = baudRate;
+    return Connect(portName, settings);
+}
+
+bool AtSession::Connect(const std::wstring& portName, const SerialSettings& settings)
 {
     Disconnect();
-    _lineBuffer.clear();
-    _waitingSmsContent = false;
-    _pendingEchoes.clear();
-    _port.SetDataHandler([this](const std::string& chunk)
+    ResetLineState();
+    {
+        // 待删除的索引属于上一个模块；自动重连找回的是同一模块，不经过这里，保留原样。
+        std::lock_guard<std::mutex> guard(_cleanupMutex);
+        _pendingDeletes.clear();
+        _deleting.clear();
+        _chainedDeletes = true;
+    }
+    // SIM 开头的端口名接到进程内虚拟模块，其余走平台串口。
+    _port.SetTransport(VirtualModemTransport::IsVirtualPort(portName) ? std::make_unique<VirtualModemTransport>() : CreateSerialTransport());
+    _port.SetDataHandler([this](std::string_view chunk)
     {
         HandleIncoming(chunk);
     });
-    if (!_port.Open(portName, baudRate))
+    _port.SetLinkLostHandler([this]()
     {
+        // 在读取线程上执行，只做通知，关闭与重开交给重连线程。
+        {
+            std::lock_guard<std::mutex> guard(_linkMutex);
+            _linkLost = true;
+        }
+        _linkSignal.notify_all();
+    });
+    if (!_port.Open(portName, settings))
+    {
+        _port.SetLinkLostHandler(nullptr);
         _port.SetDataHandler(nullptr);
         return false;
     }
+    std::wstring hardwareId;
+    for (const auto& info : EnumerateSerialPorts())
+    {
+        if (info.name == portName)
+        {
+            hardwareId = info.hardwareId;
+            break;
+        }
+    }
+    // 按 USB 硬件标识预取的信息只用于提前排队专用初始化指令，IMEI 仍以 AT+CGSN 的应答为准。
+    auto identity = _modemCache != nullptr ? _modemCache->FindByHardwareId(WideToUtf8(hardwareId)) : std::nullopt;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        _linkPortName = portName;
+        _linkSettings = settings;
+        _linkHardwareId = std::move(hardwareId);
+        _linkImei.clear();
+        _identity = std::move(identity);
+        _linkLost = false;
+        _stopReconnect = false;
+    }
+    _reconnectWorker = std::thread(&AtSession::ReconnectLoop, this);
     AppendLog(L"已连接 " + portName + L" 串口");
     ConfigureAfterConnect();
     return true;
@@ -65,13 +369,26 @@ bool AtSession::Connect(const std::wstring& portName, unsigned long baudRate)
 
 void AtSession::Disconnect()
 {
-    if (_port.IsOpen())
+    StopReconnectWorker();
+    bool connected = false;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        connected = !_linkPortName.empty();
+        _linkPortName.clear();
+    }
+    if (connected)
     {
+        _port.SetLinkLostHandler(nullptr);
         _port.SetDataHandler(nullptr);
         _port.Close();
         AppendLog(L"串口已断开");
     }
-    _pendingEchoes.clear();
+    _smsFormat = -1;
+    _ackRequired = false;
+    _commands.CancelAll();
+    // 分发线程已停止，不会再有后续段；未到齐的长短信以不完整的形式交出，不丢弃已收到的段。
+    std::lock_guard<std::mutex> guard(_reassemblyMutex);
+    _reassembler.Flush(_messageHandler);
 }
 
 bool AtSession::IsConnected() const noexcept
@@ -79,83 +396,216 @@ bool AtSession::IsConnected() const noexcept
     return _port.IsOpen();
 }
 
-bool AtSession::SendCommand(const std::wstring& commandText)
+void AtSession::SetReconnectPolicy(const ReconnectPolicy& policy)
+{
+    std::lock_guard<std::mutex> guard(_linkMutex);
+    _reconnectPolicy = policy;
+}
+
+std::chrono::milliseconds AtSession::GetLastRecoveryTime() const noexcept
+{
+    return std::chrono::milliseconds(_lastRecoveryMs.load());
+}
+
+AtCommandHandle AtSession::SendCommand(const std::wstring& commandText, std::chrono::milliseconds timeout)
+{
+    return SubmitCommand(commandText, {}, timeout, {});
+}
+
+AtCommandHandle AtSession::SubmitBackgroundCommand(const std::wstring& commandText, std::chrono::milliseconds timeout,
+                                                   AtCommandEngine::CompletionCallback onComplete)
 {
     if (!IsConnected())
     {
-        return false;
+        return _commands.Submit(AtCommandRequest{}, std::move(onComplete));
     }
-    std::wstring trimmed = Trim(commandText);
-    if (trimmed.empty())
+    AtCommandRequest request{WideToUtf8(Trim(commandText)), {}, timeout};
+    request.background = true;
+    return _commands.Submit(std::move(request), std::move(onComplete));
+}
+
+AtCommandHandle AtSession::SubmitCommand(const std::wstring& commandText, std::string payload, std::chrono::milliseconds timeout,
+                                         AtCommandEngine::CompletionCallback onComplete)
+{
+    const std::wstring trimmed = Trim(commandText);
+    if (!IsConnected() || trimmed.empty())
     {
-        return false;
+        // 空指令不会被写出，句柄立即以 NotSent 完成。
+        return _commands.Submit(AtCommandRequest{});
     }
-    std::wstring payload = trimmed;
-    if (!payload.empty() && payload.back() != L'\r')
+    AppendLog(L"--> " + trimmed);
+    const bool resetsFormat = std::any_of(kSmsFormatResetCommands.begin(), kSmsFormatResetCommands.end(), [&trimmed](std::wstring_view prefix)
     {
-        payload.push_back(L'\r');
-    }
-    const auto buffer = WideToUtf8(payload);
-    if (buffer.empty())
+        return HasCommandPrefix(trimmed, prefix);
+    });
+    if (resetsFormat)
     {
-        return false;
+        _smsFormat = -1;
     }
-    if (_port.Write(buffer))
+    AtCommandRequest request{WideToUtf8(trimmed), std::move(payload), timeout};
+    // 短信列表由流式解析器逐条交出，不在结果中保留整份列表。
+    request.collectLines = !HasCommandPrefix(trimmed, L"AT+CMGL");
+    request.urgent = std::any_of(kUrgentCommands.begin(), kUrgentCommands.end(), [&trimmed](std::wstring_view prefix)
+    {
+        return HasCommandPrefix(trimmed, prefix);
+    });
+    return _commands.Submit(std::move(request), [this, onComplete = std::move(onComplete)](const AtCommandResult& result)
     {
-        AppendLog(L"--> " + trimmed);
-        _pendingEchoes.push_back(trimmed);
-        if (_pendingEchoes.size() > 32)
+        if (result.code == AtResultCode::Timeout)
         {
-            _pendingEchoes.pop_front();
+            AppendLog(L"指令超时: " + Utf8ToWide(result.command));
         }
-        return true;
-    }
-    return false;
+        else if (result.code == AtResultCode::NotSent)
+        {
+            AppendLog(L"指令写入失败: " + Utf8ToWide(result.command));
+        }
+        if (onComplete)
+        {
+            onComplete(result);
+        }
+    });
 }
 
 bool AtSession::SendSms(const std::wstring& smsContent)
 {
-    if (!IsConnected())
+    if (!IsConnected() || Trim(smsContent).empty())
     {
         return false;
     }
-    const std::wstring trimmed = Trim(smsContent);
-    if (trimmed.empty())
+    const std::wstring target = SmsProfileSnapshot().targetNumber;
+    if (target.empty())
     {
+        AppendLog(L"未配置短信目标号码");
         return false;
     }
-    if (_smsProfile.serviceCenter.empty() == false)
+    SubmitSms(target, smsContent);
+    return true;
+}
+
+std::future<SmsSubmitResult> AtSession::SubmitSms(const std::wstring& number, const std::wstring& text, SmsSubmitCallback onComplete)
+{
+    auto promise = std::make_shared<std::promise<SmsSubmitResult>>();
+    auto future = promise->get_future();
+    const std::wstring target = Trim(number);
+    const std::wstring body = Trim(text);
+    const auto reject = [&promise, &onComplete]()
     {
-        SendCommand(L"AT+CSCA=\"" + _smsProfile.serviceCenter + L"\"");
-        std::this_thread::sleep_for(std::chrono::milliseconds(150));
-    }
-    if (!SendCommand(L"AT+CMGF=1"))
+        const SmsSubmitResult notSent{AtResultCode::NotSent};
+        if (onComplete)
+        {
+            onComplete(notSent);
+        }
+        promise->set_value(notSent);
+    };
+    if (!IsConnected() || target.empty() || body.empty())
     {
-        return false;
+        reject();
+        return future;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(150));
-    if (_smsProfile.targetNumber.empty())
+    const SmsProfile profile = SmsProfileSnapshot();
+    const auto submittedAt = std::chrono::steady_clock::now();
+    // 每段一条 AT+CMGS：文本模式只有一段，PDU 模式按编码结果分段。
+    std::vector<std::pair<std::wstring, std::string>> segments;
+    if (profile.textMode)
     {
-        AppendLog(L"未配置短信目标号码");
-        return false;
+        if (profile.serviceCenter.empty() == false)
+        {
+            SendCommand(L"AT+CSCA=\"" + profile.serviceCenter + L"\"");
+        }
+        SelectSmsFormat(true);
+        // 正文中的 Ctrl-Z 或 ESC 会提前提交或取消输入，一律去掉。
+        auto payload = WideToUtf8(body);
+        payload.erase(std::remove_if(payload.begin(), payload.end(), [](char ch)
+        {
+            return ch == kCtrlZ || ch == kEscape;
+        }), payload.end());
+        payload.push_back(kCtrlZ);
+        segments.emplace_back(L"AT+CMGS=\"" + target + L"\"", std::move(payload));
     }
-    if (!SendCommand(L"AT+CMGS=\"" + _smsProfile.targetNumber + L"\""))
+    else
     {
-        return false;
+        // 服务中心号码直接写入 PDU，不再单独发送 AT+CSCA。
+        const std::string serviceCenter = WideToUtf8(profile.serviceCenter);
+        SmsPduOptions options;
+        options.serviceCenter = serviceCenter;
+        options.concatReference = static_cast<std::uint8_t>(_nextConcatReference.fetch_add(1));
+        std::vector<SmsPduPart> parts;
+        if (!EncodeSmsSubmit(WideToUtf8(target), WideToUtf8(body), options, parts))
+        {
+            AppendLog(L"短信编码失败（号码无效或内容超过 255 段）: " + target);
+            reject();
+            return future;
+        }
+        SelectSmsFormat(false);
+        for (auto& part : parts)
+        {
+            part.hex.push_back(kCtrlZ);
+            segments.emplace_back(L"AT+CMGS=" + std::to_wstring(part.tpduLength), std::move(part.hex));
+        }
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(150));
-    auto payload = WideToUtf8(trimmed);
-    payload.push_back(static_cast<char>(0x1A));
-    const bool ok = _port.Write(payload);
-    if (ok)
+
+    auto progress = std::make_shared<SmsSubmitProgress>();
+    progress->remaining = segments.size();
+    progress->result.code = AtResultCode::Ok;
+    progress->result.parts = static_cast<int>(segments.size());
+    const AtCommandEngine::CompletionCallback onSegment = [this, promise, progress, body, submittedAt, onComplete = std::move(onComplete)](const AtCommandResult& result)
+    {
+        {
+            std::lock_guard<std::mutex> guard(progress->mutex);
+            auto& submit = progress->result;
+            // 任一段失败即整体失败，保留第一处失败的结果码。
+            if (submit.Succeeded())
+            {
+                submit.code = result.code;
+                submit.errorCode = result.errorCode;
+                if (result.Succeeded())
+                {
+                    submit.messageReference = ParseMessageReference(result);
+                }
+                else
+                {
+                    progress->failure = result.finalLine;
+                }
+            }
+            if (--progress->remaining != 0)
+            {
+                return;
+            }
+        }
+        auto submit = progress->result;
+        submit.latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - submittedAt);
+        if (submit.Succeeded())
+        {
+            AppendLog(L"已发送短信: " + body + L"（参考号 " + std::to_wstring(submit.messageReference)
+                + (submit.parts > 1 ? L"，共 " + std::to_wstring(submit.parts) + L" 段" : L"") + L"，用时 "
+                + std::to_wstring(std::chrono::duration_cast<std::chrono::milliseconds>(submit.latency).count()) + L" ms）");
+        }
+        else
+        {
+            AppendLog(L"短信发送失败: " + body + (progress->failure.empty() ? L"" : L"（" + Utf8ToWide(progress->failure) + L"）"));
+        }
+        if (onComplete)
+        {
+            onComplete(submit);
+        }
+        promise->set_value(submit);
+    };
+    for (auto& [command, payload] : segments)
     {
-        AppendLog(L"已发送短信: " + trimmed);
+        if (!SubmitCommand(command, std::move(payload), {}, onSegment))
+        {
+            // 未受理的指令不会回调，按未发送计入。
+            AtCommandResult notSent;
+            notSent.code = AtResultCode::NotSent;
+            onSegment(notSent);
+        }
     }
-    return ok;
+    return future;
 }
 
 void AtSession::SetSmsProfile(const SmsProfile& profile)
 {
+    std::lock_guard<std::mutex> guard(_profileMutex);
     _smsProfile = profile;
 }
 
@@ -171,136 +621,543 @@ void AtSession::SetSmsCallback(SmsCallback callback)
     _smsCallback = std::move(callback);
 }
 
-void AtSession::HandleIncoming(const std::string& chunk)
+void AtSession::SetSmsReassemblyPolicy(const SmsReassemblyPolicy& policy)
 {
-    _lineBuffer.append(chunk);
-    const std::string delimiter = "\r\n";
-    while (true)
+    std::lock_guard<std::mutex> guard(_reassemblyMutex);
+    _reassembler.SetPolicy(policy);
+}
+
+SmsReassemblyStatistics AtSession::GetSmsReassemblyStatistics() const
+{
+    std::lock_guard<std::mutex> guard(_reassemblyMutex);
+    return _reassembler.GetStatistics();
+}
+
+void AtSession::SetReactor(SerialReactor* reactor) noexcept
+{
+    _port.SetReactor(reactor);
+}
+
+SerialStatistics AtSession::GetSerialStatistics() const noexcept
+{
+    return _port.GetStatistics();
+}
+
+UrcDispatcher& AtSession::GetUrcDispatcher() noexcept
+{
+    return _urcs;
+}
+
+void AtSession::HandleIncoming(std::string_view chunk)
+{
+    _framer.Feed(chunk, _frameHandler);
+}
+
+void AtSession::HandleFrame(const LineFrame& frame)
+{
+    if (frame.kind == FrameKind::Prompt)
+    {
+        LogReceived(">");
+        _commands.OnPrompt();
+        return;
+    }
+    const auto line = TrimBytes(frame.text);
+    if (line.empty())
     {
-        const auto pos = _lineBuffer.find(delimiter);
-        if (pos == std::string::npos)
+        return;
+    }
+    if (_waitingUrcBody)
+    {
+        // +CMT 的正文紧随上报，不经过调度器，以免被记到在途指令上。
+        _waitingUrcBody = false;
+        DeliverSms(_lastSmsHeader, ParseCmt(_lastSmsHeader).value_or(SmsHeaderResponse{}), line);
+        if (_ackRequired)
         {
-            break;
+            // 超过网络时限未确认时网络会重发，模块还会关闭直接上报，因此确认插到排队的指令之前。
+            SendCommand(L"AT+CNMA");
         }
-        std::string line = _lineBuffer.substr(0, pos);
-        _lineBuffer.erase(0, pos + delimiter.size());
-        if (line.empty())
+        return;
+    }
+    // 后台指令的应答不写日志，期间到达的主动上报照常记录。
+    bool background = false;
+    switch (_commands.OnLine(line, &background))
+    {
+    case AtCommandEngine::LineRole::Echo:
+        // 回显意味着新指令已开始，上一条列表若因超时未收到结果码，先交出已收到的部分。
+        _listing.Finish(_recordHandler);
+        return;
+    case AtCommandEngine::LineRole::Unsolicited:
+    {
+        // 新短信上报由内部订阅处理并自行记录日志，其余上报照常写入日志。
+        const auto kind = _urcs.Dispatch(line);
+        if (kind == UrcKind::Cmt || kind == UrcKind::Cmti)
         {
-            continue;
+            return;
+        }
+        break;
+    }
+    case AtCommandEngine::LineRole::Response:
+        if (line.substr(0, 6) == "+CMGR:")
+        {
+            // +CMGR 应答不带索引，从在途指令中取得；收件箱按索引去重，之后再列出同一条不会重复保存。
+            _readIndex = ReadIndexOf(_commands.ActiveCommand());
+        }
+        // +CMGL / +CMGR 的头部与正文交给流式解析器，凑齐一条即交付，不逐行写日志。
+        if (_listing.Feed(line, _recordHandler))
+        {
+            return;
         }
-        ProcessLine(Utf8ToWide(line));
+        break;
+    case AtCommandEngine::LineRole::Final:
+        _listing.Finish(_recordHandler);
+        FlushStoredDeletes();
+        break;
+    }
+    if (!background)
+    {
+        LogReceived(line);
     }
 }
 
-void AtSession::ProcessLine(const std::wstring& line)
+void AtSession::DeliverSms(std::string_view headerLine, const SmsHeaderResponse& header, std::string_view content)
 {
-    const std::wstring normalized = Trim(line);
-    if (normalized.empty())
+    ReceivedSms sms;
+    sms.storageIndex = header.index >= 0 || headerLine.substr(0, 6) != "+CMGR:" ? header.index : _readIndex;
+    // 只有收到的短信（REC UNREAD / REC READ）在保存后删除，已发送与草稿留在模块中。
+    const int storedIndex = sms.storageIndex;
+    if (storedIndex >= 0 && (header.statusCode == 0 || header.statusCode == 1))
     {
-        return;
+        sms.storedParts = std::span<const int>(&storedIndex, 1);
     }
-    if (!_pendingEchoes.empty() && normalized == _pendingEchoes.front())
+    std::string synthesized;
+    std::optional<SmsPduMessage> message;
+    SmsConcatInfo concat;
+    if (header.IsPdu())
     {
-        _pendingEchoes.pop_front();
-        return;
+        message = DecodeSmsPdu(content);
+        if (!message)
+        {
+            AppendLog(L"短信 PDU 解析失败: " + Utf8ToWide(content));
+            return;
+        }
+        // 转成与文本模式相同的头部（保留索引与状态），回调与界面不必区分收发模式。
+        synthesized.assign(headerLine.substr(0, headerLine.find(':') + 1));
+        synthesized.push_back(' ');
+        if (header.index >= 0)
+        {
+            synthesized.append(std::to_string(header.index)).push_back(',');
+        }
+        if (!header.status.empty())
+        {
+            synthesized.append("\"").append(header.status).append("\",");
+        }
+        synthesized.append("\"").append(message->address).append("\",,\"").append(FormatModemTime(message->timestamp)).push_back('"');
+        sms.header = synthesized;
+        sms.sender = message->address;
+        sms.body = message->text;
+        if (message->deliver)
+        {
+            sms.timestamp = message->timestamp;
+        }
+        // 文本模式下模块不给出 UDH，只有 PDU 模式能识别长短信的各段。
+        concat = message->concat;
     }
-    if (normalized.rfind(L"+CMT:", 0) == 0 || normalized.rfind(L"+CMGR:", 0) == 0)
+    else
     {
-        _waitingSmsContent = true;
-        _lastSmsHeader = normalized;
-        return;
+        sms.header = headerLine;
+        sms.sender = header.address;
+        sms.body = content;
+        sms.timestamp = ParseModemTime(header.timestamp);
     }
-    if (normalized.rfind(L"+CMTI:", 0) == 0)
+    std::string modem;
     {
-        HandleCmtiNotification(normalized);
-        return;
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        modem = _linkImei.empty() ? WideToUtf8(_linkPortName) : _linkImei;
+    }
+    sms.modem = modem;
+    std::lock_guard<std::mutex> guard(_reassemblyMutex);
+    _reassembler.Add(sms, concat, SmsReassembler::Clock::now(), _messageHandler);
+}
+
+void AtSession::EmitSms(const ReceivedSms& sms)
+{
+    SmsCallback callbackCopy;
+    {
+        std::lock_guard<std::mutex> guard(_callbackMutex);
+        callbackCopy = _smsCallback;
+    }
+    const bool saved = callbackCopy && callbackCopy(sms);
+    // 未收齐的长短信留在模块中，之后再列出时可以拼出整条。
+    if (saved && sms.complete && !sms.storedParts.empty() && SmsProfileSnapshot().deleteAfterSave)
+    {
+        QueueStoredDeletes(sms.storedParts);
+    }
+    const std::wstring text = Utf8ToWide(sms.body);
+    std::wstring prefix = sms.storageIndex >= 0 ? L"短信 #" + std::to_wstring(sms.storageIndex) + L": " : std::wstring(L"收到短信: ");
+    if (!sms.complete)
+    {
+        prefix += L"(长短信未收齐) ";
+    }
+    AppendLog(prefix + text);
+}
+
+AtCommandHandle AtSession::ConfigureAfterConnect(bool recovering)
+{
+    // AT+CGSN 记录模块 IMEI，自动重连时据此确认重新出现的是同一个模块。
+    std::optional<ModemIdentity> identity;
+    bool imeiKnown = false;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        identity = _identity;
+        imeiKnown = !_linkImei.empty();
     }
-    if (_waitingSmsContent)
+    // 重连时 VerifyImei 刚以 AT+CGSN 得到应答并确认了 IMEI，链路可用且模块未变，不再重复查询。
+    const bool verified = recovering && imeiKnown;
+    // 专用初始化指令（例如把上报固定到 AT 口）须在 AT+CNMI 之前生效。模块信息未知时，
+    // 短信设置等 AT+CGSN 确定模块（缓存未命中时还要探测）并排队专用指令之后才排队。
+    const bool deferSetup = !verified && !identity;
+    const AtCommandEngine::CompletionCallback recordImei = [this, initApplied = identity.has_value()](const AtCommandResult& result)
     {
-        _waitingSmsContent = false;
-        SmsCallback callbackCopy;
+        const auto imei = ExtractImei(result);
         {
-            std::lock_guard<std::mutex> guard(_callbackMutex);
-            callbackCopy = _smsCallback;
+            std::lock_guard<std::mutex> guard(_linkMutex);
+            if (_linkImei.empty())
+            {
+                _linkImei = imei;
+            }
         }
-        if (callbackCopy)
+        if (!imei.empty())
         {
-            callbackCopy(_lastSmsHeader, line);
+            ResolveIdentity(imei, initApplied);
+            return;
+        }
+        // 取不到 IMEI 就无从确定模块，不再等待专用指令，直接设置短信。
+        if (!initApplied && result.code != AtResultCode::Cancelled)
+        {
+            SubmitSmsSetup();
+        }
+    };
+    std::vector<std::pair<std::wstring, AtCommandEngine::CompletionCallback>> commands;
+    if (!verified)
+    {
+        commands.emplace_back(L"AT", nullptr);
+        commands.emplace_back(L"AT+CGSN", recordImei);
+    }
+    if (identity)
+    {
+        for (const auto& command : identity->initCommands)
+        {
+            commands.emplace_back(Utf8ToWide(command), nullptr);
         }
-        AppendLog(L"收到短信: " + line);
-        return;
     }
-    AppendLog(L"<-- " + normalized);
+    AtCommandHandle last;
+    for (const auto& [command, onComplete] : commands)
+    {
+        last = SubmitCommand(command, {}, {}, onComplete);
+        if (!last)
+        {
+            AppendLog(L"初始化指令发送失败: " + command);
+        }
+    }
+    if (deferSetup)
+    {
+        return last;
+    }
+    return SubmitSmsSetup();
 }
 
-void AtSession::ConfigureAfterConnect()
+AtCommandHandle AtSession::SubmitSmsSetup()
 {
-    static const std::array<std::wstring, 3> commands{
-        L"AT",
-        L"AT+CMGF=1",
-        L"AT+CNMI=2,1,0,0,0"
+    const auto profile = SmsProfileSnapshot();
+    const bool textMode = profile.textMode;
+    const bool direct = profile.receiveMode == SmsReceiveMode::Direct;
+    const AtCommandEngine::CompletionCallback recordService = [this](const AtCommandResult& result)
+    {
+        _ackRequired = result.Succeeded();
     };
-    for (const auto& command : commands)
+    const AtCommandEngine::CompletionCallback confirmDirect = [this](const AtCommandResult& result)
     {
-        if (!SendCommand(command))
+        if (result.Succeeded() || result.code == AtResultCode::Cancelled)
+        {
+            return;
+        }
+        _ackRequired = false;
+        AppendLog(L"模块不支持直接上报短信，改用存储方式接收");
+        SendCommand(L"AT+CNMI=2,1,0,0,0");
+    };
+    std::vector<std::pair<std::wstring, AtCommandEngine::CompletionCallback>> commands;
+    commands.emplace_back(textMode ? L"AT+CMGF=1" : L"AT+CMGF=0", nullptr);
+    if (direct)
+    {
+        // AT+CSMS=1 使 +CMT 须由主机确认，确认之前网络不会认为短信已送达。
+        commands.emplace_back(L"AT+CSMS=1", recordService);
+        commands.emplace_back(L"AT+CNMI=2,2,0,0,0", confirmDirect);
+    }
+    else
+    {
+        commands.emplace_back(L"AT+CNMI=2,1,0,0,0", nullptr);
+    }
+    // 由调度器逐条写出，前一条的结果码一到就发下一条，不再按固定间隔等待。
+    _ackRequired = false;
+    AtCommandHandle last;
+    for (const auto& [command, onComplete] : commands)
+    {
+        last = SubmitCommand(command, {}, {}, onComplete);
+        if (!last)
         {
             AppendLog(L"初始化指令发送失败: " + command);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(150));
     }
+    _smsFormat = textMode ? 1 : 0;
+    return last;
 }
 
-void AtSession::HandleCmtiNotification(const std::wstring& line)
+void AtSession::ResolveIdentity(const std::string& imei, bool initApplied)
 {
-    const auto comma = line.rfind(L',');
-    if (comma == std::wstring::npos)
+    std::string hardwareId;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        if (_identity && _identity->imei != imei)
+        {
+            // 没有序列号的 USB 设备，硬件标识取自插口位置，同一插口换了模块时预取的信息不属于它。
+            _identity.reset();
+            initApplied = false;
+        }
+        hardwareId = WideToUtf8(_linkHardwareId);
+    }
+    auto cached = _modemCache != nullptr ? _modemCache->Find(imei) : std::nullopt;
+    if (!cached)
     {
-        AppendLog(L"CMTI 通知格式异常: " + line);
+        ProbeIdentity(imei);
         return;
     }
-    std::wstring indexText = Trim(line.substr(comma + 1));
-    if (indexText.empty())
+    if (!hardwareId.empty() && cached->hardwareId != hardwareId)
+    {
+        cached->hardwareId = hardwareId;
+        _modemCache->Store(*cached);
+    }
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        _identity = cached;
+    }
+    if (!initApplied)
+    {
+        // 专用指令此时才排队，短信设置随后重新排队，AT+CNMI 才在其后生效。
+        SubmitInitCommands(*cached);
+        SubmitSmsSetup();
+    }
+    AppendLog(L"模块: " + Utf8ToWide(cached->manufacturer + " " + cached->model + " " + cached->revision) + L"（缓存）");
+    // 型号与固件随模块不变，SIM 卡却可能在断开期间更换，冷连接时只刷新 IMSI。
+    SubmitCommand(L"AT+CIMI", {}, {}, [this, imei](const AtCommandResult& result)
+    {
+        if (!result.Succeeded())
+        {
+            return;
+        }
+        std::optional<ModemIdentity> changed;
+        {
+            std::lock_guard<std::mutex> guard(_linkMutex);
+            const auto imsi = ExtractImsi(result);
+            if (_identity && _identity->imei == imei && _identity->imsi != imsi)
+            {
+                _identity->imsi = imsi;
+                changed = _identity;
+            }
+        }
+        if (changed && _modemCache != nullptr)
+        {
+            AppendLog(L"SIM 卡已更换，IMSI: " + Utf8ToWide(changed->imsi));
+            _modemCache->Store(*changed);
+        }
+    });
+}
+
+void AtSession::ProbeIdentity(const std::string& imei)
+{
+    // 各条依次完成，回调不会并发，共用一份结果无需加锁。
+    auto probe = std::make_shared<ModemIdentity>();
+    probe->imei = imei;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        probe->hardwareId = WideToUtf8(_linkHardwareId);
+    }
+    SubmitCommand(L"ATI", {}, {}, [probe](const AtCommandResult& result)
+    {
+        ParseAti(result, *probe);
+    });
+    SubmitCommand(L"AT+CGMM", {}, {}, [probe](const AtCommandResult& result)
+    {
+        if (auto model = FirstInfoLine(result); result.Succeeded() && !model.empty())
+        {
+            probe->model = std::move(model);
+        }
+    });
+    SubmitCommand(L"AT+CGMR", {}, {}, [probe](const AtCommandResult& result)
+    {
+        if (auto revision = FirstInfoLine(result); result.Succeeded() && !revision.empty())
+        {
+            probe->revision = std::move(revision);
+        }
+    });
+    SubmitCommand(L"AT+CIMI", {}, {}, [probe](const AtCommandResult& result)
+    {
+        probe->imsi = ExtractImsi(result);
+    });
+    SubmitCommand(L"AT+CSCS=?", {}, {}, [this, probe](const AtCommandResult& result)
     {
-        AppendLog(L"CMTI 通知缺少索引: " + line);
+        if (result.code == AtResultCode::Cancelled)
+        {
+            return;
+        }
+        probe->charsets = ParseCharsets(result);
+        probe->initCommands = VendorInitCommands(*probe);
+        probe->probedAt = static_cast<std::int64_t>(std::time(nullptr));
+        {
+            std::lock_guard<std::mutex> guard(_linkMutex);
+            _identity = *probe;
+        }
+        if (_modemCache != nullptr && !_modemCache->Store(*probe))
+        {
+            AppendLog(L"模块信息缓存写入失败");
+        }
+        SubmitInitCommands(*probe);
+        SubmitSmsSetup();
+        AppendLog(L"模块: " + Utf8ToWide(probe->manufacturer + " " + probe->model + " " + probe->revision) +
+                  L"，IMSI: " + (probe->imsi.empty() ? std::wstring(L"无") : Utf8ToWide(probe->imsi)));
+    });
+}
+
+void AtSession::SubmitInitCommands(const ModemIdentity& identity)
+{
+    for (const auto& command : identity.initCommands)
+    {
+        SendCommand(Utf8ToWide(command));
+    }
+}
+
+SmsProfile AtSession::SmsProfileSnapshot() const
+{
+    std::lock_guard<std::mutex> guard(_profileMutex);
+    return _smsProfile;
+}
+
+void AtSession::SelectSmsFormat(bool textMode)
+{
+    // 群发时每条短信都先发 AT+CMGF 会让往返次数翻倍，格式未变时省去。
+    const int format = textMode ? 1 : 0;
+    if (_smsFormat.load() != format)
+    {
+        SendCommand(textMode ? L"AT+CMGF=1" : L"AT+CMGF=0");
+        _smsFormat = format;
+    }
+}
+
+void AtSession::HandleCmtiNotification(const UrcEvent& event)
+{
+    const auto notification = ParseCmti(event.line);
+    if (!notification)
+    {
+        AppendLog(L"CMTI 通知格式异常: " + Utf8ToWide(event.line));
         return;
     }
+    const std::wstring indexText = std::to_wstring(notification->index);
     AppendLog(L"检测到新短信，读取索引 " + indexText);
-    if (!SendCommand(L"AT+CMGR=" + indexText))
     {
+        // 该位置刚存入新短信，先前记下的同一索引（已被其他途径删除）不能再删。
+        std::lock_guard<std::mutex> guard(_cleanupMutex);
+        std::erase(_pendingDeletes, notification->index);
+    }
+    ++_pendingReads;
+    const auto handle = SubmitCommand(L"AT+CMGR=" + indexText, {}, {}, [this](const AtCommandResult&)
+    {
+        --_pendingReads;
+    });
+    if (!handle)
+    {
+        --_pendingReads;
         AppendLog(L"自动读取短信失败: " + indexText);
     }
 }
 
-std::wstring AtSession::Utf8ToWide(const std::string& text)
+void AtSession::QueueStoredDeletes(std::span<const int> indices)
 {
-    if (text.empty())
+    std::lock_guard<std::mutex> guard(_cleanupMutex);
+    for (const int index : indices)
     {
-        return std::wstring();
+        if (!_deleting.contains(index) && std::find(_pendingDeletes.begin(), _pendingDeletes.end(), index) == _pendingDeletes.end())
+        {
+            if (_pendingDeletes.empty())
+            {
+                _pendingDeletesSince = std::chrono::steady_clock::now();
+            }
+            _pendingDeletes.push_back(index);
+        }
     }
-    const int needed = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
-    if (needed <= 0)
+}
+
+void AtSession::FlushStoredDeletes()
+{
+    // 攒满一批再删；不满一批时等这一阵新短信读完且已推迟够久，删除不插在连续的 AT+CMGR 之间。
+    std::vector<int> indices;
+    bool chained = true;
+    {
+        std::lock_guard<std::mutex> guard(_cleanupMutex);
+        const bool due = _pendingReads.load() == 0 && std::chrono::steady_clock::now() - _pendingDeletesSince >= kDeleteDelay;
+        if (_pendingDeletes.empty() || (_pendingDeletes.size() < kDeleteBatch && !due))
+        {
+            return;
+        }
+        indices.swap(_pendingDeletes);
+        _deleting.insert(indices.begin(), indices.end());
+        chained = _chainedDeletes;
+    }
+    std::sort(indices.begin(), indices.end());
+    const std::size_t batch = chained ? kDeleteBatch : 1;
+    for (std::size_t first = 0; first < indices.size(); first += batch)
     {
-        return std::wstring();
+        const auto last = indices.begin() + static_cast<std::ptrdiff_t>(std::min(indices.size(), first + batch));
+        SubmitDeletes(std::vector<int>(indices.begin() + static_cast<std::ptrdiff_t>(first), last));
     }
-    std::wstring buffer(static_cast<std::size_t>(needed), L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed);
-    return buffer;
 }
 
-std::string AtSession::WideToUtf8(const std::wstring& text)
+void AtSession::SubmitDeletes(std::vector<int> indices)
 {
-    if (text.empty())
+    // 多条删除以分号串联成一行，整批只有一次往返与一个结果码。
+    std::wstring command = L"AT";
+    for (std::size_t i = 0; i < indices.size(); ++i)
     {
-        return std::string();
+        command += (i == 0 ? L"+CMGD=" : L";+CMGD=") + std::to_wstring(indices[i]);
     }
-    const int needed = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
-    if (needed <= 0)
+    const auto onComplete = [this, indices](const AtCommandResult& result)
+    {
+        bool unsupported = false;
+        {
+            std::lock_guard<std::mutex> guard(_cleanupMutex);
+            for (const int index : indices)
+            {
+                _deleting.erase(index);
+            }
+            // 失败时不重发：串联的前几条可能已执行，空出的位置随时会存入新短信，重发会把它删掉。
+            // 没删掉的短信在下次列出时会再次保存并删除。
+            unsupported = indices.size() > 1 && result.code == AtResultCode::Error && _chainedDeletes;
+            if (unsupported)
+            {
+                _chainedDeletes = false;
+            }
+        }
+        if (unsupported)
+        {
+            AppendLog(L"模块不接受串联的 AT+CMGD，之后改为逐条删除");
+        }
+    };
+    if (!SubmitCommand(command, {}, {}, onComplete))
     {
-        return std::string();
+        std::lock_guard<std::mutex> guard(_cleanupMutex);
+        for (const int index : indices)
+        {
+            _deleting.erase(index);
+        }
     }
-    std::string buffer(static_cast<std::size_t>(needed), '\0');
-    WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed, nullptr, nullptr);
-    return buffer;
 }
 
 void AtSession::AppendLog(const std::wstring& line)
@@ -315,3 +1172,193 @@ void AtSession::AppendLog(const std::wstring& line)
         callbackCopy(line);
     }
 }
+
+void AtSession::LogReceived(std::string_view line)
+{
+    LogCallback callbackCopy;
+    {
+        std::lock_guard<std::mutex> guard(_callbackMutex);
+        if (!_logCallback)
+        {
+            return;
+        }
+        callbackCopy = _logCallback;
+    }
+    callbackCopy(L"<-- " + Utf8ToWide(line));
+}
+
+void AtSession::ResetLineState()
+{
+    _framer.Reset();
+    _listing.Reset();
+    _waitingUrcBody = false;
+    _readIndex = -1;
+}
+
+void AtSession::StopReconnectWorker()
+{
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        _stopReconnect = true;
+    }
+    _linkSignal.notify_all();
+    // 让正在等待 IMEI 应答的重连线程立即返回。
+    _commands.CancelAll();
+    if (_reconnectWorker.joinable())
+    {
+        _reconnectWorker.join();
+    }
+}
+
+void AtSession::ReconnectLoop()
+{
+    std::unique_lock<std::mutex> lock(_linkMutex);
+    while (true)
+    {
+        // 链路正常时定期醒来做例行清理：模块空闲、没有指令结束时，推迟的删除也要按时发出。
+        if (!_linkSignal.wait_for(lock, kHousekeepingInterval, [this]()
+        {
+            return _stopReconnect || _linkLost;
+        }))
+        {
+            lock.unlock();
+            RunHousekeeping();
+            lock.lock();
+            continue;
+        }
+        if (_stopReconnect)
+        {
+            return;
+        }
+        const auto policy = _reconnectPolicy;
+        const auto portName = _linkPortName;
+        lock.unlock();
+
+        const auto lostAt = std::chrono::steady_clock::now();
+        AppendLog(policy.enabled ? L"串口链路丢失，开始自动重连: " + portName : L"串口链路丢失: " + portName);
+        bool recovered = false;
+        int attempt = 0;
+        auto delay = policy.initialDelay;
+        while (policy.enabled && !recovered)
+        {
+            lock.lock();
+            if (_linkSignal.wait_for(lock, delay, [this]() { return _stopReconnect; }))
+            {
+                return;
+            }
+            lock.unlock();
+            ++attempt;
+            recovered = TryReconnect();
+            const auto elapsed = std::chrono::steady_clock::now() - lostAt;
+            if (!recovered && policy.giveUpAfter.count() > 0 && elapsed >= policy.giveUpAfter)
+            {
+                AppendLog(L"自动重连失败，已放弃（共尝试 " + std::to_wstring(attempt) + L" 次）");
+                break;
+            }
+            delay = std::min(delay * std::max(policy.multiplier, 1u), policy.maxDelay);
+        }
+        if (!recovered)
+        {
+            // 未启用重连或已放弃：关闭端口并清除丢失标志，回到例行清理的等待，否则会立即再次进入这里。
+            _port.Close();
+            _commands.CancelAll();
+            lock.lock();
+            _linkLost = false;
+            continue;
+        }
+        // 重新枚举后的模块恢复为上电默认状态，重放初始化指令后才算恢复。
+        if (const auto replay = ConfigureAfterConnect(true))
+        {
+            replay.Wait();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lostAt);
+        _lastRecoveryMs.store(elapsed.count());
+        AppendLog(L"串口已恢复，用时 " + std::to_wstring(elapsed.count()) + L" ms（第 " + std::to_wstring(attempt) + L" 次尝试）");
+        lock.lock();
+    }
+}
+
+void AtSession::RunHousekeeping()
+{
+    FlushStoredDeletes();
+    // 最后一段迟迟不来、之后也没有新的长短信时，Add 中的过期检查不会执行，这里按时交出。
+    std::lock_guard<std::mutex> guard(_reassemblyMutex);
+    _reassembler.Expire(SmsReassembler::Clock::now(), _messageHandler);
+}
+
+bool AtSession::TryReconnect()
+{
+    _port.Close();
+    _commands.CancelAll();
+    std::wstring portName;
+    SerialSettings settings;
+    std::wstring hardwareId;
+    {
+        // 关闭后旧链路不会再报告丢失，此后的通知都属于本次打开。
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        _linkLost = false;
+        portName = _linkPortName;
+        settings = _linkSettings;
+        hardwareId = _linkHardwareId;
+    }
+    if (!hardwareId.empty())
+    {
+        for (const auto& info : EnumerateSerialPorts())
+        {
+            if (info.hardwareId == hardwareId)
+            {
+                portName = info.name;
+                break;
+            }
+        }
+    }
+    ResetLineState();
+    if (!_port.Open(portName, settings))
+    {
+        return false;
+    }
+    if (!VerifyImei())
+    {
+        _port.Close();
+        return false;
+    }
+    bool renamed = false;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        renamed = portName != _linkPortName;
+        _linkPortName = portName;
+    }
+    if (renamed)
+    {
+        AppendLog(L"模块已重新枚举为 " + portName);
+    }
+    return true;
+}
+
+bool AtSession::VerifyImei()
+{
+    std::string expected;
+    {
+        std::lock_guard<std::mutex> guard(_linkMutex);
+        expected = _linkImei;
+    }
+    if (expected.empty())
+    {
+        return true;
+    }
+    const auto handle = SendCommand(L"AT+CGSN", kImeiProbeTimeout);
+    if (!handle)
+    {
+        return false;
+    }
+    const auto reported = ExtractImei(handle.Wait());
+    if (reported == expected)
+    {
+        return true;
+    }
+    if (!reported.empty())
+    {
+        AppendLog(L"端口 IMEI 不符，跳过: " + Utf8ToWide(reported));
+    }
+    return false;
+}
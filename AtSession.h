@@ -8,66 +8,247 @@
 ------------------------------------------------------------------------*/
 #pragma once
 
+#include "AtCommandEngine.h"
 #include "CommandConfig.h"
+#include "LineFramer.h"
+#include "ModemProfileCache.h"
 #include "SerialPort.h"
+#include "SmsListingParser.h"
+#include "SmsReassembler.h"
+#include "UrcDispatcher.h"
 
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <mutex>
+#include <optional>
+#include <set>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// <summary>链路丢失后的自动重连策略，重试间隔按指数退避。</summary>
+struct ReconnectPolicy
+{
+    bool enabled = true;
+    std::chrono::milliseconds initialDelay{250};
+    std::chrono::milliseconds maxDelay{8000};
+    unsigned multiplier = 2;
+    /// <summary>自链路丢失起超过该时长仍未恢复则放弃，0 表示一直重试。</summary>
+    std::chrono::milliseconds giveUpAfter{0};
+};
+
+/// <summary>一条短信的提交结果。</summary>
+struct SmsSubmitResult
+{
+    AtResultCode code = AtResultCode::Cancelled;
+    /// <summary>+CMS ERROR 的错误码，其他情况为 -1。</summary>
+    int errorCode = -1;
+    /// <summary>模块分配的消息参考号（+CMGS: &lt;mr&gt;），失败时为 -1。</summary>
+    int messageReference = -1;
+    /// <summary>分段数，长短信大于 1；成功时参考号为最后一段的参考号。</summary>
+    int parts = 1;
+    /// <summary>从提交到最终结果的端到端耗时，包含前置的 AT+CSCA 与 AT+CMGF。</summary>
+    std::chrono::microseconds latency{0};
+
+    bool Succeeded() const noexcept
+    {
+        return code == AtResultCode::Ok;
+    }
+};
 
 /// <summary>封装 AT 会话逻辑。</summary>
 class AtSession
 {
 public:
     using LogCallback = std::function<void(const std::wstring&)>;
-    using SmsCallback = std::function<void(const std::wstring& header, const std::wstring& content)>;
+    /// <summary>短信回调，返回 true 表示已保存（已保存过的重复短信也算）；存储方式下随后从模块中删除。</summary>
+    using SmsCallback = std::function<bool(const ReceivedSms& sms)>;
+    using SmsSubmitCallback = std::function<void(const SmsSubmitResult&)>;
 
     AtSession();
     ~AtSession();
 
+    /// <summary>由共享反应器驱动串口读写，须在 Connect 之前调用。</summary>
+    void SetReactor(SerialReactor* reactor) noexcept;
+
+    /// <summary>设置模块信息缓存，须在 Connect 之前调用；为空时每次连接都完整探测模块。</summary>
+    void SetModemCache(ModemProfileCache* cache) noexcept;
+
+    /// <summary>当前模块的型号、固件、IMSI 等信息，首次探测完成或命中缓存之前为空。</summary>
+    std::optional<ModemIdentity> GetModemIdentity() const;
+
     /// <summary>尝试连接指定串口。</summary>
+    bool Connect(const std::wstring& portName, const SerialSettings& settings);
+
+    /// <summary>以默认线路参数连接指定串口。</summary>
     bool Connect(const std::wstring& portName, unsigned long baudRate);
 
     /// <summary>断开当前连接。</summary>
     void Disconnect();
 
-    /// <summary>是否已经连接。</summary>
+    /// <summary>是否已经连接，重连期间返回 false。</summary>
     bool IsConnected() const noexcept;
 
-    /// <summary>发送一条 AT 指令。</summary>
-    bool SendCommand(const std::wstring& commandText);
+    /// <summary>设置自动重连策略，下一次链路丢失时生效。</summary>
+    void SetReconnectPolicy(const ReconnectPolicy& policy);
+
+    /// <summary>最近一次自动恢复的耗时（从链路丢失到初始化指令重放完成），尚未发生时为 0。</summary>
+    std::chrono::milliseconds GetLastRecoveryTime() const noexcept;
+
+    /// <summary>发送一条 AT 指令，返回可等待最终结果码与应答行的句柄；timeout 为零时按指令类型取默认值。</summary>
+    AtCommandHandle SendCommand(const std::wstring& commandText, std::chrono::milliseconds timeout = {});
 
-    /// <summary>发送短信内容。</summary>
+    /// <summary>
+    /// 提交一条后台指令（例如定时查询信号）：只在没有在途与排队指令时受理，否则立即以 NotSent 完成；
+    /// 指令与应答不写日志。onComplete 在串口分发线程、超时线程或调用线程上执行。
+    /// </summary>
+    AtCommandHandle SubmitBackgroundCommand(const std::wstring& commandText, std::chrono::milliseconds timeout,
+                                            AtCommandEngine::CompletionCallback onComplete);
+
+    /// <summary>向短信配置中的目标号码发送短信，立即返回是否已受理；结果写入日志。</summary>
     bool SendSms(const std::wstring& smsContent);
 
+    /// <summary>提交一条短信：默认以 PDU 模式编码（中文用 UCS2，超长自动分段），等模块给出 "> " 提示符再写正文；
+    /// 结果含消息参考号与耗时。不阻塞；onComplete 在结果就绪时于串口分发线程上调用，可从任意线程提交。</summary>
+    std::future<SmsSubmitResult> SubmitSms(const std::wstring& number, const std::wstring& text, SmsSubmitCallback onComplete = {});
+
     /// <summary>配置短信参数。</summary>
     void SetSmsProfile(const SmsProfile& profile);
 
     /// <summary>注册日志回调。</summary>
     void SetLogCallback(LogCallback callback);
 
-    /// <summary>注册短信接收回调。</summary>
+    /// <summary>
+    /// 注册短信接收回调；PDU 模式下长短信拼接后整条交出。
+    /// 通常在串口分发线程上调用；等待超时的长短信由重连线程的例行清理交出，断开时未收齐的由调用 Disconnect 的线程交出。
+    /// 同一时刻只有一个线程在调用（拼接器加锁），但回调不能假定固定在某个线程上，也不可在其中调用 Disconnect。
+    /// </summary>
     void SetSmsCallback(SmsCallback callback);
 
+    /// <summary>设置长短信拼接缓存的限量，下一段到达时生效。</summary>
+    void SetSmsReassemblyPolicy(const SmsReassemblyPolicy& policy);
+
+    /// <summary>获取长短信拼接统计，含超时与挤出的条数。</summary>
+    SmsReassemblyStatistics GetSmsReassemblyStatistics() const;
+
+    /// <summary>获取串口接收统计。</summary>
+    SerialStatistics GetSerialStatistics() const noexcept;
+
+    /// <summary>主动上报分发器，可按类型订阅 +CREG、RING 等上报；回调在串口分发线程上执行。</summary>
+    UrcDispatcher& GetUrcDispatcher() noexcept;
+
 private:
     void AttachCallbacks();
-    void HandleIncoming(const std::string& chunk);
-    void ProcessLine(const std::wstring& line);
-    void ConfigureAfterConnect();
-    void HandleCmtiNotification(const std::wstring& line);
-    static std::wstring Utf8ToWide(const std::string& text);
-    static std::string WideToUtf8(const std::wstring& text);
+    /// <summary>记录日志后交给调度器；payload 为收到 "> " 提示符后写出的正文。</summary>
+    AtCommandHandle SubmitCommand(const std::wstring& commandText, std::string payload, std::chrono::milliseconds timeout,
+                                  AtCommandEngine::CompletionCallback onComplete);
+    void HandleIncoming(std::string_view chunk);
+    void HandleFrame(const LineFrame& frame);
+    /// <summary>
+    /// 排队初始化指令，返回最后一条的句柄，它完成即表示初始化结束。
+    /// 自动重连时 IMEI 已由 VerifyImei 确认，省去 AT 与 AT+CGSN；模块信息已知时先执行其专用初始化指令再设置短信。
+    /// 模块信息未知时短信设置在确定模块之后才排队，返回的句柄只到 AT+CGSN。
+    /// </summary>
+    AtCommandHandle ConfigureAfterConnect(bool recovering = false);
+    /// <summary>
+    /// 取得 IMEI 后按缓存确定模块信息，未命中时排队探测指令；initApplied 表示专用初始化指令与短信设置已经排队，
+    /// 否则在专用初始化指令之后排队短信设置。
+    /// </summary>
+    void ResolveIdentity(const std::string& imei, bool initApplied);
+    /// <summary>依次查询 ATI、AT+CGMM、AT+CGMR、AT+CIMI 与 AT+CSCS=?，完成后写入缓存，执行专用初始化指令并设置短信。</summary>
+    void ProbeIdentity(const std::string& imei);
+    void SubmitInitCommands(const ModemIdentity& identity);
+    /// <summary>按短信设置排队 AT+CMGF、AT+CSMS 与 AT+CNMI，返回最后一条的句柄。</summary>
+    AtCommandHandle SubmitSmsSetup();
+    SmsProfile SmsProfileSnapshot() const;
+    /// <summary>模块当前的短信格式与所需不同时才发送 AT+CMGF。</summary>
+    void SelectSmsFormat(bool textMode);
+    void HandleCmtiNotification(const UrcEvent& event);
+    /// <summary>记下已保存、可从模块存储中删除的索引，已在删除中的跳过。</summary>
+    void QueueStoredDeletes(std::span<const int> indices);
+    /// <summary>攒满一批，或没有在途的 AT+CMGR 且最早一项已推迟够久时，以分号串联的 AT+CMGD 删除已保存的短信；每条指令结束时与例行清理中调用。</summary>
+    void FlushStoredDeletes();
+    void SubmitDeletes(std::vector<int> indices);
+    /// <summary>整理收到的一条短信交给拼接器；PDU 模式下先解码并改写为文本模式的头部。</summary>
+    void DeliverSms(std::string_view headerLine, const SmsHeaderResponse& header, std::string_view content);
+    /// <summary>把一条完整（或已放弃等待其余段）的短信交给短信回调并记录日志。</summary>
+    void EmitSms(const ReceivedSms& sms);
     void AppendLog(const std::wstring& line);
+    /// <summary>以 "<-- " 记录收到的一行；没有日志回调时直接返回，不转码也不分配。</summary>
+    void LogReceived(std::string_view line);
+    void ResetLineState();
+    void StopReconnectWorker();
+    /// <summary>重连线程：等待链路丢失通知并按策略重试，链路正常时每隔一段时间调用 RunHousekeeping。</summary>
+    void ReconnectLoop();
+    /// <summary>在重连线程上执行的例行清理：发出已推迟够久的删除，交出等待超时的长短信。</summary>
+    void RunHousekeeping();
+    /// <summary>重新定位设备并打开，确认 IMEI 与原模块一致。</summary>
+    bool TryReconnect();
+    /// <summary>查询 IMEI 并与首次连接时记录的值比较，未记录时直接通过。</summary>
+    bool VerifyImei();
 
 private:
     SerialPort _port;
+    AtCommandEngine _commands;
+    mutable std::mutex _profileMutex;
     SmsProfile _smsProfile;
     LogCallback _logCallback;
     SmsCallback _smsCallback;
     std::mutex _callbackMutex;
-    std::string _lineBuffer;
-    std::wstring _lastSmsHeader;
-    bool _waitingSmsContent;
-    std::deque<std::wstring> _pendingEchoes;
+    LineFramer _framer;
+    LineFramer::FrameHandler _frameHandler;
+    UrcDispatcher _urcs;
+    /// <summary>+CMGL 列表与 +CMGR 应答的流式解析器，只在分发线程上使用。</summary>
+    SmsListingParser _listing;
+    SmsListingParser::RecordHandler _recordHandler;
+    /// <summary>长短信拼接器，在分发线程上交入，断开时清空；回调在持锁期间执行。</summary>
+    mutable std::mutex _reassemblyMutex;
+    SmsReassembler _reassembler;
+    SmsReassembler::MessageHandler _messageHandler;
+    /// <summary>最近的 +CMT 头部（UTF-8），交付正文时才转码。</summary>
+    std::string _lastSmsHeader;
+    /// <summary>刚收到 +CMT 上报，下一行是不属于任何指令的短信正文。</summary>
+    bool _waitingUrcBody;
+    /// <summary>当前 +CMGR 应答对应的存储索引，取自在途的 AT+CMGR=&lt;index&gt;，未知时为 -1；只在分发线程上使用。</summary>
+    int _readIndex;
+    /// <summary>初始化时 AT+CSMS=1 与 AT+CNMI=2,2 都已成功，每条 +CMT 都须以 AT+CNMA 确认。</summary>
+    std::atomic<bool> _ackRequired;
+    /// <summary>因 +CMTI 发出、尚未完成的 AT+CMGR 条数，归零即一阵新短信已读完。</summary>
+    std::atomic<int> _pendingReads;
+    std::mutex _cleanupMutex;
+    /// <summary>已保存、待删除的存储索引。</summary>
+    std::vector<int> _pendingDeletes;
+    /// <summary>待删除列表中最早一项加入的时间。</summary>
+    std::chrono::steady_clock::time_point _pendingDeletesSince;
+    /// <summary>已排队或在途的 AT+CMGD 所删的索引，期间再次列出同一条不会重复删除。</summary>
+    std::set<int> _deleting;
+    /// <summary>模块接受以分号串联的多条 AT+CMGD，串联失败一次后改为逐条删除。</summary>
+    bool _chainedDeletes;
+    /// <summary>长短信 UDH 中的参考号，每条长短信递增。</summary>
+    std::atomic<unsigned> _nextConcatReference;
+    /// <summary>最近一次设置的短信格式：0 为 PDU，1 为文本，-1 为未知（断开或执行了可能改变格式的指令）。</summary>
+    std::atomic<int> _smsFormat;
+
+    mutable std::mutex _linkMutex;
+    std::condition_variable _linkSignal;
+    ReconnectPolicy _reconnectPolicy;
+    /// <summary>当前会话的端口名与线路参数，为空表示未连接。</summary>
+    std::wstring _linkPortName;
+    SerialSettings _linkSettings;
+    /// <summary>连接时记录的 USB 硬件标识，设备重新枚举成其他端口名后据此找回。</summary>
+    std::wstring _linkHardwareId;
+    /// <summary>首次连接时模块报告的 IMEI。</summary>
+    std::string _linkImei;
+    /// <summary>当前模块的信息，连接时按 USB 硬件标识预取，取得 IMEI 后确认。</summary>
+    std::optional<ModemIdentity> _identity;
+    ModemProfileCache* _modemCache;
+    bool _linkLost;
+    bool _stopReconnect;
+    std::thread _reconnectWorker;
+    std::atomic<std::int64_t> _lastRecoveryMs;
 };
@@ -0,0 +1,456 @@
+/*------------------------------------------------------------------------
+名称：短信群发引擎实现
+说明：实现任务日志、速率控制、流水线提交与失败重试
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：日志为 UTF-8 文本，每行一条记录，字段以制表符分隔：
+      "+ id 号码 正文" 为新任务，"= id 参考号" 为已发送，"! id 结果码 错误码" 为最终失败
+------------------------------------------------------------------------*/
+#include "BulkSmsEngine.h"
+#include "TextEncoding.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iterator>
+#include <map>
+#include <string_view>
+#include <system_error>
+
+namespace
+{
+    /// <summary>AT+CMMS=1 下模块在两条短信之间至少保持链路的时长（TS 27.005 为 1 到 5 秒），空闲更久时重新开启。</summary>
+    constexpr auto kLinkHoldTime = std::chrono::seconds(1);
+    /// <summary>等待重连时检查链路的间隔。</summary>
+    constexpr auto kLinkPollInterval = std::chrono::milliseconds(500);
+    constexpr auto kProgressInterval = std::chrono::seconds(1);
+    constexpr auto kRateWindow = std::chrono::minutes(1);
+
+    /// <summary>转义制表符、换行与反斜杠，保证一条记录只占一行。</summary>
+    std::string EscapeField(std::string_view text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char ch : text)
+        {
+            switch (ch)
+            {
+            case '\\':
+                escaped.append("\\\\");
+                break;
+            case '\t':
+                escaped.append("\\t");
+                break;
+            case '\n':
+                escaped.append("\\n");
+                break;
+            case '\r':
+                escaped.append("\\r");
+                break;
+            default:
+                escaped.push_back(ch);
+                break;
+            }
+        }
+        return escaped;
+    }
+
+    std::string UnescapeField(std::string_view text)
+    {
+        std::string plain;
+        plain.reserve(text.size());
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] != '\\' || i + 1 == text.size())
+            {
+                plain.push_back(text[i]);
+                continue;
+            }
+            switch (text[++i])
+            {
+            case 't':
+                plain.push_back('\t');
+                break;
+            case 'n':
+                plain.push_back('\n');
+                break;
+            case 'r':
+                plain.push_back('\r');
+                break;
+            default:
+                plain.push_back(text[i]);
+                break;
+            }
+        }
+        return plain;
+    }
+
+    /// <summary>按制表符拆分一条记录，返回字段数（至多 fields.size()，多余内容并入最后一个字段）。</summary>
+    std::size_t SplitRecord(std::string_view line, std::array<std::string_view, 4>& fields)
+    {
+        std::size_t count = 0;
+        while (count + 1 < fields.size())
+        {
+            const auto tab = line.find('\t');
+            if (tab == std::string_view::npos)
+            {
+                break;
+            }
+            fields[count++] = line.substr(0, tab);
+            line.remove_prefix(tab + 1);
+        }
+        fields[count++] = line;
+        return count;
+    }
+
+    bool ParseId(std::string_view text, std::uint64_t& id)
+    {
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), id);
+        return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    std::string NewJobRecord(std::uint64_t id, const std::wstring& recipient, const std::wstring& body)
+    {
+        return "+\t" + std::to_string(id) + '\t' + EscapeField(WideToUtf8(recipient)) + '\t' + EscapeField(WideToUtf8(body)) + '\n';
+    }
+}
+
+BulkSmsEngine::BulkSmsEngine(AtSession& session)
+    : _session(session), _inFlight(0), _sent(0), _failed(0), _uncertain(0), _retried(0), _nextId(1), _stopping(false)
+{
+}
+
+BulkSmsEngine::~BulkSmsEngine()
+{
+    Close();
+}
+
+bool BulkSmsEngine::Open(const std::filesystem::path& journalPath)
+{
+    if (_worker.joinable())
+    {
+        return _journal.is_open();
+    }
+    // 回放日志：新任务记录之后没有结果记录的即为未完成的任务，按编号顺序恢复。
+    std::map<std::uint64_t, Job> pending;
+    std::uint64_t lastId = 0;
+    {
+        std::ifstream input(journalPath, std::ios::binary);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            std::array<std::string_view, 4> fields{};
+            const auto count = SplitRecord(line, fields);
+            std::uint64_t id = 0;
+            if (count < 2 || !ParseId(fields[1], id))
+            {
+                continue;
+            }
+            lastId = std::max(lastId, id);
+            if (fields[0] == "+" && count == 4)
+            {
+                Job job;
+                job.id = id;
+                job.recipient = Utf8ToWide(UnescapeField(fields[2]));
+                job.body = Utf8ToWide(UnescapeField(fields[3]));
+                pending[id] = std::move(job);
+            }
+            else if (fields[0] == "=" || fields[0] == "!")
+            {
+                pending.erase(id);
+            }
+        }
+    }
+    // 只保留未完成的任务重写日志，已完成的记录不再随重启累积。
+    auto compacted = journalPath;
+    compacted += L".tmp";
+    {
+        std::ofstream output(compacted, std::ios::binary | std::ios::trunc);
+        for (const auto& [id, job] : pending)
+        {
+            output << NewJobRecord(id, job.recipient, job.body);
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(compacted, journalPath, error);
+
+    std::lock_guard<std::mutex> guard(_mutex);
+    _journalPath = journalPath;
+    _journal.open(journalPath, std::ios::binary | std::ios::app);
+    for (auto& [id, job] : pending)
+    {
+        _ready.push_back(std::move(job));
+    }
+    _nextId = lastId + 1;
+    _stopping = false;
+    _worker = std::thread(&BulkSmsEngine::WorkerLoop, this);
+    return _journal.is_open() && !error;
+}
+
+void BulkSmsEngine::Close()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (!_worker.joinable())
+        {
+            return;
+        }
+        _stopping = true;
+    }
+    _signal.notify_all();
+    _worker.join();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _signal.wait(lock, [this]()
+    {
+        return _inFlight == 0;
+    });
+    // 未完成的任务已在日志中，下次 Open 时恢复。
+    _ready.clear();
+    _retries.clear();
+    _journal.close();
+}
+
+void BulkSmsEngine::SetPolicy(const BulkSmsPolicy& policy)
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _policy = policy;
+        _nextSubmitAt = Clock::time_point{};
+    }
+    _signal.notify_all();
+}
+
+void BulkSmsEngine::SetProgressCallback(ProgressCallback callback)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _progressCallback = std::move(callback);
+}
+
+std::size_t BulkSmsEngine::Enqueue(const std::vector<BulkSmsJob>& jobs)
+{
+    std::size_t accepted = 0;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        for (const auto& request : jobs)
+        {
+            if (request.recipient.empty() || request.body.empty())
+            {
+                continue;
+            }
+            Job job;
+            job.id = _nextId++;
+            job.recipient = request.recipient;
+            job.body = request.body;
+            WriteJournal(NewJobRecord(job.id, job.recipient, job.body));
+            _ready.push_back(std::move(job));
+            ++accepted;
+        }
+        // 先落盘再发送：进程在发送中途退出时，重启后从日志恢复。
+        _journal.flush();
+    }
+    _signal.notify_all();
+    return accepted;
+}
+
+BulkSmsStatistics BulkSmsEngine::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return StatisticsLocked(Clock::now());
+}
+
+void BulkSmsEngine::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        const auto now = Clock::now();
+        const auto nextRetry = PromoteRetries(now);
+        if (_ready.empty() || _inFlight >= std::max(1u, _policy.pipelineDepth))
+        {
+            if (nextRetry == Clock::time_point::max())
+            {
+                _signal.wait(lock);
+            }
+            else
+            {
+                _signal.wait_until(lock, nextRetry);
+            }
+            continue;
+        }
+        if (!_session.IsConnected())
+        {
+            _signal.wait_for(lock, kLinkPollInterval);
+            continue;
+        }
+        if (now < _nextSubmitAt)
+        {
+            _signal.wait_until(lock, _nextSubmitAt);
+            continue;
+        }
+        Job job = std::move(_ready.front());
+        _ready.pop_front();
+        ++job.attempts;
+        // 空闲超过链路保持时长后模块已关闭链路，新一轮发送前重新开启。
+        const bool burstStart = _inFlight == 0 && now - _lastActivityAt > kLinkHoldTime;
+        PruneCompletions(now);
+        if (_completions.empty())
+        {
+            _burstStartedAt = now;
+        }
+        ++_inFlight;
+        _lastActivityAt = now;
+        if (_policy.messagesPerMinute != 0)
+        {
+            _nextSubmitAt = now + std::chrono::duration_cast<Clock::duration>(kRateWindow) / _policy.messagesPerMinute;
+        }
+        const bool openLink = burstStart && _policy.keepLinkOpen;
+        lock.unlock();
+        if (openLink)
+        {
+            _session.SendCommand(L"AT+CMMS=1");
+        }
+        const std::wstring recipient = job.recipient;
+        const std::wstring body = job.body;
+        _session.SubmitSms(recipient, body, [this, job = std::move(job)](const SmsSubmitResult& result)
+        {
+            OnResult(job, result);
+        });
+        lock.lock();
+    }
+}
+
+void BulkSmsEngine::OnResult(Job job, const SmsSubmitResult& result)
+{
+    ProgressCallback callback;
+    BulkSmsStatistics statistics;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        --_inFlight;
+        const auto now = Clock::now();
+        _lastActivityAt = now;
+        if (result.Succeeded())
+        {
+            // 结果记录写入前进程退出时，重启后这条会再发一次：宁可重发，不可漏发。
+            ++_sent;
+            PruneCompletions(now);
+            _completions.push_back(now);
+            WriteJournal("=\t" + std::to_string(job.id) + '\t' + std::to_string(result.messageReference) + '\n');
+        }
+        else if (result.code == AtResultCode::Cancelled || (result.code == AtResultCode::NotSent && !_session.IsConnected()))
+        {
+            // 链路断开不计入尝试次数，恢复后排在队首继续。
+            --job.attempts;
+            _ready.push_front(std::move(job));
+        }
+        else if (result.code == AtResultCode::CmsError && job.attempts < std::max(1u, _policy.maxAttempts))
+        {
+            // 只有 +CMS ERROR 明确表示网络没有接受这条短信，重发不会让对方收到两次。
+            ++_retried;
+            job.readyAt = now + _policy.retryDelay * job.attempts;
+            _retries.push_back(std::move(job));
+        }
+        else
+        {
+            // 超时时正文可能已经发出，是否送达无从得知，按失败记录而不重发；ERROR 等其他结果重发也无济于事。
+            if (result.code == AtResultCode::Timeout)
+            {
+                ++_uncertain;
+            }
+            ++_failed;
+            WriteJournal("!\t" + std::to_string(job.id) + '\t' + std::to_string(static_cast<int>(result.code)) + '\t'
+                + std::to_string(result.errorCode) + '\n');
+        }
+        _journal.flush();
+        const bool drained = _ready.empty() && _retries.empty() && _inFlight == 0;
+        if (drained)
+        {
+            ResetJournal();
+        }
+        if (_progressCallback && (drained || now - _lastProgressAt >= kProgressInterval))
+        {
+            _lastProgressAt = now;
+            callback = _progressCallback;
+            statistics = StatisticsLocked(now);
+        }
+    }
+    _signal.notify_all();
+    if (callback)
+    {
+        callback(statistics);
+    }
+}
+
+BulkSmsEngine::Clock::time_point BulkSmsEngine::PromoteRetries(Clock::time_point now)
+{
+    auto next = Clock::time_point::max();
+    auto due = std::stable_partition(_retries.begin(), _retries.end(), [now](const Job& job)
+    {
+        return job.readyAt > now;
+    });
+    for (auto it = due; it != _retries.end(); ++it)
+    {
+        _ready.push_back(std::move(*it));
+    }
+    _retries.erase(due, _retries.end());
+    for (const auto& job : _retries)
+    {
+        next = std::min(next, job.readyAt);
+    }
+    return next;
+}
+
+void BulkSmsEngine::PruneCompletions(Clock::time_point now)
+{
+    while (!_completions.empty() && now - _completions.front() > kRateWindow)
+    {
+        _completions.pop_front();
+    }
+}
+
+BulkSmsStatistics BulkSmsEngine::StatisticsLocked(Clock::time_point now) const
+{
+    const auto recent = std::find_if(_completions.begin(), _completions.end(), [now](Clock::time_point completedAt)
+    {
+        return now - completedAt <= kRateWindow;
+    });
+    const auto count = static_cast<double>(std::distance(recent, _completions.end()));
+    BulkSmsStatistics statistics;
+    statistics.pending = _ready.size() + _retries.size();
+    statistics.inFlight = _inFlight;
+    statistics.sent = _sent;
+    statistics.failed = _failed;
+    statistics.uncertain = _uncertain;
+    statistics.retried = _retried;
+    if (count > 0)
+    {
+        // 不足一分钟时按实际发送时长折算，避免刚开始时速率偏低。
+        const auto elapsed = std::clamp<Clock::duration>(now - _burstStartedAt, std::chrono::seconds(1), kRateWindow);
+        statistics.messagesPerMinute = count * 60.0 / std::chrono::duration<double>(elapsed).count();
+    }
+    return statistics;
+}
+
+void BulkSmsEngine::WriteJournal(const std::string& record)
+{
+    if (_journal.is_open())
+    {
+        _journal.write(record.data(), static_cast<std::streamsize>(record.size()));
+    }
+}
+
+void BulkSmsEngine::ResetJournal()
+{
+    if (!_journal.is_open())
+    {
+        return;
+    }
+    _journal.close();
+    _journal.open(_journalPath, std::ios::binary | std::ios::trunc);
+    _journal.close();
+    _journal.open(_journalPath, std::ios::binary | std::ios::app);
+}
@@ -0,0 +1,141 @@
+/*------------------------------------------------------------------------
+名称：短信群发引擎
+说明：按队列向多个号码发送短信，控制速率、失败重试，并把任务记入日志文件以便重启后继续
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：每个模块（AtSession）一个实例；提交与结果处理不占用界面线程
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtSession.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>一条群发任务。</summary>
+struct BulkSmsJob
+{
+    std::wstring recipient;
+    std::wstring body;
+};
+
+/// <summary>群发的速率与重试策略。</summary>
+struct BulkSmsPolicy
+{
+    /// <summary>每分钟最多提交的短信条数，0 表示不限，按 +CMGS 结果返回的速度发送。</summary>
+    unsigned messagesPerMinute = 0;
+    /// <summary>每条任务最多尝试的次数（含首次），只有 +CMS ERROR 会重试；超时可能已经发出，不重试。</summary>
+    unsigned maxAttempts = 3;
+    /// <summary>第 n 次重试前等待 n 倍该时长。</summary>
+    std::chrono::milliseconds retryDelay{5000};
+    /// <summary>同时交给调度器的短信条数，大于 1 时下一条在上一条结果返回前已排队，模块不空等。</summary>
+    unsigned pipelineDepth = 2;
+    /// <summary>连续发送时先发 AT+CMMS=1，让模块在两条短信之间保持短信链路。</summary>
+    bool keepLinkOpen = true;
+};
+
+/// <summary>群发进度。</summary>
+struct BulkSmsStatistics
+{
+    /// <summary>尚未提交或等待重试的任务数。</summary>
+    std::size_t pending = 0;
+    std::size_t inFlight = 0;
+    std::size_t sent = 0;
+    /// <summary>用尽重试次数或不可重试而放弃的任务数。</summary>
+    std::size_t failed = 0;
+    /// <summary>其中因超时而无法确定是否已发出的条数。</summary>
+    std::size_t uncertain = 0;
+    std::size_t retried = 0;
+    /// <summary>最近一分钟的成功条数折算的每分钟速率。</summary>
+    double messagesPerMinute = 0.0;
+};
+
+/// <summary>短信群发队列：任务先写入日志再排队，发送成功或最终失败后记录结果。</summary>
+class BulkSmsEngine
+{
+public:
+    using ProgressCallback = std::function<void(const BulkSmsStatistics&)>;
+
+    explicit BulkSmsEngine(AtSession& session);
+    ~BulkSmsEngine();
+
+    BulkSmsEngine(const BulkSmsEngine&) = delete;
+    BulkSmsEngine& operator=(const BulkSmsEngine&) = delete;
+
+    /// <summary>
+    /// 打开任务日志，恢复上次未完成的任务并启动发送线程。
+    /// 日志无法打开时仍会启动，但任务只保存在内存中，返回 false。
+    /// </summary>
+    bool Open(const std::filesystem::path& journalPath);
+
+    /// <summary>停止发送线程并等待已提交的短信返回结果；应在会话断开之后调用，未完成的任务留在日志中。</summary>
+    void Close();
+
+    void SetPolicy(const BulkSmsPolicy& policy);
+
+    /// <summary>进度回调，发送过程中至多每秒一次，队列发完时再调用一次；在串口分发线程上执行。</summary>
+    void SetProgressCallback(ProgressCallback callback);
+
+    /// <summary>追加任务，号码或正文为空的任务被忽略，返回受理条数。</summary>
+    std::size_t Enqueue(const std::vector<BulkSmsJob>& jobs);
+
+    BulkSmsStatistics GetStatistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job
+    {
+        std::uint64_t id = 0;
+        std::wstring recipient;
+        std::wstring body;
+        unsigned attempts = 0;
+        Clock::time_point readyAt{};
+    };
+
+    void WorkerLoop();
+    void OnResult(Job job, const SmsSubmitResult& result);
+    /// <summary>把到期的重试任务移回待发队列，返回下一个重试的到期时间。</summary>
+    Clock::time_point PromoteRetries(Clock::time_point now);
+    void PruneCompletions(Clock::time_point now);
+    BulkSmsStatistics StatisticsLocked(Clock::time_point now) const;
+    void WriteJournal(const std::string& record);
+    /// <summary>队列发完后清空日志，避免文件随群发次数增长。</summary>
+    void ResetJournal();
+
+private:
+    AtSession& _session;
+    mutable std::mutex _mutex;
+    std::condition_variable _signal;
+    BulkSmsPolicy _policy;
+    ProgressCallback _progressCallback;
+    std::deque<Job> _ready;
+    std::vector<Job> _retries;
+    std::size_t _inFlight;
+    std::size_t _sent;
+    std::size_t _failed;
+    std::size_t _uncertain;
+    std::size_t _retried;
+    std::uint64_t _nextId;
+    /// <summary>最近一分钟内各条成功结果的时间，用于计算速率。</summary>
+    std::deque<Clock::time_point> _completions;
+    Clock::time_point _burstStartedAt;
+    Clock::time_point _lastActivityAt;
+    Clock::time_point _nextSubmitAt;
+    Clock::time_point _lastProgressAt;
+    std::filesystem::path _journalPath;
+    std::ofstream _journal;
+    bool _stopping;
+    std::thread _worker;
+};
@@ -7,12 +7,14 @@
 备注：无
 ------------------------------------------------------------------------*/
 #include "CommandConfig.h"
+#include "TextEncoding.h"
 
 #include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <cwchar>
 #include <cwctype>
-#include <windows.h>
 
 namespace
 {
@@ -30,34 +32,6 @@ namespace
         return value.substr(start, end - start);
     }
 
-    std::wstring Utf8ToWide(const std::string& text)
-    {
-        if(text.empty()) {
-            return std::wstring();
-        }
-        const int needed = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
-        if(needed <= 0) {
-            return std::wstring();
-        }
-        std::wstring buffer(static_cast<std::size_t>(needed), L'\0');
-        MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed);
-        return buffer;
-    }
-
-    std::string WideToUtf8(const std::wstring& text)
-    {
-        if(text.empty()) {
-            return std::string();
-        }
-        const int needed = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
-        if(needed <= 0) {
-            return std::string();
-        }
-        std::string buffer(static_cast<std::size_t>(needed), '\0');
-        WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed, nullptr, nullptr);
-        return buffer;
-    }
-
     bool ExtractAttribute(const std::wstring& node, const std::wstring& attribute, std::wstring& value)
     {
         const std::wstring token = attribute + L"=\"";
@@ -74,6 +48,142 @@ namespace
         return true;
     }
 
+    bool ExtractUnsigned(const std::wstring& node, const std::wstring& attribute, unsigned long& value)
+    {
+        std::wstring text;
+        if(!ExtractAttribute(node, attribute, text) || text.empty()) {
+            return false;
+        }
+        wchar_t* end = nullptr;
+        const unsigned long parsed = std::wcstoul(text.c_str(), &end, 10);
+        if(end == text.c_str() || *end != L'\0') {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    const wchar_t* ParityToText(SerialParity parity)
+    {
+        switch(parity) {
+            case SerialParity::Odd:
+                return L"odd";
+            case SerialParity::Even:
+                return L"even";
+            case SerialParity::Mark:
+                return L"mark";
+            case SerialParity::Space:
+                return L"space";
+            default:
+                return L"none";
+        }
+    }
+
+    SerialParity ParityFromText(const std::wstring& text)
+    {
+        if(text == L"odd") {
+            return SerialParity::Odd;
+        }
+        if(text == L"even") {
+            return SerialParity::Even;
+        }
+        if(text == L"mark") {
+            return SerialParity::Mark;
+        }
+        if(text == L"space") {
+            return SerialParity::Space;
+        }
+        return SerialParity::None;
+    }
+
+    const wchar_t* StopBitsToText(SerialStopBits stopBits)
+    {
+        switch(stopBits) {
+            case SerialStopBits::OnePointFive:
+                return L"1.5";
+            case SerialStopBits::Two:
+                return L"2";
+            default:
+                return L"1";
+        }
+    }
+
+    SerialStopBits StopBitsFromText(const std::wstring& text)
+    {
+        if(text == L"1.5") {
+            return SerialStopBits::OnePointFive;
+        }
+        if(text == L"2") {
+            return SerialStopBits::Two;
+        }
+        return SerialStopBits::One;
+    }
+
+    const wchar_t* FlowControlToText(FlowControl flowControl)
+    {
+        switch(flowControl) {
+            case FlowControl::RtsCts:
+                return L"rtscts";
+            case FlowControl::XonXoff:
+                return L"xonxoff";
+            default:
+                return L"none";
+        }
+    }
+
+    FlowControl FlowControlFromText(const std::wstring& text)
+    {
+        if(text == L"rtscts") {
+            return FlowControl::RtsCts;
+        }
+        if(text == L"xonxoff") {
+            return FlowControl::XonXoff;
+        }
+        return FlowControl::None;
+    }
+
+    // 默认脚本，同时作为脚本写法的示例；保存时按原文写回，缩进与 Serialize 一致。
+    const wchar_t* const kDefaultScripts[] = {
+        L"<script name=\"网络检查\" summary=\"确认 SIM 卡就绪并等待注册网络\">\n"
+        L"      <send text=\"AT+CPIN?\" capture=\"pin\" />\n"
+        L"      <if var=\"pin\" ne=\"READY\" goto=\"noSim\" />\n"
+        L"      <label name=\"poll\" />\n"
+        L"      <send text=\"AT+CEREG?\" capture=\"stat\" field=\"1\" />\n"
+        L"      <if var=\"stat\" eq=\"1\" goto=\"registered\" />\n"
+        L"      <if var=\"stat\" eq=\"5\" goto=\"registered\" />\n"
+        L"      <sleep ms=\"2000\" />\n"
+        L"      <loop goto=\"poll\" times=\"30\" />\n"
+        L"      <fail message=\"60 秒内未注册网络，最后状态 ${stat}\" />\n"
+        L"      <label name=\"registered\" />\n"
+        L"      <send text=\"AT+CSQ\" capture=\"rssi\" field=\"0\" />\n"
+        L"      <log text=\"已注册网络，信号 ${rssi}\" />\n"
+        L"      <end />\n"
+        L"      <label name=\"noSim\" />\n"
+        L"      <fail message=\"SIM 卡未就绪: ${pin}\" />\n"
+        L"    </script>",
+        L"<script name=\"APN 设置\" summary=\"设置上下文 1 的 APN 并附着分组域\">\n"
+        L"      <set var=\"apn\" value=\"cmnet\" />\n"
+        L"      <send text=\"AT+CGDCONT=1,&quot;IP&quot;,&quot;${apn}&quot;\" />\n"
+        L"      <send text=\"AT+CGATT=1\" timeout=\"75000\" />\n"
+        L"      <send text=\"AT+CGATT?\" capture=\"attached\" field=\"0\" />\n"
+        L"      <if var=\"attached\" ne=\"1\" goto=\"detached\" />\n"
+        L"      <log text=\"APN 已设为 ${apn}，分组域已附着\" />\n"
+        L"      <end />\n"
+        L"      <label name=\"detached\" />\n"
+        L"      <fail message=\"分组域未附着\" />\n"
+        L"    </script>",
+        L"<script name=\"短信自检\" summary=\"给本机号码发一条短信并等待收到（存储接收方式）\">\n"
+        L"      <send text=\"AT+CNUM\" capture=\"self\" field=\"1\" onError=\"noNumber\" />\n"
+        L"      <if var=\"self\" eq=\"\" goto=\"noNumber\" />\n"
+        L"      <sms to=\"${self}\" text=\"AT Helper 短信自检\" />\n"
+        L"      <wait urc=\"+CMTI\" timeout=\"60000\" capture=\"index\" field=\"1\" />\n"
+        L"      <log text=\"自检短信已收到，存储位置 ${index}\" />\n"
+        L"      <end />\n"
+        L"      <label name=\"noNumber\" />\n"
+        L"      <fail message=\"AT+CNUM 未返回本机号码，可把第一条改为 set var=&quot;self&quot;\" />\n"
+        L"    </script>",
+    };
+
     std::wstring UnescapeXml(const std::wstring& value)
     {
         std::wstring result;
@@ -179,6 +289,46 @@ void CommandConfig::SetTheme(ThemeMode mode) noexcept
     _theme = mode;
 }
 
+SerialSettings CommandConfig::GetPortSettings(const std::wstring& portName) const
+{
+    const auto found = _portSettings.find(portName);
+    if(found == _portSettings.end()) {
+        return SerialSettings{};
+    }
+    return found->second;
+}
+
+void CommandConfig::SetPortSettings(const std::wstring& portName, const SerialSettings& settings)
+{
+    _portSettings[portName] = settings;
+}
+
+const std::vector<std::shared_ptr<const AtScript>>& CommandConfig::GetScripts() const noexcept
+{
+    return _scripts;
+}
+
+const std::vector<std::wstring>& CommandConfig::GetScriptErrors() const noexcept
+{
+    return _scriptErrors;
+}
+
+void CommandConfig::SetScriptSources(std::vector<std::wstring> sources)
+{
+    // 脚本只在加载时编译一次，执行时不再解析文本。
+    _scripts.clear();
+    _scriptErrors.clear();
+    for(const auto& source : sources) {
+        std::wstring error;
+        if(auto script = AtScript::Compile(source, error)) {
+            _scripts.push_back(std::move(script));
+        } else {
+            _scriptErrors.push_back(std::move(error));
+        }
+    }
+    _scriptSources = std::move(sources);
+}
+
 void CommandConfig::EnsureDefaults()
 {
     _commands = {
@@ -196,12 +346,20 @@ void CommandConfig::EnsureDefaults()
     };
     _smsProfile.targetNumber.clear();
     _smsProfile.serviceCenter.clear();
+    _smsProfile.textMode = false;
+    _smsProfile.bulkRatePerMinute = 0;
+    _smsProfile.bulkMaxAttempts = 3;
+    _smsProfile.receiveMode = SmsReceiveMode::Storage;
+    _smsProfile.deleteAfterSave = true;
     _theme = ThemeMode::Light;
+    _portSettings.clear();
+    SetScriptSources(std::vector<std::wstring>(std::begin(kDefaultScripts), std::end(kDefaultScripts)));
 }
 
 bool CommandConfig::Parse(const std::wstring& xmlText)
 {
     std::vector<CommandItem> parsedCommands;
+    std::map<std::wstring, SerialSettings> parsedPorts;
     SmsProfile parsedProfile = _smsProfile;
     ThemeMode parsedTheme = _theme;
 
@@ -218,6 +376,26 @@ bool CommandConfig::Parse(const std::wstring& xmlText)
             if(ExtractAttribute(node, L"serviceCenter", service) && !service.empty()) {
                 parsedProfile.serviceCenter = UnescapeXml(service);
             }
+            std::wstring smsMode;
+            if(ExtractAttribute(node, L"smsMode", smsMode) && !smsMode.empty()) {
+                parsedProfile.textMode = smsMode == L"text";
+            }
+            unsigned long smsRate = 0;
+            if(ExtractUnsigned(node, L"smsRate", smsRate)) {
+                parsedProfile.bulkRatePerMinute = static_cast<unsigned>(smsRate);
+            }
+            unsigned long smsRetries = 0;
+            if(ExtractUnsigned(node, L"smsRetries", smsRetries) && smsRetries > 0) {
+                parsedProfile.bulkMaxAttempts = static_cast<unsigned>(smsRetries);
+            }
+            std::wstring smsReceive;
+            if(ExtractAttribute(node, L"smsReceive", smsReceive) && !smsReceive.empty()) {
+                parsedProfile.receiveMode = smsReceive == L"direct" ? SmsReceiveMode::Direct : SmsReceiveMode::Storage;
+            }
+            std::wstring smsCleanup;
+            if(ExtractAttribute(node, L"smsCleanup", smsCleanup) && !smsCleanup.empty()) {
+                parsedProfile.deleteAfterSave = smsCleanup != L"off";
+            }
             std::wstring themeAttr;
             if(ExtractAttribute(node, L"theme", themeAttr) && !themeAttr.empty()) {
                 std::wstring lowered = themeAttr;
@@ -259,9 +437,88 @@ bool CommandConfig::Parse(const std::wstring& xmlText)
         parsedCommands.push_back(std::move(item));
     }
 
+    search = 0;
+    while(true) {
+        const auto start = xmlText.find(L"<port ", search);
+        if(start == std::wstring::npos) {
+            break;
+        }
+        const auto end = xmlText.find(L"/>", start);
+        if(end == std::wstring::npos) {
+            break;
+        }
+        const auto node = xmlText.substr(start, end - start + 2);
+        search = end + 2;
+
+        std::wstring nameAttr;
+        if(!ExtractAttribute(node, L"name", nameAttr) || nameAttr.empty()) {
+            continue;
+        }
+        SerialSettings settings{};
+        unsigned long number = 0;
+        if(ExtractUnsigned(node, L"baud", number) && number > 0) {
+            settings.baudRate = number;
+        }
+        if(ExtractUnsigned(node, L"dataBits", number) && number >= 5 && number <= 8) {
+            settings.dataBits = static_cast<unsigned char>(number);
+        }
+        if(ExtractUnsigned(node, L"rxQueue", number) && number > 0) {
+            settings.rxQueueSize = number;
+        }
+        if(ExtractUnsigned(node, L"txQueue", number) && number > 0) {
+            settings.txQueueSize = number;
+        }
+        if(ExtractUnsigned(node, L"readChunk", number) && number > 0) {
+            settings.readChunkSize = number;
+        }
+        if(ExtractUnsigned(node, L"ringCapacity", number) && number > 0) {
+            settings.ringCapacity = number;
+        }
+        std::wstring textAttr;
+        if(ExtractAttribute(node, L"parity", textAttr)) {
+            settings.parity = ParityFromText(textAttr);
+        }
+        if(ExtractAttribute(node, L"stopBits", textAttr)) {
+            settings.stopBits = StopBitsFromText(textAttr);
+        }
+        if(ExtractAttribute(node, L"flowControl", textAttr)) {
+            settings.flowControl = FlowControlFromText(textAttr);
+        }
+        if(ExtractAttribute(node, L"overrun", textAttr)) {
+            settings.overrunPolicy = textAttr == L"block" ? OverrunPolicy::Block : OverrunPolicy::DropNewest;
+        }
+        parsedPorts[UnescapeXml(nameAttr)] = settings;
+    }
+
+    // 脚本含有子元素，整段 <script>…</script> 交给 AtScript 编译；"<scripts>" 本身不是脚本。
+    const bool hasScripts = xmlText.find(L"<scripts") != std::wstring::npos;
+    std::vector<std::wstring> parsedScripts;
+    search = 0;
+    while(true) {
+        const auto start = xmlText.find(L"<script", search);
+        if(start == std::wstring::npos) {
+            break;
+        }
+        search = start + 7;
+        if(search >= xmlText.size() || (std::iswspace(static_cast<wint_t>(xmlText[search])) == 0 && xmlText[search] != L'>')) {
+            continue;
+        }
+        const auto end = xmlText.find(L"</script>", start);
+        if(end == std::wstring::npos) {
+            break;
+        }
+        parsedScripts.push_back(xmlText.substr(start, end + 9 - start));
+        search = end + 9;
+    }
+
     if(!parsedCommands.empty()) {
         _commands = std::move(parsedCommands);
     }
+    _portSettings = std::move(parsedPorts);
+    // 没有 <scripts> 节的旧配置保留默认脚本，下次保存时写入。
+    if(hasScripts) {
+        SetScriptSources(std::move(parsedScripts));
+    }
     _smsProfile = parsedProfile;
     _theme = parsedTheme;
     return true;
@@ -280,13 +537,50 @@ std::wstring CommandConfig::Serialize() const
     if(!_smsProfile.serviceCenter.empty()) {
         stream << L" serviceCenter=\"" << EscapeXml(_smsProfile.serviceCenter) << L"\"";
     }
+    if(_smsProfile.textMode) {
+        stream << L" smsMode=\"text\"";
+    }
+    if(_smsProfile.bulkRatePerMinute != 0) {
+        stream << L" smsRate=\"" << _smsProfile.bulkRatePerMinute << L"\"";
+    }
+    if(_smsProfile.bulkMaxAttempts != 3) {
+        stream << L" smsRetries=\"" << _smsProfile.bulkMaxAttempts << L"\"";
+    }
+    if(_smsProfile.receiveMode == SmsReceiveMode::Direct) {
+        stream << L" smsReceive=\"direct\"";
+    }
+    if(!_smsProfile.deleteAfterSave) {
+        stream << L" smsCleanup=\"off\"";
+    }
     stream << L" />\n";
+    if(!_portSettings.empty()) {
+        stream << L"  <ports>\n";
+        for(const auto& [name, settings] : _portSettings) {
+            stream << L"    <port name=\"" << EscapeXml(name) << L"\""
+                << L" baud=\"" << settings.baudRate << L"\""
+                << L" dataBits=\"" << static_cast<unsigned int>(settings.dataBits) << L"\""
+                << L" parity=\"" << ParityToText(settings.parity) << L"\""
+                << L" stopBits=\"" << StopBitsToText(settings.stopBits) << L"\""
+                << L" flowControl=\"" << FlowControlToText(settings.flowControl) << L"\""
+                << L" rxQueue=\"" << settings.rxQueueSize << L"\""
+                << L" txQueue=\"" << settings.txQueueSize << L"\""
+                << L" readChunk=\"" << settings.readChunkSize << L"\""
+                << L" ringCapacity=\"" << settings.ringCapacity << L"\""
+                << L" overrun=\"" << (settings.overrunPolicy == OverrunPolicy::Block ? L"block" : L"drop") << L"\" />\n";
+        }
+        stream << L"  </ports>\n";
+    }
     stream << L"  <commands>\n";
     for(const auto& cmd : _commands) {
         stream << L"    <command text=\"" << EscapeXml(cmd.text)
             << L"\" summary=\"" << EscapeXml(cmd.summary) << L"\" />\n";
     }
     stream << L"  </commands>\n";
+    stream << L"  <scripts>\n";
+    for(const auto& source : _scriptSources) {
+        stream << L"    " << source << L"\n";
+    }
+    stream << L"  </scripts>\n";
     stream << L"</atHelper>\n";
     return stream.str();
 }
@@ -8,7 +8,12 @@
 ------------------------------------------------------------------------*/
 #pragma once
 
+#include "AtScript.h"
+#include "SerialSettings.h"
+
 #include <filesystem>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -19,11 +24,29 @@ struct CommandItem
     std::wstring summary;
 };
 
+/// <summary>新短信的接收方式。</summary>
+enum class SmsReceiveMode
+{
+    /// <summary>AT+CNMI=2,1：模块存储短信并上报 +CMTI，再以 AT+CMGR 读取。</summary>
+    Storage,
+    /// <summary>AT+CNMI=2,2：模块以 +CMT 直接上报内容、不占存储，支持 AT+CSMS=1 时逐条以 AT+CNMA 确认。</summary>
+    Direct
+};
+
 /// <summary>短信目标号码等配置。</summary>
 struct SmsProfile
 {
     std::wstring targetNumber;
     std::wstring serviceCenter;
+    /// <summary>为真时以文本模式（AT+CMGF=1）收发短信，默认使用 PDU 模式，中文与长短信都能正确发送。</summary>
+    bool textMode = false;
+    /// <summary>群发时每分钟最多提交的条数，0 表示不限。</summary>
+    unsigned bulkRatePerMinute = 0;
+    /// <summary>群发时每条短信最多尝试的次数。</summary>
+    unsigned bulkMaxAttempts = 3;
+    SmsReceiveMode receiveMode = SmsReceiveMode::Storage;
+    /// <summary>从模块存储读到的短信保存成功后成批删除，避免存储写满后收不到新短信。</summary>
+    bool deleteAfterSave = true;
 };
 
 /// <summary>界面主题选项。</summary>
@@ -63,8 +86,22 @@ public:
     /// <summary>设置主题。</summary>
     void SetTheme(ThemeMode mode) noexcept;
 
+    /// <summary>获取指定端口的串口参数，未保存过时返回默认值。</summary>
+    SerialSettings GetPortSettings(const std::wstring& portName) const;
+
+    /// <summary>保存指定端口的串口参数。</summary>
+    void SetPortSettings(const std::wstring& portName, const SerialSettings& settings);
+
+    /// <summary>获取加载时编译成功的脚本，按配置中的顺序；重新加载不影响正在执行的脚本。</summary>
+    const std::vector<std::shared_ptr<const AtScript>>& GetScripts() const noexcept;
+
+    /// <summary>获取编译失败的脚本说明；失败的脚本不可执行，但保存时仍原样写回。</summary>
+    const std::vector<std::wstring>& GetScriptErrors() const noexcept;
+
 private:
     void EnsureDefaults();
+    /// <summary>编译全部 &lt;script&gt; 元素，替换当前脚本。</summary>
+    void SetScriptSources(std::vector<std::wstring> sources);
     bool Parse(const std::wstring& xmlText);
     std::wstring Serialize() const;
     static std::wstring EscapeXml(const std::wstring& value);
@@ -73,4 +110,8 @@ private:
     std::vector<CommandItem> _commands;
     SmsProfile _smsProfile;
     ThemeMode _theme;
+    std::map<std::wstring, SerialSettings> _portSettings;
+    std::vector<std::wstring> _scriptSources;
+    std::vector<std::shared_ptr<const AtScript>> _scripts;
+    std::vector<std::wstring> _scriptErrors;
 };
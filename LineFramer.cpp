@@ -0,0 +1,132 @@
+/*------------------------------------------------------------------------
+名称：行分帧器实现
+说明：实现结束符查找与残行拼接
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：支持 SSE2 的目标上每次比较 16 字节，其余平台逐字节查找
+------------------------------------------------------------------------*/
+#include "LineFramer.h"
+
+#include <bit>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_FRAMER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr std::string_view kPrompt = "> ";
+
+    /// <summary>返回 [first, last) 中第一个 CR 或 LF 的位置，没有时返回 last。</summary>
+    const char* FindLineEnd(const char* first, const char* last) noexcept
+    {
+#ifdef LINE_FRAMER_SSE2
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        const __m128i lineFeed = _mm_set1_epi8('\n');
+        while (last - first >= 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(block, carriageReturn), _mm_cmpeq_epi8(block, lineFeed));
+            const auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+            if (mask != 0)
+            {
+                return first + std::countr_zero(mask);
+            }
+            first += 16;
+        }
+#endif
+        while (first != last && *first != '\r' && *first != '\n')
+        {
+            ++first;
+        }
+        return first;
+    }
+}
+
+LineFramer::LineFramer(std::size_t maxLineLength)
+    : _maxLineLength(maxLineLength), _skipLineFeed(false)
+{
+}
+
+void LineFramer::SetPromptPredicate(PromptPredicate expected)
+{
+    _promptExpected = std::move(expected);
+}
+
+void LineFramer::Feed(std::string_view chunk, const FrameHandler& handler)
+{
+    const char* cursor = chunk.data();
+    const char* const end = cursor + chunk.size();
+    while (cursor != end)
+    {
+        if (_skipLineFeed)
+        {
+            _skipLineFeed = false;
+            if (*cursor == '\n')
+            {
+                ++cursor;
+                continue;
+            }
+        }
+        // 提示符只出现在行首，即上一个结束符之后尚未缓存任何字节；可能被拆在两个块里。
+        if (_partial.empty() && end - cursor >= 2 && std::string_view(cursor, 2) == kPrompt && PromptExpected())
+        {
+            handler(LineFrame{FrameKind::Prompt, kPrompt});
+            cursor += 2;
+            continue;
+        }
+        if (_partial == kPrompt.substr(0, 1) && *cursor == kPrompt[1] && PromptExpected())
+        {
+            _partial.clear();
+            handler(LineFrame{FrameKind::Prompt, kPrompt});
+            ++cursor;
+            continue;
+        }
+
+        const char* lineEnd = FindLineEnd(cursor, end);
+        if (lineEnd == end)
+        {
+            _partial.append(cursor, end);
+            if (_partial.size() >= _maxLineLength)
+            {
+                handler(LineFrame{FrameKind::Line, _partial});
+                _partial.clear();
+            }
+            break;
+        }
+
+        std::string_view line(cursor, static_cast<std::size_t>(lineEnd - cursor));
+        if (!_partial.empty())
+        {
+            _partial.append(line);
+            line = _partial;
+        }
+        if (!line.empty())
+        {
+            handler(LineFrame{FrameKind::Line, line});
+        }
+        // clear 保留容量，残行缓冲在稳定后不再分配。
+        _partial.clear();
+        _skipLineFeed = *lineEnd == '\r';
+        cursor = lineEnd + 1;
+    }
+}
+
+void LineFramer::Reset() noexcept
+{
+    _partial.clear();
+    _skipLineFeed = false;
+}
+
+std::size_t LineFramer::PendingBytes() const noexcept
+{
+    return _partial.size();
+}
+
+bool LineFramer::PromptExpected() const
+{
+    return !_promptExpected || _promptExpected();
+}
@@ -0,0 +1,67 @@
+/*------------------------------------------------------------------------
+名称：行分帧器
+说明：把串口字节流切分为 AT 应答行与短信输入提示符
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：单次扫描，行内容以视图交出；仅跨块的残行会被拷贝
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/// <summary>分帧结果的类型。</summary>
+enum class FrameKind
+{
+    /// <summary>以 CR、LF 或 CRLF 结束的非空行，不含结束符。</summary>
+    Line,
+    /// <summary>行首的 "> "，AT+CMGS 等待输入正文时发出，后面没有换行；仅在期待提示符时识别。</summary>
+    Prompt
+};
+
+/// <summary>一帧数据，视图仅在回调期间有效。</summary>
+struct LineFrame
+{
+    FrameKind kind;
+    std::string_view text;
+};
+
+/// <summary>流式行分帧器，非线程安全，由单个分发线程驱动。</summary>
+class LineFramer
+{
+public:
+    using FrameHandler = std::function<void(const LineFrame& frame)>;
+    /// <summary>询问当前是否期待提示符，仅在行首遇到 '>' 时调用。</summary>
+    using PromptPredicate = std::function<bool()>;
+
+    /// <summary>maxLineLength 为单行上限，超过后按已收到部分强制成行，防止无结束符的数据无限堆积。</summary>
+    explicit LineFramer(std::size_t maxLineLength = 64 * 1024);
+
+    /// <summary>
+    /// 设置提示符判定，例如仅在有待写正文的指令在途时返回 true；此时列表正文中以 "> " 开头的行按普通行交出。
+    /// 未设置时行首的 "> " 总是视为提示符。
+    /// </summary>
+    void SetPromptPredicate(PromptPredicate expected);
+
+    /// <summary>处理一段字节，按顺序回调其中完整的帧。</summary>
+    void Feed(std::string_view chunk, const FrameHandler& handler);
+
+    /// <summary>丢弃残行与状态，例如重新连接之后。</summary>
+    void Reset() noexcept;
+
+    /// <summary>尚未成行的字节数。</summary>
+    std::size_t PendingBytes() const noexcept;
+
+private:
+    bool PromptExpected() const;
+
+private:
+    std::string _partial;
+    PromptPredicate _promptExpected;
+    std::size_t _maxLineLength;
+    /// <summary>上一行以 CR 结束，紧随其后的 LF 属于同一个结束符。</summary>
+    bool _skipLineFeed;
+};
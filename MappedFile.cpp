@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------
+名称：内存映射文件实现
+说明：封装 Windows 与 POSIX 的文件映射接口
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：Windows 下映射存在时无法改变文件长度，扩展前先解除映射
+------------------------------------------------------------------------*/
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() noexcept
+#ifdef _WIN32
+    : _file(INVALID_HANDLE_VALUE), _mapping(nullptr),
+#else
+    : _file(-1),
+#endif
+      _data(nullptr), _size(0), _writable(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : MappedFile()
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+#ifdef _WIN32
+        _file = std::exchange(other._file, INVALID_HANDLE_VALUE);
+        _mapping = std::exchange(other._mapping, nullptr);
+#else
+        _file = std::exchange(other._file, -1);
+#endif
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _writable = std::exchange(other._writable, false);
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::filesystem::path& path, bool writable)
+{
+    Close();
+    _writable = writable;
+#ifdef _WIN32
+    _file = CreateFileW(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                        nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(_file, &size))
+    {
+        Close();
+        return false;
+    }
+    _size = static_cast<std::uint64_t>(size.QuadPart);
+#else
+    _file = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (_file < 0)
+    {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(_file, &info) != 0)
+    {
+        Close();
+        return false;
+    }
+    _size = static_cast<std::uint64_t>(info.st_size);
+#endif
+    if (!Map())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Resize(std::uint64_t size)
+{
+    if (!IsOpen() || !_writable)
+    {
+        return false;
+    }
+    Unmap();
+#ifdef _WIN32
+    LARGE_INTEGER position{};
+    position.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(_file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(_file))
+    {
+        Map();
+        return false;
+    }
+#else
+    if (::ftruncate(_file, static_cast<off_t>(size)) != 0)
+    {
+        Map();
+        return false;
+    }
+#endif
+    _size = size;
+    return Map();
+}
+
+bool MappedFile::Flush()
+{
+    if (_data == nullptr || !_writable)
+    {
+        return true;
+    }
+#ifdef _WIN32
+    return FlushViewOfFile(_data, 0) != FALSE && FlushFileBuffers(_file) != FALSE;
+#else
+    return ::msync(_data, static_cast<std::size_t>(_size), MS_SYNC) == 0;
+#endif
+}
+
+void MappedFile::Close() noexcept
+{
+    Unmap();
+#ifdef _WIN32
+    if (_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (_file >= 0)
+    {
+        ::close(_file);
+        _file = -1;
+    }
+#endif
+    _size = 0;
+}
+
+bool MappedFile::IsOpen() const noexcept
+{
+#ifdef _WIN32
+    return _file != INVALID_HANDLE_VALUE;
+#else
+    return _file >= 0;
+#endif
+}
+
+char* MappedFile::Data() noexcept
+{
+    return _data;
+}
+
+const char* MappedFile::Data() const noexcept
+{
+    return _data;
+}
+
+std::uint64_t MappedFile::Size() const noexcept
+{
+    return _size;
+}
+
+bool MappedFile::Map()
+{
+    if (_size == 0)
+    {
+        return true;
+    }
+#ifdef _WIN32
+    _mapping = CreateFileMappingW(_file, nullptr, _writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping == nullptr)
+    {
+        return false;
+    }
+    _data = static_cast<char*>(MapViewOfFile(_mapping, _writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+        return false;
+    }
+#else
+    void* address = ::mmap(nullptr, static_cast<std::size_t>(_size), _writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, _file, 0);
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+    _data = static_cast<char*>(address);
+#endif
+    return true;
+}
+
+void MappedFile::Unmap() noexcept
+{
+#ifdef _WIN32
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping != nullptr)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+#else
+    if (_data != nullptr)
+    {
+        ::munmap(_data, static_cast<std::size_t>(_size));
+    }
+#endif
+    _data = nullptr;
+}
@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------
+名称：内存映射文件
+说明：把整个文件映射到进程地址空间，可写映射支持扩展文件长度
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：Windows 使用 CreateFileMapping，其他平台使用 mmap；扩展后映射地址可能改变
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+/// <summary>整文件映射，非线程安全；Resize 或 Close 之后先前取得的指针失效。</summary>
+class MappedFile
+{
+public:
+    MappedFile() noexcept;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// <summary>打开并映射文件；writable 为 true 时文件不存在则创建。空文件只打开不映射，Data 为空。</summary>
+    bool Open(const std::filesystem::path& path, bool writable);
+
+    /// <summary>改变文件长度并重新映射，仅限可写打开。</summary>
+    bool Resize(std::uint64_t size);
+
+    /// <summary>把映射中已修改的页写回文件。</summary>
+    bool Flush();
+
+    void Close() noexcept;
+
+    bool IsOpen() const noexcept;
+    char* Data() noexcept;
+    const char* Data() const noexcept;
+    std::uint64_t Size() const noexcept;
+
+private:
+    bool Map();
+    void Unmap() noexcept;
+
+private:
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _file;
+#endif
+    char* _data;
+    std::uint64_t _size;
+    bool _writable;
+};
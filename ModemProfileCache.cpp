@@ -0,0 +1,243 @@
+/*------------------------------------------------------------------------
+名称：模块信息缓存实现
+说明：读写按节组织的缓存文件，并按厂商生成初始化指令
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无法识别的行忽略；缺少 IMEI 的节丢弃
+------------------------------------------------------------------------*/
+#include "ModemProfileCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+    bool ContainsNoCase(std::string_view text, std::string_view upperNeedle)
+    {
+        return std::search(text.begin(), text.end(), upperNeedle.begin(), upperNeedle.end(), [](char actual, char expected)
+        {
+            return std::toupper(static_cast<unsigned char>(actual)) == expected;
+        }) != text.end();
+    }
+
+    /// <summary>值中的换行会破坏行格式，替换为空格。</summary>
+    std::string SingleLine(std::string_view value)
+    {
+        std::string line(value);
+        std::replace_if(line.begin(), line.end(), [](char ch)
+        {
+            return ch == '\r' || ch == '\n';
+        }, ' ');
+        return line;
+    }
+
+    std::vector<std::string> SplitList(std::string_view text)
+    {
+        std::vector<std::string> items;
+        while (!text.empty())
+        {
+            const auto comma = text.find(',');
+            if (const auto item = text.substr(0, comma); !item.empty())
+            {
+                items.emplace_back(item);
+            }
+            if (comma == std::string_view::npos)
+            {
+                break;
+            }
+            text.remove_prefix(comma + 1);
+        }
+        return items;
+    }
+}
+
+std::vector<std::string> VendorInitCommands(const ModemIdentity& identity)
+{
+    std::vector<std::string> commands;
+    if (ContainsNoCase(identity.manufacturer, "QUECTEL"))
+    {
+        // Quectel 默认把 +CMTI 等上报发到 USB 调制解调口，改到 AT 口才能收到。
+        commands.emplace_back("AT+QURCCFG=\"urcport\",\"usbat\"");
+    }
+    else if (ContainsNoCase(identity.manufacturer, "HUAWEI"))
+    {
+        // 关闭 ^RSSI、^BOOT 等周期性上报，日志与分发器不被淹没。
+        commands.emplace_back("AT^CURC=0");
+    }
+    return commands;
+}
+
+bool ModemProfileCache::Open(const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _path = path;
+    _entries.clear();
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        std::error_code error;
+        return !std::filesystem::exists(path, error);
+    }
+    std::optional<ModemIdentity> current;
+    const auto commit = [this, &current]()
+    {
+        if (current && !current->imei.empty())
+        {
+            _entries[current->imei] = std::move(*current);
+        }
+        current.reset();
+    };
+    std::string line;
+    while (std::getline(input, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.size() >= 2 && line.front() == '[' && line.back() == ']')
+        {
+            commit();
+            current.emplace();
+            current->imei = line.substr(1, line.size() - 2);
+            continue;
+        }
+        const auto equals = line.find('=');
+        if (!current || equals == std::string::npos)
+        {
+            continue;
+        }
+        const std::string_view key = std::string_view(line).substr(0, equals);
+        std::string value = line.substr(equals + 1);
+        if (key == "imsi")
+        {
+            current->imsi = std::move(value);
+        }
+        else if (key == "manufacturer")
+        {
+            current->manufacturer = std::move(value);
+        }
+        else if (key == "model")
+        {
+            current->model = std::move(value);
+        }
+        else if (key == "revision")
+        {
+            current->revision = std::move(value);
+        }
+        else if (key == "charsets")
+        {
+            current->charsets = SplitList(value);
+        }
+        else if (key == "hardware")
+        {
+            current->hardwareId = std::move(value);
+        }
+        else if (key == "init")
+        {
+            if (!value.empty())
+            {
+                current->initCommands.push_back(std::move(value));
+            }
+        }
+        else if (key == "probed")
+        {
+            current->probedAt = std::strtoll(value.c_str(), nullptr, 10);
+        }
+    }
+    commit();
+    return true;
+}
+
+std::optional<ModemIdentity> ModemProfileCache::Find(std::string_view imei) const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    const auto found = _entries.find(imei);
+    if (found == _entries.end())
+    {
+        return std::nullopt;
+    }
+    return found->second;
+}
+
+std::optional<ModemIdentity> ModemProfileCache::FindByHardwareId(std::string_view hardwareId) const
+{
+    if (hardwareId.empty())
+    {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (const auto& [imei, identity] : _entries)
+    {
+        if (identity.hardwareId == hardwareId)
+        {
+            return identity;
+        }
+    }
+    return std::nullopt;
+}
+
+bool ModemProfileCache::Store(const ModemIdentity& identity)
+{
+    if (identity.imei.empty())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(_mutex);
+    _entries[identity.imei] = identity;
+    return SaveLocked();
+}
+
+std::size_t ModemProfileCache::Size() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _entries.size();
+}
+
+bool ModemProfileCache::SaveLocked() const
+{
+    if (_path.empty())
+    {
+        return false;
+    }
+    auto temporary = _path;
+    temporary += L".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        if (!output)
+        {
+            return false;
+        }
+        for (const auto& [imei, identity] : _entries)
+        {
+            output << '[' << SingleLine(imei) << "]\n";
+            output << "manufacturer=" << SingleLine(identity.manufacturer) << '\n';
+            output << "model=" << SingleLine(identity.model) << '\n';
+            output << "revision=" << SingleLine(identity.revision) << '\n';
+            output << "imsi=" << SingleLine(identity.imsi) << '\n';
+            std::string charsets;
+            for (const auto& charset : identity.charsets)
+            {
+                charsets.append(charsets.empty() ? "" : ",").append(charset);
+            }
+            output << "charsets=" << SingleLine(charsets) << '\n';
+            output << "hardware=" << SingleLine(identity.hardwareId) << '\n';
+            for (const auto& command : identity.initCommands)
+            {
+                output << "init=" << SingleLine(command) << '\n';
+            }
+            output << "probed=" << identity.probedAt << "\n\n";
+        }
+        output.flush();
+        if (!output)
+        {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, _path, error);
+    return !error;
+}
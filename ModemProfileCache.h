@@ -0,0 +1,66 @@
+/*------------------------------------------------------------------------
+名称：模块信息缓存
+说明：按 IMEI 保存模块的型号、固件、IMSI、字符集与专用初始化指令，重连时免去重复查询
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：缓存文件为 UTF-8 文本，每个模块一节，可手工编辑 init 行增删该模块的初始化指令
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>模块的身份与能力，字段为 UTF-8。</summary>
+struct ModemIdentity
+{
+    std::string imei;
+    /// <summary>SIM 卡的 IMSI，未插卡或查询失败时为空。</summary>
+    std::string imsi;
+    std::string manufacturer;
+    std::string model;
+    std::string revision;
+    /// <summary>AT+CSCS=? 报告的字符集。</summary>
+    std::vector<std::string> charsets;
+    /// <summary>USB 硬件标识，虚拟模块或未知时为空。</summary>
+    std::string hardwareId;
+    /// <summary>每次连接时执行的模块专用指令；首次探测时按厂商生成。</summary>
+    std::vector<std::string> initCommands;
+    /// <summary>首次探测的时间（Unix 秒）。</summary>
+    std::int64_t probedAt = 0;
+};
+
+/// <summary>按厂商生成模块专用的初始化指令，例如把主动上报固定到 AT 口。</summary>
+std::vector<std::string> VendorInitCommands(const ModemIdentity& identity);
+
+/// <summary>模块信息缓存，线程安全；每次写入都整体重写文件（先写临时文件再替换）。</summary>
+class ModemProfileCache
+{
+public:
+    /// <summary>读取缓存文件，文件不存在时为空缓存并返回 true。</summary>
+    bool Open(const std::filesystem::path& path);
+
+    std::optional<ModemIdentity> Find(std::string_view imei) const;
+    std::optional<ModemIdentity> FindByHardwareId(std::string_view hardwareId) const;
+
+    /// <summary>按 IMEI 新增或覆盖一项并写回文件。</summary>
+    bool Store(const ModemIdentity& identity);
+
+    std::size_t Size() const;
+
+private:
+    bool SaveLocked() const;
+
+private:
+    mutable std::mutex _mutex;
+    std::filesystem::path _path;
+    std::map<std::string, ModemIdentity, std::less<>> _entries;
+};
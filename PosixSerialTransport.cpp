@@ -0,0 +1,453 @@
+/*------------------------------------------------------------------------
+名称：POSIX 串口传输实现
+说明：实现 termios 原始模式配置、epoll 等待与非阻塞读写
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：Linux 下通过 termios2/BOTHER 支持任意波特率
+------------------------------------------------------------------------*/
+#ifndef _WIN32
+
+#include "PosixSerialTransport.h"
+#include "TextEncoding.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <asm/termbits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+    void CloseDescriptor(int& fd)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    int CreateCancelDescriptor()
+    {
+        return ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    void SignalCancelDescriptor(int fd)
+    {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] const auto written = ::write(fd, &value, sizeof(value));
+    }
+
+    void DrainCancelDescriptor(int fd)
+    {
+        std::uint64_t value = 0;
+        [[maybe_unused]] const auto consumed = ::read(fd, &value, sizeof(value));
+    }
+
+    /// <summary>USB 转串口被拔出后读写返回 EIO/ENXIO/ENODEV。</summary>
+    TransportStatus FailureStatus(int error)
+    {
+        return error == EIO || error == ENXIO || error == ENODEV ? TransportStatus::Disconnected : TransportStatus::Error;
+    }
+
+    bool IsSerialDeviceName(const std::string& name)
+    {
+        return name.rfind("ttyUSB", 0) == 0 || name.rfind("ttyACM", 0) == 0;
+    }
+}
+
+std::unique_ptr<SerialTransport> CreateSerialTransport()
+{
+    return std::make_unique<PosixSerialTransport>();
+}
+
+std::vector<SerialPortInfo> EnumerateSerialPorts()
+{
+    namespace fs = std::filesystem;
+    std::vector<SerialPortInfo> ports;
+    std::error_code error;
+    // by-id 链接名包含厂商、型号、USB 序列号和接口号，设备重新枚举成其他 ttyUSBn 后仍不变。
+    for (const auto& entry : fs::directory_iterator("/dev/serial/by-id", error))
+    {
+        const auto target = fs::canonical(entry.path(), error);
+        if (!error)
+        {
+            ports.push_back(SerialPortInfo{Utf8ToWide(target.filename().string()), Utf8ToWide(entry.path().filename().string())});
+        }
+    }
+    for (const auto& entry : fs::directory_iterator("/dev", error))
+    {
+        const auto name = entry.path().filename().string();
+        const auto wideName = Utf8ToWide(name);
+        const bool known = std::any_of(ports.begin(), ports.end(), [&wideName](const SerialPortInfo& port)
+        {
+            return port.name == wideName;
+        });
+        if (IsSerialDeviceName(name) && !known)
+        {
+            ports.push_back(SerialPortInfo{wideName, {}});
+        }
+    }
+    std::sort(ports.begin(), ports.end(), [](const SerialPortInfo& left, const SerialPortInfo& right)
+    {
+        return left.name < right.name;
+    });
+    return ports;
+}
+
+PosixSerialTransport::PosixSerialTransport()
+    : _fd(-1), _epollFd(-1), _cancelFd(CreateCancelDescriptor()), _reactorFd(-1), _reactorKey(0)
+{
+}
+
+PosixSerialTransport::~PosixSerialTransport()
+{
+    Close();
+    CloseDescriptor(_cancelFd);
+}
+
+std::string PosixSerialTransport::ResolveDevicePath(const std::wstring& portName)
+{
+    std::string path = WideToUtf8(portName);
+    if (!path.empty() && path.front() != '/')
+    {
+        path = "/dev/" + path;
+    }
+    return path;
+}
+
+bool PosixSerialTransport::Open(const std::wstring& portName, const SerialSettings& settings)
+{
+    Close();
+    if (_cancelFd < 0)
+    {
+        return false;
+    }
+    DrainCancelDescriptor(_cancelFd);
+
+    const std::string path = ResolveDevicePath(portName);
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (!Configure(fd, settings))
+    {
+        CloseDescriptor(fd);
+        return false;
+    }
+
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        CloseDescriptor(fd);
+        return false;
+    }
+    epoll_event deviceEvent{};
+    deviceEvent.events = EPOLLIN;
+    deviceEvent.data.fd = fd;
+    epoll_event cancelEvent{};
+    cancelEvent.events = EPOLLIN;
+    cancelEvent.data.fd = _cancelFd;
+    if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &deviceEvent) != 0 || ::epoll_ctl(epollFd, EPOLL_CTL_ADD, _cancelFd, &cancelEvent) != 0)
+    {
+        CloseDescriptor(epollFd);
+        CloseDescriptor(fd);
+        return false;
+    }
+
+    ::ioctl(fd, TCFLSH, TCIOFLUSH);
+    int modemLines = settings.flowControl == FlowControl::RtsCts ? TIOCM_DTR : TIOCM_DTR | TIOCM_RTS;
+    ::ioctl(fd, TIOCMBIS, &modemLines);
+
+    _epollFd = epollFd;
+    _fd.store(fd);
+    return true;
+}
+
+void PosixSerialTransport::Close()
+{
+    DetachReactor();
+    std::lock_guard<std::mutex> guard(_writeMutex);
+    int fd = _fd.exchange(-1);
+    CloseDescriptor(_epollFd);
+    CloseDescriptor(fd);
+}
+
+bool PosixSerialTransport::IsOpen() const noexcept
+{
+    return _fd.load() >= 0;
+}
+
+TransportStatus PosixSerialTransport::WaitReadable()
+{
+    const int fd = _fd.load();
+    if (fd < 0 || _epollFd < 0)
+    {
+        return TransportStatus::Error;
+    }
+    std::array<epoll_event, 2> events{};
+    while (true)
+    {
+        const int ready = ::epoll_wait(_epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return TransportStatus::Error;
+        }
+        bool readable = false;
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[static_cast<std::size_t>(i)].data.fd == _cancelFd)
+            {
+                return TransportStatus::Cancelled;
+            }
+            // 挂断或错误时也交给 Read 处理，由其区分剩余数据与设备丢失。
+            readable = true;
+        }
+        if (readable)
+        {
+            return TransportStatus::Ok;
+        }
+    }
+}
+
+TransportStatus PosixSerialTransport::Read(char* buffer, std::size_t capacity, std::size_t& bytesRead)
+{
+    bytesRead = 0;
+    const int fd = _fd.load();
+    if (fd < 0)
+    {
+        return TransportStatus::Error;
+    }
+    while (true)
+    {
+        const auto result = ::read(fd, buffer, capacity);
+        if (result > 0)
+        {
+            bytesRead = static_cast<std::size_t>(result);
+            return TransportStatus::Ok;
+        }
+        if (result == 0)
+        {
+            // 非阻塞模式下读到 0 表示对端挂断。
+            return capacity == 0 ? TransportStatus::Ok : TransportStatus::Disconnected;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return TransportStatus::Ok;
+        }
+        return FailureStatus(errno);
+    }
+}
+
+TransportStatus PosixSerialTransport::Write(const char* data, std::size_t size, std::size_t& bytesWritten)
+{
+    bytesWritten = 0;
+    std::lock_guard<std::mutex> guard(_writeMutex);
+    while (bytesWritten < size)
+    {
+        const int fd = _fd.load();
+        if (fd < 0)
+        {
+            return TransportStatus::Error;
+        }
+        const auto result = ::write(fd, data + bytesWritten, size - bytesWritten);
+        if (result > 0)
+        {
+            bytesWritten += static_cast<std::size_t>(result);
+            continue;
+        }
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            const auto status = WaitWritable();
+            if (status != TransportStatus::Ok)
+            {
+                return status;
+            }
+            continue;
+        }
+        return FailureStatus(errno);
+    }
+    return TransportStatus::Ok;
+}
+
+void PosixSerialTransport::Cancel()
+{
+    if (_cancelFd >= 0)
+    {
+        SignalCancelDescriptor(_cancelFd);
+    }
+}
+
+bool PosixSerialTransport::AttachReactor(ReactorHandle reactor, std::uint64_t key)
+{
+    const int fd = _fd.load();
+    if (fd < 0 || reactor < 0)
+    {
+        return false;
+    }
+    // EPOLLONESHOT：每次通知后自动停用，处理线程读空后再 ArmReadable，避免多个线程同时处理同一端口。
+    // 加入时不带 EPOLLIN，首次通知由 ArmReadable 开启。
+    epoll_event event{};
+    event.events = EPOLLONESHOT;
+    event.data.u64 = key;
+    if (epoll_ctl(static_cast<int>(reactor), EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        return false;
+    }
+    _reactorFd = static_cast<int>(reactor);
+    _reactorKey = key;
+    return true;
+}
+
+bool PosixSerialTransport::ArmReadable()
+{
+    const int fd = _fd.load();
+    if (fd < 0 || _reactorFd < 0)
+    {
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = _reactorKey;
+    return epoll_ctl(_reactorFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void PosixSerialTransport::DetachReactor()
+{
+    const int fd = _fd.load();
+    if (fd >= 0 && _reactorFd >= 0)
+    {
+        epoll_ctl(_reactorFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    _reactorFd = -1;
+    _reactorKey = 0;
+}
+
+bool PosixSerialTransport::Configure(int fd, const SerialSettings& settings)
+{
+    struct termios2 options{};
+    if (::ioctl(fd, TCGETS2, &options) != 0)
+    {
+        return false;
+    }
+    // 等价于 cfmakeraw：关闭行规程、回显、特殊字符与输出处理。
+    options.c_iflag &= ~static_cast<tcflag_t>(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+    options.c_oflag &= ~static_cast<tcflag_t>(OPOST);
+    options.c_lflag &= ~static_cast<tcflag_t>(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    options.c_cflag &= ~static_cast<tcflag_t>(CSIZE | PARENB | PARODD | CMSPAR | CSTOPB | CRTSCTS | CBAUD);
+    options.c_cflag |= CLOCAL | CREAD | BOTHER;
+    switch (settings.dataBits)
+    {
+    case 5:
+        options.c_cflag |= CS5;
+        break;
+    case 6:
+        options.c_cflag |= CS6;
+        break;
+    case 7:
+        options.c_cflag |= CS7;
+        break;
+    default:
+        options.c_cflag |= CS8;
+        break;
+    }
+    switch (settings.parity)
+    {
+    case SerialParity::Odd:
+        options.c_cflag |= PARENB | PARODD;
+        break;
+    case SerialParity::Even:
+        options.c_cflag |= PARENB;
+        break;
+    case SerialParity::Mark:
+        options.c_cflag |= PARENB | PARODD | CMSPAR;
+        break;
+    case SerialParity::Space:
+        options.c_cflag |= PARENB | CMSPAR;
+        break;
+    default:
+        break;
+    }
+    // termios 不支持 1.5 停止位，按 2 位处理。
+    if (settings.stopBits != SerialStopBits::One)
+    {
+        options.c_cflag |= CSTOPB;
+    }
+    if (settings.flowControl == FlowControl::RtsCts)
+    {
+        options.c_cflag |= CRTSCTS;
+    }
+    else if (settings.flowControl == FlowControl::XonXoff)
+    {
+        options.c_iflag |= IXON | IXOFF;
+        options.c_cc[VSTART] = 0x11;
+        options.c_cc[VSTOP] = 0x13;
+    }
+    options.c_ispeed = static_cast<speed_t>(settings.baudRate);
+    options.c_ospeed = static_cast<speed_t>(settings.baudRate);
+    // VMIN=0 时非阻塞读在无数据时返回 0 而不是 EAGAIN，会与挂断混淆。
+    options.c_cc[VMIN] = 1;
+    options.c_cc[VTIME] = 0;
+    return ::ioctl(fd, TCSETS2, &options) == 0;
+}
+
+TransportStatus PosixSerialTransport::WaitWritable()
+{
+    const int fd = _fd.load();
+    if (fd < 0)
+    {
+        return TransportStatus::Error;
+    }
+    std::array<pollfd, 2> watches{};
+    watches[0].fd = fd;
+    watches[0].events = POLLOUT;
+    watches[1].fd = _cancelFd;
+    watches[1].events = POLLIN;
+    while (true)
+    {
+        const int ready = ::poll(watches.data(), static_cast<nfds_t>(watches.size()), -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return TransportStatus::Error;
+        }
+        if ((watches[1].revents & POLLIN) != 0)
+        {
+            return TransportStatus::Cancelled;
+        }
+        if ((watches[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+        {
+            return TransportStatus::Disconnected;
+        }
+        if ((watches[0].revents & POLLOUT) != 0)
+        {
+            return TransportStatus::Ok;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------
+名称：POSIX 串口传输
+说明：基于 termios 与 epoll 的 Linux 串口实现
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：支持 /dev/ttyUSB*、/dev/ttyACM* 及 pty 设备
+------------------------------------------------------------------------*/
+#pragma once
+
+#ifndef _WIN32
+
+#include "SerialTransport.h"
+
+#include <atomic>
+#include <mutex>
+
+/// <summary>termios 串口传输实现，读写均为非阻塞。</summary>
+class PosixSerialTransport : public SerialTransport
+{
+public:
+    PosixSerialTransport();
+    ~PosixSerialTransport() override;
+
+    PosixSerialTransport(const PosixSerialTransport&) = delete;
+    PosixSerialTransport& operator=(const PosixSerialTransport&) = delete;
+
+    bool Open(const std::wstring& portName, const SerialSettings& settings) override;
+    void Close() override;
+    bool IsOpen() const noexcept override;
+    TransportStatus WaitReadable() override;
+    TransportStatus Read(char* buffer, std::size_t capacity, std::size_t& bytesRead) override;
+    TransportStatus Write(const char* data, std::size_t size, std::size_t& bytesWritten) override;
+    void Cancel() override;
+    bool AttachReactor(ReactorHandle reactor, std::uint64_t key) override;
+    bool ArmReadable() override;
+    void DetachReactor() override;
+
+    /// <summary>将宽字符端口名转换为设备路径，例如 ttyUSB0 → /dev/ttyUSB0。</summary>
+    static std::string ResolveDevicePath(const std::wstring& portName);
+
+private:
+    bool Configure(int fd, const SerialSettings& settings);
+    /// <summary>等待设备可写，被取消时返回 Cancelled。</summary>
+    TransportStatus WaitWritable();
+
+private:
+    std::atomic<int> _fd;
+    int _epollFd;
+    int _cancelFd;
+    int _reactorFd;
+    std::uint64_t _reactorKey;
+    std::mutex _writeMutex;
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*------------------------------------------------------------------------
+名称：单写多读定长记录环
+说明：固定容量的无锁环形缓冲区，写入方覆盖最旧的记录，读取方随时取出最近的若干条
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：仅允许一个线程写入；每个槽位带序号，读取时与写入重叠的槽位被跳过而不是读到一半新一半旧的记录
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>由 Words 个 64 位字组成的记录环，容量为 2 的幂；内存在构造时一次分配。</summary>
+template <std::size_t Words>
+class SeqlockRing
+{
+public:
+    using Record = std::array<std::uint64_t, Words>;
+
+    /// <summary>分配缓冲区，容量向上取整为 2 的幂。</summary>
+    explicit SeqlockRing(std::size_t capacity)
+        : _slots(RoundUp(capacity)), _mask(_slots.size() - 1), _written(0)
+    {
+    }
+
+    SeqlockRing(const SeqlockRing&) = delete;
+    SeqlockRing& operator=(const SeqlockRing&) = delete;
+
+    std::size_t Capacity() const noexcept
+    {
+        return _slots.size();
+    }
+
+    /// <summary>累计写入的条数（含已被覆盖的），任意线程可调用。</summary>
+    std::uint64_t Written() const noexcept
+    {
+        return _written.load(std::memory_order_acquire);
+    }
+
+    /// <summary>写入方：追加一条，满时覆盖最旧的一条。</summary>
+    void Push(const Record& record) noexcept
+    {
+        const auto index = _written.load(std::memory_order_relaxed);
+        auto& slot = _slots[index & _mask];
+        // 序号先置 0，读取方看到 0 或与预期不符的序号即放弃该槽位。
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t word = 0; word < Words; ++word)
+        {
+            slot.words[word].store(record[word], std::memory_order_relaxed);
+        }
+        slot.sequence.store(index + 1, std::memory_order_release);
+        _written.store(index + 1, std::memory_order_release);
+    }
+
+    /// <summary>读取方：按从旧到新的顺序追加最近至多 maxCount 条到 out，返回追加的条数。</summary>
+    std::size_t Read(std::size_t maxCount, std::vector<Record>& out) const
+    {
+        const auto written = _written.load(std::memory_order_acquire);
+        const auto count = static_cast<std::uint64_t>(std::min({maxCount, _slots.size(), static_cast<std::size_t>(written)}));
+        const auto before = out.size();
+        for (auto index = written - count; index < written; ++index)
+        {
+            const auto& slot = _slots[index & _mask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            Record record;
+            for (std::size_t word = 0; word < Words; ++word)
+            {
+                record[word] = slot.words[word].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence == index + 1 && slot.sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                out.push_back(record);
+            }
+        }
+        return out.size() - before;
+    }
+
+private:
+    struct Slot
+    {
+        /// <summary>槽位中记录的写入序号加一，写入过程中为 0。</summary>
+        std::atomic<std::uint64_t> sequence{0};
+        std::array<std::atomic<std::uint64_t>, Words> words{};
+    };
+
+    static std::size_t RoundUp(std::size_t capacity) noexcept
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+private:
+    std::vector<Slot> _slots;
+    std::size_t _mask;
+    alignas(64) std::atomic<std::uint64_t> _written;
+};
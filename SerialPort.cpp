@@ -4,88 +4,154 @@
 作者：Lion
 邮箱：chengbin@3578.cn
 日期：2025-11-29
-备注：无
+备注：读取线程阻塞在传输层的就绪等待上，不做超时轮询
 ------------------------------------------------------------------------*/
 #include "SerialPort.h"
 
-#include <array>
-#include <chrono>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr auto kErrorRetryDelay = std::chrono::milliseconds(20);
+    // 连续出错达到该次数（约半秒）即视为链路丢失，兜底传输层未能识别的拔出方式。
+    constexpr int kLinkLossErrorLimit = 25;
+    constexpr std::size_t kReadBufferSize = 1024;
+    // 小块写入合并到一次系统调用的上限。
+    constexpr std::size_t kWriteCoalesceLimit = 4096;
+    // 写队列累计字节上限，超过后拒绝新请求而不是无限堆积。
+    constexpr std::size_t kMaxQueuedWriteBytes = 1024 * 1024;
+    constexpr auto kRateWindow = std::chrono::seconds(1);
+    // 反应器模式下单个任务读取或分发的字节上限，避免一个繁忙端口长期占用事件线程。
+    constexpr std::size_t kReactorBudget = 16 * 1024;
+}
 
 SerialPort::SerialPort()
-    : _handle(INVALID_HANDLE_VALUE), _running(false)
+    : SerialPort(CreateSerialTransport())
+{
+}
+
+SerialPort::SerialPort(std::unique_ptr<SerialTransport> transport)
+    : _transport(std::move(transport)), _running(false), _dataSignal(0), _spaceSignal(0), _bytesReceived(0),
+      _droppedBytes(0), _highWaterMark(0), _readBuffer(kReadBufferSize), _reactor(nullptr), _reactorKey(0),
+      _drainScheduled(false), _flushScheduled(false), _readPaused(false), _linkLost(false), _writerRunning(false),
+      _queuedWriteBytes(0), _bytesWritten(0), _writeBytesPerSecond(0), _rateWindowBytes(0), _handler(nullptr), _handlerUsers(0)
 {
 }
 
 SerialPort::~SerialPort()
 {
     Close();
+    SetDataHandler(nullptr);
 }
 
-bool SerialPort::Open(const std::wstring& rawPortName, unsigned long baudRate)
+void SerialPort::SetTransport(std::unique_ptr<SerialTransport> transport)
 {
     Close();
+    std::lock_guard<std::mutex> guard(_transportMutex);
+    _transport = std::move(transport);
+}
 
-    std::wstring portName = rawPortName;
-    if (portName.rfind(L"\\\\.\\", 0) != 0)
-    {
-        portName = L"\\\\.\\" + portName;
-    }
+void SerialPort::SetReactor(SerialReactor* reactor) noexcept
+{
+    _reactor = reactor;
+}
 
-    HANDLE handle = CreateFileW(portName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
-    if (handle == INVALID_HANDLE_VALUE)
+bool SerialPort::Open(const std::wstring& portName, unsigned long baudRate)
+{
+    SerialSettings settings;
+    settings.baudRate = baudRate;
+    return Open(portName, settings);
+}
+
+bool SerialPort::Open(const std::wstring& portName, const SerialSettings& settings)
+{
+    Close();
+    if (!_transport || !_transport->Open(portName, settings))
     {
         return false;
     }
-
-    if (!SetupComm(handle, 4096, 4096))
+    _settings = settings;
+    _settings.readChunkSize = std::max<std::size_t>(settings.readChunkSize, 64);
+    _readBuffer.resize(_settings.readChunkSize);
+    if (!_ring || _ring->Capacity() < _settings.ringCapacity)
     {
-        CloseHandle(handle);
-        return false;
+        _ring = std::make_unique<SpscByteRing>(_settings.ringCapacity);
     }
-
-    _handle.store(handle);
-    if (!Configure(baudRate))
+    _ring->Reset();
+    _bytesReceived.store(0);
+    _droppedBytes.store(0);
+    _highWaterMark.store(0);
+    _bytesWritten.store(0);
+    _writeBytesPerSecond.store(0);
+    _drainScheduled.store(false);
+    _flushScheduled.store(false);
+    _readPaused.store(false);
+    _linkLost.store(false);
+    _running.store(true);
     {
-        CloseHandle(handle);
-        _handle.store(INVALID_HANDLE_VALUE);
-        return false;
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        _writerRunning = true;
+        _rateWindowStart = std::chrono::steady_clock::now();
+        _rateWindowBytes = 0;
     }
-
-    COMMTIMEOUTS timeouts{};
-    timeouts.ReadIntervalTimeout = 40;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
-    timeouts.ReadTotalTimeoutConstant = 40;
-    timeouts.WriteTotalTimeoutMultiplier = 0;
-    timeouts.WriteTotalTimeoutConstant = 40;
-    if (!SetCommTimeouts(handle, &timeouts))
+    if (_reactor != nullptr)
     {
-        CloseHandle(handle);
-        _handle.store(INVALID_HANDLE_VALUE);
-        return false;
+        if (_reactor->Register(*this, *_transport) == 0)
+        {
+            Close();
+            return false;
+        }
+        return true;
     }
-
-    PurgeComm(handle, PURGE_RXCLEAR | PURGE_TXCLEAR);
-    EscapeCommFunction(handle, SETDTR);
-    EscapeCommFunction(handle, SETRTS);
-
-    _running.store(true);
+    _writer = std::thread(&SerialPort::WriterLoop, this);
+    _dispatcher = std::thread(&SerialPort::DispatchLoop, this);
     _reader = std::thread(&SerialPort::ReaderLoop, this);
     return true;
 }
 
 void SerialPort::Close()
 {
-    _running.store(false);
-    HANDLE handle = _handle.exchange(INVALID_HANDLE_VALUE);
-    if (handle != INVALID_HANDLE_VALUE)
     {
-        PurgeComm(handle, PURGE_RXABORT | PURGE_TXABORT | PURGE_RXCLEAR | PURGE_TXCLEAR);
-        CloseHandle(handle);
+        std::lock_guard<std::mutex> guard(_stopMutex);
+        _running.store(false);
+    }
+    _stopSignal.notify_all();
+    _dataSignal.fetch_add(1);
+    _dataSignal.notify_all();
+    _spaceSignal.fetch_add(1);
+    _spaceSignal.notify_all();
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        _writerRunning = false;
+    }
+    _writeSignal.notify_all();
+    if (_transport)
+    {
+        _transport->Cancel();
+    }
+    if (const auto key = _reactorKey.exchange(0); key != 0)
+    {
+        // 注销返回后不再有本端口的任务在反应器线程上执行。
+        _reactor->Unregister(key);
     }
     if (_reader.joinable())
     {
         _reader.join();
     }
+    if (_writer.joinable())
+    {
+        _writer.join();
+    }
+    FailPendingWrites();
+    if (_dispatcher.joinable())
+    {
+        _dispatcher.join();
+    }
+    if (_transport)
+    {
+        _transport->Close();
+    }
 }
 
 bool SerialPort::Write(const std::string& data)
@@ -94,98 +160,496 @@ bool SerialPort::Write(const std::string& data)
     {
         return true;
     }
-    HANDLE handle = _handle.load();
-    if (handle == INVALID_HANDLE_VALUE)
+    return WriteAsync(data).get();
+}
+
+bool SerialPort::WriteAsync(std::string data, WriteCallback onComplete)
+{
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        if (!_writerRunning || _queuedWriteBytes + data.size() > kMaxQueuedWriteBytes)
+        {
+            return false;
+        }
+        _queuedWriteBytes += data.size();
+        _writeQueue.push_back(WriteRequest{std::move(data), std::move(onComplete)});
+    }
+    if (ScheduleReactorTask(_flushScheduled, SerialReactor::TaskKind::Flush))
+    {
+        return true;
+    }
+    _writeSignal.notify_one();
+    return true;
+}
+
+std::future<bool> SerialPort::WriteAsync(std::string data)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+    if (!WriteAsync(std::move(data), [promise](bool success, std::size_t)
     {
-        return false;
+        promise->set_value(success);
+    }))
+    {
+        promise->set_value(false);
     }
-    std::lock_guard<std::mutex> guard(_writeMutex);
-    DWORD written = 0;
-    const BOOL result = WriteFile(handle, data.data(), static_cast<DWORD>(data.size()), &written, nullptr);
-    return result != FALSE && written == data.size();
+    return future;
 }
 
 void SerialPort::SetDataHandler(DataHandler handler)
 {
-    std::lock_guard<std::mutex> guard(_handlerMutex);
-    _handler = std::move(handler);
+    DataHandler* replacement = handler ? new DataHandler(std::move(handler)) : nullptr;
+    DataHandler* previous = _handler.exchange(replacement);
+    // 分发线程先登记再取指针，计数归零即说明旧回调已无人持有。
+    for (int users = _handlerUsers.load(); users != 0; users = _handlerUsers.load())
+    {
+        _handlerUsers.wait(users);
+    }
+    delete previous;
+}
+
+void SerialPort::SetLinkLostHandler(LinkLostHandler handler)
+{
+    std::lock_guard<std::mutex> guard(_linkLostMutex);
+    _linkLostHandler = std::move(handler);
+}
+
+SerialStatistics SerialPort::GetStatistics() const noexcept
+{
+    SerialStatistics statistics;
+    statistics.bytesReceived = _bytesReceived.load(std::memory_order_relaxed);
+    statistics.droppedBytes = _droppedBytes.load(std::memory_order_relaxed);
+    statistics.highWaterMark = _highWaterMark.load(std::memory_order_relaxed);
+    if (_ring)
+    {
+        statistics.bufferedBytes = _ring->Size();
+        statistics.ringCapacity = _ring->Capacity();
+    }
+    statistics.bytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        statistics.queuedWrites = _writeQueue.size();
+        statistics.queuedWriteBytes = _queuedWriteBytes;
+        // 超过两个窗口没有写出时速率视为 0，避免显示陈旧值。
+        const bool idle = std::chrono::steady_clock::now() - _rateWindowStart >= kRateWindow * 2;
+        statistics.writeBytesPerSecond = idle ? 0 : _writeBytesPerSecond.load(std::memory_order_relaxed);
+    }
+    return statistics;
 }
 
 bool SerialPort::IsOpen() const noexcept
 {
-    return _handle.load() != INVALID_HANDLE_VALUE;
+    std::lock_guard<std::mutex> guard(_transportMutex);
+    return _transport && _transport->IsOpen() && !_linkLost.load();
 }
 
 void SerialPort::ReaderLoop()
 {
-    std::array<char, 1024> buffer{};
+    int consecutiveErrors = 0;
     while (_running.load())
     {
-        HANDLE handle = _handle.load();
-        if (handle == INVALID_HANDLE_VALUE)
+        const auto waitStatus = _transport->WaitReadable();
+        if (waitStatus == TransportStatus::Cancelled || !_running.load())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            break;
+        }
+        const auto result = waitStatus == TransportStatus::Ok ? PumpInput(true, std::numeric_limits<std::size_t>::max())
+            : waitStatus == TransportStatus::Disconnected ? PumpResult::Disconnected : PumpResult::Error;
+        if (result == PumpResult::Disconnected || (result == PumpResult::Error && ++consecutiveErrors >= kLinkLossErrorLimit))
+        {
+            // 设备已不存在，继续等待只会空转；由上层关闭后重新打开。
+            ReportLinkLost();
+            break;
+        }
+        if (result == PumpResult::Error)
+        {
+            WaitBeforeRetry();
             continue;
         }
+        consecutiveErrors = 0;
+    }
+}
 
-        DWORD bytesRead = 0;
-        const BOOL ok = ReadFile(handle, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, nullptr);
-        if (!ok)
+SerialPort::PumpResult SerialPort::PumpInput(bool allowBlocking, std::size_t budget)
+{
+    // 一次就绪后取走驱动队列中的全部字节，直接读入环中避免再次拷贝。
+    std::size_t total = 0;
+    while (_running.load())
+    {
+        if (total >= budget)
         {
-            if (!_running.load())
-            {
-                break;
-            }
-            const auto error = GetLastError();
-            if (error == ERROR_OPERATION_ABORTED)
+            return PumpResult::Yielded;
+        }
+        auto region = _ring->WritableRegion();
+        const bool overrun = region.size == 0;
+        if (overrun && _settings.overrunPolicy == OverrunPolicy::Block)
+        {
+            if (!allowBlocking)
             {
-                continue;
+                return PumpResult::Paused;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            WaitForSpace();
             continue;
         }
+        if (overrun)
+        {
+            region = SpscByteRing::Region{_readBuffer.data(), _readBuffer.size()};
+        }
+        region.size = std::min(region.size, _settings.readChunkSize);
 
+        std::size_t bytesRead = 0;
+        const auto readStatus = _transport->Read(region.data, region.size, bytesRead);
+        if (readStatus != TransportStatus::Ok)
+        {
+            switch (readStatus)
+            {
+            case TransportStatus::Error:
+                return PumpResult::Error;
+            case TransportStatus::Disconnected:
+                return PumpResult::Disconnected;
+            default:
+                return PumpResult::Cancelled;
+            }
+        }
         if (bytesRead == 0)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return PumpResult::Drained;
+        }
+        total += bytesRead;
+        _bytesReceived.fetch_add(bytesRead, std::memory_order_relaxed);
+        if (overrun)
+        {
+            _droppedBytes.fetch_add(bytesRead, std::memory_order_relaxed);
             continue;
         }
 
-        DataHandler handlerCopy;
+        _ring->Commit(bytesRead);
+        const auto buffered = _ring->Size();
+        if (buffered > _highWaterMark.load(std::memory_order_relaxed))
+        {
+            _highWaterMark.store(buffered, std::memory_order_relaxed);
+        }
+        NotifyData();
+    }
+    return PumpResult::Cancelled;
+}
+
+void SerialPort::DispatchLoop()
+{
+    while (true)
+    {
+        // 先取信号序号再检查数据，保证生产者的提交不会被错过。
+        const auto sequence = _dataSignal.load();
+        if (!_running.load())
         {
-            std::lock_guard<std::mutex> guard(_handlerMutex);
-            handlerCopy = _handler;
+            break;
         }
-        if (handlerCopy)
+        if (DrainRing(_ring->Capacity()) == 0)
         {
-            handlerCopy(std::string(buffer.data(), buffer.data() + bytesRead));
+            _dataSignal.wait(sequence);
         }
     }
 }
 
-bool SerialPort::Configure(unsigned long baudRate)
+std::size_t SerialPort::DrainRing(std::size_t budget)
 {
-    HANDLE handle = _handle.load();
-    if (handle == INVALID_HANDLE_VALUE)
+    std::size_t dispatched = 0;
+    while (dispatched < budget && _running.load())
     {
-        return false;
+        const auto chunk = _ring->ReadableRegion();
+        if (chunk.empty())
+        {
+            break;
+        }
+        Dispatch(chunk);
+        _ring->Consume(chunk.size());
+        dispatched += chunk.size();
+        _spaceSignal.fetch_add(1);
+        _spaceSignal.notify_one();
     }
-    DCB dcb{};
-    dcb.DCBlength = sizeof(DCB);
-    if (!GetCommState(handle, &dcb))
+    return dispatched;
+}
+
+void SerialPort::WriterLoop()
+{
+    std::string batch;
+    std::vector<WriteRequest> requests;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_writeMutex);
+            _writeSignal.wait(lock, [this]()
+            {
+                return !_writerRunning || !_writeQueue.empty();
+            });
+            if (!_writerRunning)
+            {
+                break;
+            }
+            CollectBatch(batch, requests);
+        }
+        CompleteBatch(batch, requests);
+    }
+}
+
+void SerialPort::CollectBatch(std::string& batch, std::vector<WriteRequest>& requests)
+{
+    // 合并连续的小请求；超过上限的单个请求独占一批。
+    batch.clear();
+    requests.clear();
+    while (!_writeQueue.empty())
+    {
+        auto& next = _writeQueue.front();
+        if (!batch.empty() && batch.size() + next.data.size() > kWriteCoalesceLimit)
+        {
+            break;
+        }
+        batch.append(next.data);
+        _queuedWriteBytes -= next.data.size();
+        requests.push_back(std::move(next));
+        _writeQueue.pop_front();
+    }
+}
+
+void SerialPort::CompleteBatch(const std::string& batch, std::vector<WriteRequest>& requests)
+{
+    const std::size_t written = FlushBatch(batch);
+    std::size_t offset = 0;
+    for (auto& request : requests)
+    {
+        const std::size_t requestEnd = offset + request.data.size();
+        const bool success = written >= requestEnd;
+        const std::size_t requestWritten = written > offset ? std::min(written, requestEnd) - offset : 0;
+        if (request.onComplete)
+        {
+            request.onComplete(success, requestWritten);
+        }
+        offset = requestEnd;
+    }
+    requests.clear();
+}
+
+std::size_t SerialPort::FlushBatch(const std::string& batch)
+{
+    std::size_t total = 0;
+    while (total < batch.size() && _running.load())
+    {
+        std::size_t written = 0;
+        const auto status = _transport->Write(batch.data() + total, batch.size() - total, written);
+        total += written;
+        _bytesWritten.fetch_add(written, std::memory_order_relaxed);
+        {
+            // 按一秒窗口统计写出速率。
+            std::lock_guard<std::mutex> guard(_writeMutex);
+            _rateWindowBytes += written;
+            const auto now = std::chrono::steady_clock::now();
+            const auto elapsed = now - _rateWindowStart;
+            if (elapsed >= kRateWindow)
+            {
+                const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+                _writeBytesPerSecond.store(_rateWindowBytes * 1000 / static_cast<std::uint64_t>(elapsedMs), std::memory_order_relaxed);
+                _rateWindowStart = now;
+                _rateWindowBytes = 0;
+            }
+        }
+        if (status == TransportStatus::Disconnected)
+        {
+            ReportLinkLost();
+        }
+        if (status != TransportStatus::Ok)
+        {
+            break;
+        }
+        // 部分写入（例如硬件流控暂停发送）时继续写剩余部分。
+    }
+    return total;
+}
+
+void SerialPort::FailPendingWrites()
+{
+    std::deque<WriteRequest> pending;
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        pending.swap(_writeQueue);
+        _queuedWriteBytes = 0;
+    }
+    for (auto& request : pending)
+    {
+        if (request.onComplete)
+        {
+            request.onComplete(false, 0);
+        }
+    }
+}
+
+void SerialPort::Dispatch(std::string_view chunk)
+{
+    _handlerUsers.fetch_add(1);
+    DataHandler* handler = _handler.load();
+    if (handler != nullptr)
+    {
+        (*handler)(chunk);
+    }
+    if (_handlerUsers.fetch_sub(1) == 1)
+    {
+        _handlerUsers.notify_all();
+    }
+}
+
+void SerialPort::NotifyData()
+{
+    if (ScheduleReactorTask(_drainScheduled, SerialReactor::TaskKind::Drain))
+    {
+        return;
+    }
+    _dataSignal.fetch_add(1);
+    _dataSignal.notify_one();
+}
+
+void SerialPort::OnReactorTask(SerialReactor::TaskKind kind)
+{
+    switch (kind)
+    {
+    case SerialReactor::TaskKind::Readable:
+        OnReactorReadable();
+        break;
+    case SerialReactor::TaskKind::Drain:
+        OnReactorDrain();
+        break;
+    case SerialReactor::TaskKind::Flush:
+        OnReactorFlush();
+        break;
+    }
+}
+
+void SerialPort::OnReactorReadable()
+{
+    const auto result = PumpInput(false, kReactorBudget);
+    if (!_running.load())
+    {
+        return;
+    }
+    if (result == PumpResult::Drained)
+    {
+        _transport->ArmReadable();
+        return;
+    }
+    if (result == PumpResult::Yielded)
+    {
+        // 排到任务队列末尾，让其他端口先得到处理。
+        PostReactorTask(SerialReactor::TaskKind::Readable);
+        return;
+    }
+    if (result == PumpResult::Paused)
+    {
+        // 环已满：由分发任务腾出空间后恢复读取；置位后再检查一次，避免与分发任务错过彼此。
+        _readPaused.store(true);
+        if (_ring->WritableRegion().size != 0 && _readPaused.exchange(false))
+        {
+            PostReactorTask(SerialReactor::TaskKind::Readable);
+        }
+    }
+    if (result == PumpResult::Error || result == PumpResult::Disconnected)
+    {
+        // 不再请求通知，否则挂断的设备会让事件线程空转；反应器模式没有重试线程，出错即按链路丢失处理。
+        ReportLinkLost();
+    }
+}
+
+void SerialPort::OnReactorDrain()
+{
+    const bool resumed = DrainRing(kReactorBudget) != 0 && _readPaused.exchange(false);
+    if (resumed)
+    {
+        PostReactorTask(SerialReactor::TaskKind::Readable);
+    }
+    // 先清标志再检查剩余数据，读取方在此之间的提交会由这里或它自己重新调度。
+    _drainScheduled.store(false);
+    if (!_ring->ReadableRegion().empty())
+    {
+        ScheduleReactorTask(_drainScheduled, SerialReactor::TaskKind::Drain);
+    }
+}
+
+void SerialPort::OnReactorFlush()
+{
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        if (!_writerRunning)
+        {
+            return;
+        }
+        CollectBatch(_reactorBatch, _reactorRequests);
+    }
+    // 流控暂停发送时这里会阻塞当前事件线程，直到写超时返回部分结果。
+    CompleteBatch(_reactorBatch, _reactorRequests);
+    _flushScheduled.store(false);
+    bool pending = false;
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        pending = _writerRunning && !_writeQueue.empty();
+    }
+    if (pending)
+    {
+        ScheduleReactorTask(_flushScheduled, SerialReactor::TaskKind::Flush);
+    }
+}
+
+bool SerialPort::ScheduleReactorTask(std::atomic<bool>& scheduled, SerialReactor::TaskKind kind)
+{
+    // 只读取一次键：Close 可能在任意时刻把它换成 0。
+    const auto key = _reactorKey.load();
+    if (key == 0)
     {
         return false;
     }
-    dcb.BaudRate = baudRate;
-    dcb.ByteSize = 8;
-    dcb.StopBits = ONESTOPBIT;
-    dcb.Parity = NOPARITY;
-    dcb.fBinary = TRUE;
-    dcb.fDtrControl = DTR_CONTROL_ENABLE;
-    dcb.fRtsControl = RTS_CONTROL_ENABLE;
-    dcb.fOutxCtsFlow = FALSE;
-    dcb.fOutxDsrFlow = FALSE;
-    dcb.fOutX = FALSE;
-    dcb.fInX = FALSE;
-    return SetCommState(handle, &dcb) != FALSE;
+    if (!scheduled.exchange(true))
+    {
+        _reactor->Post(key, kind);
+    }
+    return true;
+}
+
+void SerialPort::PostReactorTask(SerialReactor::TaskKind kind)
+{
+    if (const auto key = _reactorKey.load(); key != 0)
+    {
+        _reactor->Post(key, kind);
+    }
+}
+
+void SerialPort::ReportLinkLost()
+{
+    if (!_running.load() || _linkLost.exchange(true))
+    {
+        return;
+    }
+    LinkLostHandler handler;
+    {
+        std::lock_guard<std::mutex> guard(_linkLostMutex);
+        handler = _linkLostHandler;
+    }
+    if (handler)
+    {
+        handler();
+    }
+}
+
+void SerialPort::WaitBeforeRetry()
+{
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    _stopSignal.wait_for(lock, kErrorRetryDelay, [this]()
+    {
+        return !_running.load();
+    });
+}
+
+void SerialPort::WaitForSpace()
+{
+    const auto sequence = _spaceSignal.load();
+    if (!_running.load() || _ring->WritableRegion().size != 0)
+    {
+        return;
+    }
+    _spaceSignal.wait(sequence);
 }
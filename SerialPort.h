@@ -1,53 +1,194 @@
 /*------------------------------------------------------------------------
 名称：串口通信模块
-说明：封装 Windows 串口打开、关闭与异步读写能力
+说明：封装串口打开、关闭与异步读写能力，底层由 SerialTransport 提供
 作者：Lion
 邮箱：chengbin@3578.cn
 日期：2025-11-29
-备注：无
+备注：读取线程只负责把字节写入无锁环，解析回调在独立的分发线程上执行
 ------------------------------------------------------------------------*/
 #pragma once
 
+#include "SerialReactor.h"
+#include "SerialTransport.h"
+#include "SpscByteRing.h"
+
 #include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <windows.h>
+#include <vector>
+
+/// <summary>接收统计快照。</summary>
+struct SerialStatistics
+{
+    std::uint64_t bytesReceived = 0;
+    std::uint64_t droppedBytes = 0;
+    std::size_t bufferedBytes = 0;
+    std::size_t highWaterMark = 0;
+    std::size_t ringCapacity = 0;
+    std::size_t queuedWrites = 0;
+    std::size_t queuedWriteBytes = 0;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t writeBytesPerSecond = 0;
+};
 
 /// <summary>封装底层串口句柄并回调收到的数据。</summary>
 class SerialPort
 {
 public:
-    using DataHandler = std::function<void(const std::string&)>;
+    /// <summary>数据回调，视图指向端口内部的接收环，仅在回调期间有效。</summary>
+    using DataHandler = std::function<void(std::string_view chunk)>;
+    /// <summary>写入完成回调，在写线程上执行。</summary>
+    using WriteCallback = std::function<void(bool success, std::size_t bytesWritten)>;
+    /// <summary>链路丢失回调，每次打开至多触发一次，在读取线程或反应器线程上执行，不可在其中调用 Close。</summary>
+    using LinkLostHandler = std::function<void()>;
 
     SerialPort();
+    /// <summary>使用指定传输实现构造，便于接入 pty 或模拟设备。</summary>
+    explicit SerialPort(std::unique_ptr<SerialTransport> transport);
     ~SerialPort();
 
-    /// <summary>尝试打开串口。</summary>
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    /// <summary>更换底层传输，例如切换到虚拟模块。仅在关闭状态下调用。</summary>
+    void SetTransport(std::unique_ptr<SerialTransport> transport);
+
+    /// <summary>交由反应器调度读写，不再创建专属线程；传入 nullptr 恢复线程模式。仅在关闭状态下调用。</summary>
+    void SetReactor(SerialReactor* reactor) noexcept;
+
+    /// <summary>按完整配置打开串口。</summary>
+    bool Open(const std::wstring& portName, const SerialSettings& settings);
+
+    /// <summary>以默认线路参数和指定波特率打开串口。</summary>
     bool Open(const std::wstring& portName, unsigned long baudRate);
 
-    /// <summary>关闭串口并停止读取线程。</summary>
+    /// <summary>关闭串口并立即唤醒读取与分发线程。</summary>
     void Close();
 
-    /// <summary>写入字节流。</summary>
+    /// <summary>同步写入字节流，阻塞至全部写出或失败。</summary>
     bool Write(const std::string& data);
 
-    /// <summary>设置数据回调。</summary>
+    /// <summary>将数据加入写队列，队列已满或端口未打开时返回 false 且不会回调。</summary>
+    bool WriteAsync(std::string data, WriteCallback onComplete);
+
+    /// <summary>将数据加入写队列，返回写入结果的 future。</summary>
+    std::future<bool> WriteAsync(std::string data);
+
+    /// <summary>设置数据回调，返回后旧回调不再被调用；不可在回调内部调用。</summary>
     void SetDataHandler(DataHandler handler);
 
-    /// <summary>查询串口是否处于打开状态。</summary>
+    /// <summary>设置链路丢失回调，例如 USB 转串口被拔出或模块重新枚举。</summary>
+    void SetLinkLostHandler(LinkLostHandler handler);
+
+    /// <summary>获取接收统计。</summary>
+    SerialStatistics GetStatistics() const noexcept;
+
+    /// <summary>查询串口是否处于打开状态，链路丢失后返回 false。</summary>
     bool IsOpen() const noexcept;
 
 private:
+    friend class SerialReactor;
+
+    /// <summary>一轮读取的结果。</summary>
+    enum class PumpResult
+    {
+        Drained,
+        Paused,
+        Yielded,
+        Cancelled,
+        Error,
+        Disconnected
+    };
+
+    /// <summary>一条排队中的写请求。</summary>
+    struct WriteRequest
+    {
+        std::string data;
+        WriteCallback onComplete;
+    };
+
     void ReaderLoop();
-    bool Configure(unsigned long baudRate);
+    void DispatchLoop();
+    void WriterLoop();
+    /// <summary>读空驱动队列；环满且不允许阻塞时返回 Paused，读满 budget 字节时返回 Yielded。</summary>
+    PumpResult PumpInput(bool allowBlocking, std::size_t budget);
+    /// <summary>向回调投递环中数据，最多 budget 字节，返回投递的字节数。</summary>
+    std::size_t DrainRing(std::size_t budget);
+    /// <summary>从队列取出一批可合并的请求，调用方须持有写锁。</summary>
+    void CollectBatch(std::string& batch, std::vector<WriteRequest>& requests);
+    /// <summary>写出一批数据并逐个完成请求。</summary>
+    void CompleteBatch(const std::string& batch, std::vector<WriteRequest>& requests);
+    /// <summary>写出一批合并后的数据，处理部分写入。</summary>
+    std::size_t FlushBatch(const std::string& batch);
+    /// <summary>以失败结果完成队列中剩余的请求。</summary>
+    void FailPendingWrites();
+    /// <summary>标记链路丢失并通知回调，重复调用无效果。</summary>
+    void ReportLinkLost();
+    /// <summary>出错后短暂退避，关闭时立即返回。</summary>
+    void WaitBeforeRetry();
+    /// <summary>阻塞策略下等待消费者腾出空间。</summary>
+    void WaitForSpace();
+    /// <summary>在分发线程上投递一段数据。</summary>
+    void Dispatch(std::string_view chunk);
+    /// <summary>通知消费者有新数据。</summary>
+    void NotifyData();
+    /// <summary>反应器线程上执行的任务入口。</summary>
+    void OnReactorTask(SerialReactor::TaskKind kind);
+    void OnReactorReadable();
+    void OnReactorDrain();
+    void OnReactorFlush();
+    /// <summary>反应器模式下确保恰有一个同类任务在排队或执行；不在反应器模式（含正在关闭）时返回 false。</summary>
+    bool ScheduleReactorTask(std::atomic<bool>& scheduled, SerialReactor::TaskKind kind);
+    /// <summary>向反应器投递本端口的任务；Close 已清除键时不投递，键 0 是反应器自身的控制键。</summary>
+    void PostReactorTask(SerialReactor::TaskKind kind);
 
 private:
-    std::atomic<HANDLE> _handle;
+    std::unique_ptr<SerialTransport> _transport;
+    /// <summary>保护更换传输层与 IsOpen 的并发访问；读写线程只在打开期间使用传输层，无需加锁。</summary>
+    mutable std::mutex _transportMutex;
     std::thread _reader;
+    std::thread _dispatcher;
     std::atomic<bool> _running;
-    DataHandler _handler;
-    std::mutex _handlerMutex;
-    std::mutex _writeMutex;
+    std::mutex _stopMutex;
+    std::condition_variable _stopSignal;
+    SerialSettings _settings;
+    std::unique_ptr<SpscByteRing> _ring;
+    std::atomic<std::uint32_t> _dataSignal;
+    std::atomic<std::uint32_t> _spaceSignal;
+    std::atomic<std::uint64_t> _bytesReceived;
+    std::atomic<std::uint64_t> _droppedBytes;
+    std::atomic<std::size_t> _highWaterMark;
+    std::vector<char> _readBuffer;
+    SerialReactor* _reactor;
+    std::atomic<std::uint64_t> _reactorKey;
+    std::atomic<bool> _drainScheduled;
+    std::atomic<bool> _flushScheduled;
+    std::atomic<bool> _readPaused;
+    std::atomic<bool> _linkLost;
+    std::mutex _linkLostMutex;
+    LinkLostHandler _linkLostHandler;
+    std::string _reactorBatch;
+    std::vector<WriteRequest> _reactorRequests;
+
+    std::thread _writer;
+    mutable std::mutex _writeMutex;
+    std::condition_variable _writeSignal;
+    std::deque<WriteRequest> _writeQueue;
+    bool _writerRunning;
+    std::size_t _queuedWriteBytes;
+    std::atomic<std::uint64_t> _bytesWritten;
+    std::atomic<std::uint64_t> _writeBytesPerSecond;
+    std::chrono::steady_clock::time_point _rateWindowStart;
+    std::uint64_t _rateWindowBytes;
+    std::atomic<DataHandler*> _handler;
+    std::atomic<int> _handlerUsers;
 };
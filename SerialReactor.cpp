@@ -0,0 +1,327 @@
+/*------------------------------------------------------------------------
+名称：串口反应器实现
+说明：实现事件线程、端口注册与任务投递
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：同一端口的可读通知为一次性触发，处理完毕后由端口重新请求
+------------------------------------------------------------------------*/
+#include "SerialReactor.h"
+
+#include "SerialPort.h"
+
+#include <array>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 键 0 保留给反应器自身：Linux 下为任务唤醒描述符，Windows 下为停止通知。
+    constexpr std::uint64_t kControlKey = 0;
+    constexpr std::size_t kEventBatch = 64;
+
+    // 当前线程正在执行任务的端口键，允许端口在自己的回调里关闭。
+    thread_local std::uint64_t t_currentKey = kControlKey;
+
+    void PinThread(std::thread& thread, int cpu)
+    {
+#ifdef _WIN32
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+}
+
+SerialReactor::SerialReactor()
+    : _running(false), _handle(0), _nextKey(kControlKey + 1)
+#ifndef _WIN32
+    , _wakeFd(-1)
+#endif
+{
+}
+
+SerialReactor::~SerialReactor()
+{
+    Stop();
+}
+
+bool SerialReactor::Start(std::size_t threadCount, const std::vector<int>& cpuAffinity)
+{
+    if (_running.load() || threadCount == 0)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, static_cast<DWORD>(threadCount));
+    if (completionPort == nullptr)
+    {
+        return false;
+    }
+    _handle = reinterpret_cast<ReactorHandle>(completionPort);
+#else
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        return false;
+    }
+    _handle = epollFd;
+    // 信号量模式：每次投递计数加一，每个线程取走一个任务时减一。
+    _wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kControlKey;
+    if (_wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, _wakeFd, &event) != 0)
+    {
+        CloseHandles();
+        return false;
+    }
+#endif
+    _running.store(true);
+    _workers.reserve(threadCount);
+    for (std::size_t index = 0; index < threadCount; ++index)
+    {
+        _workers.emplace_back(&SerialReactor::WorkerLoop, this);
+        if (!cpuAffinity.empty())
+        {
+            PinThread(_workers.back(), cpuAffinity[index % cpuAffinity.size()]);
+        }
+    }
+    return true;
+}
+
+void SerialReactor::Stop()
+{
+    if (!_running.exchange(false))
+    {
+        return;
+    }
+#ifdef _WIN32
+    for (std::size_t index = 0; index < _workers.size(); ++index)
+    {
+        PostQueuedCompletionStatus(reinterpret_cast<HANDLE>(_handle), 0, kControlKey, nullptr);
+    }
+#else
+    // 唤醒描述符为水平触发，停止期间不读取，所有线程都会看到它。
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(_wakeFd, &one, sizeof(one));
+#endif
+    for (auto& worker : _workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+    _workers.clear();
+    CloseHandles();
+    std::lock_guard<std::mutex> guard(_registryMutex);
+    _registry.clear();
+#ifndef _WIN32
+    _tasks.clear();
+#endif
+}
+
+bool SerialReactor::IsRunning() const noexcept
+{
+    return _running.load();
+}
+
+std::uint64_t SerialReactor::Register(SerialPort& port, SerialTransport& transport)
+{
+    if (!_running.load())
+    {
+        return kControlKey;
+    }
+    // 持锁完成关联与首次请求，事件线程要等注册结束才能开始执行该端口的任务。
+    std::lock_guard<std::mutex> guard(_registryMutex);
+    const std::uint64_t key = _nextKey++;
+    port._reactorKey.store(key);
+    if (!transport.AttachReactor(_handle, key))
+    {
+        port._reactorKey.store(kControlKey);
+        return kControlKey;
+    }
+    _registry.emplace(key, Registration{&port, 0, false});
+    if (!transport.ArmReadable())
+    {
+        port._reactorKey.store(kControlKey);
+        transport.DetachReactor();
+        _registry.erase(key);
+        return kControlKey;
+    }
+    return key;
+}
+
+void SerialReactor::Unregister(std::uint64_t key)
+{
+    std::unique_lock<std::mutex> lock(_registryMutex);
+    auto found = _registry.find(key);
+    if (found == _registry.end())
+    {
+        return;
+    }
+    found->second.removed = true;
+    // 在本端口自己的任务里注销时，当前任务不计入等待。
+    const int selfBusy = t_currentKey == key ? 1 : 0;
+    _idleSignal.wait(lock, [&found, selfBusy]()
+    {
+        return found->second.busy <= selfBusy;
+    });
+    _registry.erase(found);
+}
+
+void SerialReactor::Post(std::uint64_t key, TaskKind kind)
+{
+    // 控制键的包在 Windows 下会让收到它的事件线程退出，端口任务绝不能用它投递。
+    if (key == kControlKey || !_running.load())
+    {
+        return;
+    }
+#ifdef _WIN32
+    PostQueuedCompletionStatus(reinterpret_cast<HANDLE>(_handle), static_cast<DWORD>(kind), static_cast<ULONG_PTR>(key), nullptr);
+#else
+    {
+        std::lock_guard<std::mutex> guard(_taskMutex);
+        _tasks.emplace_back(key, kind);
+    }
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(_wakeFd, &one, sizeof(one));
+#endif
+}
+
+void SerialReactor::WorkerLoop()
+{
+#ifdef _WIN32
+    std::array<OVERLAPPED_ENTRY, kEventBatch> entries{};
+    while (true)
+    {
+        ULONG removed = 0;
+        if (!GetQueuedCompletionStatusEx(reinterpret_cast<HANDLE>(_handle), entries.data(), static_cast<ULONG>(entries.size()), &removed, INFINITE, FALSE))
+        {
+            if (!_running.load())
+            {
+                return;
+            }
+            continue;
+        }
+        for (ULONG index = 0; index < removed; ++index)
+        {
+            const auto& entry = entries[index];
+            if (entry.lpCompletionKey == kControlKey)
+            {
+                return;
+            }
+            // 带 OVERLAPPED 的包来自端口的 WaitCommEvent，其余为 Post 投递的任务。
+            const auto kind = entry.lpOverlapped != nullptr ? TaskKind::Readable : static_cast<TaskKind>(entry.dwNumberOfBytesTransferred);
+            Execute(entry.lpCompletionKey, kind);
+        }
+    }
+#else
+    std::array<epoll_event, kEventBatch> events{};
+    while (true)
+    {
+        const int count = epoll_wait(static_cast<int>(_handle), events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        for (int index = 0; index < count; ++index)
+        {
+            const auto key = events[index].data.u64;
+            if (key != kControlKey)
+            {
+                Execute(key, TaskKind::Readable);
+                continue;
+            }
+            if (!_running.load())
+            {
+                return;
+            }
+            std::uint64_t value = 0;
+            if (read(_wakeFd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+            {
+                continue;
+            }
+            std::pair<std::uint64_t, TaskKind> task{kControlKey, TaskKind::Readable};
+            {
+                std::lock_guard<std::mutex> guard(_taskMutex);
+                if (_tasks.empty())
+                {
+                    continue;
+                }
+                task = _tasks.front();
+                _tasks.pop_front();
+            }
+            Execute(task.first, task.second);
+        }
+    }
+#endif
+}
+
+void SerialReactor::Execute(std::uint64_t key, TaskKind kind)
+{
+    SerialPort* port = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(_registryMutex);
+        auto found = _registry.find(key);
+        if (found == _registry.end() || found->second.removed)
+        {
+            return;
+        }
+        ++found->second.busy;
+        port = found->second.port;
+    }
+    t_currentKey = key;
+    port->OnReactorTask(kind);
+    t_currentKey = kControlKey;
+    {
+        std::lock_guard<std::mutex> guard(_registryMutex);
+        auto found = _registry.find(key);
+        if (found != _registry.end())
+        {
+            --found->second.busy;
+            if (found->second.removed)
+            {
+                _idleSignal.notify_all();
+            }
+        }
+    }
+}
+
+void SerialReactor::CloseHandles()
+{
+#ifdef _WIN32
+    if (_handle != 0)
+    {
+        CloseHandle(reinterpret_cast<HANDLE>(_handle));
+    }
+#else
+    if (_wakeFd >= 0)
+    {
+        close(_wakeFd);
+        _wakeFd = -1;
+    }
+    if (_handle > 0)
+    {
+        close(static_cast<int>(_handle));
+    }
+#endif
+    _handle = 0;
+}
@@ -0,0 +1,86 @@
+/*------------------------------------------------------------------------
+名称：串口反应器模块
+说明：在少量线程上复用多个串口的读写事件，Linux 使用 epoll，Windows 使用完成端口
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：端口须在反应器 Stop 之前关闭
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "SerialTransport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class SerialPort;
+
+/// <summary>多端口共享的 I/O 事件循环。</summary>
+class SerialReactor
+{
+public:
+    SerialReactor();
+    ~SerialReactor();
+
+    SerialReactor(const SerialReactor&) = delete;
+    SerialReactor& operator=(const SerialReactor&) = delete;
+
+    /// <summary>启动事件线程；cpuAffinity 非空时第 i 个线程绑定到 cpuAffinity[i % size]。</summary>
+    bool Start(std::size_t threadCount, const std::vector<int>& cpuAffinity = {});
+
+    /// <summary>停止并等待全部事件线程退出。</summary>
+    void Stop();
+
+    /// <summary>反应器是否在运行。</summary>
+    bool IsRunning() const noexcept;
+
+private:
+    friend class SerialPort;
+
+    /// <summary>投递给端口的任务类型。</summary>
+    enum class TaskKind : std::uint32_t
+    {
+        Readable = 1,
+        Drain,
+        Flush
+    };
+
+    /// <summary>一个已注册端口的状态，busy 记录正在执行的任务数。</summary>
+    struct Registration
+    {
+        SerialPort* port = nullptr;
+        int busy = 0;
+        bool removed = false;
+    };
+
+    /// <summary>注册端口并请求首次可读通知，失败返回 0。</summary>
+    std::uint64_t Register(SerialPort& port, SerialTransport& transport);
+    /// <summary>注销端口，返回时不再有该端口的任务在执行。</summary>
+    void Unregister(std::uint64_t key);
+    /// <summary>把任务投递到事件线程。</summary>
+    void Post(std::uint64_t key, TaskKind kind);
+    void WorkerLoop();
+    void Execute(std::uint64_t key, TaskKind kind);
+    void CloseHandles();
+
+private:
+    std::atomic<bool> _running;
+    ReactorHandle _handle;
+    std::vector<std::thread> _workers;
+    std::mutex _registryMutex;
+    std::condition_variable _idleSignal;
+    std::unordered_map<std::uint64_t, Registration> _registry;
+    std::uint64_t _nextKey;
+#ifndef _WIN32
+    int _wakeFd;
+    std::mutex _taskMutex;
+    std::deque<std::pair<std::uint64_t, TaskKind>> _tasks;
+#endif
+};
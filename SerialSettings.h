@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------
+名称：串口参数定义
+说明：描述线路参数、流控、驱动队列与接收缓冲配置
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：由 CommandConfig 按端口持久化
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstddef>
+
+/// <summary>校验方式。</summary>
+enum class SerialParity
+{
+    None,
+    Odd,
+    Even,
+    Mark,
+    Space
+};
+
+/// <summary>停止位。</summary>
+enum class SerialStopBits
+{
+    One,
+    OnePointFive,
+    Two
+};
+
+/// <summary>流控方式。</summary>
+enum class FlowControl
+{
+    None,
+    RtsCts,
+    XonXoff
+};
+
+/// <summary>接收环写满时的处理策略。</summary>
+enum class OverrunPolicy
+{
+    /// <summary>丢弃新到达的字节并计数。</summary>
+    DropNewest,
+    /// <summary>暂停读取，由驱动队列与硬件流控承担背压。</summary>
+    Block
+};
+
+/// <summary>一个串口的完整配置。</summary>
+struct SerialSettings
+{
+    unsigned long baudRate = 115200;
+    unsigned char dataBits = 8;
+    SerialParity parity = SerialParity::None;
+    SerialStopBits stopBits = SerialStopBits::One;
+    FlowControl flowControl = FlowControl::None;
+    /// <summary>驱动接收队列大小，仅 Windows 生效。</summary>
+    std::size_t rxQueueSize = 4096;
+    /// <summary>驱动发送队列大小，仅 Windows 生效。</summary>
+    std::size_t txQueueSize = 4096;
+    /// <summary>单次读取的最大字节数。</summary>
+    std::size_t readChunkSize = 1024;
+    std::size_t ringCapacity = 64 * 1024;
+    OverrunPolicy overrunPolicy = OverrunPolicy::DropNewest;
+};
@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------
+名称：串口传输接口
+说明：抽象底层串口设备，屏蔽 Win32 与 POSIX 平台差异
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "SerialSettings.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>多路复用器句柄：Linux 下为 epoll 描述符，Windows 下为完成端口。</summary>
+using ReactorHandle = std::intptr_t;
+
+/// <summary>传输层操作结果。</summary>
+enum class TransportStatus
+{
+    Ok,
+    Cancelled,
+    Error,
+    /// <summary>设备已移除或挂断，须重新打开。</summary>
+    Disconnected
+};
+
+/// <summary>枚举到的串口。</summary>
+struct SerialPortInfo
+{
+    /// <summary>传给 Open 的端口名，例如 COM3 或 ttyUSB2。</summary>
+    std::wstring name;
+    /// <summary>稳定的硬件标识（USB 实例路径或 /dev/serial/by-id 名称），重新枚举后仍不变；未知时为空。</summary>
+    std::wstring hardwareId;
+};
+
+/// <summary>串口设备的最小操作集合，由 SerialPort 驱动。</summary>
+class SerialTransport
+{
+public:
+    virtual ~SerialTransport() = default;
+
+    /// <summary>打开设备并按配置进入原始字节流模式。</summary>
+    virtual bool Open(const std::wstring& portName, const SerialSettings& settings) = 0;
+
+    /// <summary>关闭设备，调用前应先停止等待线程。</summary>
+    virtual void Close() = 0;
+
+    /// <summary>设备是否处于打开状态。</summary>
+    virtual bool IsOpen() const noexcept = 0;
+
+    /// <summary>阻塞至有数据可读、被取消或出错。</summary>
+    virtual TransportStatus WaitReadable() = 0;
+
+    /// <summary>非阻塞读取已到达的字节，无数据时 bytesRead 为 0。</summary>
+    virtual TransportStatus Read(char* buffer, std::size_t capacity, std::size_t& bytesRead) = 0;
+
+    /// <summary>写入字节流，可能只写入部分数据。</summary>
+    virtual TransportStatus Write(const char* data, std::size_t size, std::size_t& bytesWritten) = 0;
+
+    /// <summary>唤醒所有阻塞中的等待与写入。</summary>
+    virtual void Cancel() = 0;
+
+    /// <summary>反应器模式：将设备关联到多路复用器，key 用于识别事件来源。</summary>
+    virtual bool AttachReactor(ReactorHandle reactor, std::uint64_t key) = 0;
+
+    /// <summary>反应器模式：请求下一次可读通知，每次通知后需重新调用。</summary>
+    virtual bool ArmReadable() = 0;
+
+    /// <summary>反应器模式：撤销通知并等待未完成的请求结束。</summary>
+    virtual void DetachReactor() = 0;
+};
+
+/// <summary>创建当前平台的串口传输实现。</summary>
+std::unique_ptr<SerialTransport> CreateSerialTransport();
+
+/// <summary>枚举当前平台的串口，按名称排序。</summary>
+std::vector<SerialPortInfo> EnumerateSerialPorts();
@@ -0,0 +1,540 @@
+/*------------------------------------------------------------------------
+名称：信号与注册状态采样实现
+说明：实现查询轮次、应答解析、原始采样与汇总的打包存储
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：原始采样占 2 个 64 位字，汇总占 4 个；汇总的累加和按一段至多 4095 次采样留足位宽
+------------------------------------------------------------------------*/
+#include "SignalSampler.h"
+#include "AtResponseParser.h"
+#include "TextEncoding.h"
+
+#include <algorithm>
+#include <array>
+#include <ctime>
+#include <string_view>
+
+namespace
+{
+    /// <summary>一段中的采样次数上限，累加和的位宽按此确定；超过时提前结束该段。</summary>
+    constexpr std::uint16_t kMaxBucketSamples = 4095;
+    constexpr auto kQueryTimeout = std::chrono::seconds(2);
+    /// <summary>模块忙时重新尝试提交的间隔。</summary>
+    constexpr auto kBusyRetry = std::chrono::milliseconds(200);
+    /// <summary>返回 ERROR 的查询暂停的轮数，按 30 秒一轮约一小时。</summary>
+    constexpr unsigned kSuspendRounds = 120;
+    /// <summary>新添加的模块按添加顺序错开首轮时间，多个模块的查询不会挤在同一时刻。</summary>
+    constexpr unsigned kStaggerSlots = 16;
+
+    enum class RoundState
+    {
+        Idle,
+        /// <summary>一条查询已提交，由其完成回调继续本轮。</summary>
+        InFlight,
+        /// <summary>模块忙，等采样线程稍后重试。</summary>
+        Waiting
+    };
+
+    std::uint8_t Known(int value, int unknown) noexcept
+    {
+        return value == unknown || value < 0 || value >= SignalSample::kUnknown ? SignalSample::kUnknown : static_cast<std::uint8_t>(value);
+    }
+
+    std::int64_t UnixNow() noexcept
+    {
+        return static_cast<std::int64_t>(std::time(nullptr));
+    }
+
+    std::uint64_t Field(std::uint64_t word, unsigned shift, unsigned bits) noexcept
+    {
+        return (word >> shift) & ((std::uint64_t(1) << bits) - 1);
+    }
+}
+
+bool SignalSample::IsRegistered() const noexcept
+{
+    RegistrationResponse response;
+    response.status = registration;
+    return registration != kUnknown && response.IsRegistered();
+}
+
+int SignalSample::RssiDbm() const noexcept
+{
+    if (rssi == kUnknown)
+    {
+        return 0;
+    }
+    CsqResponse response;
+    response.rssi = rssi;
+    return response.RssiDbm();
+}
+
+int SignalSample::RsrpDbm() const noexcept
+{
+    if (rsrp == kUnknown)
+    {
+        return 0;
+    }
+    CesqResponse response;
+    response.rsrp = rsrp;
+    return response.RsrpDbm();
+}
+
+void SignalSeries::RangeAccumulator::Add(std::uint8_t value) noexcept
+{
+    if (value == SignalSample::kUnknown)
+    {
+        return;
+    }
+    min = std::min(min, value);
+    max = std::max(max, value);
+    ++count;
+    sum += value;
+}
+
+void SignalSeries::Accumulator::Add(const SignalSample& sample) noexcept
+{
+    ++samples;
+    registered += sample.IsRegistered() ? 1 : 0;
+    rssi.Add(sample.rssi);
+    rsrp.Add(sample.rsrp);
+    rsrq.Add(sample.rsrq);
+}
+
+SignalSeries::SignalSeries(std::size_t recentCapacity, std::chrono::seconds bucket, std::size_t historyCapacity)
+    : _recent(std::max<std::size_t>(recentCapacity, 1)), _history(std::max<std::size_t>(historyCapacity, 1)),
+      _bucketSeconds(std::max<std::int64_t>(bucket.count(), 1))
+{
+}
+
+void SignalSeries::Append(const SignalSample& sample)
+{
+    const auto start = sample.time - sample.time % _bucketSeconds;
+    if (_current.samples != 0 && (start != _current.start || _current.samples >= kMaxBucketSamples))
+    {
+        _history.Push(Pack(_current));
+        _current = Accumulator{};
+    }
+    if (_current.samples == 0)
+    {
+        _current.start = start;
+    }
+    _current.Add(sample);
+    _recent.Push(Pack(sample));
+}
+
+void SignalSeries::SetOperatorName(const std::wstring& name)
+{
+    if (name == _lastOperator)
+    {
+        return;
+    }
+    _lastOperator = name;
+    std::lock_guard<std::mutex> guard(_operatorMutex);
+    _operator = name;
+}
+
+std::optional<SignalSample> SignalSeries::Latest() const
+{
+    std::vector<RecentRing::Record> records;
+    if (_recent.Read(1, records) == 0)
+    {
+        return std::nullopt;
+    }
+    return Unpack(records.front());
+}
+
+std::vector<SignalSample> SignalSeries::Recent(std::size_t maxCount) const
+{
+    std::vector<RecentRing::Record> records;
+    records.reserve(std::min(maxCount, _recent.Capacity()));
+    _recent.Read(maxCount, records);
+    std::vector<SignalSample> samples;
+    samples.reserve(records.size());
+    for (const auto& record : records)
+    {
+        samples.push_back(Unpack(record));
+    }
+    return samples;
+}
+
+std::vector<SignalAggregate> SignalSeries::History(std::size_t maxCount) const
+{
+    std::vector<HistoryRing::Record> records;
+    records.reserve(std::min(maxCount, _history.Capacity()));
+    _history.Read(maxCount, records);
+    std::vector<SignalAggregate> history;
+    history.reserve(records.size());
+    for (const auto& record : records)
+    {
+        history.push_back(Unpack(record));
+    }
+    return history;
+}
+
+SignalAggregate SignalSeries::Summarize(std::int64_t since) const
+{
+    Accumulator accumulator;
+    accumulator.start = since;
+    for (const auto& sample : Recent(_recent.Capacity()))
+    {
+        if (sample.time >= since && accumulator.samples < kMaxBucketSamples)
+        {
+            accumulator.Add(sample);
+        }
+    }
+    return Unpack(Pack(accumulator));
+}
+
+std::wstring SignalSeries::OperatorName() const
+{
+    std::lock_guard<std::mutex> guard(_operatorMutex);
+    return _operator;
+}
+
+std::size_t SignalSeries::MemoryUsage() const noexcept
+{
+    return _recent.Capacity() * (sizeof(std::uint64_t) * 3) + _history.Capacity() * (sizeof(std::uint64_t) * 5);
+}
+
+SignalSeries::RecentRing::Record SignalSeries::Pack(const SignalSample& sample) noexcept
+{
+    return {
+        static_cast<std::uint64_t>(sample.time),
+        std::uint64_t(sample.rssi) | std::uint64_t(sample.ber) << 8 | std::uint64_t(sample.rsrq) << 16 | std::uint64_t(sample.rsrp) << 24 |
+            std::uint64_t(sample.registration) << 32 | std::uint64_t(sample.accessTechnology) << 40
+    };
+}
+
+SignalSample SignalSeries::Unpack(const RecentRing::Record& record) noexcept
+{
+    SignalSample sample;
+    sample.time = static_cast<std::int64_t>(record[0]);
+    sample.rssi = static_cast<std::uint8_t>(Field(record[1], 0, 8));
+    sample.ber = static_cast<std::uint8_t>(Field(record[1], 8, 8));
+    sample.rsrq = static_cast<std::uint8_t>(Field(record[1], 16, 8));
+    sample.rsrp = static_cast<std::uint8_t>(Field(record[1], 24, 8));
+    sample.registration = static_cast<std::uint8_t>(Field(record[1], 32, 8));
+    sample.accessTechnology = static_cast<std::uint8_t>(Field(record[1], 40, 8));
+    return sample;
+}
+
+SignalSeries::HistoryRing::Record SignalSeries::Pack(const Accumulator& accumulator) noexcept
+{
+    // 字 1：次数；字 2：各项最小与最大值；字 3：rssi 累加和 20 位、rsrp 24 位、rsrq 20 位。
+    const auto& a = accumulator;
+    return {
+        static_cast<std::uint64_t>(a.start),
+        std::uint64_t(a.samples) | std::uint64_t(a.registered) << 16 | std::uint64_t(a.rssi.count) << 32 | std::uint64_t(a.rsrp.count) << 48,
+        std::uint64_t(a.rsrq.count) | std::uint64_t(a.rssi.min) << 16 | std::uint64_t(a.rssi.max) << 24 | std::uint64_t(a.rsrp.min) << 32 |
+            std::uint64_t(a.rsrp.max) << 40 | std::uint64_t(a.rsrq.min) << 48 | std::uint64_t(a.rsrq.max) << 56,
+        std::uint64_t(a.rssi.sum) | std::uint64_t(a.rsrp.sum) << 20 | std::uint64_t(a.rsrq.sum) << 44
+    };
+}
+
+SignalAggregate SignalSeries::Unpack(const HistoryRing::Record& record) noexcept
+{
+    const auto range = [](std::uint64_t count, std::uint64_t min, std::uint64_t max, std::uint64_t sum)
+    {
+        SignalRange result;
+        result.count = static_cast<std::uint16_t>(count);
+        if (count != 0)
+        {
+            result.min = static_cast<std::uint8_t>(min);
+            result.max = static_cast<std::uint8_t>(max);
+            result.average = static_cast<double>(sum) / static_cast<double>(count);
+        }
+        return result;
+    };
+    SignalAggregate aggregate;
+    aggregate.start = static_cast<std::int64_t>(record[0]);
+    aggregate.samples = static_cast<std::uint16_t>(Field(record[1], 0, 16));
+    aggregate.registered = static_cast<std::uint16_t>(Field(record[1], 16, 16));
+    aggregate.rssi = range(Field(record[1], 32, 16), Field(record[2], 16, 8), Field(record[2], 24, 8), Field(record[3], 0, 20));
+    aggregate.rsrp = range(Field(record[1], 48, 16), Field(record[2], 32, 8), Field(record[2], 40, 8), Field(record[3], 20, 24));
+    aggregate.rsrq = range(Field(record[2], 0, 16), Field(record[2], 48, 8), Field(record[2], 56, 8), Field(record[3], 44, 20));
+    return aggregate;
+}
+
+struct SignalSampler::Target
+{
+    AtSession* session = nullptr;
+    std::shared_ptr<SignalSeries> series;
+    std::atomic<RoundState> state{RoundState::Idle};
+    std::atomic<bool> removed{false};
+    /// <summary>以下字段由持有本轮的一方使用：Idle 与 Waiting 时为采样线程，InFlight 时为查询的完成回调。</summary>
+    Clock::time_point due;
+    Clock::time_point roundStartedAt;
+    std::size_t step = 0;
+    SignalSample sample;
+    bool collected = false;
+    std::wstring operatorName;
+    std::array<unsigned, 4> suspended{};
+};
+
+namespace
+{
+    using SampleParser = void (*)(std::string_view line, SignalSample& sample, std::wstring& operatorName);
+
+    struct SignalQuery
+    {
+        std::wstring_view command;
+        SampleParser parse;
+    };
+
+    const std::array<SignalQuery, 4> kQueries{{
+        {L"AT+CSQ", [](std::string_view line, SignalSample& sample, std::wstring&)
+        {
+            if (const auto csq = ParseCsq(line))
+            {
+                sample.rssi = csq->HasSignal() ? Known(csq->rssi, 99) : SignalSample::kUnknown;
+                sample.ber = Known(csq->ber, 99);
+            }
+        }},
+        {L"AT+CESQ", [](std::string_view line, SignalSample& sample, std::wstring&)
+        {
+            if (const auto cesq = ParseCesq(line))
+            {
+                sample.rsrq = Known(cesq->rsrq, 255);
+                sample.rsrp = Known(cesq->rsrp, 255);
+            }
+        }},
+        {L"AT+CEREG?", [](std::string_view line, SignalSample& sample, std::wstring&)
+        {
+            if (const auto registration = ParseRegistration(line); registration && registration->domain == RegistrationDomain::Eps)
+            {
+                sample.registration = Known(registration->status, -1);
+            }
+        }},
+        {L"AT+COPS?", [](std::string_view line, SignalSample& sample, std::wstring& operatorName)
+        {
+            if (const auto cops = ParseCops(line))
+            {
+                operatorName = Utf8ToWide(cops->operatorName);
+                sample.accessTechnology = Known(cops->accessTechnology, -1);
+            }
+        }}
+    }};
+}
+
+SignalSampler::SignalSampler(const SignalSamplerPolicy& policy)
+    : _policy(policy), _stopping(true)
+{
+}
+
+SignalSampler::~SignalSampler()
+{
+    Stop();
+}
+
+void SignalSampler::SetPolicy(const SignalSamplerPolicy& policy)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _policy = policy;
+}
+
+std::shared_ptr<const SignalSeries> SignalSampler::Add(AtSession& session)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (const auto& target : _targets)
+    {
+        if (target->session == &session)
+        {
+            return target->series;
+        }
+    }
+    auto target = std::make_shared<Target>();
+    target->session = &session;
+    target->series = std::make_shared<SignalSeries>(_policy.recentCapacity, _policy.bucket, _policy.historyCapacity);
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::max(_policy.interval, std::chrono::seconds(1)));
+    target->due = Clock::now() + interval * static_cast<long long>(_targets.size() % kStaggerSlots) / kStaggerSlots;
+    _targets.push_back(target);
+    _signal.notify_all();
+    return target->series;
+}
+
+void SignalSampler::Remove(AtSession& session)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    const auto found = std::find_if(_targets.begin(), _targets.end(), [&session](const std::shared_ptr<Target>& target)
+    {
+        return target->session == &session;
+    });
+    if (found != _targets.end())
+    {
+        (*found)->removed = true;
+        _targets.erase(found);
+    }
+}
+
+std::shared_ptr<const SignalSeries> SignalSampler::Find(const AtSession& session) const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (const auto& target : _targets)
+    {
+        if (target->session == &session)
+        {
+            return target->series;
+        }
+    }
+    return nullptr;
+}
+
+void SignalSampler::Start()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_worker.joinable())
+    {
+        return;
+    }
+    _stopping = false;
+    _worker = std::thread(&SignalSampler::WorkerLoop, this);
+}
+
+void SignalSampler::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _stopping = true;
+    }
+    _signal.notify_all();
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+void SignalSampler::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        const auto now = Clock::now();
+        const auto interval = std::chrono::duration_cast<Clock::duration>(std::max(_policy.interval, std::chrono::seconds(1)));
+        auto wakeAt = Clock::time_point::max();
+        for (const auto& target : _targets)
+        {
+            const auto state = target->state.load(std::memory_order_acquire);
+            if (state == RoundState::Waiting)
+            {
+                // 模块一直忙（例如群发中）超过一个周期时，本轮以已取得的字段结束，不与下一轮重叠。
+                if (now - target->roundStartedAt >= interval)
+                {
+                    FinishRound(*target);
+                }
+                else
+                {
+                    RunStep(target);
+                    wakeAt = std::min(wakeAt, now + kBusyRetry);
+                }
+                continue;
+            }
+            if (state != RoundState::Idle)
+            {
+                continue;
+            }
+            if (now < target->due)
+            {
+                wakeAt = std::min(wakeAt, target->due);
+                continue;
+            }
+            target->due += interval;
+            if (target->due <= now)
+            {
+                target->due = now + interval;
+            }
+            wakeAt = std::min(wakeAt, target->due);
+            if (!target->session->IsConnected())
+            {
+                continue;
+            }
+            target->roundStartedAt = now;
+            target->step = 0;
+            target->sample = SignalSample{};
+            target->sample.time = UnixNow();
+            target->collected = false;
+            for (auto& rounds : target->suspended)
+            {
+                rounds -= rounds != 0 ? 1 : 0;
+            }
+            RunStep(target);
+            if (target->state.load(std::memory_order_acquire) == RoundState::Waiting)
+            {
+                wakeAt = std::min(wakeAt, now + kBusyRetry);
+            }
+        }
+        if (wakeAt == Clock::time_point::max())
+        {
+            _signal.wait(lock);
+        }
+        else
+        {
+            _signal.wait_until(lock, wakeAt);
+        }
+    }
+}
+
+void SignalSampler::RunStep(const std::shared_ptr<Target>& target)
+{
+    while (target->step < kQueries.size() && target->suspended[target->step] != 0)
+    {
+        ++target->step;
+    }
+    if (target->step >= kQueries.size() || target->removed)
+    {
+        FinishRound(*target);
+        return;
+    }
+    const auto step = target->step;
+    target->state.store(RoundState::InFlight, std::memory_order_release);
+    // 模块忙时回调立即以 NotSent 执行并把状态改为 Waiting。
+    target->session->SubmitBackgroundCommand(std::wstring(kQueries[step].command), kQueryTimeout, [target, step](const AtCommandResult& result)
+    {
+        OnResult(target, step, result);
+    });
+}
+
+void SignalSampler::OnResult(const std::shared_ptr<Target>& target, std::size_t step, const AtCommandResult& result)
+{
+    switch (result.code)
+    {
+    case AtResultCode::NotSent:
+        if (target->session->IsConnected() && !target->removed)
+        {
+            target->state.store(RoundState::Waiting, std::memory_order_release);
+            return;
+        }
+        FinishRound(*target);
+        return;
+    case AtResultCode::Cancelled:
+        FinishRound(*target);
+        return;
+    case AtResultCode::Ok:
+        for (const auto& line : result.lines)
+        {
+            kQueries[step].parse(line, target->sample, target->operatorName);
+        }
+        target->collected = true;
+        break;
+    case AtResultCode::Error:
+    case AtResultCode::CmeError:
+        target->suspended[step] = kSuspendRounds;
+        break;
+    default:
+        break;
+    }
+    target->step = step + 1;
+    RunStep(target);
+}
+
+void SignalSampler::FinishRound(Target& target)
+{
+    if (target.collected)
+    {
+        target.series->Append(target.sample);
+        target.series->SetOperatorName(target.operatorName);
+        target.collected = false;
+    }
+    target.state.store(RoundState::Idle, std::memory_order_release);
+}
@@ -0,0 +1,211 @@
+/*------------------------------------------------------------------------
+名称：信号与注册状态采样
+说明：后台定时查询各模块的 +CSQ、+CESQ、+CEREG? 与 +COPS?，结果存入每个模块一份的定长时间序列
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：采样指令只在模块空闲时写出，不写日志；时间序列在添加模块时一次分配，长期运行内存不增长
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtSession.h"
+#include "SeqlockRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>一次采样，取值为 27.007 的原始编码，未知或模块不支持的字段为 kUnknown。</summary>
+struct SignalSample
+{
+    static constexpr std::uint8_t kUnknown = 0xFF;
+
+    /// <summary>本轮开始的时间（Unix 秒）。</summary>
+    std::int64_t time = 0;
+    /// <summary>+CSQ 的 &lt;rssi&gt;，0 到 31。</summary>
+    std::uint8_t rssi = kUnknown;
+    std::uint8_t ber = kUnknown;
+    /// <summary>+CESQ 的 &lt;rsrq&gt;，0 到 34。</summary>
+    std::uint8_t rsrq = kUnknown;
+    /// <summary>+CESQ 的 &lt;rsrp&gt;，0 到 97。</summary>
+    std::uint8_t rsrp = kUnknown;
+    /// <summary>+CEREG? 的 &lt;stat&gt;。</summary>
+    std::uint8_t registration = kUnknown;
+    /// <summary>+COPS? 的 &lt;AcT&gt;，7 为 LTE。</summary>
+    std::uint8_t accessTechnology = kUnknown;
+
+    bool IsRegistered() const noexcept;
+    /// <summary>信号强度（dBm），未知时返回 0。</summary>
+    int RssiDbm() const noexcept;
+    /// <summary>LTE 参考信号接收功率（dBm），未知时返回 0。</summary>
+    int RsrpDbm() const noexcept;
+};
+
+/// <summary>一个时间段内某项指标的范围，取值为原始编码；count 为 0 表示该段没有有效值。</summary>
+struct SignalRange
+{
+    std::uint8_t min = SignalSample::kUnknown;
+    std::uint8_t max = SignalSample::kUnknown;
+    std::uint16_t count = 0;
+    double average = 0.0;
+};
+
+/// <summary>一个时间段的汇总。</summary>
+struct SignalAggregate
+{
+    /// <summary>时间段的起点（Unix 秒，按段长对齐）。</summary>
+    std::int64_t start = 0;
+    std::uint16_t samples = 0;
+    /// <summary>已注册网络的采样次数。</summary>
+    std::uint16_t registered = 0;
+    SignalRange rssi;
+    SignalRange rsrp;
+    SignalRange rsrq;
+};
+
+/// <summary>
+/// 一个模块的信号时间序列：最近的原始采样与按时间段汇总的历史各存一个定长环。
+/// 只有采样器写入，界面等任意线程可随时读取，读写都不加锁。
+/// </summary>
+class SignalSeries
+{
+public:
+    SignalSeries(std::size_t recentCapacity, std::chrono::seconds bucket, std::size_t historyCapacity);
+
+    SignalSeries(const SignalSeries&) = delete;
+    SignalSeries& operator=(const SignalSeries&) = delete;
+
+    /// <summary>写入方：追加一次采样；跨入新的时间段时把上一段的汇总写入历史。</summary>
+    void Append(const SignalSample& sample);
+
+    /// <summary>写入方：更新当前运营商名称，与上次相同时不加锁。</summary>
+    void SetOperatorName(const std::wstring& name);
+
+    std::optional<SignalSample> Latest() const;
+
+    /// <summary>最近至多 maxCount 次原始采样，从旧到新。</summary>
+    std::vector<SignalSample> Recent(std::size_t maxCount) const;
+
+    /// <summary>最近至多 maxCount 个已结束时间段的汇总，从旧到新；当前未结束的一段不在其中。</summary>
+    std::vector<SignalAggregate> History(std::size_t maxCount) const;
+
+    /// <summary>汇总 since（Unix 秒）及之后的原始采样，例如最近十分钟的最小、最大与平均值。</summary>
+    SignalAggregate Summarize(std::int64_t since) const;
+
+    std::wstring OperatorName() const;
+
+    /// <summary>两个环占用的字节数，构造后不变。</summary>
+    std::size_t MemoryUsage() const noexcept;
+
+private:
+    /// <summary>汇总中的一项指标，只由写入方使用。</summary>
+    struct RangeAccumulator
+    {
+        std::uint8_t min = SignalSample::kUnknown;
+        std::uint8_t max = 0;
+        std::uint16_t count = 0;
+        std::uint32_t sum = 0;
+
+        void Add(std::uint8_t value) noexcept;
+    };
+
+    struct Accumulator
+    {
+        std::int64_t start = 0;
+        std::uint16_t samples = 0;
+        std::uint16_t registered = 0;
+        RangeAccumulator rssi;
+        RangeAccumulator rsrp;
+        RangeAccumulator rsrq;
+
+        void Add(const SignalSample& sample) noexcept;
+    };
+
+    using RecentRing = SeqlockRing<2>;
+    using HistoryRing = SeqlockRing<4>;
+
+    static RecentRing::Record Pack(const SignalSample& sample) noexcept;
+    static SignalSample Unpack(const RecentRing::Record& record) noexcept;
+    static HistoryRing::Record Pack(const Accumulator& accumulator) noexcept;
+    static SignalAggregate Unpack(const HistoryRing::Record& record) noexcept;
+
+private:
+    RecentRing _recent;
+    HistoryRing _history;
+    std::int64_t _bucketSeconds;
+    /// <summary>当前时间段的汇总，只由写入方使用。</summary>
+    Accumulator _current;
+    /// <summary>写入方上次设置的运营商名称，用于判断是否变化。</summary>
+    std::wstring _lastOperator;
+    mutable std::mutex _operatorMutex;
+    std::wstring _operator;
+};
+
+/// <summary>采样周期与时间序列的容量。</summary>
+struct SignalSamplerPolicy
+{
+    std::chrono::seconds interval{30};
+    /// <summary>保留的原始采样次数，按 30 秒一次约 8.5 小时。</summary>
+    std::size_t recentCapacity = 1024;
+    /// <summary>历史汇总的时间段长度。</summary>
+    std::chrono::seconds bucket{600};
+    /// <summary>保留的历史时间段数，按 10 分钟一段约 28 天。</summary>
+    std::size_t historyCapacity = 4096;
+};
+
+/// <summary>
+/// 多个模块共用一个采样线程：每轮对一个模块依次发出查询，每条都只在模块没有在途与排队指令时提交，
+/// 用户指令至多等待一条短查询。模块不支持的查询（返回 ERROR）暂停一段时间后再试。
+/// </summary>
+class SignalSampler
+{
+public:
+    explicit SignalSampler(const SignalSamplerPolicy& policy = {});
+    ~SignalSampler();
+
+    SignalSampler(const SignalSampler&) = delete;
+    SignalSampler& operator=(const SignalSampler&) = delete;
+
+    /// <summary>新策略对之后添加的模块生效，已添加模块的容量不变。</summary>
+    void SetPolicy(const SignalSamplerPolicy& policy);
+
+    /// <summary>开始采样一个模块并返回其时间序列，重复添加返回已有的序列；未连接时跳过该轮。</summary>
+    std::shared_ptr<const SignalSeries> Add(AtSession& session);
+
+    /// <summary>停止采样一个模块，须在会话析构之前、断开之后调用。</summary>
+    void Remove(AtSession& session);
+
+    std::shared_ptr<const SignalSeries> Find(const AtSession& session) const;
+
+    void Start();
+
+    /// <summary>停止采样线程；在途的查询照常完成，但不再开始新的查询。</summary>
+    void Stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Target;
+
+    void WorkerLoop();
+    /// <summary>提交本轮下一条仍受支持的查询，没有时结束本轮。</summary>
+    static void RunStep(const std::shared_ptr<Target>& target);
+    static void OnResult(const std::shared_ptr<Target>& target, std::size_t step, const AtCommandResult& result);
+    /// <summary>把本轮已取得的字段写入时间序列。</summary>
+    static void FinishRound(Target& target);
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _signal;
+    SignalSamplerPolicy _policy;
+    std::vector<std::shared_ptr<Target>> _targets;
+    bool _stopping;
+    std::thread _worker;
+};
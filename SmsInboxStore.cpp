@@ -0,0 +1,797 @@
+/*------------------------------------------------------------------------
+名称：短信收件箱存储实现
+说明：实现日志记录格式、索引段的写入与合并、崩溃后的恢复以及查询
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：记录写入映射页后即对其他进程可见，进程崩溃不丢失；系统掉电时未写回的尾部记录由校验和识别并截去
+------------------------------------------------------------------------*/
+#include "SmsInboxStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+namespace
+{
+    constexpr char kLogMagic[8] = {'A', 'T', 'S', 'M', 'S', 'L', 'O', 'G'};
+    constexpr char kSegmentMagic[8] = {'A', 'T', 'S', 'M', 'S', 'I', 'D', 'X'};
+    constexpr std::uint32_t kFormatVersion = 1;
+    constexpr std::uint64_t kInitialLogSize = 1u << 20;
+    /// <summary>日志每次扩展的上限，避免大文件一次翻倍占用过多磁盘。</summary>
+    constexpr std::uint64_t kMaxLogGrowth = 64u << 20;
+    /// <summary>内存表的容量，达到后写成索引段。</summary>
+    constexpr std::size_t kMemoryLimit = 16384;
+    /// <summary>合并后的段超过该条数时不再合并，限制单次合并的耗时。</summary>
+    constexpr std::size_t kMaxMergeEntries = std::size_t{1} << 19;
+    /// <summary>号码前缀匹配的候选不超过该条数时直接排序，否则改为沿时间索引过滤。</summary>
+    constexpr std::size_t kPrefixCollectLimit = 4096;
+
+    struct LogHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t end;
+        std::uint8_t padding[40];
+    };
+
+    /// <summary>日志记录头，其后依次为模块、号码与正文，整条记录按 8 字节对齐。</summary>
+    struct RecordHeader
+    {
+        std::uint32_t size;
+        /// <summary>记录中其余字节（含本头部 checksum 之后的字段）的 FNV-1a 校验和。</summary>
+        std::uint32_t checksum;
+        std::int64_t timestamp;
+        std::int64_t receivedAt;
+        std::int32_t storageIndex;
+        std::int16_t quarterHours;
+        std::uint16_t modemLength;
+        std::uint16_t senderLength;
+        std::uint16_t reserved;
+        std::uint32_t bodyLength;
+    };
+
+    struct SegmentHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t generation;
+        std::uint64_t logBegin;
+        std::uint64_t logEnd;
+        std::uint64_t count;
+        std::uint8_t padding[16];
+    };
+
+    static_assert(sizeof(LogHeader) == 64 && sizeof(SegmentHeader) == 64, "file headers are 64 bytes");
+    static_assert(sizeof(RecordHeader) == 40, "record header is 40 bytes");
+
+    constexpr std::uint64_t kChecksumSkip = offsetof(RecordHeader, timestamp);
+
+    std::uint64_t AlignRecord(std::uint64_t size) noexcept
+    {
+        return (size + 7) & ~std::uint64_t{7};
+    }
+
+    std::uint32_t Fnv32(const char* data, std::size_t size, std::uint32_t hash = 2166136261u) noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    std::uint64_t Fnv64(std::string_view data, std::uint64_t hash = 14695981039346656037ull) noexcept
+    {
+        for (const char ch : data)
+        {
+            hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    std::uint64_t Fnv64Value(T value, std::uint64_t hash) noexcept
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        return Fnv64(std::string_view(bytes, sizeof(T)), hash);
+    }
+
+    /// <summary>去重键：模块、存储索引与时间戳；没有存储索引的直接上报再加上号码与正文。</summary>
+    std::uint64_t DedupeKey(const SmsInboxEntry& entry) noexcept
+    {
+        std::uint64_t hash = Fnv64(entry.modem);
+        hash = Fnv64Value(entry.storageIndex, hash);
+        hash = Fnv64Value(entry.timestamp, hash);
+        if (entry.storageIndex < 0)
+        {
+            hash = Fnv64(entry.body, Fnv64Value('\0', Fnv64(entry.sender, hash)));
+        }
+        return hash;
+    }
+
+    bool SameMessage(const SmsInboxEntry& left, const SmsInboxEntry& right) noexcept
+    {
+        if (left.modem != right.modem || left.storageIndex != right.storageIndex || left.timestamp != right.timestamp)
+        {
+            return false;
+        }
+        return left.storageIndex >= 0 || (left.sender == right.sender && left.body == right.body);
+    }
+
+    /// <summary>大于所有以 prefix 开头的字符串的最小字符串；prefix 全为 0xFF 时不存在。</summary>
+    std::optional<std::string> PrefixSuccessor(std::string_view prefix)
+    {
+        std::string successor(prefix);
+        while (!successor.empty())
+        {
+            auto& last = reinterpret_cast<unsigned char&>(successor.back());
+            if (last != 0xFF)
+            {
+                ++last;
+                return successor;
+            }
+            successor.pop_back();
+        }
+        return std::nullopt;
+    }
+
+    std::int64_t UnixNow() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::filesystem::path SegmentPath(const std::filesystem::path& logPath, std::uint64_t generation)
+    {
+        auto path = logPath;
+        path += L"." + std::to_wstring(generation) + L".idx";
+        return path;
+    }
+
+    /// <summary>从 "日志文件名.序号.idx" 中取出序号，不是索引段文件时返回空。</summary>
+    std::optional<std::uint64_t> ParseSegmentName(const std::wstring& name, const std::wstring& logName)
+    {
+        constexpr std::wstring_view suffix = L".idx";
+        if (name.size() <= logName.size() + 1 + suffix.size() || name.compare(0, logName.size(), logName) != 0
+            || name[logName.size()] != L'.' || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            return std::nullopt;
+        }
+        std::uint64_t generation = 0;
+        for (std::size_t i = logName.size() + 1; i < name.size() - suffix.size(); ++i)
+        {
+            if (name[i] < L'0' || name[i] > L'9')
+            {
+                return std::nullopt;
+            }
+            generation = generation * 10 + static_cast<std::uint64_t>(name[i] - L'0');
+        }
+        return generation;
+    }
+}
+
+SmsInboxStore::IndexLess::IndexLess(const SmsInboxStore* store, IndexKind kind) noexcept
+    : _store(store), _kind(kind)
+{
+}
+
+bool SmsInboxStore::IndexLess::operator()(const IndexEntry& left, const IndexEntry& right) const
+{
+    return Less(KeyOf(left), KeyOf(right));
+}
+
+bool SmsInboxStore::IndexLess::operator()(const IndexEntry& left, const IndexKey& right) const
+{
+    return Less(KeyOf(left), right);
+}
+
+bool SmsInboxStore::IndexLess::operator()(const IndexKey& left, const IndexEntry& right) const
+{
+    return Less(left, KeyOf(right));
+}
+
+bool SmsInboxStore::IndexLess::Less(const IndexKey& left, const IndexKey& right) const noexcept
+{
+    if (_kind == BySender || _kind == ByModem)
+    {
+        if (const int order = left.text.compare(right.text); order != 0)
+        {
+            return order < 0;
+        }
+    }
+    if (left.key != right.key)
+    {
+        // 去重散列按无符号比较，其余索引的 key 为时间戳。
+        return _kind == ByDedupe ? static_cast<std::uint64_t>(left.key) < static_cast<std::uint64_t>(right.key) : left.key < right.key;
+    }
+    return left.offset < right.offset;
+}
+
+SmsInboxStore::IndexKey SmsInboxStore::IndexLess::KeyOf(const IndexEntry& entry) const
+{
+    IndexKey key{{}, entry.key, entry.offset};
+    if (_kind == BySender)
+    {
+        key.text = _store->ReadEntry(entry.offset).sender;
+    }
+    else if (_kind == ByModem)
+    {
+        key.text = _store->ReadEntry(entry.offset).modem;
+    }
+    return key;
+}
+
+const SmsInboxStore::IndexEntry* SmsInboxStore::Segment::Entries(IndexKind kind) const noexcept
+{
+    return reinterpret_cast<const IndexEntry*>(file.Data() + sizeof(SegmentHeader)) + kind * count;
+}
+
+SmsInboxStore::SmsInboxStore()
+    : _logEnd(0),
+      _memory{MemoryIndex(IndexLess(this, ByTime)), MemoryIndex(IndexLess(this, BySender)), MemoryIndex(IndexLess(this, ByModem)),
+              MemoryIndex(IndexLess(this, ByDedupe))},
+      _memoryBegin(0), _nextGeneration(1)
+{
+}
+
+SmsInboxStore::~SmsInboxStore()
+{
+    Close();
+}
+
+bool SmsInboxStore::Open(const std::filesystem::path& logPath)
+{
+    Close();
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_log.Open(logPath, true))
+    {
+        return false;
+    }
+    if (_log.Size() == 0)
+    {
+        if (!_log.Resize(kInitialLogSize))
+        {
+            _log.Close();
+            return false;
+        }
+        _logEnd = sizeof(LogHeader);
+        WriteHeader();
+    }
+    else
+    {
+        LogHeader header{};
+        if (_log.Size() >= sizeof(LogHeader))
+        {
+            std::memcpy(&header, _log.Data(), sizeof(header));
+        }
+        // 不认识的文件不覆盖。
+        if (_log.Size() < sizeof(LogHeader) || std::memcmp(header.magic, kLogMagic, sizeof(kLogMagic)) != 0 || header.version != kFormatVersion
+            || header.end < sizeof(LogHeader) || header.end > _log.Size())
+        {
+            _log.Close();
+            return false;
+        }
+        _logEnd = header.end;
+    }
+    _logPath = logPath;
+    LoadSegments();
+    RecoverTail(_memoryBegin);
+    return true;
+}
+
+void SmsInboxStore::Close()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_log.IsOpen())
+    {
+        return;
+    }
+    FlushMemory();
+    // 去掉预留的空白部分，下次写入时再扩展。
+    _log.Resize(_logEnd);
+    _log.Flush();
+    _log.Close();
+    _segments.clear();
+    for (auto& index : _memory)
+    {
+        index.clear();
+    }
+    _logEnd = 0;
+    _memoryBegin = 0;
+}
+
+bool SmsInboxStore::IsOpen() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _log.IsOpen();
+}
+
+SmsInboxWrite SmsInboxStore::Append(const SmsInboxEntry& entry)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_log.IsOpen() || entry.modem.size() > 0xFFFF || entry.sender.size() > 0xFFFF || entry.body.size() > 0xFFFFFFFFu)
+    {
+        return SmsInboxWrite::Failed;
+    }
+    SmsInboxEntry stored = entry;
+    stored.receivedAt = UnixNow();
+    if (stored.timestamp == 0)
+    {
+        stored.timestamp = stored.receivedAt;
+    }
+    const std::uint64_t dedupeKey = DedupeKey(stored);
+    if (IsDuplicate(stored, dedupeKey))
+    {
+        return SmsInboxWrite::Duplicate;
+    }
+
+    const std::uint64_t payload = stored.modem.size() + stored.sender.size() + stored.body.size();
+    const std::uint64_t size = AlignRecord(sizeof(RecordHeader) + payload);
+    if (size > 0xFFFFFFFFu || !EnsureCapacity(_logEnd + size))
+    {
+        return SmsInboxWrite::Failed;
+    }
+    RecordHeader header{};
+    header.size = static_cast<std::uint32_t>(size);
+    header.timestamp = stored.timestamp;
+    header.receivedAt = stored.receivedAt;
+    header.storageIndex = stored.storageIndex;
+    header.quarterHours = static_cast<std::int16_t>(stored.quarterHours);
+    header.modemLength = static_cast<std::uint16_t>(stored.modem.size());
+    header.senderLength = static_cast<std::uint16_t>(stored.sender.size());
+    header.bodyLength = static_cast<std::uint32_t>(stored.body.size());
+
+    char* record = _log.Data() + _logEnd;
+    char* cursor = record + sizeof(RecordHeader);
+    for (const auto field : {stored.modem, stored.sender, stored.body})
+    {
+        std::memcpy(cursor, field.data(), field.size());
+        cursor += field.size();
+    }
+    std::memset(cursor, 0, static_cast<std::size_t>(record + size - cursor));
+    std::memcpy(record, &header, sizeof(header));
+    header.checksum = Fnv32(record + kChecksumSkip, static_cast<std::size_t>(size - kChecksumSkip));
+    std::memcpy(record, &header, sizeof(header));
+
+    // 先写记录再推进头部中的末尾位置，中途崩溃时这条记录不算提交。
+    const std::uint64_t offset = _logEnd;
+    _logEnd += size;
+    WriteHeader();
+    Insert(offset, stored, dedupeKey);
+    if (_memory[ByTime].size() >= kMemoryLimit)
+    {
+        FlushMemory();
+    }
+    return SmsInboxWrite::Stored;
+}
+
+std::size_t SmsInboxStore::Find(const SmsInboxQuery& query, const Visitor& visitor) const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_log.IsOpen() || query.limit == 0 || query.from > query.to)
+    {
+        return 0;
+    }
+    std::vector<IndexEntry> scratch;
+    if (!query.sender.empty() && !query.senderPrefix)
+    {
+        return VisitNewestFirst(CollectRanges(BySender, {query.sender, query.from, 0}, IndexKey{query.sender, query.to, UINT64_MAX}, scratch),
+                                query, visitor);
+    }
+    if (!query.sender.empty())
+    {
+        // 同一前缀下的各号码在索引中分属不同区间，候选不多时合并排序，否则沿时间索引过滤。
+        const auto successor = PrefixSuccessor(query.sender);
+        const auto ranges = CollectRanges(BySender, {query.sender, std::numeric_limits<std::int64_t>::min(), 0},
+                                          successor ? std::optional<IndexKey>(IndexKey{*successor, std::numeric_limits<std::int64_t>::min(), 0})
+                                                    : std::nullopt,
+                                          scratch);
+        std::size_t candidates = 0;
+        for (const auto& range : ranges)
+        {
+            candidates += static_cast<std::size_t>(range.last - range.first);
+        }
+        if (candidates <= kPrefixCollectLimit)
+        {
+            std::vector<IndexEntry> sorted;
+            sorted.reserve(candidates);
+            for (const auto& range : ranges)
+            {
+                sorted.insert(sorted.end(), range.first, range.last);
+            }
+            const IndexLess byTime(this, ByTime);
+            std::sort(sorted.begin(), sorted.end(), byTime);
+            return VisitNewestFirst({IndexRange{sorted.data(), sorted.data() + sorted.size()}}, query, visitor);
+        }
+    }
+    else if (!query.modem.empty())
+    {
+        return VisitNewestFirst(CollectRanges(ByModem, {query.modem, query.from, 0}, IndexKey{query.modem, query.to, UINT64_MAX}, scratch),
+                                query, visitor);
+    }
+    std::vector<IndexEntry> timeScratch;
+    return VisitNewestFirst(CollectRanges(ByTime, {{}, query.from, 0}, IndexKey{{}, query.to, UINT64_MAX}, timeScratch), query, visitor);
+}
+
+std::size_t SmsInboxStore::Size() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    std::size_t count = _memory[ByTime].size();
+    for (const auto& segment : _segments)
+    {
+        count += segment.count;
+    }
+    return count;
+}
+
+SmsInboxEntry SmsInboxStore::ReadEntry(std::uint64_t offset) const
+{
+    RecordHeader header;
+    const char* record = _log.Data() + offset;
+    std::memcpy(&header, record, sizeof(header));
+    const char* text = record + sizeof(RecordHeader);
+    SmsInboxEntry entry;
+    entry.modem = std::string_view(text, header.modemLength);
+    entry.sender = std::string_view(text + header.modemLength, header.senderLength);
+    entry.body = std::string_view(text + header.modemLength + header.senderLength, header.bodyLength);
+    entry.timestamp = header.timestamp;
+    entry.quarterHours = header.quarterHours;
+    entry.storageIndex = header.storageIndex;
+    entry.receivedAt = header.receivedAt;
+    return entry;
+}
+
+bool SmsInboxStore::IsDuplicate(const SmsInboxEntry& entry, std::uint64_t key) const
+{
+    const IndexKey probe{{}, static_cast<std::int64_t>(key), 0};
+    const auto matches = [&](auto first, auto last)
+    {
+        return std::any_of(first, last, [&](const IndexEntry& candidate)
+        {
+            return SameMessage(ReadEntry(candidate.offset), entry);
+        });
+    };
+    const IndexLess less(this, ByDedupe);
+    for (const auto& segment : _segments)
+    {
+        const auto* begin = segment.Entries(ByDedupe);
+        const auto* first = std::lower_bound(begin, begin + segment.count, probe, less);
+        const auto* last = first;
+        while (last != begin + segment.count && last->key == probe.key)
+        {
+            ++last;
+        }
+        if (matches(first, last))
+        {
+            return true;
+        }
+    }
+    const auto& memory = _memory[ByDedupe];
+    auto first = memory.lower_bound(probe);
+    auto last = first;
+    while (last != memory.end() && last->key == probe.key)
+    {
+        ++last;
+    }
+    return matches(first, last);
+}
+
+bool SmsInboxStore::EnsureCapacity(std::uint64_t required)
+{
+    if (required <= _log.Size())
+    {
+        return true;
+    }
+    const std::uint64_t grown = _log.Size() + std::min(std::max<std::uint64_t>(_log.Size(), kInitialLogSize), kMaxLogGrowth);
+    return _log.Resize(std::max(grown, AlignRecord(required)));
+}
+
+void SmsInboxStore::Insert(std::uint64_t offset, const SmsInboxEntry& entry, std::uint64_t dedupeKey)
+{
+    _memory[ByTime].insert(IndexEntry{entry.timestamp, offset});
+    _memory[BySender].insert(IndexEntry{entry.timestamp, offset});
+    _memory[ByModem].insert(IndexEntry{entry.timestamp, offset});
+    _memory[ByDedupe].insert(IndexEntry{static_cast<std::int64_t>(dedupeKey), offset});
+}
+
+void SmsInboxStore::RecoverTail(std::uint64_t begin)
+{
+    std::uint64_t offset = begin;
+    while (offset < _logEnd)
+    {
+        RecordHeader header{};
+        bool valid = _logEnd - offset >= sizeof(RecordHeader);
+        if (valid)
+        {
+            std::memcpy(&header, _log.Data() + offset, sizeof(header));
+            const std::uint64_t payload = std::uint64_t{header.modemLength} + header.senderLength + header.bodyLength;
+            valid = header.size % 8 == 0 && header.size == AlignRecord(sizeof(RecordHeader) + payload) && header.size <= _logEnd - offset
+                && header.checksum == Fnv32(_log.Data() + offset + kChecksumSkip, static_cast<std::size_t>(header.size - kChecksumSkip));
+        }
+        if (!valid)
+        {
+            _logEnd = offset;
+            WriteHeader();
+            break;
+        }
+        const auto entry = ReadEntry(offset);
+        Insert(offset, entry, DedupeKey(entry));
+        offset += header.size;
+        if (_memory[ByTime].size() >= kMemoryLimit)
+        {
+            FlushMemory();
+        }
+    }
+}
+
+bool SmsInboxStore::LoadSegments()
+{
+    _segments.clear();
+    _nextGeneration = 1;
+    _memoryBegin = sizeof(LogHeader);
+    std::vector<Segment> found;
+    std::error_code error;
+    const std::wstring logName = _logPath.filename().wstring();
+    for (const auto& item : std::filesystem::directory_iterator(_logPath.parent_path().empty() ? std::filesystem::path(L".") : _logPath.parent_path(), error))
+    {
+        const std::wstring name = item.path().filename().wstring();
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, L".tmp") == 0 && name.compare(0, logName.size(), logName) == 0)
+        {
+            // 写到一半的段。
+            std::filesystem::remove(item.path(), error);
+            continue;
+        }
+        const auto generation = ParseSegmentName(name, logName);
+        if (!generation)
+        {
+            continue;
+        }
+        _nextGeneration = std::max(_nextGeneration, *generation + 1);
+        Segment segment;
+        segment.path = item.path();
+        SegmentHeader header{};
+        if (segment.file.Open(segment.path, false) && segment.file.Size() >= sizeof(SegmentHeader))
+        {
+            std::memcpy(&header, segment.file.Data(), sizeof(header));
+        }
+        if (std::memcmp(header.magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 || header.version != kFormatVersion
+            || header.generation != *generation || header.logBegin < sizeof(LogHeader) || header.logBegin >= header.logEnd
+            || header.logEnd > _logEnd || segment.file.Size() != sizeof(SegmentHeader) + header.count * IndexCount * sizeof(IndexEntry))
+        {
+            segment.file.Close();
+            std::filesystem::remove(segment.path, error);
+            continue;
+        }
+        segment.generation = header.generation;
+        segment.logBegin = header.logBegin;
+        segment.logEnd = header.logEnd;
+        segment.count = static_cast<std::size_t>(header.count);
+        found.push_back(std::move(segment));
+    }
+
+    // 合并中途退出会同时留下新段与被合并的旧段：从日志开头起每次取起点相接、范围最大的段，其余删除。
+    std::sort(found.begin(), found.end(), [](const Segment& left, const Segment& right)
+    {
+        return left.logBegin != right.logBegin ? left.logBegin < right.logBegin : left.logEnd > right.logEnd;
+    });
+    for (auto& segment : found)
+    {
+        if (segment.logBegin == _memoryBegin)
+        {
+            _memoryBegin = segment.logEnd;
+            _segments.push_back(std::move(segment));
+        }
+        else
+        {
+            segment.file.Close();
+            std::filesystem::remove(segment.path, error);
+        }
+    }
+    return true;
+}
+
+bool SmsInboxStore::FlushMemory()
+{
+    if (_memory[ByTime].empty())
+    {
+        return true;
+    }
+    const std::size_t count = _memory[ByTime].size();
+    const bool written = WriteSegment(_memoryBegin, _logEnd, count, [this](IndexKind kind, IndexEntry* output)
+    {
+        std::copy(_memory[kind].begin(), _memory[kind].end(), output);
+    });
+    if (!written)
+    {
+        // 写不出索引段时继续使用内存表，下次打开时从日志重建。
+        return false;
+    }
+    for (auto& index : _memory)
+    {
+        index.clear();
+    }
+    _memoryBegin = _logEnd;
+    while (_segments.size() >= 2)
+    {
+        const auto& previous = _segments[_segments.size() - 2];
+        const auto& last = _segments.back();
+        if (previous.count > last.count * 2 || previous.count + last.count > kMaxMergeEntries || !MergeLastSegments())
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+bool SmsInboxStore::WriteSegment(std::uint64_t logBegin, std::uint64_t logEnd, std::size_t count,
+                                 const std::function<void(IndexKind kind, IndexEntry* output)>& fill)
+{
+    const std::uint64_t generation = _nextGeneration++;
+    const auto path = SegmentPath(_logPath, generation);
+    auto temporary = path;
+    temporary += L".tmp";
+    std::error_code error;
+    {
+        // 先写到临时文件再改名，改名之前的崩溃只会留下打开时删除的 .tmp 文件。
+        MappedFile file;
+        if (!file.Open(temporary, true) || !file.Resize(sizeof(SegmentHeader) + std::uint64_t{count} * IndexCount * sizeof(IndexEntry)))
+        {
+            file.Close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        SegmentHeader header{};
+        std::memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+        header.version = kFormatVersion;
+        header.generation = generation;
+        header.logBegin = logBegin;
+        header.logEnd = logEnd;
+        header.count = count;
+        std::memcpy(file.Data(), &header, sizeof(header));
+        auto* entries = reinterpret_cast<IndexEntry*>(file.Data() + sizeof(SegmentHeader));
+        for (std::size_t kind = 0; kind < IndexCount; ++kind)
+        {
+            fill(static_cast<IndexKind>(kind), entries + kind * count);
+        }
+        if (!file.Flush())
+        {
+            file.Close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    Segment segment;
+    if (error || !segment.file.Open(path, false))
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    segment.path = path;
+    segment.generation = generation;
+    segment.logBegin = logBegin;
+    segment.logEnd = logEnd;
+    segment.count = count;
+    _segments.push_back(std::move(segment));
+    return true;
+}
+
+bool SmsInboxStore::MergeLastSegments()
+{
+    const std::size_t previousIndex = _segments.size() - 2;
+    const auto& previous = _segments[previousIndex];
+    const auto& last = _segments.back();
+    const bool written = WriteSegment(previous.logBegin, last.logEnd, previous.count + last.count, [&](IndexKind kind, IndexEntry* output)
+    {
+        const auto* left = previous.Entries(kind);
+        const auto* right = last.Entries(kind);
+        std::merge(left, left + previous.count, right, right + last.count, output, IndexLess(this, kind));
+    });
+    if (!written)
+    {
+        return false;
+    }
+    // 新段已经落盘，旧段可以删除；删除失败的文件在下次打开时因被新段覆盖而清理。
+    std::error_code error;
+    for (std::size_t i = previousIndex; i < previousIndex + 2; ++i)
+    {
+        _segments[i].file.Close();
+        std::filesystem::remove(_segments[i].path, error);
+    }
+    _segments.erase(_segments.begin() + static_cast<std::ptrdiff_t>(previousIndex), _segments.begin() + static_cast<std::ptrdiff_t>(previousIndex + 2));
+    return true;
+}
+
+std::vector<SmsInboxStore::IndexRange> SmsInboxStore::CollectRanges(IndexKind kind, const IndexKey& low, const std::optional<IndexKey>& high,
+                                                                   std::vector<IndexEntry>& scratch) const
+{
+    const IndexLess less(this, kind);
+    std::vector<IndexRange> ranges;
+    ranges.reserve(_segments.size() + 1);
+    for (const auto& segment : _segments)
+    {
+        const auto* begin = segment.Entries(kind);
+        const auto* end = begin + segment.count;
+        const auto* first = std::lower_bound(begin, end, low, less);
+        const auto* last = high ? std::lower_bound(first, end, *high, less) : end;
+        if (first != last)
+        {
+            ranges.push_back(IndexRange{first, last});
+        }
+    }
+    const auto& memory = _memory[kind];
+    scratch.assign(memory.lower_bound(low), high ? memory.lower_bound(*high) : memory.end());
+    if (!scratch.empty())
+    {
+        ranges.push_back(IndexRange{scratch.data(), scratch.data() + scratch.size()});
+    }
+    return ranges;
+}
+
+std::size_t SmsInboxStore::VisitNewestFirst(std::vector<IndexRange> ranges, const SmsInboxQuery& query, const Visitor& visitor) const
+{
+    std::size_t visited = 0;
+    while (visited < query.limit)
+    {
+        // 数据源只有十几个，逐个比较各区间末尾即可，不必建堆。
+        IndexRange* newest = nullptr;
+        for (auto& range : ranges)
+        {
+            if (range.first != range.last
+                && (newest == nullptr || range.last[-1].key > newest->last[-1].key
+                    || (range.last[-1].key == newest->last[-1].key && range.last[-1].offset > newest->last[-1].offset)))
+            {
+                newest = &range;
+            }
+        }
+        if (newest == nullptr)
+        {
+            break;
+        }
+        --newest->last;
+        const auto entry = ReadEntry(newest->last->offset);
+        if (!Matches(entry, query))
+        {
+            continue;
+        }
+        ++visited;
+        if (!visitor(entry))
+        {
+            break;
+        }
+    }
+    return visited;
+}
+
+bool SmsInboxStore::Matches(const SmsInboxEntry& entry, const SmsInboxQuery& query) const noexcept
+{
+    if (entry.timestamp < query.from || entry.timestamp > query.to)
+    {
+        return false;
+    }
+    if (!query.sender.empty()
+        && (query.senderPrefix ? entry.sender.substr(0, query.sender.size()) != query.sender : entry.sender != query.sender))
+    {
+        return false;
+    }
+    if (!query.modem.empty() && entry.modem != query.modem)
+    {
+        return false;
+    }
+    return query.text.empty() || entry.body.find(query.text) != std::string_view::npos;
+}
+
+void SmsInboxStore::WriteHeader()
+{
+    LogHeader header{};
+    std::memcpy(header.magic, kLogMagic, sizeof(kLogMagic));
+    header.version = kFormatVersion;
+    header.end = _logEnd;
+    std::memcpy(_log.Data(), &header, sizeof(header));
+}
@@ -0,0 +1,199 @@
+/*------------------------------------------------------------------------
+名称：短信收件箱存储
+说明：把收到的短信追加写入内存映射的日志文件，按号码、时间与模块建立索引并去重
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：正文只存在于映射文件中；索引为若干已排序的映射段文件加一张容量固定的内存表，
+      内存占用与短信条数无关
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "MappedFile.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <vector>
+
+/// <summary>收件箱中的一条短信，字段为 UTF-8；查询结果中的视图仅在回调期间有效。</summary>
+struct SmsInboxEntry
+{
+    /// <summary>收到短信的模块，通常为 IMEI。</summary>
+    std::string_view modem;
+    std::string_view sender;
+    std::string_view body;
+    /// <summary>服务中心时间戳（Unix 秒），写入时为 0 表示未知，以写入时间代替。</summary>
+    std::int64_t timestamp = 0;
+    /// <summary>时间戳的时区，以 15 分钟为单位。</summary>
+    int quarterHours = 0;
+    /// <summary>模块存储索引，+CMT 直接上报的短信为 -1。</summary>
+    int storageIndex = -1;
+    /// <summary>写入收件箱的时间（Unix 秒），写入时由存储填写。</summary>
+    std::int64_t receivedAt = 0;
+};
+
+/// <summary>查询条件，各条件同时满足；结果按时间戳从新到旧。</summary>
+struct SmsInboxQuery
+{
+    /// <summary>发送方号码，为空表示不限。</summary>
+    std::string_view sender;
+    /// <summary>按号码前缀匹配，否则要求完全相同。</summary>
+    bool senderPrefix = false;
+    std::string_view modem;
+    /// <summary>正文包含的文字，为空表示不限；该条件不走索引，在其余条件选出的范围内逐条比较。</summary>
+    std::string_view text;
+    std::int64_t from = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to = std::numeric_limits<std::int64_t>::max();
+    std::size_t limit = 100;
+};
+
+/// <summary>写入结果。</summary>
+enum class SmsInboxWrite
+{
+    Stored,
+    /// <summary>同一模块、同一存储索引、同一时间戳的短信已存在（例如重复执行 AT+CMGL）。</summary>
+    Duplicate,
+    Failed
+};
+
+/// <summary>
+/// 仅追加的短信收件箱，可从任意线程调用。
+/// 日志文件保存短信原文，索引段文件按需合并；关闭时未成段的索引写成新段，下次打开时不必重扫日志。
+/// </summary>
+class SmsInboxStore
+{
+public:
+    /// <summary>查询回调，返回 false 停止查询；回调期间持有存储的锁，不能再调用本对象。</summary>
+    using Visitor = std::function<bool(const SmsInboxEntry& entry)>;
+
+    SmsInboxStore();
+    ~SmsInboxStore();
+
+    SmsInboxStore(const SmsInboxStore&) = delete;
+    SmsInboxStore& operator=(const SmsInboxStore&) = delete;
+
+    /// <summary>打开或创建日志文件，索引段与之同目录，文件名为日志文件名加 .序号.idx。</summary>
+    bool Open(const std::filesystem::path& logPath);
+
+    /// <summary>把内存表写成索引段并关闭全部文件。</summary>
+    void Close();
+
+    bool IsOpen() const;
+
+    SmsInboxWrite Append(const SmsInboxEntry& entry);
+
+    /// <summary>按条件查询，返回交给回调的条数。</summary>
+    std::size_t Find(const SmsInboxQuery& query, const Visitor& visitor) const;
+
+    /// <summary>已保存的短信条数。</summary>
+    std::size_t Size() const;
+
+private:
+    /// <summary>索引项：key 为时间戳或去重散列，offset 为记录在日志中的位置。</summary>
+    struct IndexEntry
+    {
+        std::int64_t key;
+        std::uint64_t offset;
+    };
+
+    enum IndexKind : std::size_t
+    {
+        ByTime,
+        BySender,
+        ByModem,
+        ByDedupe,
+        IndexCount
+    };
+
+    /// <summary>比较用的键：号码或模块（其余索引为空）、key、offset。</summary>
+    struct IndexKey
+    {
+        std::string_view text;
+        std::int64_t key;
+        std::uint64_t offset;
+    };
+
+    /// <summary>按索引种类比较索引项，号码与模块从日志中读取。</summary>
+    class IndexLess
+    {
+    public:
+        using is_transparent = void;
+
+        IndexLess(const SmsInboxStore* store, IndexKind kind) noexcept;
+
+        bool operator()(const IndexEntry& left, const IndexEntry& right) const;
+        bool operator()(const IndexEntry& left, const IndexKey& right) const;
+        bool operator()(const IndexKey& left, const IndexEntry& right) const;
+        bool Less(const IndexKey& left, const IndexKey& right) const noexcept;
+        IndexKey KeyOf(const IndexEntry& entry) const;
+
+    private:
+        const SmsInboxStore* _store;
+        IndexKind _kind;
+    };
+
+    /// <summary>已排序的索引段，覆盖日志中 [logBegin, logEnd) 范围内的全部记录。</summary>
+    struct Segment
+    {
+        MappedFile file;
+        std::filesystem::path path;
+        std::uint64_t generation = 0;
+        std::uint64_t logBegin = 0;
+        std::uint64_t logEnd = 0;
+        std::size_t count = 0;
+
+        const IndexEntry* Entries(IndexKind kind) const noexcept;
+    };
+
+    using MemoryIndex = std::set<IndexEntry, IndexLess>;
+
+    /// <summary>一个数据源上的索引区间，按索引顺序排列。</summary>
+    struct IndexRange
+    {
+        const IndexEntry* first;
+        const IndexEntry* last;
+    };
+
+    SmsInboxEntry ReadEntry(std::uint64_t offset) const;
+    bool IsDuplicate(const SmsInboxEntry& entry, std::uint64_t key) const;
+    bool EnsureCapacity(std::uint64_t required);
+    void Insert(std::uint64_t offset, const SmsInboxEntry& entry, std::uint64_t dedupeKey);
+    /// <summary>扫描日志中尚未进入索引段的记录，重建内存表；遇到损坏的记录时截断日志。</summary>
+    void RecoverTail(std::uint64_t begin);
+    /// <summary>加载首尾相接覆盖日志开头的索引段，删除残缺或已被合并的段。</summary>
+    bool LoadSegments();
+    /// <summary>把内存表写成新的索引段，并合并大小相近的相邻段。</summary>
+    bool FlushMemory();
+    /// <summary>写出覆盖日志 [logBegin, logEnd) 的索引段，fill 依次填入各索引的 count 项。</summary>
+    bool WriteSegment(std::uint64_t logBegin, std::uint64_t logEnd, std::size_t count,
+                      const std::function<void(IndexKind kind, IndexEntry* output)>& fill);
+    bool MergeLastSegments();
+    /// <summary>收集各数据源在 [low, high) 内的区间，high 为空表示直到末尾；内存表部分复制到 scratch 中。</summary>
+    std::vector<IndexRange> CollectRanges(IndexKind kind, const IndexKey& low, const std::optional<IndexKey>& high,
+                                          std::vector<IndexEntry>& scratch) const;
+    /// <summary>按时间戳从新到旧合并各区间（每个区间内已按时间排序），逐条过滤后交给回调。</summary>
+    std::size_t VisitNewestFirst(std::vector<IndexRange> ranges, const SmsInboxQuery& query, const Visitor& visitor) const;
+    bool Matches(const SmsInboxEntry& entry, const SmsInboxQuery& query) const noexcept;
+    void WriteHeader();
+
+private:
+    mutable std::mutex _mutex;
+    std::filesystem::path _logPath;
+    MappedFile _log;
+    /// <summary>日志中已提交记录的末尾。</summary>
+    std::uint64_t _logEnd;
+    std::vector<Segment> _segments;
+    /// <summary>尚未写成索引段的最近记录，按各索引的顺序排列。</summary>
+    std::array<MemoryIndex, IndexCount> _memory;
+    /// <summary>内存表覆盖的日志起点，等于最后一个索引段的终点。</summary>
+    std::uint64_t _memoryBegin;
+    std::uint64_t _nextGeneration;
+};
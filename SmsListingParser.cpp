@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------
+名称：短信列表流式解析实现
+说明：按头部行切分短信记录，拼接多行正文
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：正文中恰好以 +CMGL: 或 +CMGR: 开头的行会被当作下一条的头部，这是文本模式协议本身的歧义
+------------------------------------------------------------------------*/
+#include "SmsListingParser.h"
+
+namespace
+{
+    constexpr std::string_view kListPrefix = "+CMGL:";
+    constexpr std::string_view kReadPrefix = "+CMGR:";
+
+    bool StartsWith(std::string_view text, std::string_view prefix) noexcept
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+}
+
+SmsListingParser::SmsListingParser()
+    : _inRecord(false), _bodyLines(0)
+{
+}
+
+bool SmsListingParser::Feed(std::string_view line, const RecordHandler& handler)
+{
+    if (StartsWith(line, kListPrefix) || StartsWith(line, kReadPrefix))
+    {
+        Flush(handler);
+        _header.assign(line);
+        _body.clear();
+        _bodyLines = 0;
+        _inRecord = true;
+        return true;
+    }
+    if (!_inRecord)
+    {
+        return false;
+    }
+    if (_bodyLines++ != 0)
+    {
+        _body.push_back('\n');
+    }
+    _body.append(line);
+    return true;
+}
+
+void SmsListingParser::Finish(const RecordHandler& handler)
+{
+    Flush(handler);
+}
+
+void SmsListingParser::Reset() noexcept
+{
+    _inRecord = false;
+    _bodyLines = 0;
+    _header.clear();
+    _body.clear();
+}
+
+bool SmsListingParser::InRecord() const noexcept
+{
+    return _inRecord;
+}
+
+void SmsListingParser::Flush(const RecordHandler& handler)
+{
+    if (!_inRecord)
+    {
+        return;
+    }
+    _inRecord = false;
+    SmsListingRecord record;
+    record.headerLine = _header;
+    record.body = _body;
+    const auto header = StartsWith(_header, kListPrefix) ? ParseCmgl(_header) : ParseCmgr(_header);
+    if (header)
+    {
+        record.header = *header;
+    }
+    if (handler)
+    {
+        handler(record);
+    }
+}
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------
+名称：短信列表流式解析
+说明：逐行解析 AT+CMGL 列表与 AT+CMGR 应答，每凑齐一条短信（头部加完整正文）即交出
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：只缓存当前一条短信，列表再长占用也不变；缓冲区在各条之间复用
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtResponseParser.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/// <summary>一条完整的短信记录，视图仅在回调期间有效。</summary>
+struct SmsListingRecord
+{
+    /// <summary>头部字段；头部格式无法识别时为默认值（索引与状态为 -1）。</summary>
+    SmsHeaderResponse header;
+    /// <summary>原始头部行，+CMGL: 或 +CMGR: 开头。</summary>
+    std::string_view headerLine;
+    /// <summary>正文，多行正文以 LF 连接；PDU 模式下为十六进制 PDU。</summary>
+    std::string_view body;
+};
+
+/// <summary>
+/// 流式短信列表解析器，非线程安全，由单个分发线程驱动。
+/// 调用方只交入属于在途指令的应答行，主动上报不应交入；最终结果码到达时调用 Finish。
+/// </summary>
+class SmsListingParser
+{
+public:
+    using RecordHandler = std::function<void(const SmsListingRecord& record)>;
+
+    SmsListingParser();
+
+    /// <summary>处理一行应答：头部开始新的一条并交出上一条，其后的行并入正文。行属于短信列表时返回 true。</summary>
+    bool Feed(std::string_view line, const RecordHandler& handler);
+
+    /// <summary>指令已结束，交出最后一条。</summary>
+    void Finish(const RecordHandler& handler);
+
+    /// <summary>丢弃未交出的一条，例如断开之后。</summary>
+    void Reset() noexcept;
+
+    /// <summary>当前是否正在收集一条短信。</summary>
+    bool InRecord() const noexcept;
+
+private:
+    void Flush(const RecordHandler& handler);
+
+private:
+    std::string _header;
+    std::string _body;
+    bool _inRecord;
+    /// <summary>正文已有的行数，用于在行之间插入 LF。</summary>
+    std::size_t _bodyLines;
+};
@@ -0,0 +1,919 @@
+/*------------------------------------------------------------------------
+名称：短信 PDU 编解码实现
+说明：实现 GSM 7 位字母表查表、septet 打包与拆包、UCS2 转换以及 TPDU 各字段的读写
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：编码路径只在输出字符串上分配内存，PDU 先写入栈上缓冲再整体转为十六进制
+------------------------------------------------------------------------*/
+#include "SmsPdu.h"
+
+#include <array>
+
+namespace
+{
+    constexpr char16_t kEscapeMarker = 0x00A0;
+
+    /// <summary>GSM 03.38 默认字母表，下标为 septet 值；0x1B 为扩展表转义，显示为不换行空格。</summary>
+    constexpr std::array<char16_t, 128> kGsm7Basic{{
+        u'@', 0x00A3, u'$', 0x00A5, 0x00E8, 0x00E9, 0x00F9, 0x00EC, 0x00F2, 0x00C7, u'\n', 0x00D8, 0x00F8, u'\r', 0x00C5, 0x00E5,
+        0x0394, u'_', 0x03A6, 0x0393, 0x039B, 0x03A9, 0x03A0, 0x03A8, 0x03A3, 0x0398, 0x039E, kEscapeMarker, 0x00C6, 0x00E6, 0x00DF, 0x00C9,
+        u' ', u'!', u'"', u'#', 0x00A4, u'%', u'&', u'\'', u'(', u')', u'*', u'+', u',', u'-', u'.', u'/',
+        u'0', u'1', u'2', u'3', u'4', u'5', u'6', u'7', u'8', u'9', u':', u';', u'<', u'=', u'>', u'?',
+        0x00A1, u'A', u'B', u'C', u'D', u'E', u'F', u'G', u'H', u'I', u'J', u'K', u'L', u'M', u'N', u'O',
+        u'P', u'Q', u'R', u'S', u'T', u'U', u'V', u'W', u'X', u'Y', u'Z', 0x00C4, 0x00D6, 0x00D1, 0x00DC, 0x00A7,
+        0x00BF, u'a', u'b', u'c', u'd', u'e', u'f', u'g', u'h', u'i', u'j', u'k', u'l', u'm', u'n', u'o',
+        u'p', u'q', u'r', u's', u't', u'u', u'v', u'w', u'x', u'y', u'z', 0x00E4, 0x00F6, 0x00F1, 0x00FC, 0x00E0
+    }};
+
+    struct ExtensionEntry
+    {
+        std::uint8_t septet;
+        char16_t code;
+    };
+
+    /// <summary>扩展表：先写 0x1B 再写下列 septet，各占两个 septet。</summary>
+    constexpr std::array<ExtensionEntry, 10> kGsm7Extension{{
+        {0x0A, 0x000C},
+        {0x14, u'^'},
+        {0x28, u'{'},
+        {0x29, u'}'},
+        {0x2F, u'\\'},
+        {0x3C, u'['},
+        {0x3D, u'~'},
+        {0x3E, u']'},
+        {0x40, u'|'},
+        {0x65, 0x20AC}
+    }};
+
+    constexpr std::uint8_t kEscapeSeptet = 0x1B;
+    constexpr std::uint16_t kUnmapped = 0xFFFF;
+    /// <summary>编码表中标记需要转义的位。</summary>
+    constexpr std::uint16_t kExtended = 0x100;
+
+    /// <summary>ASCII 到 GSM 7 位的反查表，覆盖绝大多数发送内容；其余字符走线性查找。</summary>
+    constexpr std::array<std::uint16_t, 128> kAsciiToGsm7 = []()
+    {
+        std::array<std::uint16_t, 128> table{};
+        for (auto& entry : table)
+        {
+            entry = kUnmapped;
+        }
+        for (std::uint16_t septet = 0; septet < kGsm7Basic.size(); ++septet)
+        {
+            if (kGsm7Basic[septet] < table.size() && septet != kEscapeSeptet)
+            {
+                table[kGsm7Basic[septet]] = septet;
+            }
+        }
+        for (const auto& entry : kGsm7Extension)
+        {
+            if (entry.code < table.size() && table[entry.code] == kUnmapped)
+            {
+                table[entry.code] = static_cast<std::uint16_t>(kExtended | entry.septet);
+            }
+        }
+        return table;
+    }();
+
+    constexpr std::size_t kGsm7SingleLimit = 160;
+    constexpr std::size_t kGsm7PartLimit = 153;
+    constexpr std::size_t kUcs2SingleLimit = 70;
+    constexpr std::size_t kUcs2PartLimit = 67;
+    constexpr std::size_t kMaxParts = 255;
+    constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+    std::uint16_t LookupNonAsciiGsm7(char32_t code) noexcept
+    {
+        for (std::uint16_t septet = 0; septet < kGsm7Basic.size(); ++septet)
+        {
+            if (kGsm7Basic[septet] == code && septet != kEscapeSeptet)
+            {
+                return septet;
+            }
+        }
+        for (const auto& entry : kGsm7Extension)
+        {
+            if (entry.code == code)
+            {
+                return static_cast<std::uint16_t>(kExtended | entry.septet);
+            }
+        }
+        return kUnmapped;
+    }
+
+    /// <summary>读取一个多字节 UTF-8 码点并前移，非法序列返回 U+FFFD 并跳过一个字节。</summary>
+    char32_t NextMultiByteCodePoint(std::string_view text, std::size_t& position) noexcept
+    {
+        const auto lead = static_cast<unsigned char>(text[position]);
+        std::size_t length = 0;
+        char32_t code = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            code = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            code = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            code = lead & 0x07;
+        }
+        if (length == 0 || position + length > text.size())
+        {
+            ++position;
+            return 0xFFFD;
+        }
+        for (std::size_t i = 1; i < length; ++i)
+        {
+            const auto next = static_cast<unsigned char>(text[position + i]);
+            if ((next & 0xC0) != 0x80)
+            {
+                ++position;
+                return 0xFFFD;
+            }
+            code = (code << 6) | (next & 0x3F);
+        }
+        position += length;
+        return code;
+    }
+
+    inline std::uint16_t LookupGsm7(char32_t code) noexcept
+    {
+        return code < kAsciiToGsm7.size() ? kAsciiToGsm7[code] : LookupNonAsciiGsm7(code);
+    }
+
+    /// <summary>读取一个 UTF-8 码点并前移；ASCII 在内联路径上处理，发送内容大多是 ASCII。</summary>
+    inline char32_t NextCodePoint(std::string_view text, std::size_t& position) noexcept
+    {
+        const auto lead = static_cast<unsigned char>(text[position]);
+        if (lead < 0x80)
+        {
+            ++position;
+            return lead;
+        }
+        return NextMultiByteCodePoint(text, position);
+    }
+
+    void AppendUtf8(std::string& output, char32_t code)
+    {
+        if (code < 0x80)
+        {
+            output.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800)
+        {
+            output.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            output.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+            output.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    /// <summary>定长字节缓冲，最长的 PDU（12 字节服务中心地址加 164 字节 TPDU）也放得下。</summary>
+    class ByteWriter
+    {
+    public:
+        void Put(std::uint8_t value) noexcept
+        {
+            if (_size < _data.size())
+            {
+                _data[_size++] = value;
+            }
+        }
+
+        std::size_t Size() const noexcept
+        {
+            return _size;
+        }
+
+        std::uint8_t& At(std::size_t index) noexcept
+        {
+            return _data[index];
+        }
+
+        void AppendHex(std::string& output) const
+        {
+            output.resize(_size * 2);
+            for (std::size_t i = 0; i < _size; ++i)
+            {
+                output[i * 2] = kHexDigits[_data[i] >> 4];
+                output[i * 2 + 1] = kHexDigits[_data[i] & 0x0F];
+            }
+        }
+
+    private:
+        std::array<std::uint8_t, 192> _data{};
+        std::size_t _size = 0;
+    };
+
+    /// <summary>按位把 septet 依次写入字节，fill 为起始处的填充位数（UDH 之后对齐到 septet 边界）。</summary>
+    void PackSeptets(const std::uint8_t* septets, std::size_t count, unsigned fill, ByteWriter& output) noexcept
+    {
+        std::uint32_t accumulator = 0;
+        unsigned bits = fill;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            accumulator |= static_cast<std::uint32_t>(septets[i]) << bits;
+            bits += 7;
+            while (bits >= 8)
+            {
+                output.Put(static_cast<std::uint8_t>(accumulator));
+                accumulator >>= 8;
+                bits -= 8;
+            }
+        }
+        if (bits > 0)
+        {
+            // 最后一个字节空出 7 位时按 TS 23.038 用 CR 填充，避免接收方多显示一个 '@'。
+            if (bits == 1)
+            {
+                accumulator |= 0x0Du << 1;
+            }
+            output.Put(static_cast<std::uint8_t>(accumulator));
+        }
+    }
+
+    bool UnpackSeptets(const std::uint8_t* data, std::size_t size, unsigned fill, std::size_t count, std::uint8_t* septets) noexcept
+    {
+        if ((fill + count * 7 + 7) / 8 > size)
+        {
+            return false;
+        }
+        std::uint32_t accumulator = 0;
+        unsigned bits = 0;
+        std::size_t index = 0;
+        if (fill > 0)
+        {
+            accumulator = static_cast<std::uint32_t>(data[index++]) >> fill;
+            bits = 8 - fill;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (bits < 7)
+            {
+                accumulator |= static_cast<std::uint32_t>(data[index++]) << bits;
+                bits += 8;
+            }
+            septets[i] = static_cast<std::uint8_t>(accumulator & 0x7F);
+            accumulator >>= 7;
+            bits -= 7;
+        }
+        return true;
+    }
+
+    void AppendGsm7Text(const std::uint8_t* septets, std::size_t count, std::string& output)
+    {
+        // 最长的字符（欧元符号）转为 UTF-8 占 3 字节。
+        output.reserve(output.size() + count * 3);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (septets[i] != kEscapeSeptet)
+            {
+                AppendUtf8(output, kGsm7Basic[septets[i]]);
+                continue;
+            }
+            if (++i == count)
+            {
+                break;
+            }
+            // 未定义的扩展字符按规范显示为默认表中的对应字符。
+            char16_t code = kGsm7Basic[septets[i]];
+            for (const auto& entry : kGsm7Extension)
+            {
+                if (entry.septet == septets[i])
+                {
+                    code = entry.code;
+                    break;
+                }
+            }
+            AppendUtf8(output, code);
+        }
+    }
+
+    /// <summary>号码字符到半字节，'*' 与 '#' 按 TS 23.040 9.1.2.3 编码，其他字符不可拨号。</summary>
+    int DialDigit(char ch) noexcept
+    {
+        if (ch >= '0' && ch <= '9')
+        {
+            return ch - '0';
+        }
+        if (ch == '*')
+        {
+            return 0x0A;
+        }
+        if (ch == '#')
+        {
+            return 0x0B;
+        }
+        return -1;
+    }
+
+    constexpr char kDialCharacters[] = "0123456789*#abc";
+
+    /// <summary>写入地址字段；serviceCenter 为真时长度以字节计（含类型字节），否则以数字个数计。</summary>
+    bool WriteAddress(std::string_view number, bool serviceCenter, bool allowAlphanumeric, ByteWriter& output)
+    {
+        if (number.empty())
+        {
+            if (!serviceCenter)
+            {
+                return false;
+            }
+            output.Put(0x00);
+            return true;
+        }
+        const bool international = number.front() == '+';
+        const auto digits = international ? number.substr(1) : number;
+        bool dialable = !digits.empty() && digits.size() <= 20;
+        for (const char ch : digits)
+        {
+            dialable = dialable && DialDigit(ch) >= 0;
+        }
+        if (!dialable)
+        {
+            if (!allowAlphanumeric || serviceCenter)
+            {
+                return false;
+            }
+            // 字母数字地址（例如发件人为 "Bank"）：GSM 7 位打包，长度为所占的半字节数。
+            std::array<std::uint8_t, 11> septets{};
+            std::size_t count = 0;
+            for (std::size_t position = 0; position < number.size() && count < septets.size();)
+            {
+                const auto code = LookupGsm7(NextCodePoint(number, position));
+                if (code == kUnmapped || (code & kExtended) != 0)
+                {
+                    return false;
+                }
+                septets[count++] = static_cast<std::uint8_t>(code);
+            }
+            output.Put(static_cast<std::uint8_t>((count * 7 + 3) / 4));
+            output.Put(0xD0);
+            PackSeptets(septets.data(), count, 0, output);
+            return true;
+        }
+        output.Put(static_cast<std::uint8_t>(serviceCenter ? 1 + (digits.size() + 1) / 2 : digits.size()));
+        output.Put(international ? 0x91 : 0x81);
+        for (std::size_t i = 0; i < digits.size(); i += 2)
+        {
+            const int low = DialDigit(digits[i]);
+            const int high = i + 1 < digits.size() ? DialDigit(digits[i + 1]) : 0x0F;
+            output.Put(static_cast<std::uint8_t>(low | (high << 4)));
+        }
+        return true;
+    }
+
+    std::uint8_t SwapDigits(int value) noexcept
+    {
+        return static_cast<std::uint8_t>(((value % 10) << 4) | ((value / 10) % 10));
+    }
+
+    int UnswapDigits(std::uint8_t value) noexcept
+    {
+        return (value & 0x0F) * 10 + (value >> 4);
+    }
+
+    /// <summary>划分各段在原文中的范围并确定编码，超过 255 段时返回 false。</summary>
+    bool SplitText(std::string_view text, SmsEncoding& encoding, std::vector<SmsPduPart>& parts, std::size_t& partCount)
+    {
+        std::size_t septets = 0;
+        std::size_t units = 0;
+        encoding = SmsEncoding::Gsm7;
+        for (std::size_t position = 0; position < text.size();)
+        {
+            const auto code = NextCodePoint(text, position);
+            units += code > 0xFFFF ? 2 : 1;
+            if (encoding == SmsEncoding::Gsm7)
+            {
+                const auto mapped = LookupGsm7(code);
+                encoding = mapped == kUnmapped ? SmsEncoding::Ucs2 : encoding;
+                septets += (mapped & kExtended) != 0 ? 2 : 1;
+            }
+        }
+        const bool gsm7 = encoding == SmsEncoding::Gsm7;
+        const std::size_t total = gsm7 ? septets : units;
+        const std::size_t single = gsm7 ? kGsm7SingleLimit : kUcs2SingleLimit;
+        const std::size_t perPart = gsm7 ? kGsm7PartLimit : kUcs2PartLimit;
+        partCount = total <= single ? 1 : (total + perPart - 1) / perPart;
+        if (partCount > kMaxParts)
+        {
+            return false;
+        }
+        parts.resize(partCount);
+        if (partCount == 1)
+        {
+            parts[0].textOffset = 0;
+            parts[0].textLength = text.size();
+            return true;
+        }
+        // 逐字符累加，转义序列与代理对不拆到两段；因此实际段数可能比估算多一段。
+        std::size_t index = 0;
+        std::size_t used = 0;
+        std::size_t start = 0;
+        for (std::size_t position = 0; position < text.size();)
+        {
+            const std::size_t before = position;
+            const auto code = NextCodePoint(text, position);
+            const std::size_t cost = gsm7 ? ((LookupGsm7(code) & kExtended) != 0 ? 2 : 1) : (code > 0xFFFF ? 2 : 1);
+            if (used + cost > perPart)
+            {
+                if (index + 1 >= kMaxParts)
+                {
+                    return false;
+                }
+                if (index + 1 >= parts.size())
+                {
+                    parts.resize(index + 2);
+                }
+                parts[index].textOffset = start;
+                parts[index].textLength = before - start;
+                ++index;
+                start = before;
+                used = 0;
+            }
+            used += cost;
+        }
+        parts[index].textOffset = start;
+        parts[index].textLength = text.size() - start;
+        parts.resize(index + 1);
+        partCount = parts.size();
+        return true;
+    }
+
+    /// <summary>写入一段的 UDL 与 UD，concat.total 为 0 时不带 UDH。</summary>
+    void WriteUserData(std::string_view text, SmsEncoding encoding, const SmsConcatInfo& concat, ByteWriter& output)
+    {
+        const std::size_t udlIndex = output.Size();
+        output.Put(0);
+        std::size_t udhOctets = 0;
+        if (concat.total > 1)
+        {
+            udhOctets = 6;
+            output.Put(0x05);
+            output.Put(0x00);
+            output.Put(0x03);
+            output.Put(static_cast<std::uint8_t>(concat.reference));
+            output.Put(concat.total);
+            output.Put(concat.sequence);
+        }
+        if (encoding == SmsEncoding::Gsm7)
+        {
+            std::array<std::uint8_t, kGsm7SingleLimit> septets{};
+            std::size_t count = 0;
+            for (std::size_t position = 0; position < text.size() && count < septets.size();)
+            {
+                const auto mapped = LookupGsm7(NextCodePoint(text, position));
+                if ((mapped & kExtended) != 0)
+                {
+                    septets[count++] = kEscapeSeptet;
+                }
+                if (count < septets.size())
+                {
+                    septets[count++] = static_cast<std::uint8_t>(mapped & 0x7F);
+                }
+            }
+            const unsigned fill = static_cast<unsigned>((7 - (udhOctets * 8) % 7) % 7);
+            const std::size_t udhSeptets = (udhOctets * 8 + fill) / 7;
+            PackSeptets(septets.data(), count, fill, output);
+            output.At(udlIndex) = static_cast<std::uint8_t>(udhSeptets + count);
+            return;
+        }
+        std::size_t octets = udhOctets;
+        for (std::size_t position = 0; position < text.size();)
+        {
+            auto code = NextCodePoint(text, position);
+            if (code > 0xFFFF)
+            {
+                code -= 0x10000;
+                const char32_t high = 0xD800 + (code >> 10);
+                output.Put(static_cast<std::uint8_t>(high >> 8));
+                output.Put(static_cast<std::uint8_t>(high));
+                code = 0xDC00 + (code & 0x3FF);
+                octets += 2;
+            }
+            output.Put(static_cast<std::uint8_t>(code >> 8));
+            output.Put(static_cast<std::uint8_t>(code));
+            octets += 2;
+        }
+        output.At(udlIndex) = static_cast<std::uint8_t>(octets);
+    }
+
+    bool EncodeMessage(bool deliver, std::string_view address, std::string_view text, const ModemTime& timestamp,
+                       const SmsPduOptions& options, std::vector<SmsPduPart>& parts)
+    {
+        SmsEncoding encoding = SmsEncoding::Gsm7;
+        std::size_t partCount = 0;
+        if (!SplitText(text, encoding, parts, partCount))
+        {
+            return false;
+        }
+        for (std::size_t index = 0; index < partCount; ++index)
+        {
+            auto& part = parts[index];
+            const SmsConcatInfo concat{options.concatReference, static_cast<std::uint8_t>(partCount > 1 ? partCount : 0),
+                                       static_cast<std::uint8_t>(index + 1)};
+            ByteWriter output;
+            if (!WriteAddress(options.serviceCenter, true, false, output))
+            {
+                return false;
+            }
+            const std::size_t tpduStart = output.Size();
+            const std::uint8_t udhi = concat.total > 1 ? 0x40 : 0x00;
+            const std::uint8_t report = options.statusReport ? 0x20 : 0x00;
+            if (deliver)
+            {
+                // SMS-DELIVER，TP-MMS 置位表示没有更多待发短信。
+                output.Put(static_cast<std::uint8_t>(0x04 | udhi | report));
+                if (!WriteAddress(address, false, true, output))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                // SMS-SUBMIT，相对有效期格式，TP-MR 由模块填写。
+                output.Put(static_cast<std::uint8_t>(0x01 | 0x10 | udhi | report));
+                output.Put(0x00);
+                if (!WriteAddress(address, false, false, output))
+                {
+                    return false;
+                }
+            }
+            output.Put(0x00);
+            output.Put(encoding == SmsEncoding::Ucs2 ? 0x08 : 0x00);
+            if (deliver)
+            {
+                output.Put(SwapDigits(timestamp.year % 100));
+                output.Put(SwapDigits(timestamp.month));
+                output.Put(SwapDigits(timestamp.day));
+                output.Put(SwapDigits(timestamp.hour));
+                output.Put(SwapDigits(timestamp.minute));
+                output.Put(SwapDigits(timestamp.second));
+                const int zone = timestamp.quarterHours < 0 ? -timestamp.quarterHours : timestamp.quarterHours;
+                output.Put(static_cast<std::uint8_t>(SwapDigits(zone) | (timestamp.quarterHours < 0 ? 0x08 : 0x00)));
+            }
+            else
+            {
+                output.Put(options.validityPeriod);
+            }
+            WriteUserData(text.substr(part.textOffset, part.textLength), encoding, concat, output);
+            output.AppendHex(part.hex);
+            part.tpduLength = static_cast<int>(output.Size() - tpduStart);
+        }
+        return true;
+    }
+
+    int HexValue(char ch) noexcept
+    {
+        if (ch >= '0' && ch <= '9')
+        {
+            return ch - '0';
+        }
+        if (ch >= 'A' && ch <= 'F')
+        {
+            return ch - 'A' + 10;
+        }
+        if (ch >= 'a' && ch <= 'f')
+        {
+            return ch - 'a' + 10;
+        }
+        return -1;
+    }
+
+    /// <summary>按顺序读取 PDU 字节，越界后 Failed 为真，之后读到的都是 0。</summary>
+    class ByteReader
+    {
+    public:
+        ByteReader(const std::uint8_t* data, std::size_t size) noexcept
+            : _data(data), _size(size), _position(0), _failed(false)
+        {
+        }
+
+        std::uint8_t Get() noexcept
+        {
+            if (_position >= _size)
+            {
+                _failed = true;
+                return 0;
+            }
+            return _data[_position++];
+        }
+
+        const std::uint8_t* Take(std::size_t count) noexcept
+        {
+            if (_size - _position < count)
+            {
+                _failed = true;
+                _position = _size;
+                return _data + _size;
+            }
+            const auto* start = _data + _position;
+            _position += count;
+            return start;
+        }
+
+        std::size_t Remaining() const noexcept
+        {
+            return _size - _position;
+        }
+
+        bool Failed() const noexcept
+        {
+            return _failed;
+        }
+
+    private:
+        const std::uint8_t* _data;
+        std::size_t _size;
+        std::size_t _position;
+        bool _failed;
+    };
+
+    void AppendDigits(const std::uint8_t* data, std::size_t octets, std::size_t digits, std::string& output)
+    {
+        for (std::size_t i = 0; i < digits && i / 2 < octets; ++i)
+        {
+            const unsigned nibble = i % 2 == 0 ? data[i / 2] & 0x0F : data[i / 2] >> 4;
+            if (nibble == 0x0F)
+            {
+                break;
+            }
+            output.push_back(kDialCharacters[nibble < 15 ? nibble : 0]);
+        }
+    }
+
+    /// <summary>读取发件人或收件人地址，length 为半字节数。</summary>
+    bool ReadAddress(ByteReader& reader, std::string& output)
+    {
+        const std::size_t length = reader.Get();
+        const std::uint8_t type = reader.Get();
+        const std::size_t octets = (length + 1) / 2;
+        const auto* data = reader.Take(octets);
+        if (reader.Failed() || length > 20)
+        {
+            return false;
+        }
+        if ((type & 0x70) == 0x50)
+        {
+            std::array<std::uint8_t, 11> septets{};
+            const std::size_t count = std::min<std::size_t>(length * 4 / 7, septets.size());
+            UnpackSeptets(data, octets, 0, count, septets.data());
+            AppendGsm7Text(septets.data(), count, output);
+            return true;
+        }
+        if ((type & 0x70) == 0x10)
+        {
+            output.push_back('+');
+        }
+        AppendDigits(data, octets, length, output);
+        return true;
+    }
+
+    std::optional<SmsEncoding> EncodingFromScheme(std::uint8_t scheme) noexcept
+    {
+        // TS 23.038 第 4 节：00xx/01xx 为通用编码组，bit5 置位表示压缩（不支持）。
+        if ((scheme & 0x80) == 0)
+        {
+            if ((scheme & 0x20) != 0)
+            {
+                return std::nullopt;
+            }
+            switch ((scheme >> 2) & 0x03)
+            {
+            case 1:
+                return SmsEncoding::EightBit;
+            case 2:
+                return SmsEncoding::Ucs2;
+            default:
+                return SmsEncoding::Gsm7;
+            }
+        }
+        if ((scheme & 0xF0) == 0xF0)
+        {
+            return (scheme & 0x04) != 0 ? SmsEncoding::EightBit : SmsEncoding::Gsm7;
+        }
+        if ((scheme & 0xF0) == 0xE0)
+        {
+            return SmsEncoding::Ucs2;
+        }
+        return SmsEncoding::Gsm7;
+    }
+
+    /// <summary>解析 UDH 中的长短信信息单元（8 位或 16 位参考号）。</summary>
+    void ReadConcatInfo(const std::uint8_t* header, std::size_t length, SmsConcatInfo& concat) noexcept
+    {
+        std::size_t position = 0;
+        while (position + 2 <= length)
+        {
+            const std::uint8_t id = header[position];
+            const std::size_t size = header[position + 1];
+            const auto* data = header + position + 2;
+            if (position + 2 + size > length)
+            {
+                return;
+            }
+            if (id == 0x00 && size == 3)
+            {
+                concat = SmsConcatInfo{data[0], data[1], data[2]};
+            }
+            else if (id == 0x08 && size == 4)
+            {
+                concat = SmsConcatInfo{static_cast<std::uint16_t>((data[0] << 8) | data[1]), data[2], data[3]};
+            }
+            position += 2 + size;
+        }
+    }
+}
+
+SmsEncoding ChooseSmsEncoding(std::string_view text, std::size_t* partCount)
+{
+    std::vector<SmsPduPart> parts;
+    SmsEncoding encoding = SmsEncoding::Gsm7;
+    std::size_t count = 0;
+    if (!SplitText(text, encoding, parts, count))
+    {
+        count = 0;
+    }
+    if (partCount != nullptr)
+    {
+        *partCount = count;
+    }
+    return encoding;
+}
+
+bool EncodeSmsSubmit(std::string_view destination, std::string_view text, const SmsPduOptions& options, std::vector<SmsPduPart>& parts)
+{
+    return EncodeMessage(false, destination, text, ModemTime{}, options, parts);
+}
+
+bool EncodeSmsDeliver(std::string_view sender, std::string_view text, std::string_view timestamp, const SmsPduOptions& options,
+                      std::vector<SmsPduPart>& parts)
+{
+    const auto time = ParseModemTime(timestamp);
+    if (!time)
+    {
+        return false;
+    }
+    return EncodeMessage(true, sender, text, *time, options, parts);
+}
+
+std::optional<SmsPduMessage> DecodeSmsPdu(std::string_view hex)
+{
+    std::array<std::uint8_t, 192> bytes{};
+    if (hex.size() % 2 != 0 || hex.size() / 2 > bytes.size())
+    {
+        return std::nullopt;
+    }
+    for (std::size_t i = 0; i < hex.size(); i += 2)
+    {
+        const int high = HexValue(hex[i]);
+        const int low = HexValue(hex[i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return std::nullopt;
+        }
+        bytes[i / 2] = static_cast<std::uint8_t>((high << 4) | low);
+    }
+    ByteReader reader(bytes.data(), hex.size() / 2);
+    SmsPduMessage message;
+
+    const std::size_t centerLength = reader.Get();
+    if (centerLength > 0)
+    {
+        const std::uint8_t type = reader.Get();
+        const auto* digits = reader.Take(centerLength - 1);
+        // 长度字节来自串口，可能是残行或乱码；短信中心号码至多 20 位（10 字节）加类型字节。
+        if (reader.Failed() || centerLength > 12)
+        {
+            return std::nullopt;
+        }
+        if ((type & 0x70) == 0x10)
+        {
+            message.serviceCenter.push_back('+');
+        }
+        AppendDigits(digits, centerLength - 1, (centerLength - 1) * 2, message.serviceCenter);
+    }
+    const std::uint8_t first = reader.Get();
+    const unsigned messageType = first & 0x03;
+    if (reader.Failed() || messageType > 1)
+    {
+        return std::nullopt;
+    }
+    message.deliver = messageType == 0;
+    message.statusReport = (first & 0x20) != 0;
+    if (!message.deliver)
+    {
+        reader.Get();
+    }
+    if (!ReadAddress(reader, message.address))
+    {
+        return std::nullopt;
+    }
+    reader.Get();
+    const auto encoding = EncodingFromScheme(reader.Get());
+    if (!encoding)
+    {
+        return std::nullopt;
+    }
+    message.encoding = *encoding;
+    if (message.deliver)
+    {
+        const auto* stamp = reader.Take(7);
+        if (!reader.Failed())
+        {
+            message.timestamp.year = 2000 + UnswapDigits(stamp[0]);
+            message.timestamp.month = UnswapDigits(stamp[1]);
+            message.timestamp.day = UnswapDigits(stamp[2]);
+            message.timestamp.hour = UnswapDigits(stamp[3]);
+            message.timestamp.minute = UnswapDigits(stamp[4]);
+            message.timestamp.second = UnswapDigits(stamp[5]);
+            const int zone = (stamp[6] & 0x07) * 10 + (stamp[6] >> 4);
+            message.timestamp.quarterHours = (stamp[6] & 0x08) != 0 ? -zone : zone;
+        }
+    }
+    else
+    {
+        // TP-VPF：10 为 1 字节相对格式，01 与 11 为 7 字节格式。
+        const unsigned validityFormat = (first >> 3) & 0x03;
+        reader.Take(validityFormat == 2 ? 1 : validityFormat == 0 ? 0 : 7);
+    }
+    const std::size_t dataLength = reader.Get();
+    if (reader.Failed())
+    {
+        return std::nullopt;
+    }
+    const bool gsm7 = message.encoding == SmsEncoding::Gsm7;
+    const std::size_t octets = gsm7 ? (dataLength * 7 + 7) / 8 : dataLength;
+    if (octets > reader.Remaining())
+    {
+        return std::nullopt;
+    }
+    const auto* data = reader.Take(octets);
+    std::size_t headerOctets = 0;
+    if ((first & 0x40) != 0)
+    {
+        headerOctets = octets == 0 ? 0 : 1 + static_cast<std::size_t>(data[0]);
+        if (headerOctets == 0 || headerOctets > octets)
+        {
+            return std::nullopt;
+        }
+        ReadConcatInfo(data + 1, headerOctets - 1, message.concat);
+    }
+    if (gsm7)
+    {
+        const unsigned fill = static_cast<unsigned>((7 - (headerOctets * 8) % 7) % 7);
+        const std::size_t headerSeptets = (headerOctets * 8 + fill) / 7;
+        if (headerSeptets > dataLength)
+        {
+            return std::nullopt;
+        }
+        std::array<std::uint8_t, kGsm7SingleLimit> septets{};
+        const std::size_t count = std::min(dataLength - headerSeptets, septets.size());
+        if (!UnpackSeptets(data + headerOctets, octets - headerOctets, fill, count, septets.data()))
+        {
+            return std::nullopt;
+        }
+        AppendGsm7Text(septets.data(), count, message.text);
+        return message;
+    }
+    if (message.encoding == SmsEncoding::EightBit)
+    {
+        for (std::size_t i = headerOctets; i < octets; ++i)
+        {
+            AppendUtf8(message.text, data[i]);
+        }
+        return message;
+    }
+    message.text.reserve((octets - headerOctets) / 2 * 3);
+    for (std::size_t i = headerOctets; i + 1 < octets; i += 2)
+    {
+        char32_t code = static_cast<char32_t>((data[i] << 8) | data[i + 1]);
+        if (code >= 0xD800 && code < 0xDC00 && i + 3 < octets)
+        {
+            const char32_t low = static_cast<char32_t>((data[i + 2] << 8) | data[i + 3]);
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        AppendUtf8(message.text, code);
+    }
+    return message;
+}
@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------
+名称：短信 PDU 编解码
+说明：按 3GPP TS 23.040 / 23.038 生成 SMS-SUBMIT、SMS-DELIVER PDU 并解析收到的 PDU，
+      支持 GSM 7 位默认字母表（含扩展表）、UCS2 与长短信分段（UDH）
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：文本一律为 UTF-8；能用 GSM 7 位表示的内容优先用 7 位编码，否则整条改用 UCS2
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtResponseParser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>用户数据的编码方式。</summary>
+enum class SmsEncoding
+{
+    Gsm7,
+    EightBit,
+    Ucs2
+};
+
+/// <summary>长短信的分段信息（UDH 信息单元 00 或 08）。</summary>
+struct SmsConcatInfo
+{
+    /// <summary>同一条长短信各段共用的参考号。</summary>
+    std::uint16_t reference = 0;
+    /// <summary>总段数，为 0 表示不是长短信。</summary>
+    std::uint8_t total = 0;
+    /// <summary>本段序号，从 1 开始。</summary>
+    std::uint8_t sequence = 0;
+};
+
+/// <summary>编码一条短信时的可选参数。</summary>
+struct SmsPduOptions
+{
+    /// <summary>写入 PDU 的服务中心号码，为空时使用模块中保存的号码（AT+CSCA）。</summary>
+    std::string_view serviceCenter;
+    /// <summary>长短信的参考号，同一号码的相邻两条长短信应不同。</summary>
+    std::uint8_t concatReference = 0;
+    /// <summary>相对有效期（TP-VP），0xA7 为 24 小时。</summary>
+    std::uint8_t validityPeriod = 0xA7;
+    /// <summary>请求状态报告（TP-SRR）。</summary>
+    bool statusReport = false;
+};
+
+/// <summary>编码结果中的一段，对应一次 AT+CMGS。</summary>
+struct SmsPduPart
+{
+    /// <summary>十六进制 PDU（含服务中心地址），直接作为 AT+CMGS 的正文写出。</summary>
+    std::string hex;
+    /// <summary>TPDU 字节数（不含服务中心地址），即 AT+CMGS=&lt;length&gt; 的参数。</summary>
+    int tpduLength = 0;
+    /// <summary>本段内容在原 UTF-8 文本中的起始字节与字节数。</summary>
+    std::size_t textOffset = 0;
+    std::size_t textLength = 0;
+};
+
+/// <summary>解析出的一条短信。</summary>
+struct SmsPduMessage
+{
+    /// <summary>true 为 SMS-DELIVER（收到的短信），false 为 SMS-SUBMIT（待发或已发）。</summary>
+    bool deliver = true;
+    /// <summary>发送方（DELIVER）或接收方（SUBMIT）号码，国际号码带 '+'，字母数字地址已解码。</summary>
+    std::string address;
+    std::string serviceCenter;
+    /// <summary>服务中心时间戳，仅 DELIVER 有效。</summary>
+    ModemTime timestamp;
+    SmsEncoding encoding = SmsEncoding::Gsm7;
+    SmsConcatInfo concat;
+    bool statusReport = false;
+    /// <summary>用户数据，已转为 UTF-8；8 位数据按 Latin-1 转换。</summary>
+    std::string text;
+};
+
+/// <summary>计算文本需要的编码与段数，不生成 PDU。</summary>
+SmsEncoding ChooseSmsEncoding(std::string_view text, std::size_t* partCount = nullptr);
+
+/// <summary>
+/// 把一条短信编码为一个或多个 SMS-SUBMIT PDU，parts 中原有的字符串容量会被复用。
+/// 号码含有非拨号字符或文本超过 255 段时返回 false。
+/// </summary>
+bool EncodeSmsSubmit(std::string_view destination, std::string_view text, const SmsPduOptions& options, std::vector<SmsPduPart>& parts);
+
+/// <summary>编码为 SMS-DELIVER PDU（模拟收到的短信），timestamp 为 yy/MM/dd,hh:mm:ss±zz。</summary>
+bool EncodeSmsDeliver(std::string_view sender, std::string_view text, std::string_view timestamp, const SmsPduOptions& options,
+                      std::vector<SmsPduPart>& parts);
+
+/// <summary>解析 +CMT、+CMGR、+CMGL 之后的十六进制 PDU（含服务中心地址），格式错误时返回空。</summary>
+std::optional<SmsPduMessage> DecodeSmsPdu(std::string_view hex);
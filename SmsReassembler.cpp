@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------
+名称：长短信拼接实现
+说明：按第一段到达的先后维护等待中的长短信，到齐、超时或超限时交出
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：参考号只有 8 或 16 位，同一号码的参考号会循环使用；等待时限保证旧的残段不会与新的长短信拼在一起太久
+------------------------------------------------------------------------*/
+#include "SmsReassembler.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    /// <summary>缺少的段在正文中的占位（UTF-8 的 "[…]"）。</summary>
+    constexpr std::string_view kMissingPart = "[\xE2\x80\xA6]";
+
+    std::string MakeKey(std::string_view sender, const SmsConcatInfo& concat)
+    {
+        std::string key(sender);
+        key.push_back('\0');
+        key.append(std::to_string(concat.reference)).push_back('/');
+        key.append(std::to_string(concat.total));
+        return key;
+    }
+}
+
+SmsReassembler::SmsReassembler(const SmsReassemblyPolicy& policy)
+    : _policy(policy), _bytes(0)
+{
+}
+
+void SmsReassembler::SetPolicy(const SmsReassemblyPolicy& policy)
+{
+    _policy = policy;
+}
+
+void SmsReassembler::Add(const ReceivedSms& part, const SmsConcatInfo& concat, Clock::time_point now, const MessageHandler& handler)
+{
+    Expire(now, handler);
+    if (concat.total <= 1 || concat.sequence < 1 || concat.sequence > concat.total)
+    {
+        handler(part);
+        return;
+    }
+    auto key = MakeKey(part.sender, concat);
+    auto found = _index.find(key);
+    if (found == _index.end())
+    {
+        Pending pending;
+        pending.key = std::move(key);
+        pending.sender.assign(part.sender);
+        pending.modem.assign(part.modem);
+        pending.total = concat.total;
+        pending.texts.resize(concat.total);
+        pending.firstSeen = now;
+        pending.bytes = sizeof(Pending) + pending.key.size() * 2 + pending.sender.size() + pending.modem.size() +
+                        concat.total * sizeof(std::string);
+        _pending.push_back(std::move(pending));
+        const auto inserted = std::prev(_pending.end());
+        found = _index.emplace(inserted->key, inserted).first;
+        _bytes += inserted->bytes;
+    }
+    auto pending = found->second;
+    const std::size_t slot = concat.sequence - 1;
+    if (pending->present.test(slot))
+    {
+        ++_statistics.duplicateParts;
+        return;
+    }
+    pending->present.set(slot);
+    ++pending->received;
+    pending->texts[slot].assign(part.body);
+    pending->storedParts.insert(pending->storedParts.end(), part.storedParts.begin(), part.storedParts.end());
+    _bytes -= pending->bytes;
+    pending->bytes += part.body.size() + part.storedParts.size() * sizeof(int);
+    if (pending->firstSequence == 0 || concat.sequence < pending->firstSequence)
+    {
+        // 头部、时间戳与存储索引取序号最小的一段，收件箱据此去重，重复列出同一条长短信时结果一致。
+        pending->bytes += part.header.size();
+        pending->bytes -= pending->header.size();
+        pending->header.assign(part.header);
+        pending->timestamp = part.timestamp;
+        pending->storageIndex = part.storageIndex;
+        pending->firstSequence = concat.sequence;
+    }
+    _bytes += pending->bytes;
+    _statistics.peakBytes = std::max(_statistics.peakBytes, _bytes);
+
+    if (pending->received == pending->total)
+    {
+        ++_statistics.completed;
+        Emit(pending, handler);
+        return;
+    }
+    while (!_pending.empty() && (_pending.size() > _policy.maxMessages || _bytes > _policy.maxBytes))
+    {
+        ++_statistics.evicted;
+        Emit(_pending.begin(), handler);
+    }
+}
+
+void SmsReassembler::Expire(Clock::time_point now, const MessageHandler& handler)
+{
+    while (!_pending.empty() && now - _pending.front().firstSeen >= _policy.timeout)
+    {
+        ++_statistics.expired;
+        Emit(_pending.begin(), handler);
+    }
+}
+
+void SmsReassembler::Flush(const MessageHandler& handler)
+{
+    while (!_pending.empty())
+    {
+        ++_statistics.flushed;
+        Emit(_pending.begin(), handler);
+    }
+}
+
+SmsReassemblyStatistics SmsReassembler::GetStatistics() const noexcept
+{
+    auto statistics = _statistics;
+    statistics.pendingMessages = _pending.size();
+    statistics.pendingBytes = _bytes;
+    return statistics;
+}
+
+void SmsReassembler::Emit(PendingList::iterator pending, const MessageHandler& handler)
+{
+    // 先移出缓存再回调，回调期间的统计与缓存状态已不含这一条。
+    const Pending detached = std::move(*pending);
+    _index.erase(detached.key);
+    _pending.erase(pending);
+    _bytes -= detached.bytes;
+
+    _body.clear();
+    for (std::size_t slot = 0; slot < detached.total; ++slot)
+    {
+        _body.append(detached.present.test(slot) ? std::string_view(detached.texts[slot]) : kMissingPart);
+    }
+    ReceivedSms sms;
+    sms.header = detached.header;
+    sms.sender = detached.sender;
+    sms.body = _body;
+    sms.timestamp = detached.timestamp;
+    sms.storageIndex = detached.storageIndex;
+    sms.modem = detached.modem;
+    sms.parts = detached.total;
+    sms.complete = detached.received == detached.total;
+    sms.storedParts = detached.storedParts;
+    handler(sms);
+}
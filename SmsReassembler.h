@@ -0,0 +1,136 @@
+/*------------------------------------------------------------------------
+名称：长短信拼接
+说明：按 (号码, 参考号, 总段数) 缓存长短信的各段，到齐后拼成一条交出
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：缓存按条数与字节数限量，并有等待时限；超时或被挤出的长短信以不完整的形式交出，不丢弃已收到的段
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "AtResponseParser.h"
+#include "SmsPdu.h"
+
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>收到的一条短信，字段为 UTF-8 视图，仅在回调期间有效。</summary>
+struct ReceivedSms
+{
+    /// <summary>文本模式形式的头部行；PDU 模式下由解码结果改写而成，长短信取序号最小的一段。</summary>
+    std::string_view header;
+    std::string_view sender;
+    std::string_view body;
+    /// <summary>服务中心时间戳，头部中没有或无法解析时为空。</summary>
+    std::optional<ModemTime> timestamp;
+    /// <summary>模块存储索引，+CMT 直接上报的短信为 -1。</summary>
+    int storageIndex = -1;
+    /// <summary>收到短信的模块：IMEI，尚未取得时为端口名。</summary>
+    std::string_view modem;
+    /// <summary>拼成本条的段数，普通短信为 1。</summary>
+    int parts = 1;
+    /// <summary>长短信未到齐就被交出（等待超时、缓存已满或断开）时为 false，缺少的段以 "[…]" 代替。</summary>
+    bool complete = true;
+    /// <summary>组成本条的各段在模块存储中的索引，仅含收到的短信（不含已发送与草稿），保存后可据此删除。</summary>
+    std::span<const int> storedParts;
+};
+
+/// <summary>拼接缓存的限量。</summary>
+struct SmsReassemblyPolicy
+{
+    /// <summary>自第一段到达起等待其余各段的时长。</summary>
+    std::chrono::milliseconds timeout{std::chrono::minutes(5)};
+    std::size_t maxMessages = 64;
+    /// <summary>缓存中各段文本、头部与号码的总字节数上限（含每条的固定开销）。</summary>
+    std::size_t maxBytes = 256 * 1024;
+};
+
+/// <summary>拼接统计。</summary>
+struct SmsReassemblyStatistics
+{
+    std::size_t pendingMessages = 0;
+    std::size_t pendingBytes = 0;
+    /// <summary>缓存字节数的历史最大值。</summary>
+    std::size_t peakBytes = 0;
+    std::uint64_t completed = 0;
+    /// <summary>等待超时后不完整交出的条数。</summary>
+    std::uint64_t expired = 0;
+    /// <summary>缓存超限时被挤出（不完整交出）的条数。</summary>
+    std::uint64_t evicted = 0;
+    /// <summary>断开时不完整交出的条数。</summary>
+    std::uint64_t flushed = 0;
+    /// <summary>重复收到而被忽略的段数，例如重复执行 AT+CMGL。</summary>
+    std::uint64_t duplicateParts = 0;
+};
+
+/// <summary>长短信拼接器，非线程安全。</summary>
+class SmsReassembler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using MessageHandler = std::function<void(const ReceivedSms& sms)>;
+
+    explicit SmsReassembler(const SmsReassemblyPolicy& policy = {});
+
+    /// <summary>新限量在下一段到达时生效。</summary>
+    void SetPolicy(const SmsReassemblyPolicy& policy);
+
+    /// <summary>
+    /// 交入一条短信或长短信的一段：concat.total 不大于 1 时直接交出，否则缓存到齐后交出整条。
+    /// 先交出已超时的长短信。
+    /// </summary>
+    void Add(const ReceivedSms& part, const SmsConcatInfo& concat, Clock::time_point now, const MessageHandler& handler);
+
+    /// <summary>交出等待超过时限的长短信。</summary>
+    void Expire(Clock::time_point now, const MessageHandler& handler);
+
+    /// <summary>交出全部等待中的长短信，例如断开之后。</summary>
+    void Flush(const MessageHandler& handler);
+
+    SmsReassemblyStatistics GetStatistics() const noexcept;
+
+private:
+    /// <summary>一条等待中的长短信，头部信息取自序号最小的一段。</summary>
+    struct Pending
+    {
+        std::string key;
+        std::string header;
+        std::string sender;
+        std::string modem;
+        std::optional<ModemTime> timestamp;
+        int storageIndex = -1;
+        int firstSequence = 0;
+        std::uint8_t total = 0;
+        std::size_t received = 0;
+        std::bitset<256> present;
+        std::vector<std::string> texts;
+        std::vector<int> storedParts;
+        std::size_t bytes = 0;
+        Clock::time_point firstSeen;
+    };
+
+    using PendingList = std::list<Pending>;
+
+    /// <summary>拼出正文并交出，然后移出缓存。</summary>
+    void Emit(PendingList::iterator pending, const MessageHandler& handler);
+
+private:
+    SmsReassemblyPolicy _policy;
+    /// <summary>按第一段到达的先后排列，最早的在前，超时与挤出都从前面开始。</summary>
+    PendingList _pending;
+    std::unordered_map<std::string, PendingList::iterator> _index;
+    std::size_t _bytes;
+    SmsReassemblyStatistics _statistics;
+    /// <summary>拼接正文的缓冲区，在各条之间复用。</summary>
+    std::string _body;
+};
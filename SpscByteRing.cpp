@@ -0,0 +1,77 @@
+/*------------------------------------------------------------------------
+名称：单生产者单消费者字节环实现
+说明：以单调递增的读写计数加掩码定位，避免取模与锁
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无
+------------------------------------------------------------------------*/
+#include "SpscByteRing.h"
+
+#include <algorithm>
+
+namespace
+{
+    std::size_t RoundUpToPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+SpscByteRing::SpscByteRing(std::size_t capacity)
+    : _buffer(RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2))), _mask(_buffer.size() - 1), _head(0), _tail(0)
+{
+}
+
+std::size_t SpscByteRing::Capacity() const noexcept
+{
+    return _buffer.size();
+}
+
+std::size_t SpscByteRing::Size() const noexcept
+{
+    const auto tail = _tail.load(std::memory_order_acquire);
+    const auto head = _head.load(std::memory_order_acquire);
+    return head - tail;
+}
+
+SpscByteRing::Region SpscByteRing::WritableRegion() noexcept
+{
+    const auto head = _head.load(std::memory_order_relaxed);
+    const auto tail = _tail.load(std::memory_order_acquire);
+    const auto free = _buffer.size() - (head - tail);
+    const auto offset = head & _mask;
+    const auto contiguous = std::min(free, _buffer.size() - offset);
+    return Region{_buffer.data() + offset, contiguous};
+}
+
+void SpscByteRing::Commit(std::size_t count) noexcept
+{
+    _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+std::string_view SpscByteRing::ReadableRegion() const noexcept
+{
+    const auto tail = _tail.load(std::memory_order_relaxed);
+    const auto head = _head.load(std::memory_order_acquire);
+    const auto available = head - tail;
+    const auto offset = tail & _mask;
+    const auto contiguous = std::min(available, _buffer.size() - offset);
+    return std::string_view(_buffer.data() + offset, contiguous);
+}
+
+void SpscByteRing::Consume(std::size_t count) noexcept
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+void SpscByteRing::Reset() noexcept
+{
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
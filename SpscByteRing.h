@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------
+名称：单生产者单消费者字节环
+说明：串口读取线程与解析线程之间的无锁有界缓冲区
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：仅允许一个线程写入、一个线程读取
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/// <summary>容量为 2 的幂的无锁字节环。</summary>
+class SpscByteRing
+{
+public:
+    /// <summary>可写区域，生产者直接写入后调用 Commit 提交。</summary>
+    struct Region
+    {
+        char* data;
+        std::size_t size;
+    };
+
+    /// <summary>分配缓冲区，容量向上取整为 2 的幂。</summary>
+    explicit SpscByteRing(std::size_t capacity);
+
+    SpscByteRing(const SpscByteRing&) = delete;
+    SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+    /// <summary>缓冲区总容量。</summary>
+    std::size_t Capacity() const noexcept;
+
+    /// <summary>当前已缓存的字节数，任意线程可调用。</summary>
+    std::size_t Size() const noexcept;
+
+    /// <summary>生产者：获取一段连续可写区域，满时 size 为 0。</summary>
+    Region WritableRegion() noexcept;
+
+    /// <summary>生产者：提交已写入可写区域的字节数。</summary>
+    void Commit(std::size_t count) noexcept;
+
+    /// <summary>消费者：获取一段连续可读数据，空时返回空视图。</summary>
+    std::string_view ReadableRegion() const noexcept;
+
+    /// <summary>消费者：释放已处理的字节。</summary>
+    void Consume(std::size_t count) noexcept;
+
+    /// <summary>清空缓冲区，仅可在生产者与消费者都停止时调用。</summary>
+    void Reset() noexcept;
+
+private:
+    std::vector<char> _buffer;
+    std::size_t _mask;
+    alignas(64) std::atomic<std::size_t> _head;
+    alignas(64) std::atomic<std::size_t> _tail;
+};
@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------
+名称：文本编码实现
+说明：Windows 下调用系统转换接口，其余平台使用内置 UTF-8 编解码
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无
+------------------------------------------------------------------------*/
+#include "TextEncoding.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+std::wstring Utf8ToWide(std::string_view text)
+{
+    if (text.empty())
+    {
+        return std::wstring();
+    }
+    const int needed = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    if (needed <= 0)
+    {
+        return std::wstring();
+    }
+    std::wstring buffer(static_cast<std::size_t>(needed), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed);
+    return buffer;
+}
+
+std::string WideToUtf8(std::wstring_view text)
+{
+    if (text.empty())
+    {
+        return std::string();
+    }
+    const int needed = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    if (needed <= 0)
+    {
+        return std::string();
+    }
+    std::string buffer(static_cast<std::size_t>(needed), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), buffer.data(), needed, nullptr, nullptr);
+    return buffer;
+}
+
+#else
+
+namespace
+{
+    constexpr char32_t kReplacement = 0xFFFD;
+
+    void AppendCodePoint(std::wstring& output, char32_t codePoint)
+    {
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            if (codePoint >= 0x10000)
+            {
+                codePoint -= 0x10000;
+                output.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+                output.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+                return;
+            }
+        }
+        output.push_back(static_cast<wchar_t>(codePoint));
+    }
+
+    void AppendUtf8(std::string& output, char32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            output.push_back(static_cast<char>(codePoint));
+        }
+        else if (codePoint < 0x800)
+        {
+            output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else if (codePoint < 0x10000)
+        {
+            output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+}
+
+std::wstring Utf8ToWide(std::string_view text)
+{
+    std::wstring result;
+    result.reserve(text.size());
+    std::size_t i = 0;
+    while (i < text.size())
+    {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        if (lead < 0x80)
+        {
+            result.push_back(static_cast<wchar_t>(lead));
+            ++i;
+            continue;
+        }
+        std::size_t length = 0;
+        char32_t codePoint = 0;
+        char32_t minimum = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            AppendCodePoint(result, kReplacement);
+            ++i;
+            continue;
+        }
+
+        std::size_t consumed = 1;
+        while (consumed < length && i + consumed < text.size())
+        {
+            const auto next = static_cast<unsigned char>(text[i + consumed]);
+            if ((next & 0xC0) != 0x80)
+            {
+                break;
+            }
+            codePoint = (codePoint << 6) | (next & 0x3F);
+            ++consumed;
+        }
+        const bool surrogate = codePoint >= 0xD800 && codePoint <= 0xDFFF;
+        if (consumed != length || codePoint < minimum || codePoint > 0x10FFFF || surrogate)
+        {
+            AppendCodePoint(result, kReplacement);
+        }
+        else
+        {
+            AppendCodePoint(result, codePoint);
+        }
+        i += consumed;
+    }
+    return result;
+}
+
+std::string WideToUtf8(std::wstring_view text)
+{
+    std::string result;
+    result.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        char32_t codePoint = static_cast<char32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < text.size())
+            {
+                const auto low = static_cast<char32_t>(text[i + 1]);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+        }
+        if ((codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+        {
+            codePoint = kReplacement;
+        }
+        AppendUtf8(result, codePoint);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,18 @@
+/*------------------------------------------------------------------------
+名称：文本编码模块
+说明：提供 UTF-8 与宽字符串之间的跨平台转换
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/// <summary>将 UTF-8 字节转换为宽字符串，非法序列替换为 U+FFFD。</summary>
+std::wstring Utf8ToWide(std::string_view text);
+
+/// <summary>将宽字符串转换为 UTF-8 字节。</summary>
+std::string WideToUtf8(std::wstring_view text);
@@ -0,0 +1,205 @@
+/*------------------------------------------------------------------------
+名称：主动上报分发器实现
+说明：实现前缀树匹配与写时复制的订阅表
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：前缀只含大写字母、数字、'+'、':' 与空格，节点按 40 个槽位展开
+------------------------------------------------------------------------*/
+#include "UrcDispatcher.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// <summary>一条前缀定义。不以冒号结尾的前缀（RING、RDY 等）须与整行相同。</summary>
+    struct UrcDefinition
+    {
+        std::string_view prefix;
+        UrcKind kind;
+    };
+
+    constexpr std::array<UrcDefinition, 25> kDefinitions{{
+        {"+CMTI:", UrcKind::Cmti},
+        {"+CMT:", UrcKind::Cmt},
+        {"+CDSI:", UrcKind::Cdsi},
+        {"+CDS:", UrcKind::Cds},
+        {"+CBM:", UrcKind::Cbm},
+        {"+CREG:", UrcKind::Creg},
+        {"+CEREG:", UrcKind::Cereg},
+        {"+CGREG:", UrcKind::Cgreg},
+        {"+C5GREG:", UrcKind::C5greg},
+        {"RING", UrcKind::Ring},
+        {"+CLIP:", UrcKind::Clip},
+        {"+CRING:", UrcKind::Cring},
+        {"+CUSD:", UrcKind::Cusd},
+        {"+CIEV:", UrcKind::Ciev},
+        {"+CPIN:", UrcKind::Cpin},
+        {"+CTZV:", UrcKind::Ctzv},
+        {"+CTZE:", UrcKind::Ctze},
+        {"+CGEV:", UrcKind::Cgev},
+        {"+CFUN:", UrcKind::Cfun},
+        {"+QIURC:", UrcKind::Qiurc},
+        {"+QIND:", UrcKind::Qind},
+        {"+QUSIM:", UrcKind::Qusim},
+        {"RDY", UrcKind::Rdy},
+        {"SMS DONE", UrcKind::SmsDone},
+        {"PB DONE", UrcKind::PbDone}
+    }};
+
+    constexpr std::size_t kAlphabetSize = 40;
+
+    /// <summary>字节到槽位的映射，0 表示该字节不会出现在任何前缀中。</summary>
+    constexpr std::array<std::uint8_t, 256> kSlots = []()
+    {
+        std::array<std::uint8_t, 256> slots{};
+        std::uint8_t next = 1;
+        for (char ch = 'A'; ch <= 'Z'; ++ch)
+        {
+            slots[static_cast<unsigned char>(ch)] = next++;
+        }
+        for (char ch = '0'; ch <= '9'; ++ch)
+        {
+            slots[static_cast<unsigned char>(ch)] = next++;
+        }
+        slots[static_cast<unsigned char>('+')] = next++;
+        slots[static_cast<unsigned char>(':')] = next++;
+        slots[static_cast<unsigned char>(' ')] = next++;
+        return slots;
+    }();
+
+    class PrefixTrie
+    {
+    public:
+        PrefixTrie()
+        {
+            _nodes.emplace_back();
+            for (const auto& definition : kDefinitions)
+            {
+                Insert(definition);
+            }
+        }
+
+        /// <summary>沿树走到不能再走为止，返回最长的匹配。</summary>
+        UrcKind Match(std::string_view line, std::size_t& length) const noexcept
+        {
+            std::size_t node = 0;
+            UrcKind found = UrcKind::None;
+            for (std::size_t i = 0; i < line.size(); ++i)
+            {
+                const auto slot = kSlots[static_cast<unsigned char>(line[i])];
+                const auto next = slot == 0 ? 0 : _nodes[node].children[slot];
+                if (next == 0)
+                {
+                    break;
+                }
+                node = next;
+                const auto& current = _nodes[node];
+                if (current.kind != UrcKind::None && (!current.exact || i + 1 == line.size()))
+                {
+                    found = current.kind;
+                    length = i + 1;
+                }
+            }
+            return found;
+        }
+
+    private:
+        struct Node
+        {
+            std::array<std::uint16_t, kAlphabetSize> children{};
+            UrcKind kind = UrcKind::None;
+            bool exact = false;
+        };
+
+        void Insert(const UrcDefinition& definition)
+        {
+            std::size_t node = 0;
+            for (const char ch : definition.prefix)
+            {
+                const auto slot = kSlots[static_cast<unsigned char>(ch)];
+                if (_nodes[node].children[slot] == 0)
+                {
+                    _nodes[node].children[slot] = static_cast<std::uint16_t>(_nodes.size());
+                    _nodes.emplace_back();
+                }
+                node = _nodes[node].children[slot];
+            }
+            _nodes[node].kind = definition.kind;
+            _nodes[node].exact = definition.prefix.back() != ':';
+        }
+
+        std::vector<Node> _nodes;
+    };
+
+    const PrefixTrie& Trie()
+    {
+        static const PrefixTrie trie;
+        return trie;
+    }
+}
+
+UrcDispatcher::UrcDispatcher()
+    : _subscribers(std::make_shared<SubscriberTable>()), _nextId(1)
+{
+}
+
+UrcKind UrcDispatcher::Match(std::string_view line, std::size_t* payloadOffset) noexcept
+{
+    std::size_t length = 0;
+    const auto kind = Trie().Match(line, length);
+    if (payloadOffset != nullptr)
+    {
+        while (length < line.size() && line[length] == ' ')
+        {
+            ++length;
+        }
+        *payloadOffset = length;
+    }
+    return kind;
+}
+
+UrcDispatcher::SubscriptionId UrcDispatcher::Subscribe(UrcKind kind, Handler handler)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto table = std::make_shared<SubscriberTable>(*_subscribers);
+    const auto id = _nextId++;
+    (*table)[static_cast<std::size_t>(kind)].push_back(Subscriber{id, std::move(handler)});
+    _subscribers = std::move(table);
+    return id;
+}
+
+void UrcDispatcher::Unsubscribe(SubscriptionId id)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto table = std::make_shared<SubscriberTable>(*_subscribers);
+    for (auto& subscribers : *table)
+    {
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [id](const Subscriber& subscriber)
+        {
+            return subscriber.id == id;
+        }), subscribers.end());
+    }
+    _subscribers = std::move(table);
+}
+
+UrcKind UrcDispatcher::Dispatch(std::string_view line) const
+{
+    std::size_t offset = 0;
+    const auto kind = Match(line, &offset);
+    if (kind == UrcKind::None)
+    {
+        return kind;
+    }
+    std::shared_ptr<const SubscriberTable> table;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        table = _subscribers;
+    }
+    const UrcEvent event{kind, line, line.substr(offset)};
+    for (const auto& subscriber : (*table)[static_cast<std::size_t>(kind)])
+    {
+        subscriber.handler(event);
+    }
+    return kind;
+}
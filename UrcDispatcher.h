@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------
+名称：主动上报分发器
+说明：按前缀识别模块的主动上报（URC），分发给按类型订阅的组件
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：前缀匹配基于字节前缀树，耗时只与前缀长度有关，与登记的前缀数量无关
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/// <summary>已知的主动上报类型。</summary>
+enum class UrcKind : std::uint8_t
+{
+    None,
+    /// <summary>+CMTI：新短信已存储。</summary>
+    Cmti,
+    /// <summary>+CMT：新短信直接上报，下一行为正文。</summary>
+    Cmt,
+    Cdsi,
+    Cds,
+    Cbm,
+    Creg,
+    Cereg,
+    Cgreg,
+    C5greg,
+    Ring,
+    Clip,
+    Cring,
+    Cusd,
+    Ciev,
+    Cpin,
+    Ctzv,
+    Ctze,
+    Cgev,
+    Cfun,
+    Qiurc,
+    Qind,
+    Qusim,
+    Rdy,
+    SmsDone,
+    PbDone,
+    Count
+};
+
+/// <summary>一条主动上报，视图仅在回调期间有效。</summary>
+struct UrcEvent
+{
+    UrcKind kind;
+    /// <summary>完整的一行。</summary>
+    std::string_view line;
+    /// <summary>前缀之后的参数部分，已去掉前导空格。</summary>
+    std::string_view payload;
+};
+
+/// <summary>按类型分发主动上报，订阅与分发可在不同线程进行。</summary>
+class UrcDispatcher
+{
+public:
+    using Handler = std::function<void(const UrcEvent& event)>;
+    using SubscriptionId = std::uint64_t;
+
+    UrcDispatcher();
+
+    UrcDispatcher(const UrcDispatcher&) = delete;
+    UrcDispatcher& operator=(const UrcDispatcher&) = delete;
+
+    /// <summary>识别一行的上报类型，不是已知上报时返回 None；payloadOffset 为参数部分的起始位置。</summary>
+    static UrcKind Match(std::string_view line, std::size_t* payloadOffset = nullptr) noexcept;
+
+    /// <summary>订阅一类上报，返回用于退订的编号。</summary>
+    SubscriptionId Subscribe(UrcKind kind, Handler handler);
+
+    /// <summary>退订；返回后该订阅不会再被新的分发调用，正在进行的调用可能仍在执行。</summary>
+    void Unsubscribe(SubscriptionId id);
+
+    /// <summary>识别并分发一行，返回其类型。不分配内存。</summary>
+    UrcKind Dispatch(std::string_view line) const;
+
+private:
+    struct Subscriber
+    {
+        SubscriptionId id;
+        Handler handler;
+    };
+    using SubscriberTable = std::array<std::vector<Subscriber>, static_cast<std::size_t>(UrcKind::Count)>;
+
+    /// <summary>写时复制：分发线程只取快照，订阅变更替换整张表。</summary>
+    mutable std::mutex _mutex;
+    std::shared_ptr<const SubscriberTable> _subscribers;
+    SubscriptionId _nextId;
+};
@@ -0,0 +1,831 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块实现
+说明：实现指令解析、短信存储与按时间排队的输出
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：应答格式遵循 3GPP TS 27.005/27.007 的 verbose 模式（V1）
+------------------------------------------------------------------------*/
+#include "VirtualModem.h"
+#include "SmsPdu.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
+
+namespace
+{
+    constexpr char kCtrlZ = 0x1A;
+    constexpr char kEscape = 0x1B;
+    constexpr char kBackspace = 0x08;
+
+    std::string Ok()
+    {
+        return "\r\nOK\r\n";
+    }
+
+    std::string Error()
+    {
+        return "\r\nERROR\r\n";
+    }
+
+    std::string CmsError(int code)
+    {
+        return "\r\n+CMS ERROR: " + std::to_string(code) + "\r\n";
+    }
+
+    std::string CmeError(int code)
+    {
+        return "\r\n+CME ERROR: " + std::to_string(code) + "\r\n";
+    }
+
+    std::string WithInfo(const std::string& info)
+    {
+        return "\r\n" + info + "\r\n" + Ok();
+    }
+
+    /// <summary>引号外的字符转大写并去掉空格，引号内保持原样。</summary>
+    std::string NormalizeCommand(std::string_view raw)
+    {
+        std::string normalized;
+        normalized.reserve(raw.size());
+        bool quoted = false;
+        for (const char ch : raw)
+        {
+            if (ch == '"')
+            {
+                quoted = !quoted;
+            }
+            else if (!quoted)
+            {
+                if (ch == ' ' || ch == '\t')
+                {
+                    continue;
+                }
+                normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+                continue;
+            }
+            normalized.push_back(ch);
+        }
+        return normalized;
+    }
+
+    bool StartsWith(std::string_view text, std::string_view prefix)
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    /// <summary>解析逗号分隔的整数参数，非数字项记为 -1。</summary>
+    std::vector<int> ParseIntegers(std::string_view arguments)
+    {
+        std::vector<int> values;
+        while (true)
+        {
+            const auto comma = arguments.find(',');
+            const auto item = std::string(arguments.substr(0, comma));
+            char* end = nullptr;
+            const long value = std::strtol(item.c_str(), &end, 10);
+            values.push_back(item.empty() || end == nullptr || *end != '\0' ? -1 : static_cast<int>(value));
+            if (comma == std::string_view::npos)
+            {
+                break;
+            }
+            arguments.remove_prefix(comma + 1);
+        }
+        return values;
+    }
+
+    /// <summary>查找引号外的字符。</summary>
+    std::size_t FindUnquoted(std::string_view text, char target, std::size_t from = 0)
+    {
+        bool quoted = false;
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '"')
+            {
+                quoted = !quoted;
+            }
+            else if (!quoted && text[i] == target && i >= from)
+            {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    /// <summary>取第一个引号内的内容。</summary>
+    std::string FirstQuoted(std::string_view text)
+    {
+        const auto open = text.find('"');
+        if (open == std::string_view::npos)
+        {
+            return {};
+        }
+        const auto close = text.find('"', open + 1);
+        return std::string(text.substr(open + 1, close == std::string_view::npos ? std::string_view::npos : close - open - 1));
+    }
+}
+
+VirtualModem::VirtualModem(VirtualModemOptions options)
+    : _options(std::move(options)), _baudRate(0), _present(true), _composing(false), _textMode(false), _cnmiMode(2), _cnmiMt(1), _cmmsMode(0),
+      _csmsService(0), _awaitingAck(false), _storage(_options.storageCapacity), _nextReference(1), _nextConcatReference(0)
+{
+}
+
+void VirtualModem::AttachLine(unsigned long baudRate)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _baudRate = baudRate;
+    _output.clear();
+    _input.clear();
+    _composing = false;
+    _outputFreeAt = Clock::time_point{};
+    _inputFreeAt = Clock::time_point{};
+}
+
+void VirtualModem::SetOutputNotifier(OutputNotifier notifier)
+{
+    // 与 Notify 互斥，返回后旧通知不再被调用，驱动方可以安全析构。
+    std::lock_guard<std::mutex> guard(_notifierMutex);
+    _notifier = std::move(notifier);
+}
+
+void VirtualModem::SetCommandHook(CommandHook hook)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _hook = std::move(hook);
+}
+
+void VirtualModem::SetResponseLatency(std::chrono::microseconds latency)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _options.responseLatency = latency;
+}
+
+void VirtualModem::SetSignalQuality(int quality)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _options.signalQuality = quality;
+}
+
+void VirtualModem::SetPresent(bool present)
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_present == present)
+        {
+            return;
+        }
+        _present = present;
+        _output.clear();
+        _input.clear();
+        _composing = false;
+        _textMode = false;
+        _cnmiMode = 2;
+        _cnmiMt = 1;
+        _cmmsMode = 0;
+        ResetSmsService();
+    }
+    // 唤醒驱动方，让其尽快观察到设备丢失。
+    Notify();
+}
+
+bool VirtualModem::IsPresent() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _present;
+}
+
+void VirtualModem::Receive(std::string_view bytes)
+{
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (!_present)
+        {
+            return;
+        }
+        const auto outputBefore = _output.size();
+        // 字节在线路上传完后才算到达模块。
+        const auto arrival = std::max(Clock::now(), _inputFreeAt) + TransmitTime(bytes.size());
+        _inputFreeAt = arrival;
+
+        std::string echo;
+        for (const char ch : bytes)
+        {
+            if (_composing)
+            {
+                if (ch == kCtrlZ || ch == kEscape)
+                {
+                    Enqueue(std::move(echo), arrival);
+                    echo.clear();
+                    _composing = false;
+                    if (ch == kEscape)
+                    {
+                        _input.clear();
+                        Enqueue(Ok(), arrival + _options.responseLatency);
+                        continue;
+                    }
+                    VirtualSentSms sent{std::move(_composeTarget), std::move(_input), 0};
+                    if (!_textMode)
+                    {
+                        // PDU 模式下正文是十六进制 SMS-SUBMIT，解出号码与内容后记录。
+                        const auto message = DecodeSmsPdu(sent.body);
+                        if (!message || message->deliver)
+                        {
+                            _composeTarget.clear();
+                            _input.clear();
+                            Enqueue(CmsError(304), arrival + _options.responseLatency);
+                            continue;
+                        }
+                        sent.destination = message->address;
+                        sent.body = message->text;
+                    }
+                    const int reference = _nextReference;
+                    _nextReference = _nextReference % 255 + 1;
+                    sent.reference = reference;
+                    _sent.push_back(std::move(sent));
+                    _composeTarget.clear();
+                    _input.clear();
+                    Enqueue(WithInfo("+CMGS: " + std::to_string(reference)), arrival + _options.responseLatency);
+                    continue;
+                }
+                _input.push_back(ch);
+                if (_options.echo)
+                {
+                    echo.push_back(ch);
+                }
+                continue;
+            }
+
+            if (_options.echo && ch != '\n')
+            {
+                echo.push_back(ch);
+            }
+            if (ch == '\r')
+            {
+                Enqueue(std::move(echo), arrival);
+                echo.clear();
+                const std::string command = std::move(_input);
+                _input.clear();
+                ExecuteCommand(command, arrival);
+            }
+            else if (ch == kBackspace)
+            {
+                if (!_input.empty())
+                {
+                    _input.pop_back();
+                }
+            }
+            else if (ch != '\n')
+            {
+                _input.push_back(ch);
+            }
+        }
+        Enqueue(std::move(echo), arrival);
+        queued = _output.size() != outputBefore;
+    }
+    if (queued)
+    {
+        Notify();
+    }
+}
+
+void VirtualModem::InjectSms(std::string sender, std::string text, std::string timestamp)
+{
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (timestamp.empty())
+        {
+            timestamp = _options.timestamp;
+        }
+        SmsPduOptions options;
+        options.concatReference = _nextConcatReference++;
+        std::vector<SmsPduPart> parts;
+        if (!EncodeSmsDeliver(sender, text, timestamp, options, parts))
+        {
+            parts.assign(1, SmsPduPart{{}, 0, 0, text.size()});
+        }
+        std::string urc;
+        for (const auto& part : parts)
+        {
+            VirtualSms message{"REC UNREAD", sender, timestamp, text.substr(part.textOffset, part.textLength), part.hex};
+            if (_cnmiMt == 2)
+            {
+                // mt=2：不存储，直接上报内容。
+                DeliverDirect(_textMode ? "\r\n+CMT: \"" + sender + "\",,\"" + timestamp + "\"\r\n" + message.text + "\r\n"
+                                        : "\r\n+CMT: ," + std::to_string(part.tpduLength) + "\r\n" + part.hex + "\r\n",
+                              std::move(message));
+                queued = true;
+                continue;
+            }
+            const auto index = StoreMessage(std::move(message));
+            if (index && _cnmiMt != 0)
+            {
+                urc += "\r\n+CMTI: \"SM\"," + std::to_string(*index) + "\r\n";
+            }
+        }
+        if (!urc.empty())
+        {
+            Enqueue(std::move(urc), Clock::now());
+            queued = true;
+        }
+    }
+    if (queued)
+    {
+        Notify();
+    }
+}
+
+void VirtualModem::EmitUrc(std::string_view line)
+{
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        Enqueue("\r\n" + std::string(line) + "\r\n", Clock::now());
+        queued = true;
+    }
+    if (queued)
+    {
+        Notify();
+    }
+}
+
+std::size_t VirtualModem::TakeOutput(char* buffer, std::size_t capacity)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    const auto now = Clock::now();
+    std::size_t copied = 0;
+    while (copied < capacity && !_output.empty() && _output.front().due <= now)
+    {
+        auto& front = _output.front();
+        const auto count = std::min(capacity - copied, front.data.size() - front.offset);
+        std::copy_n(front.data.data() + front.offset, count, buffer + copied);
+        copied += count;
+        front.offset += count;
+        if (front.offset == front.data.size())
+        {
+            _output.pop_front();
+        }
+    }
+    return copied;
+}
+
+std::optional<VirtualModem::Clock::time_point> VirtualModem::NextOutputTime() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_output.empty())
+    {
+        return std::nullopt;
+    }
+    return _output.front().due;
+}
+
+std::vector<VirtualSms> VirtualModem::StoredMessages() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    std::vector<VirtualSms> messages;
+    for (const auto& slot : _storage)
+    {
+        if (slot)
+        {
+            messages.push_back(*slot);
+        }
+    }
+    return messages;
+}
+
+std::vector<VirtualSentSms> VirtualModem::SentMessages() const
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _sent;
+}
+
+void VirtualModem::Notify()
+{
+    std::lock_guard<std::mutex> guard(_notifierMutex);
+    if (_notifier)
+    {
+        _notifier();
+    }
+}
+
+void VirtualModem::ExecuteCommand(const std::string& command, Clock::time_point arrival)
+{
+    std::optional<std::string> response;
+    if (_hook)
+    {
+        // 钩子在内部锁内执行，不可回调本对象。
+        response = _hook(command);
+    }
+    if (!response)
+    {
+        response = Respond(command);
+    }
+    Enqueue(std::move(*response), arrival + _options.responseLatency);
+}
+
+std::string VirtualModem::Respond(const std::string& rawCommand)
+{
+    const std::string command = NormalizeCommand(rawCommand);
+    if (command.empty())
+    {
+        return {};
+    }
+    if (!StartsWith(command, "AT"))
+    {
+        return Error();
+    }
+    if (FindUnquoted(command, ';') != std::string::npos)
+    {
+        // 以分号串联的指令依次执行，只输出最后一个 OK；遇到错误即停止，前面已执行的不回退。
+        std::string response;
+        std::string_view rest = std::string_view(command).substr(2);
+        while (true)
+        {
+            const auto separator = FindUnquoted(rest, ';');
+            auto result = Respond("AT" + std::string(rest.substr(0, separator)));
+            const auto ok = Ok();
+            if (result.size() < ok.size() || result.compare(result.size() - ok.size(), ok.size(), ok) != 0)
+            {
+                return response + result;
+            }
+            response += result.substr(0, result.size() - ok.size());
+            if (separator == std::string_view::npos)
+            {
+                return response + ok;
+            }
+            rest.remove_prefix(separator + 1);
+        }
+    }
+    const std::string_view body = std::string_view(command).substr(2);
+    if (body.empty() || body == "&F" || body == "Z")
+    {
+        if (!body.empty())
+        {
+            _textMode = false;
+            _cnmiMode = 2;
+            _cnmiMt = 1;
+            _cmmsMode = 0;
+            ResetSmsService();
+        }
+        return Ok();
+    }
+    if (body == "E0" || body == "E1")
+    {
+        _options.echo = body == "E1";
+        return Ok();
+    }
+    if (body == "I")
+    {
+        return WithInfo(_options.manufacturer + "\r\n" + _options.model + "\r\nRevision: " + _options.revision);
+    }
+    if (body == "+CGMI")
+    {
+        return WithInfo(_options.manufacturer);
+    }
+    if (body == "+CGMM")
+    {
+        return WithInfo(_options.model);
+    }
+    if (body == "+CGMR")
+    {
+        return WithInfo("+CGMR: " + _options.revision);
+    }
+    if (body == "+CGSN" || body == "+GSN")
+    {
+        return WithInfo(_options.imei);
+    }
+    if (body == "+CSQ")
+    {
+        return WithInfo("+CSQ: " + std::to_string(_options.signalQuality) + ",99");
+    }
+    if (body == "+CREG?")
+    {
+        return WithInfo("+CREG: 0,1");
+    }
+    if (body == "+CESQ")
+    {
+        // 按 +CSQ 的强度折算出 LTE 的 RSRP（每级约 2 dB），RSRQ 取中等值。
+        const int rsrp = _options.signalQuality == 99 ? 255 : std::min(97, 27 + _options.signalQuality * 2);
+        return WithInfo("+CESQ: 99,99,255,255," + std::string(rsrp == 255 ? "255" : "20") + "," + std::to_string(rsrp));
+    }
+    if (body == "+CEREG?")
+    {
+        return WithInfo("+CEREG: 0,1");
+    }
+    if (body == "+COPS?")
+    {
+        return WithInfo("+COPS: 0,0,\"CHINA MOBILE\",7");
+    }
+    if (body == "+CFUN?")
+    {
+        return WithInfo("+CFUN: 1");
+    }
+    if (body == "+CIMI")
+    {
+        return _options.imsi.empty() ? CmeError(10) : WithInfo(_options.imsi);
+    }
+    if (body == "+CSCS=?")
+    {
+        return WithInfo("+CSCS: (\"IRA\",\"GSM\",\"UCS2\")");
+    }
+    if (StartsWith(body, "+CFUN=") || StartsWith(body, "+CSCS="))
+    {
+        return Ok();
+    }
+    if (body == "+CMGF?")
+    {
+        return WithInfo(std::string("+CMGF: ") + (_textMode ? "1" : "0"));
+    }
+    if (StartsWith(body, "+CMGF="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.size() != 1 || (values[0] != 0 && values[0] != 1))
+        {
+            return Error();
+        }
+        _textMode = values[0] == 1;
+        return Ok();
+    }
+    if (body == "+CNMI?")
+    {
+        return WithInfo("+CNMI: " + std::to_string(_cnmiMode) + "," + std::to_string(_cnmiMt) + ",0,0,0");
+    }
+    if (StartsWith(body, "+CNMI="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.empty() || values[0] < 0 || (values.size() > 1 && (values[1] < 0 || values[1] > 3)))
+        {
+            return Error();
+        }
+        _cnmiMode = values[0];
+        _cnmiMt = values.size() > 1 ? values[1] : 0;
+        return Ok();
+    }
+    if (body == "+CSMS?")
+    {
+        return WithInfo("+CSMS: " + std::to_string(_csmsService) + ",1,1,1");
+    }
+    if (StartsWith(body, "+CSMS="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.size() != 1 || (values[0] != 0 && values[0] != 1))
+        {
+            return CmsError(303);
+        }
+        _csmsService = values[0];
+        return WithInfo("+CSMS: 1,1,1");
+    }
+    if (body == "+CNMA" || StartsWith(body, "+CNMA="))
+    {
+        if (!_awaitingAck)
+        {
+            // 340：没有等待确认的短信。
+            return CmsError(340);
+        }
+        _awaitingAck = false;
+        _unacknowledged.reset();
+        std::string response = Ok();
+        if (!_undelivered.empty())
+        {
+            // 网络收到确认后才下发下一条。
+            auto next = std::move(_undelivered.front());
+            _undelivered.pop_front();
+            _awaitingAck = true;
+            _unacknowledged = std::move(next.second);
+            response += next.first;
+        }
+        return response;
+    }
+    if (body == "+CMMS?")
+    {
+        return WithInfo("+CMMS: " + std::to_string(_cmmsMode));
+    }
+    if (StartsWith(body, "+CMMS="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.size() != 1 || values[0] < 0 || values[0] > 2)
+        {
+            return Error();
+        }
+        _cmmsMode = values[0];
+        return Ok();
+    }
+    if (body == "+CSCA?")
+    {
+        return WithInfo("+CSCA: \"" + _serviceCenter + "\",145");
+    }
+    if (StartsWith(body, "+CSCA="))
+    {
+        _serviceCenter = FirstQuoted(body);
+        return Ok();
+    }
+    if (body == "+CPMS?" || StartsWith(body, "+CPMS="))
+    {
+        const auto used = std::to_string(std::count_if(_storage.begin(), _storage.end(), [](const auto& slot)
+        {
+            return slot.has_value();
+        }));
+        const auto capacity = std::to_string(_storage.size());
+        const std::string memory = body == "+CPMS?" ? "\"SM\"," : "";
+        return WithInfo("+CPMS: " + memory + used + "," + capacity + "," + memory + used + "," + capacity + "," + memory + used + "," + capacity);
+    }
+    if (StartsWith(body, "+CMGR="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.size() != 1 || values[0] <= 0)
+        {
+            return CmsError(321);
+        }
+        return ReadMessage(static_cast<std::size_t>(values[0]));
+    }
+    if (body == "+CMGL" || StartsWith(body, "+CMGL="))
+    {
+        if (_textMode)
+        {
+            return ListMessages(body == "+CMGL" ? "REC UNREAD" : FirstQuoted(body));
+        }
+        // PDU 模式下状态以数字给出，0 到 4 依次对应 REC UNREAD 到 ALL。
+        static constexpr std::string_view statuses[] = {"REC UNREAD", "REC READ", "STO UNSENT", "STO SENT", "ALL"};
+        const auto values = ParseIntegers(body.substr(6));
+        const int status = body == "+CMGL" ? 0 : values.size() == 1 ? values[0] : -1;
+        if (status < 0 || status > 4)
+        {
+            return CmsError(302);
+        }
+        return ListMessages(statuses[status]);
+    }
+    if (StartsWith(body, "+CMGD="))
+    {
+        const auto values = ParseIntegers(body.substr(6));
+        if (values.empty() || values[0] < 0)
+        {
+            return CmsError(321);
+        }
+        const int flag = values.size() > 1 ? values[1] : 0;
+        for (std::size_t slot = 0; slot < _storage.size(); ++slot)
+        {
+            auto& message = _storage[slot];
+            const bool target = slot + 1 == static_cast<std::size_t>(values[0]);
+            const bool read = message && message->status == "REC READ";
+            if (message && ((flag == 0 && target) || (flag == 1 && read) || flag >= 4 || (flag >= 2 && flag <= 3 && message->status != "REC UNREAD")))
+            {
+                message.reset();
+            }
+        }
+        return Ok();
+    }
+    if (StartsWith(body, "+CMGS="))
+    {
+        if (_textMode)
+        {
+            _composeTarget = FirstQuoted(body);
+            if (_composeTarget.empty())
+            {
+                return CmsError(304);
+            }
+        }
+        else
+        {
+            const auto values = ParseIntegers(body.substr(6));
+            if (values.size() != 1 || values[0] <= 0)
+            {
+                return CmsError(304);
+            }
+            _composeTarget.clear();
+        }
+        _composing = true;
+        _input.clear();
+        return "\r\n> ";
+    }
+    return Error();
+}
+
+std::string VirtualModem::ListMessages(std::string_view filter)
+{
+    std::string response;
+    for (std::size_t slot = 0; slot < _storage.size(); ++slot)
+    {
+        auto& message = _storage[slot];
+        if (!message || (filter != "ALL" && filter != message->status))
+        {
+            continue;
+        }
+        response += FormatMessage("+CMGL: ", slot + 1, *message);
+        if (message->status == "REC UNREAD")
+        {
+            message->status = "REC READ";
+        }
+    }
+    if (!response.empty())
+    {
+        response += "\r\n";
+    }
+    return response + Ok();
+}
+
+std::string VirtualModem::ReadMessage(std::size_t index)
+{
+    if (index == 0 || index > _storage.size() || !_storage[index - 1])
+    {
+        return CmsError(321);
+    }
+    auto& message = *_storage[index - 1];
+    std::string response = FormatMessage("+CMGR: ", 0, message) + "\r\n" + Ok();
+    if (message.status == "REC UNREAD")
+    {
+        message.status = "REC READ";
+    }
+    return response;
+}
+
+std::string VirtualModem::FormatMessage(std::string_view prefix, std::size_t index, const VirtualSms& message) const
+{
+    std::string response = "\r\n" + std::string(prefix);
+    if (index != 0)
+    {
+        response += std::to_string(index) + ",";
+    }
+    if (_textMode || message.pdu.empty())
+    {
+        return response + "\"" + message.status + "\",\"" + message.sender + "\",,\"" + message.timestamp + "\"\r\n" + message.text;
+    }
+    static constexpr std::string_view statuses[] = {"REC UNREAD", "REC READ", "STO UNSENT", "STO SENT"};
+    const auto status = std::find(std::begin(statuses), std::end(statuses), message.status) - std::begin(statuses);
+    // PDU 的第一个字节是服务中心地址长度，TPDU 长度不含这一段。
+    const auto centerOctets = std::stoul(message.pdu.substr(0, 2), nullptr, 16) + 1;
+    return response + std::to_string(status) + ",," + std::to_string(message.pdu.size() / 2 - centerOctets) + "\r\n" + message.pdu;
+}
+
+std::optional<std::size_t> VirtualModem::StoreMessage(VirtualSms message)
+{
+    for (std::size_t slot = 0; slot < _storage.size(); ++slot)
+    {
+        if (!_storage[slot])
+        {
+            _storage[slot] = std::move(message);
+            return slot + 1;
+        }
+    }
+    return std::nullopt;
+}
+
+void VirtualModem::DeliverDirect(std::string urc, VirtualSms message)
+{
+    if (_csmsService != 1)
+    {
+        Enqueue(std::move(urc), Clock::now());
+        return;
+    }
+    if (_awaitingAck)
+    {
+        _undelivered.emplace_back(std::move(urc), std::move(message));
+        return;
+    }
+    _awaitingAck = true;
+    _unacknowledged = std::move(message);
+    Enqueue(std::move(urc), Clock::now());
+}
+
+void VirtualModem::ResetSmsService()
+{
+    if (_unacknowledged)
+    {
+        StoreMessage(std::move(*_unacknowledged));
+    }
+    for (auto& pending : _undelivered)
+    {
+        StoreMessage(std::move(pending.second));
+    }
+    _unacknowledged.reset();
+    _undelivered.clear();
+    _awaitingAck = false;
+    _csmsService = 0;
+}
+
+void VirtualModem::Enqueue(std::string data, Clock::time_point earliest)
+{
+    // 拔出期间的上报（例如注入短信产生的 +CMTI）随设备一起丢失，短信本身仍留在存储中。
+    if (data.empty() || !_present)
+    {
+        return;
+    }
+    // 输出按序串行发送：开始时间不早于上一段发完的时间。
+    const auto start = std::max(earliest, _outputFreeAt);
+    const auto due = start + TransmitTime(data.size());
+    _outputFreeAt = due;
+    _output.push_back(PendingOutput{due, std::move(data), 0});
+}
+
+VirtualModem::Clock::duration VirtualModem::TransmitTime(std::size_t bytes) const
+{
+    if (!_options.baudPacing || _baudRate == 0)
+    {
+        return Clock::duration::zero();
+    }
+    // 8N1 每字节 10 位。
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(bytes * 10 * 1000000ULL / _baudRate));
+}
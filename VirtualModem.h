@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块
+说明：模拟 4G 模块的 AT 指令应答、短信存储与主动上报，用于无硬件测试
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：本身不含线程，由 VirtualModemTransport 或 VirtualModemPty 驱动
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>虚拟模块的行为参数。</summary>
+struct VirtualModemOptions
+{
+    /// <summary>收到完整指令到开始应答的延迟。</summary>
+    std::chrono::microseconds responseLatency{0};
+    /// <summary>为真时按线路波特率（每字节 10 位）模拟收发耗时。</summary>
+    bool baudPacing = false;
+    bool echo = true;
+    int signalQuality = 23;
+    std::size_t storageCapacity = 50;
+    std::string imei = "860000000000001";
+    /// <summary>SIM 卡的 IMSI，为空时 AT+CIMI 报 +CME ERROR: 10（未插卡）。</summary>
+    std::string imsi = "460001234567890";
+    std::string manufacturer = "SIMCOM";
+    std::string model = "SIM7600CE";
+    std::string revision = "LE20B04SIM7600M22";
+    /// <summary>注入短信未指定时间时使用的时间戳，固定值保证输出可重复。</summary>
+    std::string timestamp = "26/10/16,12:00:00+32";
+};
+
+/// <summary>模块存储中的一条短信。</summary>
+struct VirtualSms
+{
+    std::string status;
+    std::string sender;
+    std::string timestamp;
+    /// <summary>长短信在存储中按段保存，这里是本段的内容。</summary>
+    std::string text;
+    /// <summary>PDU 模式下读取时输出的 SMS-DELIVER（十六进制）。</summary>
+    std::string pdu;
+};
+
+/// <summary>主机经 AT+CMGS 发出的一条短信。</summary>
+struct VirtualSentSms
+{
+    std::string destination;
+    std::string body;
+    int reference = 0;
+};
+
+/// <summary>按 AT 指令集应答的模拟模块，所有方法线程安全。</summary>
+class VirtualModem
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    /// <summary>指令钩子：返回值非空时以其作为完整应答（原样输出），否则走内置处理。</summary>
+    using CommandHook = std::function<std::optional<std::string>(std::string_view command)>;
+    /// <summary>有新输出排队时调用，用于唤醒驱动方；不持有状态锁，但不可在其中调用 SetOutputNotifier。</summary>
+    using OutputNotifier = std::function<void()>;
+
+    explicit VirtualModem(VirtualModemOptions options = {});
+
+    VirtualModem(const VirtualModem&) = delete;
+    VirtualModem& operator=(const VirtualModem&) = delete;
+
+    /// <summary>线路建立：清空收发状态并设置用于限速的波特率。</summary>
+    void AttachLine(unsigned long baudRate);
+
+    /// <summary>设置输出通知。同一时刻只能有一个驱动方。</summary>
+    void SetOutputNotifier(OutputNotifier notifier);
+
+    /// <summary>设置指令钩子，用于脚本化特殊应答。</summary>
+    void SetCommandHook(CommandHook hook);
+
+    void SetResponseLatency(std::chrono::microseconds latency);
+    void SetSignalQuality(int quality);
+
+    /// <summary>模拟 USB 拔出（false）与重新插入（true）。拔出时丢弃在途数据，重新插入后模块状态恢复上电默认值。</summary>
+    void SetPresent(bool present);
+    bool IsPresent() const;
+
+    /// <summary>主机写入的字节。</summary>
+    void Receive(std::string_view bytes);
+
+    /// <summary>
+    /// 模拟收到一条短信，按 AT+CNMI 设置存储并上报 +CMTI，或直接上报 +CMT；长短信按段存储与上报。
+    /// AT+CSMS=1 时直接上报的每段须以 AT+CNMA 确认后才上报下一段，未确认的排队等待。
+    /// </summary>
+    void InjectSms(std::string sender, std::string text, std::string timestamp = {});
+
+    /// <summary>输出一条任意主动上报，自动加上 CRLF。</summary>
+    void EmitUrc(std::string_view line);
+
+    /// <summary>取出已到发送时间的输出，返回字节数。</summary>
+    std::size_t TakeOutput(char* buffer, std::size_t capacity);
+
+    /// <summary>最早一段待发输出的到期时间，没有输出时为空。</summary>
+    std::optional<Clock::time_point> NextOutputTime() const;
+
+    /// <summary>模块存储中的短信。</summary>
+    std::vector<VirtualSms> StoredMessages() const;
+
+    /// <summary>主机已发出的短信。</summary>
+    std::vector<VirtualSentSms> SentMessages() const;
+
+private:
+    /// <summary>一段待发输出。</summary>
+    struct PendingOutput
+    {
+        Clock::time_point due;
+        std::string data;
+        std::size_t offset = 0;
+    };
+
+    void Notify();
+    void ExecuteCommand(const std::string& command, Clock::time_point arrival);
+    std::string Respond(const std::string& command);
+    std::string ListMessages(std::string_view filter);
+    /// <summary>按当前模式（文本或 PDU）格式化一条存储中的短信，index 为 0 时不输出索引（+CMGR）。</summary>
+    std::string FormatMessage(std::string_view prefix, std::size_t index, const VirtualSms& message) const;
+    std::string ReadMessage(std::size_t index);
+    std::optional<std::size_t> StoreMessage(VirtualSms message);
+    /// <summary>上报一条 +CMT；须确认时等上一条确认后再上报。</summary>
+    void DeliverDirect(std::string urc, VirtualSms message);
+    /// <summary>上电复位：未确认的直接上报按网络重发的结果存入存储。</summary>
+    void ResetSmsService();
+    void Enqueue(std::string data, Clock::time_point earliest);
+    Clock::duration TransmitTime(std::size_t bytes) const;
+
+private:
+    mutable std::mutex _mutex;
+    VirtualModemOptions _options;
+    unsigned long _baudRate;
+    bool _present;
+    std::mutex _notifierMutex;
+    OutputNotifier _notifier;
+    CommandHook _hook;
+    std::deque<PendingOutput> _output;
+    Clock::time_point _outputFreeAt;
+    Clock::time_point _inputFreeAt;
+    std::string _input;
+    bool _composing;
+    std::string _composeTarget;
+    bool _textMode;
+    int _cnmiMode;
+    int _cnmiMt;
+    /// <summary>AT+CMMS 设置的短信链路保持模式，模拟模块只记录不影响发送。</summary>
+    int _cmmsMode;
+    /// <summary>AT+CSMS 选择的短信服务：1 表示直接上报须以 AT+CNMA 确认。</summary>
+    int _csmsService;
+    /// <summary>已上报、等待 AT+CNMA 确认的 +CMT。</summary>
+    bool _awaitingAck;
+    /// <summary>等待上报的 +CMT 及对应短信，网络在上一条确认前不会下发下一条。</summary>
+    std::deque<std::pair<std::string, VirtualSms>> _undelivered;
+    /// <summary>已上报、尚未确认的那一条。</summary>
+    std::optional<VirtualSms> _unacknowledged;
+    std::string _serviceCenter;
+    std::vector<std::optional<VirtualSms>> _storage;
+    std::vector<VirtualSentSms> _sent;
+    int _nextReference;
+    std::uint8_t _nextConcatReference;
+};
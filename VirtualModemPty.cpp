@@ -0,0 +1,191 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块 pty 服务实现
+说明：实现 pty 创建与主端读写循环
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：等待超时取自模块下一段输出的到期时间，精度为微秒
+------------------------------------------------------------------------*/
+#ifndef _WIN32
+
+#include "VirtualModemPty.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+    void CloseDescriptor(int& fd)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    void SignalDescriptor(int fd)
+    {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] const auto written = ::write(fd, &value, sizeof(value));
+    }
+
+    /// <summary>写出全部字节；缓冲满时等待可写，停止或出错时放弃。</summary>
+    bool WriteAll(int fd, int wakeFd, const std::atomic<bool>& running, const char* data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            const auto written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN)
+                {
+                    return false;
+                }
+                std::array<pollfd, 2> descriptors{pollfd{fd, POLLOUT, 0}, pollfd{wakeFd, POLLIN, 0}};
+                if ((::poll(descriptors.data(), descriptors.size(), -1) < 0 && errno != EINTR) || !running.load())
+                {
+                    return false;
+                }
+                if ((descriptors[1].revents & POLLIN) != 0)
+                {
+                    // 新输出通知无需处理，服务循环每轮都会重新取到期时间。
+                    std::uint64_t value = 0;
+                    [[maybe_unused]] const auto consumed = ::read(wakeFd, &value, sizeof(value));
+                }
+                continue;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+VirtualModemPty::VirtualModemPty(std::shared_ptr<VirtualModem> modem)
+    : _modem(std::move(modem)), _running(false), _masterFd(-1), _slaveFd(-1), _wakeFd(-1)
+{
+}
+
+VirtualModemPty::~VirtualModemPty()
+{
+    Stop();
+}
+
+bool VirtualModemPty::Start(unsigned long baudRate)
+{
+    Stop();
+    _masterFd = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC | O_NONBLOCK);
+    std::array<char, 128> name{};
+    if (_masterFd < 0 || ::grantpt(_masterFd) != 0 || ::unlockpt(_masterFd) != 0 || ::ptsname_r(_masterFd, name.data(), name.size()) != 0)
+    {
+        CloseDescriptor(_masterFd);
+        return false;
+    }
+    _devicePath = name.data();
+    _slaveFd = ::open(_devicePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    _wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_slaveFd < 0 || _wakeFd < 0)
+    {
+        Stop();
+        return false;
+    }
+    // 先置为原始模式，客户端打开前主机写入的字节也不会被回显或转换。
+    termios options{};
+    ::tcgetattr(_slaveFd, &options);
+    ::cfmakeraw(&options);
+    ::tcsetattr(_slaveFd, TCSANOW, &options);
+
+    _modem->AttachLine(baudRate);
+    const int wakeFd = _wakeFd;
+    _modem->SetOutputNotifier([wakeFd]()
+    {
+        SignalDescriptor(wakeFd);
+    });
+    _running.store(true);
+    _server = std::thread(&VirtualModemPty::ServeLoop, this);
+    return true;
+}
+
+void VirtualModemPty::Stop()
+{
+    if (_running.exchange(false))
+    {
+        SignalDescriptor(_wakeFd);
+    }
+    if (_server.joinable())
+    {
+        _server.join();
+    }
+    if (_modem)
+    {
+        _modem->SetOutputNotifier(nullptr);
+    }
+    CloseDescriptor(_wakeFd);
+    CloseDescriptor(_slaveFd);
+    CloseDescriptor(_masterFd);
+    _devicePath.clear();
+}
+
+const std::string& VirtualModemPty::DevicePath() const noexcept
+{
+    return _devicePath;
+}
+
+void VirtualModemPty::ServeLoop()
+{
+    std::array<char, 4096> buffer{};
+    std::array<pollfd, 2> descriptors{pollfd{_masterFd, POLLIN, 0}, pollfd{_wakeFd, POLLIN, 0}};
+    while (_running.load())
+    {
+        timespec timeout{};
+        timespec* timeoutPointer = nullptr;
+        if (const auto next = _modem->NextOutputTime())
+        {
+            const auto remaining = std::max(*next - VirtualModem::Clock::now(), VirtualModem::Clock::duration::zero());
+            const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+            timeout.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+            timeout.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+            timeoutPointer = &timeout;
+        }
+        if (::ppoll(descriptors.data(), descriptors.size(), timeoutPointer, nullptr) < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if ((descriptors[1].revents & POLLIN) != 0)
+        {
+            std::uint64_t value = 0;
+            [[maybe_unused]] const auto consumed = ::read(_wakeFd, &value, sizeof(value));
+        }
+        if ((descriptors[0].revents & POLLIN) != 0)
+        {
+            const auto received = ::read(_masterFd, buffer.data(), buffer.size());
+            if (received > 0)
+            {
+                _modem->Receive(std::string_view(buffer.data(), static_cast<std::size_t>(received)));
+            }
+        }
+        while (true)
+        {
+            const auto count = _modem->TakeOutput(buffer.data(), buffer.size());
+            if (count == 0 || !WriteAll(_masterFd, _wakeFd, _running, buffer.data(), count))
+            {
+                break;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块 pty 服务
+说明：在 Linux 伪终端主端运行 VirtualModem，从端可被任意串口程序打开
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：仅 Linux；用于连同 PosixSerialTransport 在内的整链路压测
+------------------------------------------------------------------------*/
+#pragma once
+
+#ifndef _WIN32
+
+#include "VirtualModem.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+/// <summary>把模拟模块挂在一个 pty 上。</summary>
+class VirtualModemPty
+{
+public:
+    explicit VirtualModemPty(std::shared_ptr<VirtualModem> modem);
+    ~VirtualModemPty();
+
+    VirtualModemPty(const VirtualModemPty&) = delete;
+    VirtualModemPty& operator=(const VirtualModemPty&) = delete;
+
+    /// <summary>创建 pty 并启动服务线程。baudRate 用于模块的线路限速。</summary>
+    bool Start(unsigned long baudRate = 115200);
+
+    /// <summary>停止服务并关闭 pty。</summary>
+    void Stop();
+
+    /// <summary>从端设备路径，例如 /dev/pts/3。</summary>
+    const std::string& DevicePath() const noexcept;
+
+private:
+    void ServeLoop();
+
+private:
+    std::shared_ptr<VirtualModem> _modem;
+    std::atomic<bool> _running;
+    int _masterFd;
+    /// <summary>服务自身持有的从端描述符，客户端断开重连期间主端不会收到挂断。</summary>
+    int _slaveFd;
+    int _wakeFd;
+    std::string _devicePath;
+    std::thread _server;
+};
+
+#endif
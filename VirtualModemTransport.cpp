@@ -0,0 +1,287 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块传输实现
+说明：实现虚拟串口的等待、读写与反应器通知
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：反应器模式下由计时线程在输出到期时投递一次性可读通知
+------------------------------------------------------------------------*/
+#include "VirtualModemTransport.h"
+
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    std::mutex g_sharedModemMutex;
+    std::map<std::wstring, std::weak_ptr<VirtualModem>> g_sharedModems;
+
+#ifdef _WIN32
+    // 完成端口只比较包中的 OVERLAPPED 是否为空，投递包不会被内核访问。
+    OVERLAPPED g_readyPacket{};
+#endif
+}
+
+bool VirtualModemTransport::IsVirtualPort(const std::wstring& portName)
+{
+    return std::wstring_view(portName).substr(0, kPortPrefix.size()) == kPortPrefix;
+}
+
+std::shared_ptr<VirtualModem> VirtualModemTransport::SharedModem(const std::wstring& portName)
+{
+    std::lock_guard<std::mutex> guard(g_sharedModemMutex);
+    auto& entry = g_sharedModems[portName];
+    auto modem = entry.lock();
+    if (!modem)
+    {
+        modem = std::make_shared<VirtualModem>();
+        entry = modem;
+    }
+    return modem;
+}
+
+VirtualModemTransport::VirtualModemTransport(std::shared_ptr<VirtualModem> modem)
+    : _modem(std::move(modem)), _open(false), _cancelled(false), _reactor(0), _reactorKey(0), _reactorActive(false),
+      _armed(false), _readyFd(-1)
+{
+}
+
+VirtualModemTransport::~VirtualModemTransport()
+{
+    Close();
+}
+
+bool VirtualModemTransport::Open(const std::wstring& portName, const SerialSettings& settings)
+{
+    Close();
+    if (!_modem)
+    {
+        _modem = SharedModem(portName);
+    }
+    if (!_modem->IsPresent())
+    {
+        return false;
+    }
+    _modem->AttachLine(settings.baudRate);
+    _modem->SetOutputNotifier([this]()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _changed.notify_all();
+    });
+    std::lock_guard<std::mutex> guard(_mutex);
+    _cancelled = false;
+    _open.store(true);
+    return true;
+}
+
+void VirtualModemTransport::Close()
+{
+    DetachReactor();
+    if (!_open.exchange(false))
+    {
+        return;
+    }
+    _modem->SetOutputNotifier(nullptr);
+    std::lock_guard<std::mutex> guard(_mutex);
+    _changed.notify_all();
+}
+
+bool VirtualModemTransport::IsOpen() const noexcept
+{
+    return _open.load();
+}
+
+TransportStatus VirtualModemTransport::WaitReadable()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        if (_cancelled)
+        {
+            return TransportStatus::Cancelled;
+        }
+        if (!_open.load())
+        {
+            return TransportStatus::Error;
+        }
+        if (!_modem->IsPresent())
+        {
+            return TransportStatus::Disconnected;
+        }
+        const auto next = _modem->NextOutputTime();
+        if (!next)
+        {
+            _changed.wait(lock);
+        }
+        else if (*next > VirtualModem::Clock::now())
+        {
+            _changed.wait_until(lock, *next);
+        }
+        else
+        {
+            return TransportStatus::Ok;
+        }
+    }
+}
+
+TransportStatus VirtualModemTransport::Read(char* buffer, std::size_t capacity, std::size_t& bytesRead)
+{
+    bytesRead = 0;
+    if (!_open.load())
+    {
+        return TransportStatus::Error;
+    }
+    if (!_modem->IsPresent())
+    {
+        return TransportStatus::Disconnected;
+    }
+    bytesRead = _modem->TakeOutput(buffer, capacity);
+    return TransportStatus::Ok;
+}
+
+TransportStatus VirtualModemTransport::Write(const char* data, std::size_t size, std::size_t& bytesWritten)
+{
+    bytesWritten = 0;
+    if (!_open.load())
+    {
+        return TransportStatus::Error;
+    }
+    if (!_modem->IsPresent())
+    {
+        return TransportStatus::Disconnected;
+    }
+    _modem->Receive(std::string_view(data, size));
+    bytesWritten = size;
+    return TransportStatus::Ok;
+}
+
+void VirtualModemTransport::Cancel()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _cancelled = true;
+    _changed.notify_all();
+}
+
+bool VirtualModemTransport::AttachReactor(ReactorHandle reactor, std::uint64_t key)
+{
+    if (!_open.load() || reactor == 0)
+    {
+        return false;
+    }
+#ifndef _WIN32
+    // 用 eventfd 代表虚拟端口加入 epoll，计时线程写入即视为可读。
+    _readyFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLONESHOT;
+    event.data.u64 = key;
+    if (_readyFd < 0 || epoll_ctl(static_cast<int>(reactor), EPOLL_CTL_ADD, _readyFd, &event) != 0)
+    {
+        if (_readyFd >= 0)
+        {
+            ::close(_readyFd);
+            _readyFd = -1;
+        }
+        return false;
+    }
+#endif
+    std::lock_guard<std::mutex> guard(_mutex);
+    _reactor = reactor;
+    _reactorKey = key;
+    _reactorActive = true;
+    _armed = false;
+    _timer = std::thread(&VirtualModemTransport::TimerLoop, this);
+    return true;
+}
+
+bool VirtualModemTransport::ArmReadable()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (!_reactorActive)
+    {
+        return false;
+    }
+#ifndef _WIN32
+    std::uint64_t value = 0;
+    [[maybe_unused]] const auto consumed = ::read(_readyFd, &value, sizeof(value));
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = _reactorKey;
+    if (epoll_ctl(static_cast<int>(_reactor), EPOLL_CTL_MOD, _readyFd, &event) != 0)
+    {
+        return false;
+    }
+#endif
+    _armed = true;
+    _changed.notify_all();
+    return true;
+}
+
+void VirtualModemTransport::DetachReactor()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (!_reactorActive)
+        {
+            return;
+        }
+        _reactorActive = false;
+        _changed.notify_all();
+    }
+    if (_timer.joinable())
+    {
+        _timer.join();
+    }
+#ifndef _WIN32
+    epoll_ctl(static_cast<int>(_reactor), EPOLL_CTL_DEL, _readyFd, nullptr);
+    ::close(_readyFd);
+    _readyFd = -1;
+#endif
+    _reactor = 0;
+    _reactorKey = 0;
+}
+
+std::shared_ptr<VirtualModem> VirtualModemTransport::Modem() const
+{
+    return _modem;
+}
+
+void VirtualModemTransport::TimerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_reactorActive)
+    {
+        // 设备拔出时立即投递，由 Read 报告 Disconnected。
+        const auto next = !_armed || _cancelled ? std::nullopt
+            : _modem->IsPresent() ? _modem->NextOutputTime() : std::optional(VirtualModem::Clock::now());
+        if (!next)
+        {
+            _changed.wait(lock);
+        }
+        else if (*next > VirtualModem::Clock::now())
+        {
+            _changed.wait_until(lock, *next);
+        }
+        else
+        {
+            _armed = false;
+            SignalReactor();
+        }
+    }
+}
+
+void VirtualModemTransport::SignalReactor()
+{
+#ifdef _WIN32
+    PostQueuedCompletionStatus(reinterpret_cast<HANDLE>(_reactor), 0, static_cast<ULONG_PTR>(_reactorKey), &g_readyPacket);
+#else
+    const std::uint64_t value = 1;
+    [[maybe_unused]] const auto written = ::write(_readyFd, &value, sizeof(value));
+#endif
+}
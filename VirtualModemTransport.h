@@ -0,0 +1,72 @@
+/*------------------------------------------------------------------------
+名称：虚拟模块传输
+说明：把 VirtualModem 作为进程内串口接入 SerialPort，无需硬件或驱动
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：端口名以 SIM 开头时由 AtSession 自动选用
+------------------------------------------------------------------------*/
+#pragma once
+
+#include "SerialTransport.h"
+#include "VirtualModem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+/// <summary>进程内虚拟串口，读写直接作用于模拟模块。</summary>
+class VirtualModemTransport : public SerialTransport
+{
+public:
+    /// <summary>虚拟端口名前缀。</summary>
+    static constexpr std::wstring_view kPortPrefix = L"SIM";
+
+    /// <summary>端口名是否指向虚拟模块。</summary>
+    static bool IsVirtualPort(const std::wstring& portName);
+
+    /// <summary>获取同名端口共享的模拟模块，便于在外部注入短信或调整延迟。</summary>
+    static std::shared_ptr<VirtualModem> SharedModem(const std::wstring& portName);
+
+    /// <summary>modem 为空时在 Open 时按端口名取共享模块。</summary>
+    explicit VirtualModemTransport(std::shared_ptr<VirtualModem> modem = nullptr);
+    ~VirtualModemTransport() override;
+
+    VirtualModemTransport(const VirtualModemTransport&) = delete;
+    VirtualModemTransport& operator=(const VirtualModemTransport&) = delete;
+
+    bool Open(const std::wstring& portName, const SerialSettings& settings) override;
+    void Close() override;
+    bool IsOpen() const noexcept override;
+    TransportStatus WaitReadable() override;
+    TransportStatus Read(char* buffer, std::size_t capacity, std::size_t& bytesRead) override;
+    TransportStatus Write(const char* data, std::size_t size, std::size_t& bytesWritten) override;
+    void Cancel() override;
+    bool AttachReactor(ReactorHandle reactor, std::uint64_t key) override;
+    bool ArmReadable() override;
+    void DetachReactor() override;
+
+    /// <summary>当前关联的模拟模块。</summary>
+    std::shared_ptr<VirtualModem> Modem() const;
+
+private:
+    /// <summary>反应器模式下等待输出到期并投递可读通知。</summary>
+    void TimerLoop();
+    void SignalReactor();
+
+private:
+    std::shared_ptr<VirtualModem> _modem;
+    mutable std::mutex _mutex;
+    std::condition_variable _changed;
+    std::atomic<bool> _open;
+    bool _cancelled;
+    ReactorHandle _reactor;
+    std::uint64_t _reactorKey;
+    bool _reactorActive;
+    bool _armed;
+    int _readyFd;
+    std::thread _timer;
+};
@@ -0,0 +1,511 @@
+/*------------------------------------------------------------------------
+名称：Win32 串口传输实现
+说明：实现 COM 口打开、配置与重叠读写
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：读取采用 WaitCommEvent(EV_RXCHAR) 事件驱动
+------------------------------------------------------------------------*/
+#ifdef _WIN32
+
+#include "Win32SerialTransport.h"
+
+#include <algorithm>
+#include <array>
+#include <cwchar>
+#include <limits>
+#include <setupapi.h>
+#include <initguid.h>
+#include <devguid.h>
+#include <cfgmgr32.h>
+
+#pragma comment(lib, "setupapi.lib")
+
+namespace
+{
+    /// <summary>准备一次重叠请求；suppressPort 为真时完成通知不投递到完成端口。</summary>
+    void PrepareOverlapped(OVERLAPPED& overlapped, HANDLE completionEvent, bool suppressPort)
+    {
+        overlapped = OVERLAPPED{};
+        ResetEvent(completionEvent);
+        // 事件句柄低位置 1 是 Win32 约定，表示该请求完成时不进入关联的完成端口。
+        const auto raw = reinterpret_cast<ULONG_PTR>(completionEvent);
+        overlapped.hEvent = reinterpret_cast<HANDLE>(suppressPort ? (raw | 1) : raw);
+    }
+
+    /// <summary>按最近一次错误码区分设备丢失与一般错误。</summary>
+    TransportStatus FailureStatus()
+    {
+        switch (GetLastError())
+        {
+        case ERROR_OPERATION_ABORTED:
+            return TransportStatus::Cancelled;
+        // USB 转串口被拔出或模块重启时驱动返回的典型错误码。
+        case ERROR_ACCESS_DENIED:
+        case ERROR_BAD_COMMAND:
+        case ERROR_DEVICE_REMOVED:
+        case ERROR_DEVICE_NOT_CONNECTED:
+        case ERROR_FILE_NOT_FOUND:
+        case ERROR_GEN_FAILURE:
+        case ERROR_INVALID_HANDLE:
+        case ERROR_NO_SUCH_DEVICE:
+            return TransportStatus::Disconnected;
+        default:
+            return TransportStatus::Error;
+        }
+    }
+
+    std::wstring DeviceInstanceId(DEVINST instance)
+    {
+        std::array<wchar_t, MAX_DEVICE_ID_LEN + 1> buffer{};
+        if (CM_Get_Device_IDW(instance, buffer.data(), static_cast<ULONG>(buffer.size()), 0) != CR_SUCCESS)
+        {
+            return {};
+        }
+        return buffer.data();
+    }
+
+    /// <summary>
+    /// 复合设备的接口节点（含 MI_xx）实例号随插口变化，改用父节点（带 USB 序列号）加接口号，
+    /// 使同一模块重新枚举后得到相同标识。
+    /// </summary>
+    std::wstring HardwareIdentity(DEVINST instance)
+    {
+        std::wstring identity = DeviceInstanceId(instance);
+        const auto interfacePos = identity.find(L"&MI_");
+        DEVINST parent = 0;
+        if (interfacePos == std::wstring::npos || CM_Get_Parent(&parent, instance, 0) != CR_SUCCESS)
+        {
+            return identity;
+        }
+        const std::wstring parentIdentity = DeviceInstanceId(parent);
+        if (parentIdentity.empty())
+        {
+            return identity;
+        }
+        return parentIdentity + L"\\" + identity.substr(interfacePos + 1, 5);
+    }
+
+    void CloseEvent(HANDLE& eventHandle)
+    {
+        if (eventHandle != nullptr)
+        {
+            CloseHandle(eventHandle);
+            eventHandle = nullptr;
+        }
+    }
+}
+
+std::unique_ptr<SerialTransport> CreateSerialTransport()
+{
+    return std::make_unique<Win32SerialTransport>();
+}
+
+std::vector<SerialPortInfo> EnumerateSerialPorts()
+{
+    std::vector<SerialPortInfo> ports;
+    HDEVINFO devices = SetupDiGetClassDevsW(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
+    if (devices != INVALID_HANDLE_VALUE)
+    {
+        SP_DEVINFO_DATA info{};
+        info.cbSize = sizeof(info);
+        for (DWORD index = 0; SetupDiEnumDeviceInfo(devices, index, &info); ++index)
+        {
+            HKEY key = SetupDiOpenDevRegKey(devices, &info, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+            if (key == INVALID_HANDLE_VALUE)
+            {
+                continue;
+            }
+            std::array<wchar_t, 64> name{};
+            DWORD size = static_cast<DWORD>((name.size() - 1) * sizeof(wchar_t));
+            DWORD type = 0;
+            const bool found = RegQueryValueExW(key, L"PortName", nullptr, &type, reinterpret_cast<LPBYTE>(name.data()), &size) == ERROR_SUCCESS;
+            RegCloseKey(key);
+            if (found && type == REG_SZ && std::wcsncmp(name.data(), L"COM", 3) == 0)
+            {
+                ports.push_back(SerialPortInfo{name.data(), HardwareIdentity(info.DevInst)});
+            }
+        }
+        SetupDiDestroyDeviceInfoList(devices);
+    }
+
+    // 部分虚拟串口驱动不注册到 Ports 类，再用 DOS 设备名补齐。
+    std::vector<wchar_t> buffer(4096);
+    DWORD length = QueryDosDeviceW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
+    if (length == 0 && GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+    {
+        buffer.resize(32768);
+        length = QueryDosDeviceW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
+    }
+    for (const wchar_t* current = buffer.data(); length != 0 && *current != L'\0'; current += std::wcslen(current) + 1)
+    {
+        const std::wstring name = current;
+        const bool known = std::any_of(ports.begin(), ports.end(), [&name](const SerialPortInfo& port)
+        {
+            return port.name == name;
+        });
+        if (name.rfind(L"COM", 0) == 0 && !known)
+        {
+            ports.push_back(SerialPortInfo{name, {}});
+        }
+    }
+    std::sort(ports.begin(), ports.end(), [](const SerialPortInfo& left, const SerialPortInfo& right)
+    {
+        return left.name < right.name;
+    });
+    return ports;
+}
+
+Win32SerialTransport::Win32SerialTransport()
+    : _handle(INVALID_HANDLE_VALUE), _stopEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+      _waitEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr)), _readEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+      _writeEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr)), _waitRequest{}, _readRequest{}, _writeRequest{},
+      _eventMask(0), _completionPort(nullptr), _reactorKey(0), _reactorArmed(false)
+{
+}
+
+Win32SerialTransport::~Win32SerialTransport()
+{
+    Close();
+    CloseEvent(_waitEvent);
+    CloseEvent(_readEvent);
+    CloseEvent(_writeEvent);
+    CloseEvent(_stopEvent);
+}
+
+bool Win32SerialTransport::Open(const std::wstring& rawPortName, const SerialSettings& settings)
+{
+    Close();
+    if (_stopEvent == nullptr || _waitEvent == nullptr || _readEvent == nullptr || _writeEvent == nullptr)
+    {
+        return false;
+    }
+
+    std::wstring portName = rawPortName;
+    if (portName.rfind(L"\\\\.\\", 0) != 0)
+    {
+        portName = L"\\\\.\\" + portName;
+    }
+
+    HANDLE handle = CreateFileW(portName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    const auto rxQueue = static_cast<DWORD>(std::min<std::size_t>(settings.rxQueueSize, MAXDWORD));
+    const auto txQueue = static_cast<DWORD>(std::min<std::size_t>(settings.txQueueSize, MAXDWORD));
+    if (!SetupComm(handle, rxQueue, txQueue) || !Configure(handle, settings))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // 读取立即返回已到达的字节，等待交给 WaitCommEvent 完成，不再依赖超时轮询。
+    COMMTIMEOUTS timeouts{};
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+    // 流控暂停时写入按此超时返回已写部分，由 SerialPort 写线程续写剩余数据。
+    timeouts.WriteTotalTimeoutConstant = 500;
+    if (!SetCommTimeouts(handle, &timeouts) || !SetCommMask(handle, EV_RXCHAR | EV_ERR))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    PurgeComm(handle, PURGE_RXCLEAR | PURGE_TXCLEAR);
+    EscapeCommFunction(handle, SETDTR);
+    if (settings.flowControl != FlowControl::RtsCts)
+    {
+        EscapeCommFunction(handle, SETRTS);
+    }
+
+    ResetEvent(_stopEvent);
+    _handle.store(handle);
+    return true;
+}
+
+void Win32SerialTransport::Close()
+{
+    DetachReactor();
+    _completionPort = nullptr;
+    HANDLE handle = _handle.exchange(INVALID_HANDLE_VALUE);
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        std::lock_guard<std::mutex> guard(_writeMutex);
+        PurgeComm(handle, PURGE_RXABORT | PURGE_TXABORT | PURGE_RXCLEAR | PURGE_TXCLEAR);
+        CloseHandle(handle);
+    }
+}
+
+bool Win32SerialTransport::IsOpen() const noexcept
+{
+    return _handle.load() != INVALID_HANDLE_VALUE;
+}
+
+TransportStatus Win32SerialTransport::WaitReadable()
+{
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return TransportStatus::Error;
+    }
+
+    // 先确认队列是否已有数据，避免在 WaitCommEvent 之前到达的字节被延迟。
+    DWORD errors = 0;
+    COMSTAT status{};
+    if (!ClearCommError(handle, &errors, &status))
+    {
+        return FailureStatus();
+    }
+    if (status.cbInQue > 0)
+    {
+        return TransportStatus::Ok;
+    }
+
+    PrepareOverlapped(_waitRequest, _waitEvent, true);
+    if (WaitCommEvent(handle, &_eventMask, &_waitRequest))
+    {
+        return TransportStatus::Ok;
+    }
+    if (GetLastError() != ERROR_IO_PENDING)
+    {
+        return FailureStatus();
+    }
+    DWORD transferred = 0;
+    return WaitOverlapped(handle, _waitRequest, _waitEvent, transferred);
+}
+
+TransportStatus Win32SerialTransport::Read(char* buffer, std::size_t capacity, std::size_t& bytesRead)
+{
+    bytesRead = 0;
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return TransportStatus::Error;
+    }
+    DWORD errors = 0;
+    COMSTAT status{};
+    if (!ClearCommError(handle, &errors, &status))
+    {
+        return FailureStatus();
+    }
+    if (status.cbInQue == 0 || capacity == 0)
+    {
+        return TransportStatus::Ok;
+    }
+
+    const DWORD limit = static_cast<DWORD>(std::min<std::size_t>(capacity, std::numeric_limits<DWORD>::max()));
+    const DWORD toRead = std::min<DWORD>(status.cbInQue, limit);
+    DWORD transferred = 0;
+    PrepareOverlapped(_readRequest, _readEvent, true);
+    if (!ReadFile(handle, buffer, toRead, nullptr, &_readRequest))
+    {
+        if (GetLastError() != ERROR_IO_PENDING)
+        {
+            return FailureStatus();
+        }
+        const auto result = WaitOverlapped(handle, _readRequest, _readEvent, transferred);
+        if (result != TransportStatus::Ok)
+        {
+            return result;
+        }
+    }
+    else if (!GetOverlappedResult(handle, &_readRequest, &transferred, FALSE))
+    {
+        return FailureStatus();
+    }
+    bytesRead = transferred;
+    return TransportStatus::Ok;
+}
+
+TransportStatus Win32SerialTransport::Write(const char* data, std::size_t size, std::size_t& bytesWritten)
+{
+    bytesWritten = 0;
+    std::lock_guard<std::mutex> guard(_writeMutex);
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return TransportStatus::Error;
+    }
+    const DWORD toWrite = static_cast<DWORD>(std::min<std::size_t>(size, std::numeric_limits<DWORD>::max()));
+    DWORD transferred = 0;
+    PrepareOverlapped(_writeRequest, _writeEvent, true);
+    if (!WriteFile(handle, data, toWrite, nullptr, &_writeRequest))
+    {
+        if (GetLastError() != ERROR_IO_PENDING)
+        {
+            return FailureStatus();
+        }
+        const auto result = WaitOverlapped(handle, _writeRequest, _writeEvent, transferred);
+        bytesWritten = transferred;
+        return result;
+    }
+    if (!GetOverlappedResult(handle, &_writeRequest, &transferred, FALSE))
+    {
+        return FailureStatus();
+    }
+    bytesWritten = transferred;
+    return TransportStatus::Ok;
+}
+
+void Win32SerialTransport::Cancel()
+{
+    if (_stopEvent != nullptr)
+    {
+        SetEvent(_stopEvent);
+    }
+    HANDLE handle = _handle.load();
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        CancelIoEx(handle, nullptr);
+    }
+}
+
+bool Win32SerialTransport::AttachReactor(ReactorHandle reactor, std::uint64_t key)
+{
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE || reactor == 0)
+    {
+        return false;
+    }
+    auto* completionPort = reinterpret_cast<HANDLE>(reactor);
+    if (CreateIoCompletionPort(handle, completionPort, static_cast<ULONG_PTR>(key), 0) == nullptr)
+    {
+        return false;
+    }
+    _completionPort = completionPort;
+    _reactorKey = static_cast<ULONG_PTR>(key);
+    return true;
+}
+
+bool Win32SerialTransport::ArmReadable()
+{
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE || _completionPort == nullptr)
+    {
+        return false;
+    }
+    DWORD errors = 0;
+    COMSTAT status{};
+    if (!ClearCommError(handle, &errors, &status))
+    {
+        return false;
+    }
+    if (status.cbInQue > 0)
+    {
+        // 队列已有数据时直接投递就绪通知，不必等待下一个字符。
+        _reactorArmed = false;
+        return PostQueuedCompletionStatus(_completionPort, 0, _reactorKey, &_waitRequest) != FALSE;
+    }
+    // 等待请求的完成需要进入完成端口，因此不设置事件低位。
+    PrepareOverlapped(_waitRequest, _waitEvent, false);
+    if (!WaitCommEvent(handle, &_eventMask, &_waitRequest) && GetLastError() != ERROR_IO_PENDING)
+    {
+        _reactorArmed = false;
+        return false;
+    }
+    _reactorArmed = true;
+    return true;
+}
+
+void Win32SerialTransport::DetachReactor()
+{
+    HANDLE handle = _handle.load();
+    if (handle == INVALID_HANDLE_VALUE || !_reactorArmed)
+    {
+        return;
+    }
+    // 完成端口投递前内核仍会写入 _waitRequest，必须等请求真正结束。
+    CancelIoEx(handle, &_waitRequest);
+    DWORD transferred = 0;
+    GetOverlappedResult(handle, &_waitRequest, &transferred, TRUE);
+    _reactorArmed = false;
+}
+
+bool Win32SerialTransport::Configure(HANDLE handle, const SerialSettings& settings)
+{
+    DCB dcb{};
+    dcb.DCBlength = sizeof(DCB);
+    if (!GetCommState(handle, &dcb))
+    {
+        return false;
+    }
+    dcb.BaudRate = settings.baudRate;
+    dcb.ByteSize = settings.dataBits;
+    switch (settings.stopBits)
+    {
+    case SerialStopBits::OnePointFive:
+        dcb.StopBits = ONE5STOPBITS;
+        break;
+    case SerialStopBits::Two:
+        dcb.StopBits = TWOSTOPBITS;
+        break;
+    default:
+        dcb.StopBits = ONESTOPBIT;
+        break;
+    }
+    switch (settings.parity)
+    {
+    case SerialParity::Odd:
+        dcb.Parity = ODDPARITY;
+        break;
+    case SerialParity::Even:
+        dcb.Parity = EVENPARITY;
+        break;
+    case SerialParity::Mark:
+        dcb.Parity = MARKPARITY;
+        break;
+    case SerialParity::Space:
+        dcb.Parity = SPACEPARITY;
+        break;
+    default:
+        dcb.Parity = NOPARITY;
+        break;
+    }
+    dcb.fParity = settings.parity == SerialParity::None ? FALSE : TRUE;
+    dcb.fBinary = TRUE;
+    dcb.fDtrControl = DTR_CONTROL_ENABLE;
+    dcb.fOutxDsrFlow = FALSE;
+    dcb.fDsrSensitivity = FALSE;
+    dcb.fAbortOnError = FALSE;
+
+    const bool hardware = settings.flowControl == FlowControl::RtsCts;
+    const bool software = settings.flowControl == FlowControl::XonXoff;
+    dcb.fOutxCtsFlow = hardware ? TRUE : FALSE;
+    dcb.fRtsControl = hardware ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_ENABLE;
+    dcb.fOutX = software ? TRUE : FALSE;
+    dcb.fInX = software ? TRUE : FALSE;
+    dcb.fTXContinueOnXoff = TRUE;
+    if (software)
+    {
+        // 驱动接收队列剩余四分之一时发送 XOFF，回落到四分之一时发送 XON。
+        const auto threshold = static_cast<WORD>(std::min<std::size_t>(settings.rxQueueSize / 4, 0xFFFF));
+        dcb.XonChar = 0x11;
+        dcb.XoffChar = 0x13;
+        dcb.XonLim = threshold;
+        dcb.XoffLim = threshold;
+    }
+    return SetCommState(handle, &dcb) != FALSE;
+}
+
+TransportStatus Win32SerialTransport::WaitOverlapped(HANDLE handle, OVERLAPPED& overlapped, HANDLE completionEvent, DWORD& transferred)
+{
+    const std::array<HANDLE, 2> waitHandles{completionEvent, _stopEvent};
+    const DWORD signaled = WaitForMultipleObjects(static_cast<DWORD>(waitHandles.size()), waitHandles.data(), FALSE, INFINITE);
+    if (signaled != WAIT_OBJECT_0)
+    {
+        CancelIoEx(handle, &overlapped);
+        GetOverlappedResult(handle, &overlapped, &transferred, TRUE);
+        return signaled == WAIT_OBJECT_0 + 1 ? TransportStatus::Cancelled : TransportStatus::Error;
+    }
+    if (!GetOverlappedResult(handle, &overlapped, &transferred, FALSE))
+    {
+        return FailureStatus();
+    }
+    return TransportStatus::Ok;
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------
+名称：Win32 串口传输
+说明：基于重叠 I/O 与 WaitCommEvent 的 Windows 串口实现
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：无
+------------------------------------------------------------------------*/
+#pragma once
+
+#ifdef _WIN32
+
+#include "SerialTransport.h"
+
+#include <atomic>
+#include <mutex>
+#include <windows.h>
+
+/// <summary>Windows COM 口传输实现。</summary>
+class Win32SerialTransport : public SerialTransport
+{
+public:
+    Win32SerialTransport();
+    ~Win32SerialTransport() override;
+
+    Win32SerialTransport(const Win32SerialTransport&) = delete;
+    Win32SerialTransport& operator=(const Win32SerialTransport&) = delete;
+
+    bool Open(const std::wstring& portName, const SerialSettings& settings) override;
+    void Close() override;
+    bool IsOpen() const noexcept override;
+    TransportStatus WaitReadable() override;
+    TransportStatus Read(char* buffer, std::size_t capacity, std::size_t& bytesRead) override;
+    TransportStatus Write(const char* data, std::size_t size, std::size_t& bytesWritten) override;
+    void Cancel() override;
+    bool AttachReactor(ReactorHandle reactor, std::uint64_t key) override;
+    bool ArmReadable() override;
+    void DetachReactor() override;
+
+private:
+    bool Configure(HANDLE handle, const SerialSettings& settings);
+    /// <summary>等待重叠操作完成，被取消时返回 Cancelled。</summary>
+    TransportStatus WaitOverlapped(HANDLE handle, OVERLAPPED& overlapped, HANDLE completionEvent, DWORD& transferred);
+
+private:
+    std::atomic<HANDLE> _handle;
+    HANDLE _stopEvent;
+    HANDLE _waitEvent;
+    HANDLE _readEvent;
+    HANDLE _writeEvent;
+    OVERLAPPED _waitRequest;
+    OVERLAPPED _readRequest;
+    OVERLAPPED _writeRequest;
+    DWORD _eventMask;
+    HANDLE _completionPort;
+    ULONG_PTR _reactorKey;
+    bool _reactorArmed;
+    std::mutex _writeMutex;
+};
+
+#endif
@@ -23,6 +23,8 @@
 #define IDC_COMBO_BAUD             1012
 #define IDC_BUTTON_CLEAR_LOG       1013
 #define IDC_COMBO_THEME             1014
+#define IDC_EDIT_INBOX_QUERY       1015
+#define IDC_BUTTON_SEARCH_INBOX    1016
 
 #ifndef IDC_STATIC
 #define IDC_STATIC                 -1
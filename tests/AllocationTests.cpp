@@ -0,0 +1,192 @@
+/*------------------------------------------------------------------------
+名称：接收路径分配测试
+说明：统计串口分发线程上的堆分配次数，确认主动上报与普通应答的处理不分配内存，并按接收字节数折算每 MB 的分配
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：只计分发线程上的分配（见 CountingAllocator）；分发线程由 RING 订阅回调记下
+------------------------------------------------------------------------*/
+#include "AtSession.h"
+#include "CountingAllocator.h"
+#include "TestSupport.h"
+#include "VirtualModemTransport.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace
+{
+    struct Measurement
+    {
+        double perUrcLine = 0.0;
+        double perCommand = 0.0;
+        long rings = 0;
+    };
+
+    /// <summary>等待 counter 达到 expected，最多 5 秒。</summary>
+    bool WaitFor(const std::atomic<long>& counter, long expected)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (counter.load() < expected)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+    /// <summary>预热后让虚拟模块连续输出混合的主动上报，再执行一批 AT，分别统计分发线程上的分配。</summary>
+    Measurement Measure(const std::wstring& portName, bool withLog)
+    {
+        constexpr int kLines = 6000;
+        constexpr int kCommands = 200;
+        constexpr const char* kUrcs[] = {"+CREG: 0,1", "RING", "+QIND: \"csq\",20,99", "+CEREG: 1,\"1A2B\",\"01C3D4E5\",7",
+                                         "+CGEV: NW PDN DEACT 1", "SOMETHING ELSE"};
+        constexpr int kKinds = static_cast<int>(std::size(kUrcs));
+
+        Measurement result;
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        std::atomic<long> logs{0};
+        if (withLog)
+        {
+            session.SetLogCallback([&logs](const std::wstring&)
+            {
+                ++logs;
+            });
+        }
+        std::atomic<long> rings{0};
+        const auto token = session.GetUrcDispatcher().Subscribe(UrcKind::Ring, [&rings](const UrcEvent&)
+        {
+            CountingAllocator::CountThread(std::this_thread::get_id());
+            ++rings;
+        });
+        CHECK(session.Connect(portName, 115200));
+        session.SendCommand(L"AT").Wait();
+
+        // 预热：首次出现的各类上报可能扩充缓冲区，之后应当复用。
+        long expectedRings = 0;
+        for (int round = 0; round < 2; ++round)
+        {
+            for (int i = 0; i < 600; ++i)
+            {
+                modem->EmitUrc(kUrcs[i % kKinds]);
+            }
+            expectedRings += 600 / kKinds;
+            CHECK(WaitFor(rings, expectedRings));
+        }
+        session.SendCommand(L"AT").Wait();
+
+        long before = CountingAllocator::Allocations();
+        for (int i = 0; i < kLines; ++i)
+        {
+            modem->EmitUrc(kUrcs[i % kKinds]);
+            // 分批输出，不让接收环溢出丢行。
+            if (i % 100 == 99)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        expectedRings += kLines / kKinds;
+        CHECK(WaitFor(rings, expectedRings));
+        // RING 之后还有其他上报，以一条 AT 的往返确认它们都已处理。
+        session.SendCommand(L"AT").Wait();
+        result.perUrcLine = static_cast<double>(CountingAllocator::Allocations() - before) / kLines;
+
+        before = CountingAllocator::Allocations();
+        for (int i = 0; i < kCommands; ++i)
+        {
+            session.SendCommand(L"AT").Wait();
+        }
+        result.perCommand = static_cast<double>(CountingAllocator::Allocations() - before) / kCommands;
+        result.rings = rings.load();
+
+        CountingAllocator::CountThread(std::thread::id{});
+        session.GetUrcDispatcher().Unsubscribe(token);
+        session.Disconnect();
+        return result;
+    }
+
+    /// <summary>
+    /// 约 2 MB 的长行经接收路径（接收环 → 字符串视图回调 → 分帧 → 分发）处理，返回每 MB 的分配次数。
+    /// 每批以 RING 结尾，等其到达后再发下一批，接收环不会溢出。
+    /// </summary>
+    double MeasurePerMegabyte(const std::wstring& portName)
+    {
+        constexpr std::size_t kTotalBytes = 2 << 20;
+        constexpr int kLinesPerBatch = 40;
+        const std::string lines[] = {"+QENG: \"servingcell\",\"NOCONN\",\"LTE\",\"FDD\",460,00,1A2B3C4,123,1650,3,5,5,6C5D,-95,-11,-64,12,34,"
+                                         + std::string(80, '0'),
+                                     "+CEREG: 1,\"1A2B\",\"01C3D4E5\",7," + std::string(120, ' ') + "9",
+                                     "UNSOLICITED TRACE " + std::string(180, 'x')};
+
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        std::atomic<long> rings{0};
+        const auto token = session.GetUrcDispatcher().Subscribe(UrcKind::Ring, [&rings](const UrcEvent&)
+        {
+            CountingAllocator::CountThread(std::this_thread::get_id());
+            ++rings;
+        });
+        CHECK(session.Connect(portName, 115200));
+        session.SendCommand(L"AT").Wait();
+
+        long expectedRings = 0;
+        const auto emitBatch = [&](std::size_t& bytes)
+        {
+            for (int i = 0; i < kLinesPerBatch; ++i)
+            {
+                const auto& line = lines[static_cast<std::size_t>(i) % std::size(lines)];
+                modem->EmitUrc(line);
+                bytes += line.size() + 2;
+            }
+            modem->EmitUrc("RING");
+            bytes += 6;
+            CHECK(WaitFor(rings, ++expectedRings));
+        };
+        // 预热：分帧器的残行缓冲只在长行恰好跨块时扩容，多发几批让它达到最长行的容量。
+        std::size_t warmup = 0;
+        for (int batch = 0; batch < 32; ++batch)
+        {
+            emitBatch(warmup);
+        }
+
+        std::size_t received = 0;
+        const long before = CountingAllocator::Allocations();
+        while (received < kTotalBytes)
+        {
+            emitBatch(received);
+        }
+        // 每批最后的 RING 已到达，前面的行都已处理完。
+        const long allocations = CountingAllocator::Allocations() - before;
+
+        CountingAllocator::CountThread(std::thread::id{});
+        session.GetUrcDispatcher().Unsubscribe(token);
+        session.Disconnect();
+        const double megabytes = static_cast<double>(received) / (1 << 20);
+        std::printf("receive path: %ld allocation(s) over %.2f MB, %.2f allocs/MB\n", allocations, megabytes, allocations / megabytes);
+        return allocations / megabytes;
+    }
+}
+
+int main()
+{
+    const auto quiet = Measure(L"SIM9401", false);
+    std::printf("no log callback: %.3f allocs/URC line, %.2f allocs/command\n", quiet.perUrcLine, quiet.perCommand);
+    CHECK(quiet.perUrcLine < 0.01);
+    CHECK(quiet.perCommand < 0.05);
+
+    // 有日志回调时每行转码为宽字符串交给界面，这是显示所需，只检查没有多出别的分配。
+    const auto logged = Measure(L"SIM9402", true);
+    std::printf("with log callback: %.3f allocs/URC line, %.2f allocs/command\n", logged.perUrcLine, logged.perCommand);
+    CHECK(logged.perUrcLine <= 2.01);
+
+    // 收到的字节以视图交给分帧器，只有跨块的残行被拷贝到复用的缓冲区；稳定后与数据量无关。
+    CHECK(MeasurePerMegabyte(L"SIM9403") < 1.0);
+    return TestSupport::Finish("AllocationTests");
+}
@@ -0,0 +1,98 @@
+/*------------------------------------------------------------------------
+名称：AT 应答解析基准
+说明：对各类应答的典型行反复解析，报告每种解析函数的每行耗时与解析期间的堆分配次数
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为每种行的解析次数，默认一百万
+------------------------------------------------------------------------*/
+#include "AtResponseParser.h"
+#include "CountingAllocator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// <summary>反复解析同一行，报告每行耗时与期间的分配次数；parse 返回是否解析成功。</summary>
+    template <typename Parse>
+    void Measure(const char* name, std::string_view line, long rounds, Parse parse)
+    {
+        long parsed = 0;
+        const auto allocationsBefore = CountingAllocator::Allocations();
+        const auto started = Clock::now();
+        for (long i = 0; i < rounds; ++i)
+        {
+            // 每次经由 volatile 读取长度，防止编译器把循环外提。
+            volatile std::size_t size = line.size();
+            parsed += parse(line.substr(0, size)) ? 1 : 0;
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        std::printf("%-14s %6.1f ns/line  %ld allocation(s)  %s\n", name, seconds / rounds * 1e9,
+                    CountingAllocator::Allocations() - allocationsBefore, parsed == rounds ? "" : "(parse failed)");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 1000000;
+    CountingAllocator::CountThread(std::this_thread::get_id());
+
+    Measure("+CSQ", "+CSQ: 23,99", rounds, [](std::string_view line)
+    {
+        return ParseCsq(line).has_value();
+    });
+    Measure("+CESQ", "+CESQ: 99,99,255,255,20,45", rounds, [](std::string_view line)
+    {
+        return ParseCesq(line).has_value();
+    });
+    Measure("+CEREG query", "+CEREG: 2,1,\"1A2B\",\"01C3D4E5\",7", rounds, [](std::string_view line)
+    {
+        return ParseRegistration(line).has_value();
+    });
+    Measure("+CEREG urc", "+CEREG: 5,\"1A2B\",\"01C3D4E5\",7", rounds, [](std::string_view line)
+    {
+        return ParseRegistration(line).has_value();
+    });
+    Measure("+COPS", "+COPS: 0,0,\"CHINA MOBILE\",7", rounds, [](std::string_view line)
+    {
+        return ParseCops(line).has_value();
+    });
+    Measure("+CPMS", "+CPMS: \"SM\",3,50,\"ME\",0,200,\"SM\",3,50", rounds, [](std::string_view line)
+    {
+        return ParseCpms(line).has_value();
+    });
+    Measure("+CMGL text", "+CMGL: 4,\"REC UNREAD\",\"+8613800000000\",\"Alice\",\"26/10/16,12:00:00+32\",145,12", rounds,
+            [](std::string_view line)
+    {
+        return ParseCmgl(line).has_value();
+    });
+    Measure("+CMGL pdu", "+CMGL: 1,1,,24", rounds, [](std::string_view line)
+    {
+        return ParseCmgl(line).has_value();
+    });
+    Measure("+CMT text", "+CMT: \"+8613800000000\",,\"26/10/16,12:00:00+32\"", rounds, [](std::string_view line)
+    {
+        return ParseCmt(line).has_value();
+    });
+    Measure("+CMTI", "+CMTI: \"SM\",12", rounds, [](std::string_view line)
+    {
+        return ParseCmti(line).has_value();
+    });
+    Measure("+CMS ERROR", "+CMS ERROR: 500", rounds, [](std::string_view line)
+    {
+        return ParseAtError(line).has_value();
+    });
+    Measure("+CCLK", "+CCLK: \"26/10/16,12:34:56-08\"", rounds, [](std::string_view line)
+    {
+        return ParseCclk(line).has_value();
+    });
+
+    CountingAllocator::CountThread(std::thread::id{});
+    return 0;
+}
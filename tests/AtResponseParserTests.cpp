@@ -0,0 +1,229 @@
+/*------------------------------------------------------------------------
+名称：AT 应答解析测试
+说明：以常见模块的真实应答为语料逐个核对解析结果，检查格式错误的行被拒绝，并确认解析过程不分配内存
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：分配计数与接收路径分配测试共用 CountingAllocator，只计本线程
+------------------------------------------------------------------------*/
+#include "AtResponseParser.h"
+#include "CountingAllocator.h"
+#include "TestSupport.h"
+
+#include <string_view>
+#include <thread>
+
+namespace
+{
+    void TestFieldReader()
+    {
+        AtFieldReader reader(" 1, \"a,b\" , ,\"\",x y ,\"unterminated");
+        std::string_view field;
+        bool quoted = false;
+        CHECK(reader.Next(field, quoted) && field == "1" && !quoted);
+        CHECK(reader.Next(field, quoted) && field == "a,b" && quoted);
+        CHECK(reader.Next(field, quoted) && field.empty() && !quoted);
+        CHECK(reader.Next(field, quoted) && field.empty() && quoted);
+        CHECK(reader.Next(field, quoted) && field == "x y" && !quoted);
+        CHECK(reader.Next(field, quoted) && field == "unterminated" && quoted);
+        CHECK(!reader.Next(field));
+
+        // 引号字段之后到逗号之前的多余内容被丢弃。
+        AtFieldReader trailing("\"SM\"junk,3");
+        CHECK(trailing.Next(field) && field == "SM");
+        CHECK(trailing.Next(field) && field == "3");
+        CHECK(!trailing.Next(field));
+
+        AtFieldReader empty("");
+        CHECK(empty.Next(field) && field.empty());
+        CHECK(!empty.Next(field));
+    }
+
+    void TestSignal()
+    {
+        const auto csq = ParseCsq("+CSQ: 23,99");
+        CHECK(csq && csq->rssi == 23 && csq->ber == 99 && csq->HasSignal() && csq->RssiDbm() == -67);
+        const auto noSignal = ParseCsq("+CSQ:99,99");
+        CHECK(noSignal && !noSignal->HasSignal() && noSignal->RssiDbm() == 0);
+        const auto tdscdma = ParseCsq("+CSQ: 150,0");
+        CHECK(tdscdma && tdscdma->RssiDbm() == -66);
+        CHECK(!ParseCsq("+CSQ: 23"));
+        CHECK(!ParseCsq("+CSQ: x,99"));
+        CHECK(!ParseCsq("+CSQ: ,99"));
+        CHECK(!ParseCsq("+CESQ: 99,99,255,255,20,45"));
+
+        const auto cesq = ParseCesq("+CESQ: 99,99,255,255,20,45");
+        CHECK(cesq && cesq->rsrq == 20 && cesq->rsrp == 45 && cesq->RsrpDbm() == -96);
+        const auto unknown = ParseCesq("+CESQ: 99,99,255,255,255,255");
+        CHECK(unknown && unknown->RsrpDbm() == 0);
+        CHECK(!ParseCesq("+CESQ: 99,99,255,255,20"));
+    }
+
+    void TestRegistration()
+    {
+        // 查询应答带 <n>，主动上报不带；区码与小区号为十六进制。
+        const auto query = ParseRegistration("+CREG: 2,1,\"1A2B\",\"01C3D4E5\",7");
+        CHECK(query && query->domain == RegistrationDomain::Circuit && query->mode == 2 && query->status == 1);
+        CHECK(query && query->area == 0x1A2B && query->cell == 0x01C3D4E5 && query->accessTechnology == 7 && query->IsRegistered());
+
+        const auto urc = ParseRegistration("+CEREG: 5,\"1A2B\",\"01C3D4E5\",7");
+        CHECK(urc && urc->domain == RegistrationDomain::Eps && urc->mode == -1 && urc->status == 5 && urc->area == 0x1A2B);
+        CHECK(urc && urc->IsRegistered());
+
+        const auto shortQuery = ParseRegistration("+CGREG: 0,2");
+        CHECK(shortQuery && shortQuery->domain == RegistrationDomain::Packet && shortQuery->mode == 0 && shortQuery->status == 2);
+        CHECK(shortQuery && shortQuery->area == -1 && shortQuery->cell == -1 && !shortQuery->IsRegistered());
+
+        const auto shortUrc = ParseRegistration("+CREG: 3");
+        CHECK(shortUrc && shortUrc->mode == -1 && shortUrc->status == 3);
+
+        const auto emptyFields = ParseRegistration("+CEREG: 1,1,,,7");
+        CHECK(emptyFields && emptyFields->area == -1 && emptyFields->cell == -1 && emptyFields->accessTechnology == 7);
+
+        CHECK(!ParseRegistration("+CREG:"));
+        CHECK(!ParseRegistration("+CREG: x"));
+        CHECK(!ParseRegistration("+CREG: 1,\"ZZZZ\""));
+        CHECK(!ParseRegistration("+C5GREG: 1"));
+    }
+
+    void TestOperatorAndStorage()
+    {
+        const auto cops = ParseCops("+COPS: 0,0,\"CHINA MOBILE\",7");
+        CHECK(cops && cops->mode == 0 && cops->format == 0 && cops->operatorName == "CHINA MOBILE" && cops->accessTechnology == 7);
+        const auto numeric = ParseCops("+COPS: 0,2,\"46000\"");
+        CHECK(numeric && numeric->format == 2 && numeric->operatorName == "46000" && numeric->accessTechnology == -1);
+        const auto unregistered = ParseCops("+COPS: 0");
+        CHECK(unregistered && unregistered->format == -1 && unregistered->operatorName.empty());
+        CHECK(!ParseCops("+COPS: \"x\""));
+        CHECK(!ParseCops("+COPS: 0,0,\"CMCC\",LTE"));
+
+        const auto query = ParseCpms("+CPMS: \"SM\",3,50,\"ME\",0,200,\"SM\",3,50");
+        CHECK(query && query->count == 3);
+        CHECK(query && query->memories[0].name == "SM" && query->memories[0].used == 3 && query->memories[0].total == 50);
+        CHECK(query && query->memories[1].name == "ME" && query->memories[1].total == 200);
+        const auto set = ParseCpms("+CPMS: 3,50,0,200");
+        CHECK(set && set->count == 2 && set->memories[0].name.empty() && set->memories[1].used == 0 && set->memories[1].total == 200);
+        CHECK(!ParseCpms("+CPMS:"));
+        CHECK(!ParseCpms("+CPMS: \"SM\",3"));
+        CHECK(!ParseCpms("+CPMS: 3,x"));
+    }
+
+    void TestSmsHeaders()
+    {
+        const auto text = ParseCmgl("+CMGL: 4,\"REC UNREAD\",\"+8613800000000\",\"Alice\",\"26/10/16,12:00:00+32\",145,12");
+        CHECK(text && text->index == 4 && text->status == "REC UNREAD" && text->statusCode == 0);
+        CHECK(text && text->address == "+8613800000000" && text->alpha == "Alice" && text->timestamp == "26/10/16,12:00:00+32");
+        CHECK(text && !text->IsPdu());
+
+        const auto pdu = ParseCmgl("+CMGL: 1,1,,24");
+        CHECK(pdu && pdu->index == 1 && pdu->statusCode == 1 && pdu->status == "REC READ" && pdu->length == 24 && pdu->IsPdu());
+        const auto unknownStatus = ParseCmgl("+CMGL: 2,\"SOMETHING\",\"10086\",,");
+        CHECK(unknownStatus && unknownStatus->statusCode == -1 && unknownStatus->address == "10086");
+        CHECK(!ParseCmgl("+CMGL: x,\"REC READ\""));
+        CHECK(!ParseCmgl("+CMGL: 1,1,,"));
+
+        const auto read = ParseCmgr("+CMGR: \"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"");
+        CHECK(read && read->index == -1 && read->statusCode == 1 && read->address == "+8613800000000");
+        const auto readPdu = ParseCmgr("+CMGR: 0,,31");
+        CHECK(readPdu && readPdu->statusCode == 0 && readPdu->length == 31);
+
+        const auto cmt = ParseCmt("+CMT: \"+8613800000000\",,\"26/10/16,12:00:00+32\"");
+        CHECK(cmt && cmt->address == "+8613800000000" && cmt->alpha.empty() && cmt->timestamp == "26/10/16,12:00:00+32" && !cmt->IsPdu());
+        const auto cmtPdu = ParseCmt("+CMT: ,24");
+        CHECK(cmtPdu && cmtPdu->IsPdu() && cmtPdu->length == 24);
+        // 带引号的名称只有两个字段时既不是 PDU 也不是完整的文本头部。
+        CHECK(!ParseCmt("+CMT: \"+8613800000000\",\"24\""));
+
+        const auto cmti = ParseCmti("+CMTI: \"SM\",12");
+        CHECK(cmti && cmti->storage == "SM" && cmti->index == 12);
+        CHECK(!ParseCmti("+CMTI: \"SM\""));
+    }
+
+    void TestErrorsAndTime()
+    {
+        const auto cms = ParseAtError("+CMS ERROR: 500");
+        CHECK(cms && cms->source == AtErrorSource::MessageService && cms->code == 500 && cms->text == "500");
+        const auto verbose = ParseAtError("+CME ERROR: SIM not inserted");
+        CHECK(verbose && verbose->source == AtErrorSource::Equipment && verbose->code == -1 && verbose->text == "SIM not inserted");
+        CHECK(!ParseAtError("ERROR"));
+
+        const auto clock = ParseCclk("+CCLK: \"26/10/16,12:34:56-08\"");
+        CHECK(clock && clock->year == 2026 && clock->month == 10 && clock->day == 16 && clock->hour == 12);
+        CHECK(clock && clock->minute == 34 && clock->second == 56 && clock->quarterHours == -8);
+        CHECK(clock && FormatModemTime(*clock) == "26/10/16,12:34:56-08");
+        CHECK(clock && ModemTimeToUnix(*clock) == 1792161296);
+        CHECK(ParseModemTime("26/10/16,12:00:00"));
+        CHECK(!ParseModemTime("26/13/16,12:00:00+32"));
+        CHECK(!ParseModemTime("26/10/16 12:00:00+32"));
+        CHECK(!ParseModemTime("26/10/16,12:00:00+3x"));
+
+        // 往返换算覆盖闰日与负时区。
+        for (const std::int64_t seconds : {std::int64_t{0}, std::int64_t{951782400}, std::int64_t{1792161296}, std::int64_t{4107542399}})
+        {
+            for (const int zone : {-48, 0, 32})
+            {
+                CHECK(ModemTimeToUnix(ModemTimeFromUnix(seconds, zone)) == seconds);
+            }
+        }
+    }
+
+    /// <summary>整套解析函数在本线程上反复执行，堆分配次数应为零。</summary>
+    void TestNoAllocation()
+    {
+        constexpr std::string_view kCorpus[] = {
+            "+CSQ: 23,99", "+CESQ: 99,99,255,255,20,45", "+CREG: 2,1,\"1A2B\",\"01C3D4E5\",7", "+CEREG: 5,\"1A2B\",\"01C3D4E5\",7",
+            "+COPS: 0,0,\"CHINA MOBILE\",7", "+CPMS: \"SM\",3,50,\"ME\",0,200,\"SM\",3,50",
+            "+CMGL: 4,\"REC UNREAD\",\"+8613800000000\",\"Alice\",\"26/10/16,12:00:00+32\",145,12", "+CMGL: 1,1,,24",
+            "+CMGR: \"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"", "+CMT: ,24", "+CMTI: \"SM\",12",
+            "+CMS ERROR: 500", "+CCLK: \"26/10/16,12:34:56-08\"", "OK", "garbage,\"x"};
+        long parsed = 0;
+        CountingAllocator::CountThread(std::this_thread::get_id());
+        const auto before = CountingAllocator::Allocations();
+        for (int round = 0; round < 1000; ++round)
+        {
+            for (const auto line : kCorpus)
+            {
+                parsed += ParseCsq(line) ? 1 : 0;
+                parsed += ParseCesq(line) ? 1 : 0;
+                parsed += ParseRegistration(line) ? 1 : 0;
+                parsed += ParseCops(line) ? 1 : 0;
+                parsed += ParseCpms(line) ? 1 : 0;
+                parsed += ParseCmgl(line) ? 1 : 0;
+                parsed += ParseCmgr(line) ? 1 : 0;
+                parsed += ParseCmt(line) ? 1 : 0;
+                parsed += ParseCmti(line) ? 1 : 0;
+                parsed += ParseAtError(line) ? 1 : 0;
+                if (const auto time = ParseCclk(line))
+                {
+                    parsed += ModemTimeToUnix(*time) > 0 ? 1 : 0;
+                }
+            }
+        }
+        const auto allocations = CountingAllocator::Allocations() - before;
+        CountingAllocator::CountThread(std::thread::id{});
+        std::printf("parsed %ld lines, %ld allocation(s)\n", parsed, allocations);
+        CHECK(parsed == 13000);
+        CHECK(allocations == 0);
+
+        // 计数本身须有效，否则上面的零没有意义。
+        CountingAllocator::CountThread(std::this_thread::get_id());
+        const auto probeBefore = CountingAllocator::Allocations();
+        const auto formatted = FormatModemTime(ModemTime{2026, 10, 16, 12, 0, 0, 32});
+        const auto probe = CountingAllocator::Allocations() - probeBefore;
+        CountingAllocator::CountThread(std::thread::id{});
+        CHECK(formatted == "26/10/16,12:00:00+32");
+        CHECK(probe >= 1);
+    }
+}
+
+int main()
+{
+    TestFieldReader();
+    TestSignal();
+    TestRegistration();
+    TestOperatorAndStorage();
+    TestSmsHeaders();
+    TestErrorsAndTime();
+    TestNoAllocation();
+    return TestSupport::Finish("AtResponseParserTests");
+}
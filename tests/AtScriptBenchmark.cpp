@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本解释基准
+说明：执行只含计算类指令的循环脚本，报告每条指令的解释耗时与稳定后的堆分配次数；另测一条收发指令的往返耗时
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为循环次数（默认十五万）；每次循环五条指令，总数须低于死循环判定的一百万条
+------------------------------------------------------------------------*/
+#include "AtScript.h"
+#include "AtScriptRunner.h"
+#include "AtSession.h"
+#include "CountingAllocator.h"
+#include "VirtualModemTransport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::shared_ptr<const AtScript> CompileOrExit(const std::wstring& element)
+    {
+        std::wstring error;
+        auto script = AtScript::Compile(element, error);
+        if (!script)
+        {
+            std::printf("compile error: %ls\n", error.c_str());
+            std::exit(1);
+        }
+        return script;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 150000;
+    if (iterations <= 0 || iterations >= 199999)
+    {
+        std::printf("iterations must be between 1 and 199998\n");
+        return 1;
+    }
+    const auto count = std::to_wstring(iterations);
+
+    // 每次循环：加一、赋值（模板展开）、两次比较与一次跳转。
+    const auto compute = CompileOrExit(L"<script name=\"compute\"><set var=\"i\" value=\"0\"/><label name=\"top\"/>"
+                                       L"<add var=\"i\"/><set var=\"text\" value=\"AT+CMGR=${i}\"/>"
+                                       L"<if var=\"i\" eq=\"-1\" goto=\"end\"/><if var=\"i\" ge=\"" + count + L"\" goto=\"end\"/>"
+                                       L"<goto label=\"top\"/><label name=\"end\"/></script>");
+    AtSession idle;
+    AtScriptRunner runner(idle);
+
+    // 先执行一遍，让变量缓冲区达到稳定容量，再计时与计数。
+    runner.Run(*compute);
+    CountingAllocator::CountThread(std::this_thread::get_id());
+    const auto allocationsBefore = CountingAllocator::Allocations();
+    const auto started = std::chrono::steady_clock::now();
+    const auto result = runner.Run(*compute);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const auto allocations = CountingAllocator::Allocations() - allocationsBefore;
+    CountingAllocator::CountThread(std::thread::id{});
+    if (!result.succeeded)
+    {
+        std::printf("compute script failed: %ls\n", result.message.c_str());
+        return 1;
+    }
+    std::printf("compute: %llu steps, %.1f ns/step, %.4f allocations/step\n", static_cast<unsigned long long>(result.steps),
+                seconds / static_cast<double>(result.steps) * 1e9, static_cast<double>(allocations) / static_cast<double>(result.steps));
+
+    // 收发指令的耗时由串口往返决定，这里以虚拟模块给出参照。
+    const std::wstring portName = L"SIM9801";
+    auto modem = VirtualModemTransport::SharedModem(portName);
+    AtSession session;
+    if (!session.Connect(portName, 115200))
+    {
+        std::printf("cannot open virtual modem\n");
+        return 1;
+    }
+    AtScriptRunner sender(session);
+    const auto send = CompileOrExit(L"<script name=\"send\"><label name=\"top\"/><send text=\"AT+CSQ\" capture=\"rssi\" field=\"0\"/>"
+                                    L"<loop times=\"2000\" goto=\"top\"/></script>");
+    const auto sendResult = sender.Run(*send);
+    std::printf("send: %llu steps in %lld ms, %.1f us per AT+CSQ round trip\n", static_cast<unsigned long long>(sendResult.steps),
+                static_cast<long long>(sendResult.elapsed.count()), static_cast<double>(sendResult.elapsed.count()) * 1e3 / 2000.0);
+    session.Disconnect();
+    return sendResult.succeeded ? 0 : 1;
+}
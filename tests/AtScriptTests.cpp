@@ -0,0 +1,294 @@
+/*------------------------------------------------------------------------
+名称：AT 脚本测试
+说明：检查编译错误的报告、标签与跳转（含前向引用、循环与比较），以及指令失败、指令超时、等待上报超时、死循环与取消
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：执行部分接到进程内虚拟模块，特殊应答由指令钩子给出；各用例使用不同的端口名
+------------------------------------------------------------------------*/
+#include "AtScript.h"
+#include "AtScriptRunner.h"
+#include "AtSession.h"
+#include "TestSupport.h"
+#include "VirtualModemTransport.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::shared_ptr<const AtScript> Compile(const std::wstring& body, std::wstring& error)
+    {
+        return AtScript::Compile(L"<script name=\"t\" summary=\"测试\">" + body + L"</script>", error);
+    }
+
+    bool Contains(const std::wstring& text, const std::wstring& part)
+    {
+        return text.find(part) != std::wstring::npos;
+    }
+
+    /// <summary>收集 &lt;log&gt; 输出，去掉 "[t] " 前缀。</summary>
+    class ScriptLog
+    {
+    public:
+        explicit ScriptLog(AtScriptRunner& runner)
+        {
+            runner.SetLogCallback([this](const std::wstring& text)
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _lines.push_back(text.substr(text.find(L"] ") + 2));
+            });
+        }
+
+        std::vector<std::wstring> Lines() const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            return _lines;
+        }
+
+    private:
+        mutable std::mutex _mutex;
+        std::vector<std::wstring> _lines;
+    };
+
+    /// <summary>编译并在 runner 上执行，编译失败时记为失败。</summary>
+    AtScriptResult Run(AtScriptRunner& runner, const std::wstring& body)
+    {
+        std::wstring error;
+        const auto script = Compile(body, error);
+        CHECK(script != nullptr);
+        if (!script)
+        {
+            std::printf("compile error: %ls\n", error.c_str());
+            return {};
+        }
+        return runner.Run(*script);
+    }
+
+    void TestCompileErrors()
+    {
+        struct Case
+        {
+            std::wstring element;
+            std::wstring expected;
+        };
+        const std::vector<Case> cases{
+            {L"<script name=\"t\"><end/>", L"缺少 </script>"},
+            {L"<script><end/></script>", L"缺少属性 name"},
+            {L"<script name=\"t\"/></script>", L"应以 <script> 开始"},
+            {L"<script name=\"t\"><foo/></script>", L"脚本「t」第 1 个元素: 不支持的元素 <foo>"},
+            {L"<script name=\"t\"><log text=\"a\"/><send text=\"AT\"></script>", L"第 2 个元素: <send> 须写成自闭合元素"},
+            {L"<script name=\"t\"><goto label=\"nowhere\"/></script>", L"标签 nowhere 不存在"},
+            {L"<script name=\"t\"><label name=\"a\"/><label name=\"a\"/></script>", L"第 2 个元素: 标签 a 重复"},
+            {L"<script name=\"t\"><log text=\"${x}\"/></script>", L"变量 x 从未赋值"},
+            {L"<script name=\"t\"><log text=\"${x\"/></script>", L"变量引用 ${...} 格式错误"},
+            {L"<script name=\"t\"><log text=\"${}\"/></script>", L"变量引用 ${...} 格式错误"},
+            {L"<script name=\"t\"><send text=\"AT\" timeout=\"abc\"/></script>", L"属性 timeout 须为 0 到 3600000 之间的整数"},
+            {L"<script name=\"t\"><send text=\"AT\" timeout=\"3600001\"/></script>", L"属性 timeout 须为"},
+            {L"<script name=\"t\"><send text=\"\"/></script>", L"缺少属性 text"},
+            {L"<script name=\"t\"><wait urc=\"+CSQ\" timeout=\"10\"/></script>", L"urc 不是已知的主动上报前缀"},
+            {L"<script name=\"t\"><wait urc=\"+CMTI\" timeout=\"0\"/></script>", L"属性 timeout 须为 1 到"},
+            {L"<script name=\"t\"><set var=\"a\"/><if var=\"a\" eq=\"1\" ne=\"2\" goto=\"x\"/><label name=\"x\"/></script>", L"只能有一个比较条件"},
+            {L"<script name=\"t\"><set var=\"a\"/><if var=\"a\" goto=\"x\"/><label name=\"x\"/></script>", L"缺少比较条件"},
+            {L"<script name=\"t\"><add var=\"a\" value=\"1.5\"/></script>", L"value 须为整数"},
+            {L"<script name=\"t\"><loop times=\"0\" goto=\"x\"/><label name=\"x\"/></script>", L"属性 times 须为 1 到"},
+            {L"<script name=\"t\"><log text=a/></script>", L"属性 text 的值须加引号"},
+            {L"<script name=\"t\"><log text=\"a\" text=\"b\"/></script>", L"属性 text 重复"},
+            {L"<script name=\"t\"><!-- <end/> </script>", L"注释未闭合"}};
+        for (const auto& entry : cases)
+        {
+            std::wstring error;
+            const auto script = AtScript::Compile(entry.element, error);
+            CHECK(script == nullptr);
+            CHECK(Contains(error, entry.expected));
+            if (!Contains(error, entry.expected))
+            {
+                std::printf("  got: %ls\n", error.c_str());
+            }
+        }
+    }
+
+    void TestCompiledLayout()
+    {
+        std::wstring error;
+        const auto script = Compile(L"<!-- 注释 -->"
+                                    L"<send text=\"AT+CSQ\" capture=\"rssi\" field=\"0\" onError=\"tail\"/>"
+                                    L"<wait urc=\"+CMTI\" timeout=\"10\" capture=\"index\" field=\"1\"/>"
+                                    L"<wait urc=\"RING\" timeout=\"10\"/><wait urc=\"+CMTI:\" timeout=\"10\"/>"
+                                    L"<label name=\"tail\"/><loop times=\"2\" goto=\"tail\"/>"
+                                    L"<log text=\"&lt;${rssi}&amp;${index}&gt;\"/>",
+                                    error);
+        CHECK(script != nullptr);
+        if (!script)
+        {
+            return;
+        }
+        CHECK(script->Name() == L"t" && script->Summary() == L"测试");
+        const auto code = script->Code();
+        CHECK(code.size() == 8);
+        CHECK(code[0].op == AtScriptOp::Send && code[0].target == 5);
+        CHECK(code[1].op == AtScriptOp::Capture && code[1].flag == 0 && script->Prefix(code[1].a) == "+CSQ:");
+        CHECK(code[2].op == AtScriptOp::WaitUrc && code[2].flag == static_cast<std::uint8_t>(UrcKind::Cmti) && code[2].a == 1);
+        CHECK(code[3].op == AtScriptOp::WaitUrc && code[3].slot == AtScript::kNoSlot && code[3].a == AtScript::kWholeLine);
+        CHECK(code[5].op == AtScriptOp::Loop && code[5].target == 5 && code[5].a == 2);
+        CHECK(code[7].op == AtScriptOp::End);
+        // result、rssi、index 三个变量；重复等待同一类上报只订阅一次。
+        CHECK(script->VariableCount() == 3 && script->CounterCount() == 1);
+        CHECK(script->UrcKinds().size() == 2);
+
+        std::vector<std::wstring> variables(script->VariableCount());
+        variables[code[1].slot] = L"17";
+        variables[code[2].slot] = L"3";
+        std::wstring text;
+        script->Expand(code[6].a, variables, text);
+        CHECK(text == L"<17&3>");
+    }
+
+    /// <summary>纯计算的脚本：计数循环、loop、前向 goto、数值与文本比较。</summary>
+    void TestJumpsAndLabels()
+    {
+        AtSession session;
+        AtScriptRunner runner(session);
+        ScriptLog log(runner);
+        const auto result = Run(runner, L"<set var=\"i\" value=\"0\"/>"
+                                        L"<label name=\"top\"/><add var=\"i\"/><if var=\"i\" lt=\"5\" goto=\"top\"/>"
+                                        L"<log text=\"i=${i}\"/>"
+                                        L"<label name=\"again\"/><log text=\"tick\"/><loop times=\"3\" goto=\"again\"/>"
+                                        L"<goto label=\"skip\"/><log text=\"never\"/><label name=\"skip\"/>"
+                                        L"<set var=\"n\" value=\"10\"/><if var=\"n\" gt=\"9\" goto=\"numeric\"/><fail message=\"text compare\"/>"
+                                        L"<label name=\"numeric\"/><set var=\"s\" value=\"b\"/><if var=\"s\" gt=\"a\" goto=\"text\"/><fail/>"
+                                        L"<label name=\"text\"/><add var=\"i\" value=\"-7\"/><if var=\"i\" eq=\"-2\" goto=\"done\"/>"
+                                        L"<fail message=\"add\"/><label name=\"done\"/>");
+        CHECK(result.succeeded);
+        CHECK(log.Lines() == std::vector<std::wstring>({L"i=5", L"tick", L"tick", L"tick"}));
+        // 1 + 5×2 + 1 + 3×2 + 1 + 2 + 2 + 2 条指令，外加末尾的 End。
+        CHECK(result.steps == 26);
+
+        const auto failed = Run(runner, L"<set var=\"a\" value=\"x\"/><add var=\"a\"/>");
+        CHECK(!failed.succeeded && Contains(failed.message, L"不是整数"));
+        const auto explicitFail = Run(runner, L"<set var=\"a\" value=\"7\"/><fail message=\"a=${a}\"/>");
+        CHECK(!explicitFail.succeeded && explicitFail.message == L"a=7");
+
+        // 没有收发或等待的死循环在一百万条后结束，而不是挂起。
+        const auto spin = Run(runner, L"<label name=\"a\"/><goto label=\"a\"/>");
+        CHECK(!spin.succeeded && Contains(spin.message, L"死循环"));
+    }
+
+    /// <summary>指令失败时按 onError 结束、继续或跳转，结果写入 result；能从应答中捕获字段。</summary>
+    void TestSendAndCapture()
+    {
+        const std::wstring portName = L"SIM9701";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        modem->SetSignalQuality(17);
+        modem->SetCommandHook([](std::string_view command) -> std::optional<std::string>
+        {
+            if (command == "AT+BOGUS")
+            {
+                return std::string("\r\n+CME ERROR: 100\r\n");
+            }
+            return std::nullopt;
+        });
+        AtSession session;
+        CHECK(session.Connect(portName, 115200));
+        AtScriptRunner runner(session);
+        ScriptLog log(runner);
+
+        const auto captured = Run(runner, L"<send text=\"AT+CSQ\" capture=\"rssi\" field=\"0\"/><send text=\"AT+CSQ\" capture=\"all\"/>"
+                                          L"<log text=\"${rssi}|${all}|${result}\"/>");
+        CHECK(captured.succeeded);
+        const auto failed = Run(runner, L"<send text=\"AT+BOGUS\"/><log text=\"never\"/>");
+        CHECK(!failed.succeeded && Contains(failed.message, L"AT+BOGUS 失败: +CME ERROR: 100"));
+        const auto continued = Run(runner, L"<send text=\"AT+BOGUS\" onError=\"continue\"/><log text=\"continued ${result}\"/>");
+        CHECK(continued.succeeded);
+        const auto jumped = Run(runner, L"<send text=\"AT+BOGUS\" onError=\"handler\"/><fail message=\"no jump\"/>"
+                                        L"<label name=\"handler\"/><log text=\"handled\"/>");
+        CHECK(jumped.succeeded);
+        CHECK(log.Lines() == std::vector<std::wstring>({L"17|17,99|OK", L"continued +CME ERROR: 100", L"handled"}));
+        session.Disconnect();
+    }
+
+    /// <summary>指令超时与等待上报超时：按 onError / onTimeout 处理，耗时不短于所设超时；早于等待到达的上报不丢失。</summary>
+    void TestTimeouts()
+    {
+        const std::wstring portName = L"SIM9702";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        modem->SetCommandHook([](std::string_view command) -> std::optional<std::string>
+        {
+            if (command == "AT+SLOW")
+            {
+                return std::string();
+            }
+            if (command == "AT+EMIT")
+            {
+                return std::string("\r\n+CMTI: \"SM\",7\r\n\r\nOK\r\n");
+            }
+            return std::nullopt;
+        });
+        AtSession session;
+        CHECK(session.Connect(portName, 115200));
+        AtScriptRunner runner(session);
+        ScriptLog log(runner);
+
+        const auto slow = Run(runner, L"<send text=\"AT+SLOW\" timeout=\"200\" onError=\"late\"/><fail/>"
+                                      L"<label name=\"late\"/><log text=\"${result}\"/>");
+        CHECK(slow.succeeded && slow.elapsed >= std::chrono::milliseconds(200));
+        const auto slowFail = Run(runner, L"<send text=\"AT+SLOW\" timeout=\"100\"/>");
+        CHECK(!slowFail.succeeded && Contains(slowFail.message, L"TIMEOUT"));
+
+        const auto waited = Run(runner, L"<wait urc=\"+CMTI\" timeout=\"150\"/>");
+        CHECK(!waited.succeeded && waited.message == L"等待主动上报超时" && waited.elapsed >= std::chrono::milliseconds(150));
+        const auto waitJump = Run(runner, L"<wait urc=\"RING\" timeout=\"50\" onTimeout=\"none\"/><fail/>"
+                                          L"<label name=\"none\"/><log text=\"no ring\"/>");
+        CHECK(waitJump.succeeded);
+
+        // +CMTI 在 AT+EMIT 的应答中途到达，早于执行到 <wait>。
+        const auto early = Run(runner, L"<send text=\"AT+EMIT\"/><wait urc=\"+CMTI\" timeout=\"2000\" capture=\"index\" field=\"1\"/>"
+                                       L"<log text=\"index ${index}\"/>");
+        CHECK(early.succeeded && early.elapsed < std::chrono::milliseconds(2000));
+        CHECK(log.Lines() == std::vector<std::wstring>({L"TIMEOUT", L"no ring", L"index 7"}));
+        session.Disconnect();
+    }
+
+    /// <summary>后台执行时取消立即结束休眠；执行中再次启动被拒绝。</summary>
+    void TestCancel()
+    {
+        AtSession session;
+        AtScriptRunner runner(session);
+        std::wstring error;
+        const auto script = Compile(L"<sleep ms=\"60000\"/>", error);
+        CHECK(script != nullptr);
+        AtScriptResult finished;
+        std::mutex mutex;
+        CHECK(runner.Start(script, [&](const AtScriptResult& result)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            finished = result;
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(runner.IsRunning());
+        CHECK(!runner.Start(script, {}));
+        const auto busy = runner.Run(*script);
+        CHECK(!busy.succeeded && busy.message == L"已有脚本在执行");
+
+        const auto started = std::chrono::steady_clock::now();
+        runner.Cancel();
+        CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(2));
+        CHECK(!runner.IsRunning());
+        std::lock_guard<std::mutex> guard(mutex);
+        CHECK(!finished.succeeded && finished.message == L"已取消");
+    }
+}
+
+int main()
+{
+    TestCompileErrors();
+    TestCompiledLayout();
+    TestJumpsAndLabels();
+    TestSendAndCapture();
+    TestTimeouts();
+    TestCancel();
+    return TestSupport::Finish("AtScriptTests");
+}
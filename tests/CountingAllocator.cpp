@@ -0,0 +1,52 @@
+/*------------------------------------------------------------------------
+名称：分配计数实现
+说明：全局 operator new / delete 的替换，按线程过滤后计数
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：数组形式与对齐形式的 new 默认转调这里的 operator new，无需单独替换
+------------------------------------------------------------------------*/
+#include "CountingAllocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::thread::id> g_countedThread{};
+    std::atomic<long> g_allocations{0};
+}
+
+void CountingAllocator::CountThread(std::thread::id thread) noexcept
+{
+    g_countedThread.store(thread, std::memory_order_relaxed);
+}
+
+long CountingAllocator::Allocations() noexcept
+{
+    return g_allocations.load();
+}
+
+void* operator new(std::size_t size)
+{
+    if (std::this_thread::get_id() == g_countedThread.load(std::memory_order_relaxed))
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* block = std::malloc(size == 0 ? 1 : size))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
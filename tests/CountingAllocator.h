@@ -0,0 +1,20 @@
+/*------------------------------------------------------------------------
+名称：分配计数
+说明：替换全局 operator new，统计指定线程上的堆分配次数，供分配相关的测试与基准共用
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：替换函数定义在 CountingAllocator.cpp，只链接进需要计数的程序；未指定线程时不计数
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <thread>
+
+namespace CountingAllocator
+{
+    /// <summary>只统计 thread 上的分配；传入默认构造的编号停止统计。</summary>
+    void CountThread(std::thread::id thread) noexcept;
+
+    /// <summary>程序启动以来统计到的分配次数。</summary>
+    long Allocations() noexcept;
+}
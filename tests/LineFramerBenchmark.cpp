@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------
+名称：行分帧基准
+说明：把约 1 MB 的典型模块输出按不同块长反复交给行分帧器，报告吞吐与每行耗时
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为重复次数，默认两百
+------------------------------------------------------------------------*/
+#include "LineFramer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 200;
+
+    // 短应答、上报与列表正文混合，其中少量以 "> " 开头的正文行需要询问提示符判定。
+    std::string stream;
+    for (std::size_t i = 0; stream.size() < (1u << 20); ++i)
+    {
+        stream += "AT+CSQ\r\r\n+CSQ: 23,99\r\n\r\nOK\r\n";
+        stream += "\r\n+CMTI: \"SM\"," + std::to_string(i % 50) + "\r\n";
+        stream += "+CMGL: " + std::to_string(i) + ",\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"\r\n";
+        stream += i % 8 == 0 ? "> quoted reply\n您的验证码是 482913，5 分钟内有效。\r\n" : std::string(120, 'k') + "\r\n";
+    }
+
+    std::printf("stream: %zu bytes\n", stream.size());
+    for (const std::size_t chunkSize : {64, 4096, 65536})
+    {
+        LineFramer framer;
+        framer.SetPromptPredicate([]
+        {
+            return false;
+        });
+        std::size_t lines = 0;
+        std::size_t bytes = 0;
+        const LineFramer::FrameHandler onFrame = [&](const LineFrame& frame)
+        {
+            ++lines;
+            bytes += frame.text.size();
+        };
+        const auto started = Clock::now();
+        for (long round = 0; round < rounds; ++round)
+        {
+            for (std::size_t offset = 0; offset < stream.size(); offset += chunkSize)
+            {
+                framer.Feed(std::string_view(stream).substr(offset, chunkSize), onFrame);
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        std::printf("%6zu-byte chunks: %6.0f MB/s, %5.1f ns/line (checksum %zu %zu)\n", chunkSize,
+                    stream.size() * static_cast<double>(rounds) / seconds / 1e6, seconds / static_cast<double>(lines) * 1e9, lines, bytes);
+    }
+    return 0;
+}
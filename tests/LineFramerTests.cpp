@@ -0,0 +1,230 @@
+/*------------------------------------------------------------------------
+名称：行分帧测试
+说明：检查各种结束符及其跨块拆分、提示符识别（含列表正文中以 "> " 开头的行）、超长行与 Reset
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：随机语料使用固定种子；提示符判定接到真实的指令引擎上，与会话中的用法一致
+------------------------------------------------------------------------*/
+#include "AtCommandEngine.h"
+#include "LineFramer.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// <summary>帧的拷贝：提示符记为 "<PROMPT>"，其余为行内容。</summary>
+    using Frames = std::vector<std::string>;
+
+    constexpr std::string_view kPromptMark = "<PROMPT>";
+
+    /// <summary>按 cuts 给出的块长度依次交入，剩余部分作为最后一块。</summary>
+    Frames Split(LineFramer& framer, std::string_view stream, const std::vector<std::size_t>& cuts)
+    {
+        Frames frames;
+        const LineFramer::FrameHandler onFrame = [&frames](const LineFrame& frame)
+        {
+            frames.emplace_back(frame.kind == FrameKind::Prompt ? kPromptMark : frame.text);
+        };
+        std::size_t offset = 0;
+        for (const auto cut : cuts)
+        {
+            const auto length = std::min(cut, stream.size() - offset);
+            framer.Feed(stream.substr(offset, length), onFrame);
+            offset += length;
+        }
+        framer.Feed(stream.substr(offset), onFrame);
+        return frames;
+    }
+
+    /// <summary>对每一个拆分位置与逐字节交入分别检查结果，每次使用新的分帧器。</summary>
+    template <typename MakeFramer>
+    void CheckEverySplit(std::string_view stream, const Frames& expected, MakeFramer makeFramer)
+    {
+        for (std::size_t cut = 0; cut <= stream.size(); ++cut)
+        {
+            auto framer = makeFramer();
+            CHECK(Split(framer, stream, {cut}) == expected);
+        }
+        auto framer = makeFramer();
+        CHECK(Split(framer, stream, std::vector<std::size_t>(stream.size(), 1)) == expected);
+    }
+
+    LineFramer PlainFramer()
+    {
+        return LineFramer();
+    }
+
+    /// <summary>CR、LF、CRLF 混用，CR 与 LF 落在不同块时不产生多余的行。</summary>
+    void TestLineEndings()
+    {
+        CheckEverySplit("one\r\ntwo\rthree\nfour\r\n\r\nfive\r\r\nsix\n\n", {"one", "two", "three", "four", "five", "six"}, PlainFramer);
+
+        // CR 在块尾、LF 在下一块开头；之后紧跟的行与提示符都不受影响。
+        LineFramer framer;
+        CHECK(Split(framer, "OK\r", {}) == Frames{"OK"});
+        CHECK(Split(framer, "\n> ", {}) == Frames{std::string(kPromptMark)});
+        CHECK(Split(framer, "x\r", {}) == Frames{"x"});
+        CHECK(Split(framer, "\ny\r\n", {}) == Frames{"y"});
+        CHECK(framer.PendingBytes() == 0);
+    }
+
+    /// <summary>与逐字节参照实现比较 1 MB 随机语料，块长随机。</summary>
+    void TestRandomCorpus()
+    {
+        std::mt19937 random(10);
+        const std::string alphabet = "ABCDEFGHIJ,:\"+0123456789 >\r\n\r\n";
+        std::string stream;
+        while (stream.size() < (1u << 20))
+        {
+            stream.push_back(alphabet[random() % alphabet.size()]);
+        }
+        Frames expected;
+        std::string line;
+        for (const char c : stream)
+        {
+            if (c == '\r' || c == '\n')
+            {
+                if (!line.empty())
+                {
+                    expected.push_back(line);
+                }
+                line.clear();
+                continue;
+            }
+            line.push_back(c);
+        }
+        std::vector<std::size_t> cuts;
+        for (std::size_t total = 0; total < stream.size(); total += cuts.back())
+        {
+            cuts.push_back(1 + random() % 300);
+        }
+        LineFramer framer;
+        framer.SetPromptPredicate([]
+        {
+            return false;
+        });
+        CHECK(Split(framer, stream, cuts) == expected);
+        CHECK(framer.PendingBytes() == line.size());
+    }
+
+    /// <summary>提示符只在行首识别；未设置判定时保持总是识别。</summary>
+    void TestPromptPosition()
+    {
+        CheckEverySplit("\r\n> ", {std::string(kPromptMark)}, PlainFramer);
+        CheckEverySplit("a> b\r\n>x\r\n", {"a> b", ">x"}, PlainFramer);
+        CheckEverySplit("AT+CMGS=\"+8613800000000\"\r\r\n> ", {"AT+CMGS=\"+8613800000000\"", std::string(kPromptMark)}, PlainFramer);
+    }
+
+    /// <summary>
+    /// 判定接到指令引擎：列表指令在途时正文中的 "> " 行原样成行；
+    /// 短信发送指令在途时提示符照常识别并写出正文，正文写出后再出现的 "> " 不再是提示符。
+    /// </summary>
+    void TestPromptOnlyForPayloadCommand()
+    {
+        std::vector<std::string> written;
+        AtCommandEngine engine([&written](std::string data, std::function<void(bool)> onWritten)
+        {
+            written.push_back(std::move(data));
+            onWritten(true);
+            return true;
+        });
+        const auto makeFramer = [&engine]
+        {
+            LineFramer framer;
+            framer.SetPromptPredicate([&engine]
+            {
+                return engine.AwaitingPrompt();
+            });
+            return framer;
+        };
+
+        AtCommandRequest listing;
+        listing.command = "AT+CMGL=\"ALL\"";
+        auto listed = engine.Submit(std::move(listing));
+        CHECK(!engine.AwaitingPrompt());
+        const std::string body = "+CMGL: 1,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"\r\n"
+                                 "> quoted reply\n> \n>> nested\r\n";
+        CheckEverySplit(body, {"+CMGL: 1,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"", "> quoted reply", "> ", ">> nested"},
+                        makeFramer);
+        engine.OnLine("OK");
+        CHECK(listed.IsReady() && listed.Wait().code == AtResultCode::Ok);
+
+        AtCommandRequest send;
+        send.command = "AT+CMGS=\"+8613800000000\"";
+        send.payload = "hello\x1A";
+        auto sent = engine.Submit(std::move(send));
+        CHECK(engine.AwaitingPrompt());
+        CheckEverySplit("\r\n> ", {std::string(kPromptMark)}, makeFramer);
+
+        auto framer = makeFramer();
+        const LineFramer::FrameHandler onFrame = [&engine](const LineFrame& frame)
+        {
+            if (frame.kind == FrameKind::Prompt)
+            {
+                engine.OnPrompt();
+                return;
+            }
+            engine.OnLine(frame.text);
+        };
+        framer.Feed("AT+CMGS=\"+8613800000000\"\r\r\n>", onFrame);
+        framer.Feed(" ", onFrame);
+        CHECK(!engine.AwaitingPrompt());
+        CHECK(!written.empty() && written.back() == "hello\x1A");
+        framer.Feed("\r\n> not a prompt\r\n+CMGS: 7\r\n\r\nOK\r\n", onFrame);
+        CHECK(sent.IsReady() && sent.Wait().code == AtResultCode::Ok);
+        CHECK(sent.Wait().lines == std::vector<std::string>({"> not a prompt", "+CMGS: 7"}));
+    }
+
+    /// <summary>判定只在行首遇到 '>' 时询问，普通行不增加开销。</summary>
+    void TestPredicateCalls()
+    {
+        int calls = 0;
+        LineFramer framer;
+        framer.SetPromptPredicate([&calls]
+        {
+            ++calls;
+            return false;
+        });
+        std::string stream;
+        for (int i = 0; i < 1000; ++i)
+        {
+            stream += "+CSQ: 23,99\r\nOK\r\n";
+        }
+        Split(framer, stream, {7, 300, 5000});
+        CHECK(calls == 0);
+        Split(framer, "> a\r\nb > c\r\n", {});
+        CHECK(calls == 1);
+    }
+
+    void TestLongLineAndReset()
+    {
+        LineFramer framer(32);
+        CHECK(Split(framer, std::string(20, 'a'), {}).empty());
+        CHECK(framer.PendingBytes() == 20);
+        CHECK(Split(framer, std::string(20, 'b'), {}) == Frames{std::string(20, 'a') + std::string(20, 'b')});
+        CHECK(framer.PendingBytes() == 0);
+
+        // Reset 丢弃残行与待跳过的 LF。
+        CHECK(Split(framer, "partial\r", {}) == Frames{"partial"});
+        CHECK(Split(framer, "half", {}).empty());
+        framer.Reset();
+        CHECK(framer.PendingBytes() == 0);
+        CHECK(Split(framer, "> ", {}) == Frames{std::string(kPromptMark)});
+    }
+}
+
+int main()
+{
+    TestLineEndings();
+    TestRandomCorpus();
+    TestPromptPosition();
+    TestPromptOnlyForPayloadCommand();
+    TestPredicateCalls();
+    TestLongLineAndReset();
+    return TestSupport::Finish("LineFramerTests");
+}
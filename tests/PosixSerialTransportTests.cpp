@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------
+名称：POSIX 串口传输测试
+说明：以伪终端对检查 PosixSerialTransport 的打开、收发、取消、关闭与挂断处理
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：关闭主端相当于拔出 USB 转串口，从端读写随即报告 Disconnected
+------------------------------------------------------------------------*/
+#include "PosixSerialTransport.h"
+#include "PtyPair.h"
+#include "SerialPort.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+namespace
+{
+    /// <summary>等待并读取已到达的数据，直到读满 size 字节或出错。</summary>
+    TransportStatus ReadUntil(SerialTransport& transport, std::string& out, std::size_t size)
+    {
+        char buffer[256];
+        while (out.size() < size)
+        {
+            auto status = transport.WaitReadable();
+            if (status != TransportStatus::Ok)
+            {
+                return status;
+            }
+            std::size_t count = 0;
+            status = transport.Read(buffer, sizeof(buffer), count);
+            if (status != TransportStatus::Ok)
+            {
+                return status;
+            }
+            out.append(buffer, count);
+        }
+        return TransportStatus::Ok;
+    }
+
+    void TestOpenReadWrite()
+    {
+        PtyPair pty;
+        CHECK(pty.IsOpen());
+        PosixSerialTransport transport;
+        CHECK(!transport.IsOpen());
+        CHECK(transport.Open(pty.SlavePath(), SerialSettings{}));
+        CHECK(transport.IsOpen());
+
+        // 原始模式：CR 不转换、不回显。
+        const std::string reply = "\r\nOK\r\n";
+        CHECK(pty.WriteAll(reply.data(), reply.size()));
+        std::string received;
+        CHECK(ReadUntil(transport, received, reply.size()) == TransportStatus::Ok);
+        CHECK(received == reply);
+
+        const std::string command = "AT+CSQ\r";
+        std::size_t written = 0;
+        CHECK(transport.Write(command.data(), command.size(), written) == TransportStatus::Ok);
+        CHECK(written == command.size());
+        std::string echoed;
+        CHECK(pty.ReadExactly(echoed, command.size()));
+        CHECK(echoed == command);
+
+        // 没有数据时非阻塞读返回 Ok 与 0 字节，不被当作挂断。
+        char buffer[16];
+        std::size_t count = 1;
+        CHECK(transport.Read(buffer, sizeof(buffer), count) == TransportStatus::Ok && count == 0);
+
+        transport.Close();
+        CHECK(!transport.IsOpen());
+        CHECK(transport.Read(buffer, sizeof(buffer), count) == TransportStatus::Error);
+    }
+
+    void TestOpenFailures()
+    {
+        PosixSerialTransport transport;
+        CHECK(!transport.Open(L"/dev/athelper-no-such-port", SerialSettings{}));
+        CHECK(!transport.IsOpen());
+
+        // 不带 /dev/ 前缀的端口名按 /dev 下的相对路径解析。
+        PtyPair pty;
+        const auto& path = pty.SlavePath();
+        CHECK(path.rfind(L"/dev/", 0) == 0);
+        CHECK(transport.Open(path.substr(5), SerialSettings{}));
+        transport.Close();
+    }
+
+    void TestCancel()
+    {
+        PtyPair pty;
+        PosixSerialTransport transport;
+        CHECK(transport.Open(pty.SlavePath(), SerialSettings{}));
+        auto waiting = std::async(std::launch::async, [&transport]()
+        {
+            return transport.WaitReadable();
+        });
+        CHECK(waiting.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+        transport.Cancel();
+        CHECK(waiting.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+        if (waiting.valid())
+        {
+            CHECK(waiting.get() == TransportStatus::Cancelled);
+        }
+        transport.Close();
+
+        // 重新打开后取消状态已清除，等待恢复正常。
+        CHECK(transport.Open(pty.SlavePath(), SerialSettings{}));
+        CHECK(pty.WriteAll("x", 1));
+        std::string received;
+        CHECK(ReadUntil(transport, received, 1) == TransportStatus::Ok);
+        transport.Close();
+    }
+
+    void TestHangup()
+    {
+        PtyPair pty;
+        PosixSerialTransport transport;
+        CHECK(transport.Open(pty.SlavePath(), SerialSettings{}));
+        auto waiting = std::async(std::launch::async, [&transport]()
+        {
+            std::string received;
+            return ReadUntil(transport, received, 1);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pty.CloseMaster();
+        CHECK(waiting.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+        if (waiting.valid())
+        {
+            CHECK(waiting.get() == TransportStatus::Disconnected);
+        }
+        std::size_t written = 0;
+        CHECK(transport.Write("AT\r", 3, written) != TransportStatus::Ok || written == 0);
+        transport.Close();
+    }
+
+    /// <summary>经 SerialPort 的读取线程：挂断只报告一次链路丢失，端口随即视为关闭。</summary>
+    void TestLinkLost()
+    {
+        PtyPair pty;
+        SerialPort port(std::make_unique<PosixSerialTransport>());
+        std::atomic<int> lost{0};
+        port.SetLinkLostHandler([&lost]()
+        {
+            ++lost;
+        });
+        CHECK(port.Open(pty.SlavePath(), 115200));
+        CHECK(port.IsOpen());
+        pty.CloseMaster();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+        while (lost.load() == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CHECK(lost.load() == 1);
+        CHECK(!port.IsOpen());
+        CHECK(!port.Write("AT\r"));
+        port.Close();
+    }
+}
+
+int main()
+{
+    TestOpenReadWrite();
+    TestOpenFailures();
+    TestCancel();
+    TestHangup();
+    TestLinkLost();
+    return TestSupport::Finish("PosixSerialTransportTests");
+}
@@ -0,0 +1,149 @@
+/*------------------------------------------------------------------------
+名称：伪终端对
+说明：以 posix_openpt 打开一对伪终端，主端在测试中扮演模块，从端交给被测的串口
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：仅用于 POSIX 平台的测试；主端读写带超时，超时视为失败
+------------------------------------------------------------------------*/
+#pragma once
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+/// <summary>一对伪终端；析构时关闭仍打开的主端。</summary>
+class PtyPair
+{
+public:
+    PtyPair()
+        : _master(::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC))
+    {
+        char name[128] = {};
+        if (_master < 0 || ::grantpt(_master) != 0 || ::unlockpt(_master) != 0 || ::ptsname_r(_master, name, sizeof(name)) != 0)
+        {
+            CloseMaster();
+            return;
+        }
+        _slavePath.assign(name, name + std::char_traits<char>::length(name));
+    }
+
+    ~PtyPair()
+    {
+        CloseMaster();
+    }
+
+    PtyPair(const PtyPair&) = delete;
+    PtyPair& operator=(const PtyPair&) = delete;
+
+    bool IsOpen() const noexcept
+    {
+        return _master >= 0;
+    }
+
+    int Master() const noexcept
+    {
+        return _master;
+    }
+
+    /// <summary>从端的完整路径，传给串口的 Open。</summary>
+    const std::wstring& SlavePath() const noexcept
+    {
+        return _slavePath;
+    }
+
+    /// <summary>关闭主端，从端随即挂断，相当于拔出 USB 转串口。</summary>
+    void CloseMaster() noexcept
+    {
+        if (_master >= 0)
+        {
+            ::close(_master);
+            _master = -1;
+        }
+    }
+
+    /// <summary>从主端写出全部数据，timeout 内写不完返回 false。</summary>
+    bool WriteAll(const char* data, std::size_t size, std::chrono::milliseconds timeout = std::chrono::seconds(10)) const
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::size_t offset = 0;
+        while (offset < size)
+        {
+            if (!Poll(POLLOUT, deadline))
+            {
+                return false;
+            }
+            const auto written = ::write(_master, data + offset, size - offset);
+            if (written > 0)
+            {
+                offset += static_cast<std::size_t>(written);
+            }
+            else if (written < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// <summary>从主端读取恰好 size 字节追加到 out，timeout 内读不满返回 false。</summary>
+    bool ReadExactly(std::string& out, std::size_t size, std::chrono::milliseconds timeout = std::chrono::seconds(10)) const
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        char buffer[4096];
+        std::size_t remaining = size;
+        while (remaining != 0)
+        {
+            if (!Poll(POLLIN, deadline))
+            {
+                return false;
+            }
+            const auto count = ::read(_master, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+            if (count > 0)
+            {
+                out.append(buffer, static_cast<std::size_t>(count));
+                remaining -= static_cast<std::size_t>(count);
+            }
+            else if (count == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    bool Poll(short events, std::chrono::steady_clock::time_point deadline) const
+    {
+        while (true)
+        {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+            {
+                return false;
+            }
+            pollfd watch{_master, events, 0};
+            const int ready = ::poll(&watch, 1, static_cast<int>(left.count()));
+            if (ready > 0)
+            {
+                return (watch.revents & events) != 0;
+            }
+            if (ready < 0 && errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+private:
+    int _master;
+    std::wstring _slavePath;
+};
+
+#endif
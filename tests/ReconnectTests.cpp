@@ -0,0 +1,144 @@
+/*------------------------------------------------------------------------
+名称：自动重连测试
+说明：在虚拟模块上模拟拔出与重新插入，检查恢复、未启用重连与放弃重连三种结果
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：未启用或放弃后重连线程须回到空闲等待，日志不再增长
+------------------------------------------------------------------------*/
+#include "AtSession.h"
+#include "TestSupport.h"
+#include "VirtualModemTransport.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /// <summary>收集会话日志，按子串计数。</summary>
+    class LogRecorder
+    {
+    public:
+        explicit LogRecorder(AtSession& session)
+        {
+            session.SetLogCallback([this](const std::wstring& line)
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _lines.push_back(line);
+            });
+        }
+
+        int Count(const std::wstring& text) const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            int count = 0;
+            for (const auto& line : _lines)
+            {
+                count += line.find(text) != std::wstring::npos ? 1 : 0;
+            }
+            return count;
+        }
+
+        /// <summary>等待含 text 的日志出现，最多 timeout。</summary>
+        bool WaitFor(const std::wstring& text, std::chrono::milliseconds timeout) const
+        {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (Count(text) == 0)
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            return true;
+        }
+
+    private:
+        mutable std::mutex _mutex;
+        std::vector<std::wstring> _lines;
+    };
+
+    void TestRecovers()
+    {
+        const std::wstring portName = L"SIM9501";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        LogRecorder log(session);
+        ReconnectPolicy policy;
+        policy.initialDelay = std::chrono::milliseconds(20);
+        policy.maxDelay = std::chrono::milliseconds(50);
+        session.SetReconnectPolicy(policy);
+        CHECK(session.Connect(portName, 115200));
+        session.SendCommand(L"AT").Wait();
+
+        modem->SetPresent(false);
+        CHECK(log.WaitFor(L"开始自动重连", std::chrono::seconds(2)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        modem->SetPresent(true);
+        CHECK(log.WaitFor(L"串口已恢复", std::chrono::seconds(3)));
+        CHECK(session.IsConnected());
+        CHECK(session.SendCommand(L"AT").Wait().Succeeded());
+        session.Disconnect();
+    }
+
+    void TestDisabled()
+    {
+        const std::wstring portName = L"SIM9502";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        LogRecorder log(session);
+        ReconnectPolicy policy;
+        policy.enabled = false;
+        session.SetReconnectPolicy(policy);
+        CHECK(session.Connect(portName, 115200));
+        session.SendCommand(L"AT").Wait();
+
+        modem->SetPresent(false);
+        CHECK(log.WaitFor(L"串口链路丢失", std::chrono::seconds(2)));
+        // 丢失只报告一次，之后重连线程空闲，不再反复进入。
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CHECK(log.Count(L"串口链路丢失") == 1);
+        CHECK(!session.IsConnected());
+        modem->SetPresent(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CHECK(!session.IsConnected());
+        session.Disconnect();
+    }
+
+    void TestGivesUp()
+    {
+        const std::wstring portName = L"SIM9503";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        LogRecorder log(session);
+        ReconnectPolicy policy;
+        policy.initialDelay = std::chrono::milliseconds(20);
+        policy.maxDelay = std::chrono::milliseconds(50);
+        policy.giveUpAfter = std::chrono::milliseconds(200);
+        session.SetReconnectPolicy(policy);
+        CHECK(session.Connect(portName, 115200));
+        session.SendCommand(L"AT").Wait();
+
+        modem->SetPresent(false);
+        CHECK(log.WaitFor(L"已放弃", std::chrono::seconds(2)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        CHECK(log.Count(L"已放弃") == 1);
+        CHECK(log.Count(L"开始自动重连") == 1);
+        CHECK(!session.IsConnected());
+        modem->SetPresent(true);
+        session.Disconnect();
+    }
+}
+
+int main()
+{
+    TestRecovers();
+    TestDisabled();
+    TestGivesUp();
+    return TestSupport::Finish("ReconnectTests");
+}
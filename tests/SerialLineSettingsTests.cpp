@@ -0,0 +1,144 @@
+/*------------------------------------------------------------------------
+名称：线路参数测试
+说明：以配置中最高的波特率与 RTS/CTS 流控打开伪终端，双向传送数兆字节，检查逐字节一致且无丢失
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：伪终端不按波特率限速也不执行硬件流控，这里检查的是参数被接受、生效以及整条接收路径不丢字节
+------------------------------------------------------------------------*/
+#include "PtyPair.h"
+#include "SerialPort.h"
+#include "TestSupport.h"
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+    /// <summary>界面中可选的最高波特率。</summary>
+    constexpr unsigned long kTopBaudRate = 4000000;
+
+    /// <summary>覆盖全部 256 个字节值的伪随机数据，含 CR、LF 与 XON/XOFF。</summary>
+    std::string MakePattern(std::size_t size, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        std::string data(size, '\0');
+        for (auto& byte : data)
+        {
+            byte = static_cast<char>(random() & 0xFF);
+        }
+        return data;
+    }
+
+    void TestTopRateWithFlowControl()
+    {
+        PtyPair pty;
+        CHECK(pty.IsOpen());
+        if (!pty.IsOpen())
+        {
+            return;
+        }
+        SerialSettings settings;
+        settings.baudRate = kTopBaudRate;
+        settings.flowControl = FlowControl::RtsCts;
+        settings.readChunkSize = 4096;
+        settings.overrunPolicy = OverrunPolicy::Block;
+
+        SerialPort port;
+        std::mutex mutex;
+        std::string received;
+        port.SetDataHandler([&mutex, &received](std::string_view chunk)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            received.append(chunk);
+        });
+        CHECK(port.Open(pty.SlavePath(), settings));
+
+        // 伪终端两端共用一份 termios，从主端即可读回串口设置的参数。
+        struct termios2 options{};
+        CHECK(::ioctl(pty.Master(), TCGETS2, &options) == 0);
+        CHECK(options.c_ospeed == kTopBaudRate && options.c_ispeed == kTopBaudRate);
+        CHECK((options.c_cflag & CRTSCTS) != 0);
+        CHECK((options.c_cflag & CSIZE) == CS8 && (options.c_cflag & (PARENB | CSTOPB)) == 0);
+        CHECK((options.c_lflag & ICANON) == 0 && (options.c_iflag & (IXON | ICRNL)) == 0);
+
+        // 模块到主机：8 MB。
+        const auto inbound = MakePattern(8 * 1024 * 1024, 6);
+        const auto started = std::chrono::steady_clock::now();
+        std::thread writer([&pty, &inbound]()
+        {
+            CHECK(pty.WriteAll(inbound.data(), inbound.size(), std::chrono::seconds(30)));
+        });
+        const auto deadline = started + std::chrono::seconds(30);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (received.size() >= inbound.size())
+                {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        writer.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            CHECK(received.size() == inbound.size());
+            CHECK(received == inbound);
+        }
+        CHECK(port.GetStatistics().droppedBytes == 0);
+        std::printf("inbound: %.1f MB/s\n", inbound.size() / seconds / 1e6);
+
+        // 主机到模块：1 MB。
+        const auto outbound = MakePattern(1024 * 1024, 7);
+        std::string echoed;
+        std::thread reader([&pty, &outbound, &echoed]()
+        {
+            CHECK(pty.ReadExactly(echoed, outbound.size(), std::chrono::seconds(30)));
+        });
+        CHECK(port.Write(outbound));
+        reader.join();
+        CHECK(echoed == outbound);
+        port.Close();
+    }
+
+    void TestLineFormats()
+    {
+        PtyPair pty;
+        CHECK(pty.IsOpen());
+        if (!pty.IsOpen())
+        {
+            return;
+        }
+        SerialSettings settings;
+        settings.baudRate = 9600;
+        settings.dataBits = 7;
+        settings.parity = SerialParity::Even;
+        settings.stopBits = SerialStopBits::Two;
+        settings.flowControl = FlowControl::XonXoff;
+        SerialPort port;
+        CHECK(port.Open(pty.SlavePath(), settings));
+        struct termios2 options{};
+        CHECK(::ioctl(pty.Master(), TCGETS2, &options) == 0);
+        CHECK(options.c_ospeed == 9600);
+        // 伪终端驱动总是改回 8 位无校验，数据位与校验位只能在真实串口上检查。
+        CHECK((options.c_cflag & CSTOPB) != 0 && (options.c_cflag & CRTSCTS) == 0);
+        CHECK((options.c_iflag & (IXON | IXOFF)) == (IXON | IXOFF));
+        port.Close();
+    }
+}
+
+int main()
+{
+    TestTopRateWithFlowControl();
+    TestLineFormats();
+    return TestSupport::Finish("SerialLineSettingsTests");
+}
@@ -0,0 +1,158 @@
+/*------------------------------------------------------------------------
+名称：串口反应器基准
+说明：64 个伪终端端口接入同一反应器，分别测量空闲一秒的进程 CPU 占用，以及全部端口同时收数据时的 CPU 与吞吐
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：仅 POSIX 平台；参数依次为端口数（默认 64）、事件线程数（默认 2）、每端口字节数（默认 200000）
+------------------------------------------------------------------------*/
+#include "PtyPair.h"
+#include "SerialPort.h"
+#include "SerialReactor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <termios.h>
+
+namespace
+{
+    /// <summary>进程累计的用户态与内核态 CPU 时间，单位毫秒。</summary>
+    double ProcessCpuMilliseconds()
+    {
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+    }
+
+    /// <summary>主端切到原始模式，避免行规程改写或回显测试数据。</summary>
+    void MakeRaw(int fd)
+    {
+        termios attributes{};
+        ::tcgetattr(fd, &attributes);
+        ::cfmakeraw(&attributes);
+        ::tcsetattr(fd, TCSANOW, &attributes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    const std::size_t portCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const std::size_t threadCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2;
+    const std::size_t bytesPerPort = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200000;
+
+    SerialReactor reactor;
+    if (!reactor.Start(threadCount))
+    {
+        std::printf("reactor start failed\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<PtyPair>> ptys;
+    std::vector<std::unique_ptr<SerialPort>> ports;
+    std::vector<std::atomic<std::size_t>> received(portCount);
+    for (std::size_t i = 0; i < portCount; ++i)
+    {
+        auto pty = std::make_unique<PtyPair>();
+        if (!pty->IsOpen())
+        {
+            std::printf("pty %zu open failed\n", i);
+            return 1;
+        }
+        MakeRaw(pty->Master());
+        auto port = std::make_unique<SerialPort>();
+        port->SetReactor(&reactor);
+        auto& counter = received[i];
+        port->SetDataHandler([&counter](std::string_view chunk)
+        {
+            counter += chunk.size();
+        });
+        // 阻塞策略不丢字节，收满即说明全部数据已经过接收路径。
+        SerialSettings settings;
+        settings.overrunPolicy = OverrunPolicy::Block;
+        if (!port->Open(pty->SlavePath(), settings))
+        {
+            std::printf("port %zu open failed\n", i);
+            return 1;
+        }
+        ptys.push_back(std::move(pty));
+        ports.push_back(std::move(port));
+    }
+
+    // 空闲：没有数据时事件线程应全部睡在 epoll 上，不轮询。
+    double cpuBefore = ProcessCpuMilliseconds();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const double idleCpu = ProcessCpuMilliseconds() - cpuBefore;
+    std::printf("idle: %zu ports, %zu threads, %.1f ms CPU over 1 s\n", portCount, threadCount, idleCpu);
+
+    // 繁忙：每个端口一个写线程从主端灌数据，同时各端口排一条异步写。
+    const std::string block(1000, 'x');
+    std::atomic<std::size_t> writesDone{0};
+    cpuBefore = ProcessCpuMilliseconds();
+    const auto started = Clock::now();
+    std::vector<std::thread> feeders;
+    for (std::size_t i = 0; i < portCount; ++i)
+    {
+        feeders.emplace_back([&, i]
+        {
+            for (std::size_t sent = 0; sent < bytesPerPort; sent += block.size())
+            {
+                if (!ptys[i]->WriteAll(block.data(), block.size()))
+                {
+                    std::printf("feed %zu stalled\n", i);
+                    return;
+                }
+            }
+        });
+        ports[i]->WriteAsync("AT\r", [&writesDone](bool success, std::size_t)
+        {
+            if (success)
+            {
+                ++writesDone;
+            }
+        });
+    }
+    for (auto& feeder : feeders)
+    {
+        feeder.join();
+    }
+    const std::size_t expected = (bytesPerPort + block.size() - 1) / block.size() * block.size();
+    const auto deadline = Clock::now() + std::chrono::seconds(30);
+    std::size_t total = 0;
+    while (Clock::now() < deadline)
+    {
+        total = 0;
+        for (const auto& counter : received)
+        {
+            total += counter.load();
+        }
+        if (total >= expected * portCount)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    const double busyCpu = ProcessCpuMilliseconds() - cpuBefore;
+
+    std::printf("busy: %.1f MB in %.3f s (%.1f MB/s), %.1f ms CPU (%.0f%% of one core), async writes %zu/%zu\n",
+                total / 1e6, seconds, total / 1e6 / seconds, busyCpu, busyCpu / (seconds * 10), writesDone.load(), portCount);
+    if (total < expected * portCount)
+    {
+        std::printf("incomplete: expected %zu bytes\n", expected * portCount);
+    }
+
+    for (auto& port : ports)
+    {
+        port->Close();
+    }
+    reactor.Stop();
+    return total < expected * portCount ? 1 : 0;
+}
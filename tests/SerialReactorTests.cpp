@@ -0,0 +1,179 @@
+/*------------------------------------------------------------------------
+名称：串口反应器测试
+说明：在读写任务仍在投递时反复关闭端口，确认事件线程一个不少、写请求恰好完成一次、Stop 能正常返回
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：使用虚拟模块端口，Linux 走 epoll、Windows 走完成端口；
+      关闭时清零的键若被当作任务投递，在完成端口上等同于停止信号，会悄悄少掉一个事件线程
+------------------------------------------------------------------------*/
+#include "SerialPort.h"
+#include "SerialReactor.h"
+#include "TestSupport.h"
+#include "VirtualModemTransport.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace
+{
+    constexpr std::size_t kWorkers = 2;
+
+    /// <summary>等待 condition 成立，最多 timeout。</summary>
+    template <typename Condition>
+    bool WaitUntil(Condition condition, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::unique_ptr<SerialPort> OpenVirtualPort(SerialReactor& reactor, const std::wstring& portName)
+    {
+        auto port = std::make_unique<SerialPort>(std::make_unique<VirtualModemTransport>());
+        port->SetReactor(&reactor);
+        CHECK(port->Open(portName, 115200));
+        return port;
+    }
+
+    /// <summary>
+    /// 两个端口的回调互相等待：A 的回调阻塞到 B 的回调执行为止。
+    /// 只有全部事件线程都还在时 B 才能在 A 阻塞期间被调度，否则 A 超时返回 false。
+    /// </summary>
+    bool AllWorkersAlive(SerialReactor& reactor, const std::wstring& nameA, const std::wstring& nameB)
+    {
+        auto modemA = VirtualModemTransport::SharedModem(nameA);
+        auto modemB = VirtualModemTransport::SharedModem(nameB);
+        std::atomic<bool> enteredA{false};
+        std::atomic<bool> reachedB{false};
+        std::atomic<bool> metB{false};
+        std::atomic<bool> leftA{false};
+
+        auto portA = OpenVirtualPort(reactor, nameA);
+        auto portB = OpenVirtualPort(reactor, nameB);
+        portA->SetDataHandler([&](std::string_view)
+        {
+            if (enteredA.exchange(true))
+            {
+                return;
+            }
+            metB = WaitUntil([&] { return reachedB.load(); }, std::chrono::seconds(2));
+            leftA = true;
+        });
+        portB->SetDataHandler([&](std::string_view)
+        {
+            reachedB = true;
+        });
+
+        modemA->EmitUrc("RING");
+        CHECK(WaitUntil([&] { return enteredA.load(); }));
+        modemB->EmitUrc("RING");
+        // A 的回调至多阻塞 2 秒，返回后才能安全关闭。
+        CHECK(WaitUntil([&] { return leftA.load(); }));
+        portA->Close();
+        portB->Close();
+        return metB.load();
+    }
+
+    /// <summary>收发进行中立即关闭，Close 返回时接受的写请求都已完成且只完成一次。</summary>
+    void TestCloseWhileTasksInFlight()
+    {
+        SerialReactor reactor;
+        CHECK(reactor.Start(kWorkers));
+        CHECK(AllWorkersAlive(reactor, L"SIM9911", L"SIM9912"));
+
+        auto modem = VirtualModemTransport::SharedModem(L"SIM9910");
+        long accepted = 0;
+        std::atomic<long> completed{0};
+        std::atomic<long> received{0};
+        for (int round = 0; round < 300; ++round)
+        {
+            auto port = OpenVirtualPort(reactor, L"SIM9910");
+            port->SetDataHandler([&received](std::string_view chunk)
+            {
+                received += static_cast<long>(chunk.size());
+            });
+            for (int i = 0; i < 4; ++i)
+            {
+                modem->EmitUrc("+CREG: 0,1");
+                if (port->WriteAsync("AT\r", [&completed](bool, std::size_t) { ++completed; }))
+                {
+                    ++accepted;
+                }
+            }
+            // 有时先让部分任务跑起来，有时直接关闭，覆盖投递与关闭的不同先后。
+            if (round % 3 == 0)
+            {
+                std::this_thread::yield();
+            }
+            port->Close();
+            CHECK(!port->IsOpen());
+            CHECK(completed.load() == accepted);
+            // 关闭后再提交写请求应被拒绝，也不会向反应器投递任务。
+            CHECK(!port->WriteAsync("AT\r", [&completed](bool, std::size_t) { ++completed; }));
+        }
+        CHECK(completed.load() == accepted);
+        CHECK(received.load() > 0);
+
+        // 反复关闭后两个事件线程仍然都在。
+        CHECK(AllWorkersAlive(reactor, L"SIM9911", L"SIM9912"));
+        reactor.Stop();
+        CHECK(!reactor.IsRunning());
+    }
+
+    /// <summary>关闭与收数据在不同线程上并发进行，反应器持续可用，Stop 正常返回。</summary>
+    void TestConcurrentCloseAndTraffic()
+    {
+        SerialReactor reactor;
+        CHECK(reactor.Start(kWorkers));
+        auto modem = VirtualModemTransport::SharedModem(L"SIM9913");
+        std::atomic<bool> stop{false};
+        std::thread talker([&]
+        {
+            while (!stop.load())
+            {
+                modem->EmitUrc("+CSQ: 20,99");
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+
+        for (int round = 0; round < 200; ++round)
+        {
+            auto port = OpenVirtualPort(reactor, L"SIM9913");
+            std::atomic<long> chunks{0};
+            port->SetDataHandler([&chunks](std::string_view)
+            {
+                ++chunks;
+            });
+            port->WriteAsync("AT+CSQ\r", nullptr);
+            if (round % 2 == 0)
+            {
+                WaitUntil([&] { return chunks.load() > 0; }, std::chrono::milliseconds(50));
+            }
+            port->Close();
+        }
+        stop = true;
+        talker.join();
+
+        CHECK(AllWorkersAlive(reactor, L"SIM9914", L"SIM9915"));
+        reactor.Stop();
+        CHECK(!reactor.IsRunning());
+    }
+}
+
+int main()
+{
+    TestCloseWhileTasksInFlight();
+    TestConcurrentCloseAndTraffic();
+    return TestSupport::Finish("SerialReactorTests");
+}
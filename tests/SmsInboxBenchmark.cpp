@@ -0,0 +1,171 @@
+/*------------------------------------------------------------------------
+名称：短信收件箱基准
+说明：向收件箱写入数百万条短信，报告写入速率、最慢一次写入、磁盘占用、重新打开耗时与各类查询的 p50/p99
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：参数为条数（默认三百万）与存放目录（默认系统临时目录下的子目录，结束时删除）
+------------------------------------------------------------------------*/
+#include "SmsInboxStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::int64_t kBaseTime = 1792000000;
+    constexpr std::size_t kSenders = 20000;
+
+    std::string SenderOf(std::size_t index)
+    {
+        return "+86138" + std::to_string(10000000 + index % kSenders * 37);
+    }
+
+    double Microseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    /// <summary>执行 rounds 次查询，报告每次耗时的 p50 与 p99。</summary>
+    template <typename MakeQuery>
+    void Measure(const SmsInboxStore& store, const char* name, int rounds, MakeQuery makeQuery)
+    {
+        std::mt19937 random(7);
+        std::vector<double> samples;
+        std::size_t found = 0;
+        for (int i = 0; i < rounds; ++i)
+        {
+            std::string sender;
+            const auto query = makeQuery(random, sender);
+            const auto started = Clock::now();
+            found += store.Find(query, [](const SmsInboxEntry&)
+            {
+                return true;
+            });
+            samples.push_back(Microseconds(Clock::now() - started));
+        }
+        std::sort(samples.begin(), samples.end());
+        std::printf("  %-28s p50 %8.1f us   p99 %8.1f us   (%.1f results/query)\n", name, samples[samples.size() / 2],
+                    samples[samples.size() * 99 / 100], static_cast<double>(found) / rounds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3000000;
+    const bool keep = argc > 2;
+    const fs::path directory = keep ? fs::path(argv[2]) : fs::temp_directory_path() / "athelper-inbox-benchmark";
+    if (!keep)
+    {
+        fs::remove_all(directory);
+    }
+    fs::create_directories(directory);
+    const auto path = directory / "inbox.log";
+
+    {
+        SmsInboxStore store;
+        if (!store.Open(path))
+        {
+            std::printf("cannot open %s\n", path.string().c_str());
+            return 1;
+        }
+        std::string body;
+        std::string sender;
+        double worst = 0.0;
+        const auto started = Clock::now();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sender = SenderOf(i * 7919);
+            body = "您的验证码是 " + std::to_string(100000 + i % 900000) + "，5 分钟内有效。订单 " + std::to_string(i) + " 已发货。";
+            SmsInboxEntry entry;
+            entry.modem = i % 4 == 0 ? "860000000000002" : "860000000000001";
+            entry.sender = sender;
+            entry.body = body;
+            entry.timestamp = kBaseTime + static_cast<std::int64_t>(i);
+            entry.storageIndex = static_cast<int>(i % 50);
+            const auto before = Clock::now();
+            store.Append(entry);
+            worst = std::max(worst, Microseconds(Clock::now() - before));
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        std::printf("append: %zu messages, %.0f k msgs/s, worst single append %.1f ms\n", count, count / seconds / 1e3, worst / 1e3);
+    }
+
+    std::uintmax_t logBytes = 0;
+    std::uintmax_t indexBytes = 0;
+    for (const auto& item : fs::directory_iterator(directory))
+    {
+        (item.path() == path ? logBytes : indexBytes) += item.file_size();
+    }
+    std::printf("disk: log %.1f MB, index segments %.1f MB\n", logBytes / 1e6, indexBytes / 1e6);
+
+    const auto opening = Clock::now();
+    SmsInboxStore store;
+    store.Open(path);
+    std::printf("reopen: %.2f ms, %zu messages\n", Microseconds(Clock::now() - opening) / 1e3, store.Size());
+
+    const auto span = static_cast<std::int64_t>(count);
+    Measure(store, "exact sender, newest 20", 2000, [](std::mt19937& random, std::string& sender)
+    {
+        sender = SenderOf(random());
+        SmsInboxQuery query;
+        query.sender = sender;
+        query.limit = 20;
+        return query;
+    });
+    Measure(store, "7-digit sender prefix", 2000, [](std::mt19937& random, std::string& sender)
+    {
+        sender = SenderOf(random()).substr(0, 10);
+        SmsInboxQuery query;
+        query.sender = sender;
+        query.senderPrefix = true;
+        query.limit = 20;
+        return query;
+    });
+    Measure(store, "1 h time window", 2000, [span](std::mt19937& random, std::string&)
+    {
+        SmsInboxQuery query;
+        query.from = kBaseTime + static_cast<std::int64_t>(random() % static_cast<std::uint64_t>(span));
+        query.to = query.from + 3600;
+        query.limit = 20;
+        return query;
+    });
+    Measure(store, "modem plus window", 2000, [span](std::mt19937& random, std::string&)
+    {
+        SmsInboxQuery query;
+        query.modem = "860000000000002";
+        query.from = kBaseTime + static_cast<std::int64_t>(random() % static_cast<std::uint64_t>(span));
+        query.to = query.from + 3600;
+        query.limit = 20;
+        return query;
+    });
+    Measure(store, "common-word text search", 2000, [](std::mt19937&, std::string&)
+    {
+        SmsInboxQuery query;
+        query.text = "已发货";
+        query.limit = 20;
+        return query;
+    });
+    Measure(store, "text that matches nothing", 5, [](std::mt19937&, std::string&)
+    {
+        SmsInboxQuery query;
+        query.text = "不存在的文字";
+        query.limit = 20;
+        return query;
+    });
+    store.Close();
+    if (!keep)
+    {
+        fs::remove_all(directory);
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*------------------------------------------------------------------------
+名称：短信收件箱存储测试
+说明：写入跨越多个索引段的短信，关闭后重新打开，按各种条件查询并与逐条比较的结果对照；另测去重与日志尾部损坏的恢复
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：文件写在系统临时目录下的独立子目录中，结束时删除
+------------------------------------------------------------------------*/
+#include "SmsInboxStore.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    /// <summary>写入的一条短信的原文，查询结果据此对照。</summary>
+    struct Reference
+    {
+        std::string modem;
+        std::string sender;
+        std::string body;
+        std::int64_t timestamp = 0;
+        int storageIndex = -1;
+    };
+
+    constexpr std::int64_t kBaseTime = 1792000000;
+
+    /// <summary>
+    /// 生成 count 条短信：100 个号码、2 个模块；时间戳互不相同但不按写入顺序递增，
+    /// 条数超过内存表容量，写入期间会生成并合并多个索引段。
+    /// </summary>
+    std::vector<Reference> MakeMessages(std::size_t count)
+    {
+        std::vector<Reference> messages(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& message = messages[i];
+            message.modem = i % 3 == 0 ? "860000000000002" : "860000000000001";
+            message.sender = "+86138" + std::to_string(10000000 + (i * 7919) % 100);
+            message.body = "第 " + std::to_string(i) + " 条 word" + std::to_string(i % 50) + (i % 11 == 0 ? " 验证码" : "");
+            // 奇偶不同，提前的时间戳不会与其他条相同。
+            message.timestamp = kBaseTime + static_cast<std::int64_t>(i) * 2 - (i % 7 == 0 ? 5 : 0);
+            message.storageIndex = static_cast<int>(i);
+        }
+        return messages;
+    }
+
+    SmsInboxEntry ToEntry(const Reference& message)
+    {
+        SmsInboxEntry entry;
+        entry.modem = message.modem;
+        entry.sender = message.sender;
+        entry.body = message.body;
+        entry.timestamp = message.timestamp;
+        entry.storageIndex = message.storageIndex;
+        return entry;
+    }
+
+    std::vector<std::string> FindBodies(const SmsInboxStore& store, const SmsInboxQuery& query)
+    {
+        std::vector<std::string> bodies;
+        store.Find(query, [&bodies](const SmsInboxEntry& entry)
+        {
+            bodies.emplace_back(entry.body);
+            return true;
+        });
+        return bodies;
+    }
+
+    /// <summary>逐条比较得到的结果：按时间戳从新到旧，取前 limit 条。</summary>
+    std::vector<std::string> BruteForce(const std::vector<Reference>& messages, const SmsInboxQuery& query)
+    {
+        std::vector<const Reference*> matched;
+        for (const auto& message : messages)
+        {
+            const std::string_view sender = message.sender;
+            if (message.timestamp < query.from || message.timestamp > query.to)
+            {
+                continue;
+            }
+            if (!query.sender.empty() && (query.senderPrefix ? sender.substr(0, query.sender.size()) != query.sender : sender != query.sender))
+            {
+                continue;
+            }
+            if ((!query.modem.empty() && message.modem != query.modem)
+                || (!query.text.empty() && message.body.find(query.text) == std::string::npos))
+            {
+                continue;
+            }
+            matched.push_back(&message);
+        }
+        std::sort(matched.begin(), matched.end(), [](const Reference* left, const Reference* right)
+        {
+            return left->timestamp > right->timestamp;
+        });
+        std::vector<std::string> bodies;
+        for (std::size_t i = 0; i < matched.size() && i < query.limit; ++i)
+        {
+            bodies.push_back(matched[i]->body);
+        }
+        return bodies;
+    }
+
+    /// <summary>随机组合各种条件，查询结果须与逐条比较完全一致。</summary>
+    void CheckQueries(const SmsInboxStore& store, const std::vector<Reference>& messages, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        const auto span = static_cast<std::int64_t>(messages.size()) * 2;
+        const std::string modems[] = {"", "860000000000001", "860000000000002"};
+        const std::string texts[] = {"", "验证码", "word7", "不存在的文字"};
+        std::size_t mismatches = 0;
+        for (int round = 0; round < 200; ++round)
+        {
+            const auto& pick = messages[random() % messages.size()];
+            std::string sender;
+            SmsInboxQuery query;
+            switch (round % 4)
+            {
+            case 0:
+                sender = pick.sender;
+                break;
+            case 1:
+                sender = pick.sender.substr(0, 10 + random() % 4);
+                query.senderPrefix = true;
+                break;
+            default:
+                break;
+            }
+            query.sender = sender;
+            query.modem = modems[random() % 3];
+            query.text = texts[random() % 4];
+            if (round % 3 != 0)
+            {
+                query.from = kBaseTime + static_cast<std::int64_t>(random() % span);
+                query.to = query.from + static_cast<std::int64_t>(random() % 7200);
+            }
+            query.limit = round % 5 == 0 ? 1000000 : 1 + random() % 40;
+            mismatches += FindBodies(store, query) != BruteForce(messages, query) ? 1 : 0;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    void TestWriteReopenQuery(const fs::path& directory)
+    {
+        const auto path = directory / "inbox.log";
+        const auto messages = MakeMessages(60000);
+        {
+            SmsInboxStore store;
+            CHECK(store.Open(path));
+            std::size_t stored = 0;
+            for (const auto& message : messages)
+            {
+                stored += store.Append(ToEntry(message)) == SmsInboxWrite::Stored ? 1 : 0;
+            }
+            CHECK(stored == messages.size());
+            CHECK(store.Size() == messages.size());
+            // 同一模块、同一存储索引、同一时间戳，例如重复执行 AT+CMGL。
+            CHECK(store.Append(ToEntry(messages[123])) == SmsInboxWrite::Duplicate);
+            CHECK(store.Append(ToEntry(messages.back())) == SmsInboxWrite::Duplicate);
+            CheckQueries(store, messages, 1);
+            store.Close();
+            CHECK(!store.IsOpen());
+        }
+        {
+            SmsInboxStore store;
+            CHECK(store.Open(path));
+            CHECK(store.Size() == messages.size());
+            CHECK(store.Append(ToEntry(messages[40000])) == SmsInboxWrite::Duplicate);
+            CheckQueries(store, messages, 2);
+
+            // 查询结果带回完整字段。
+            SmsInboxQuery query;
+            query.sender = messages[5].sender;
+            query.from = messages[5].timestamp;
+            query.to = messages[5].timestamp;
+            std::size_t visited = 0;
+            store.Find(query, [&visited, &messages](const SmsInboxEntry& entry)
+            {
+                ++visited;
+                CHECK(entry.modem == messages[5].modem && entry.body == messages[5].body);
+                CHECK(entry.storageIndex == 5 && entry.receivedAt > 0);
+                return true;
+            });
+            CHECK(visited == 1);
+        }
+    }
+
+    /// <summary>最后一条记录损坏、且覆盖它的索引段丢失时，重新打开丢弃这一条，其余完好。</summary>
+    void TestTornTail(const fs::path& directory)
+    {
+        const auto path = directory / "torn.log";
+        const auto messages = MakeMessages(20000);
+        {
+            SmsInboxStore store;
+            CHECK(store.Open(path));
+            for (const auto& message : messages)
+            {
+                store.Append(ToEntry(message));
+            }
+        }
+        const auto size = fs::file_size(path);
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(size - 3));
+            file.put('X');
+        }
+        fs::path newest;
+        std::uint64_t generation = 0;
+        for (const auto& item : fs::directory_iterator(directory))
+        {
+            const auto name = item.path().filename().string();
+            const std::string prefix = "torn.log.";
+            if (name.rfind(prefix, 0) == 0 && name.size() > prefix.size() + 4 && name.substr(name.size() - 4) == ".idx")
+            {
+                const auto value = std::stoull(name.substr(prefix.size()));
+                if (value >= generation)
+                {
+                    generation = value;
+                    newest = item.path();
+                }
+            }
+        }
+        CHECK(!newest.empty());
+        fs::remove(newest);
+
+        auto survivors = messages;
+        survivors.pop_back();
+        SmsInboxStore store;
+        CHECK(store.Open(path));
+        CHECK(store.Size() == survivors.size());
+        CheckQueries(store, survivors, 3);
+        // 被截掉的那条可以重新写入。
+        CHECK(store.Append(ToEntry(messages.back())) == SmsInboxWrite::Stored);
+        CHECK(store.Size() == messages.size());
+    }
+}
+
+int main()
+{
+    const auto directory = fs::temp_directory_path() / ("athelper-inbox-" + std::to_string(getpid()));
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    TestWriteReopenQuery(directory);
+    TestTornTail(directory);
+    std::error_code error;
+    fs::remove_all(directory, error);
+    return TestSupport::Finish("SmsInboxStoreTests");
+}
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------
+名称：短信列表解析基准
+说明：把 500 条短信的 AT+CMGL 输出按串口读取大小拆块，经行分帧器与列表解析器反复解析，报告每秒条数与吞吐
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为重复次数（默认两千）与块长（默认 4096 字节）
+------------------------------------------------------------------------*/
+#include "LineFramer.h"
+#include "SmsListingParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t kMessages = 500;
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 2000;
+    const std::size_t chunkSize = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+
+    std::string dump = "AT+CMGL=\"ALL\"\r\r\n";
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+        dump += "+CMGL: " + std::to_string(i + 1) + ",\"REC READ\",\"+86138" + std::to_string(10000000 + i) + "\",,\"26/10/16,12:00:"
+                + std::to_string(10 + i % 50) + "+32\"\r\n";
+        dump += i % 4 == 0 ? "您的验证码是 482913，5 分钟内有效。\n如非本人操作请忽略。\r\n"
+                           : "Meeting moved to 15:30 in room B; bring the Q3 report.\r\n";
+    }
+    dump += "\r\nOK\r\n";
+
+    LineFramer framer;
+    SmsListingParser parser;
+    std::size_t records = 0;
+    std::size_t bodyBytes = 0;
+    const SmsListingParser::RecordHandler onRecord = [&](const SmsListingRecord& record)
+    {
+        ++records;
+        bodyBytes += record.body.size();
+    };
+    const LineFramer::FrameHandler onFrame = [&](const LineFrame& frame)
+    {
+        if (frame.kind != FrameKind::Line)
+        {
+            return;
+        }
+        if (frame.text == "OK")
+        {
+            parser.Finish(onRecord);
+            return;
+        }
+        parser.Feed(frame.text, onRecord);
+    };
+
+    const auto started = Clock::now();
+    for (long round = 0; round < rounds; ++round)
+    {
+        for (std::size_t offset = 0; offset < dump.size(); offset += chunkSize)
+        {
+            framer.Feed(std::string_view(dump).substr(offset, chunkSize), onFrame);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::printf("dump: %zu messages, %zu bytes, %zu-byte chunks\n", kMessages, dump.size(), chunkSize);
+    std::printf("parse: %.2f ms/dump, %.1f M messages/s, %.0f MB/s\n", seconds / rounds * 1e3, records / seconds / 1e6,
+                dump.size() * static_cast<double>(rounds) / seconds / 1e6);
+    std::printf("checksum %zu %zu\n", records, bodyBytes);
+    return records == kMessages * static_cast<std::size_t>(rounds) ? 0 : 1;
+}
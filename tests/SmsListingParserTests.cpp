@@ -0,0 +1,324 @@
+/*------------------------------------------------------------------------
+名称：短信列表解析测试
+说明：文本模式与 PDU 模式的 AT+CMGL 列表、AT+CMGR 应答，经行分帧器按任意位置拆块后解析，逐条核对
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：多行正文以 LF 分隔、每条以 CRLF 结束，与常见模块的输出一致；随机拆块使用固定种子
+------------------------------------------------------------------------*/
+#include "LineFramer.h"
+#include "SmsListingParser.h"
+#include "SmsPdu.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// <summary>一条记录的拷贝，便于在回调之外比较。</summary>
+    struct Record
+    {
+        std::string headerLine;
+        int index = -1;
+        int statusCode = -1;
+        std::string status;
+        std::string address;
+        std::string timestamp;
+        int length = -1;
+        std::string body;
+
+        bool operator==(const Record&) const = default;
+    };
+
+    /// <summary>一段模块输出与其中应解析出的记录。</summary>
+    struct Listing
+    {
+        std::string stream;
+        std::vector<Record> records;
+    };
+
+    /// <summary>解析一段输出的结果。</summary>
+    struct Parsed
+    {
+        std::vector<Record> records;
+        /// <summary>不属于列表的行，例如列表之前的回显。</summary>
+        std::vector<std::string> otherLines;
+        std::size_t prompts = 0;
+    };
+
+    Record Copy(const SmsListingRecord& record)
+    {
+        Record copy;
+        copy.headerLine = record.headerLine;
+        copy.index = record.header.index;
+        copy.statusCode = record.header.statusCode;
+        copy.status = record.header.status;
+        copy.address = record.header.address;
+        copy.timestamp = record.header.timestamp;
+        copy.length = record.header.length;
+        copy.body = record.body;
+        return copy;
+    }
+
+    /// <summary>按 cuts 给出的块长度依次交入，剩余部分作为最后一块；OK 视为最终结果码。</summary>
+    Parsed Parse(std::string_view stream, const std::vector<std::size_t>& cuts)
+    {
+        LineFramer framer;
+        SmsListingParser parser;
+        Parsed parsed;
+        const SmsListingParser::RecordHandler onRecord = [&](const SmsListingRecord& record)
+        {
+            parsed.records.push_back(Copy(record));
+        };
+        const LineFramer::FrameHandler onFrame = [&](const LineFrame& frame)
+        {
+            if (frame.kind == FrameKind::Prompt)
+            {
+                ++parsed.prompts;
+                return;
+            }
+            if (frame.text == "OK")
+            {
+                parser.Finish(onRecord);
+                return;
+            }
+            if (!parser.Feed(frame.text, onRecord))
+            {
+                parsed.otherLines.emplace_back(frame.text);
+            }
+        };
+        std::size_t offset = 0;
+        for (const auto cut : cuts)
+        {
+            const auto length = std::min(cut, stream.size() - offset);
+            framer.Feed(stream.substr(offset, length), onFrame);
+            offset += length;
+        }
+        framer.Feed(stream.substr(offset), onFrame);
+        return parsed;
+    }
+
+    Parsed Parse(std::string_view stream)
+    {
+        return Parse(stream, {});
+    }
+
+    std::string Sender(std::size_t i)
+    {
+        return "+86138" + std::to_string(10000000 + i * 7919 % 1000000);
+    }
+
+    std::string Timestamp(std::size_t i)
+    {
+        const auto minute = std::to_string(10 + i / 60 % 50);
+        const auto second = std::to_string(10 + i % 50);
+        return "26/10/16,12:" + minute + ":" + second + "+32";
+    }
+
+    /// <summary>正文为 1 到 3 行，含逗号、引号、中文以及形似结果码或头部的文字。</summary>
+    std::vector<std::string> BodyLines(std::size_t i)
+    {
+        static const std::vector<std::string> samples{
+            "您的验证码是 482913，5 分钟内有效。",
+            "Meeting moved to 15:30, room \"B\"; bring the Q3 report.",
+            "OK then, see you",
+            "ERROR rate was 3% last week",
+            "+CMGL is not at the start here: +CMGL: 9",
+            "a,b,,c,\"d\"",
+            std::string(160, 'k')};
+        std::vector<std::string> lines;
+        for (std::size_t line = 0; line <= i % 3; ++line)
+        {
+            lines.push_back(samples[(i + line * 3) % samples.size()]);
+        }
+        return lines;
+    }
+
+    /// <summary>文本模式的 AT+CMGL="ALL" 输出，前面带回显。</summary>
+    Listing TextListing(std::size_t count)
+    {
+        Listing listing;
+        listing.stream = "AT+CMGL=\"ALL\"\r\r\n";
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Record record;
+            record.index = static_cast<int>(i + 1);
+            record.statusCode = i % 2 == 0 ? 0 : 1;
+            record.status = i % 2 == 0 ? "REC UNREAD" : "REC READ";
+            record.address = Sender(i);
+            record.timestamp = Timestamp(i);
+            record.headerLine = "+CMGL: " + std::to_string(record.index) + ",\"" + record.status + "\",\"" + record.address + "\",,\""
+                                + record.timestamp + "\"";
+            const auto lines = BodyLines(i);
+            for (std::size_t line = 0; line < lines.size(); ++line)
+            {
+                record.body += (line == 0 ? "" : "\n") + lines[line];
+            }
+            listing.stream += record.headerLine + "\r\n" + record.body + "\r\n";
+            listing.records.push_back(std::move(record));
+        }
+        listing.stream += "\r\nOK\r\n";
+        return listing;
+    }
+
+    /// <summary>PDU 模式的 AT+CMGL=4 输出；正文是可解码的 SMS-DELIVER。</summary>
+    Listing PduListing(std::size_t count, std::vector<std::string>& texts)
+    {
+        Listing listing;
+        listing.stream = "AT+CMGL=4\r\r\n";
+        std::vector<SmsPduPart> parts;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto lines = BodyLines(i);
+            texts.push_back(lines.front().substr(0, 60));
+            CHECK(EncodeSmsDeliver(Sender(i), texts.back(), Timestamp(i), SmsPduOptions{}, parts));
+            Record record;
+            record.index = static_cast<int>(i + 1);
+            record.statusCode = i % 2 == 0 ? 0 : 1;
+            record.status = i % 2 == 0 ? "REC UNREAD" : "REC READ";
+            record.length = parts.front().tpduLength;
+            record.headerLine = "+CMGL: " + std::to_string(record.index) + "," + std::to_string(record.statusCode) + ",,"
+                                + std::to_string(record.length);
+            record.body = parts.front().hex;
+            listing.stream += record.headerLine + "\r\n" + record.body + "\r\n";
+            listing.records.push_back(std::move(record));
+        }
+        listing.stream += "\r\nOK\r\n";
+        return listing;
+    }
+
+    void CheckParsed(const Parsed& parsed, const Listing& listing, std::string_view echo)
+    {
+        CHECK(parsed.records == listing.records);
+        CHECK(parsed.otherLines.size() == 1 && parsed.otherLines.front() == echo);
+        CHECK(parsed.prompts == 0);
+    }
+
+    /// <summary>在每一个字节位置拆成两块，以及逐字节交入。</summary>
+    void TestEverySplitPoint()
+    {
+        const auto listing = TextListing(6);
+        for (std::size_t cut = 0; cut <= listing.stream.size(); ++cut)
+        {
+            CheckParsed(Parse(listing.stream, {cut}), listing, "AT+CMGL=\"ALL\"");
+        }
+        CheckParsed(Parse(listing.stream, std::vector<std::size_t>(listing.stream.size(), 1)), listing, "AT+CMGL=\"ALL\"");
+    }
+
+    /// <summary>长列表按随机块长交入，块长覆盖从 1 字节到串口一次读取的常见大小。</summary>
+    void TestRandomChunks()
+    {
+        const auto listing = TextListing(500);
+        std::mt19937 random(19);
+        for (const std::size_t maxChunk : {7, 64, 4096})
+        {
+            std::uniform_int_distribution<std::size_t> size(1, maxChunk);
+            std::vector<std::size_t> cuts;
+            for (std::size_t total = 0; total < listing.stream.size(); total += cuts.back())
+            {
+                cuts.push_back(size(random));
+            }
+            CheckParsed(Parse(listing.stream, cuts), listing, "AT+CMGL=\"ALL\"");
+        }
+    }
+
+    void TestPduListing()
+    {
+        std::vector<std::string> texts;
+        const auto listing = PduListing(40, texts);
+        std::mt19937 random(4);
+        std::uniform_int_distribution<std::size_t> size(1, 33);
+        std::vector<std::size_t> cuts;
+        for (std::size_t total = 0; total < listing.stream.size(); total += cuts.back())
+        {
+            cuts.push_back(size(random));
+        }
+        for (const auto& parsed : {Parse(listing.stream), Parse(listing.stream, cuts)})
+        {
+            CheckParsed(parsed, listing, "AT+CMGL=4");
+            for (std::size_t i = 0; i < parsed.records.size() && i < texts.size(); ++i)
+            {
+                CHECK(parsed.records[i].length >= 0);
+                CHECK(parsed.records[i].address.empty());
+                const auto message = DecodeSmsPdu(parsed.records[i].body);
+                CHECK(message && message->text == texts[i] && message->address == Sender(i));
+            }
+        }
+    }
+
+    /// <summary>+CMGR 不带索引；正文同样可以跨多行。</summary>
+    void TestCmgr()
+    {
+        const std::string stream = "AT+CMGR=7\r\r\n+CMGR: \"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"\r\n"
+                                   "first line\nsecond line\r\n\r\nOK\r\n";
+        const auto parsed = Parse(stream, {30, 1, 1, 40});
+        CHECK(parsed.records.size() == 1);
+        if (!parsed.records.empty())
+        {
+            const auto& record = parsed.records.front();
+            CHECK(record.index == -1);
+            CHECK(record.statusCode == 1);
+            CHECK(record.address == "+8613800000000");
+            CHECK(record.timestamp == "26/10/16,12:00:00+32");
+            CHECK(record.body == "first line\nsecond line");
+        }
+    }
+
+    void TestParserState()
+    {
+        SmsListingParser parser;
+        std::vector<Record> records;
+        const SmsListingParser::RecordHandler onRecord = [&](const SmsListingRecord& record)
+        {
+            records.push_back(Copy(record));
+        };
+
+        // 没有头部之前的行不属于列表；空列表结束时不交出任何记录。
+        CHECK(!parser.Feed("some line", onRecord));
+        parser.Finish(onRecord);
+        CHECK(records.empty());
+
+        // 断开后 Reset 丢弃收了一半的记录。
+        CHECK(parser.Feed("+CMGL: 1,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"", onRecord));
+        CHECK(parser.Feed("half", onRecord));
+        CHECK(parser.InRecord());
+        parser.Reset();
+        CHECK(!parser.InRecord());
+        parser.Finish(onRecord);
+        CHECK(records.empty());
+
+        // 头部字段无法识别时仍交出原始头部与正文，字段为默认值；Finish 重复调用只交出一次。
+        CHECK(parser.Feed("+CMGL: garbage", onRecord));
+        CHECK(parser.Feed("body", onRecord));
+        parser.Finish(onRecord);
+        parser.Finish(onRecord);
+        CHECK(records.size() == 1);
+        if (!records.empty())
+        {
+            CHECK(records.front().headerLine == "+CMGL: garbage");
+            CHECK(records.front().index == -1 && records.front().statusCode == -1);
+            CHECK(records.front().body == "body");
+        }
+
+        // 没有正文的记录交出空正文，下一条头部到达时交出。
+        records.clear();
+        CHECK(parser.Feed("+CMGL: 1,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"", onRecord));
+        CHECK(parser.Feed("+CMGL: 2,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"", onRecord));
+        CHECK(records.size() == 1 && records.front().index == 1 && records.front().body.empty());
+        parser.Finish(onRecord);
+        CHECK(records.size() == 2 && records.back().index == 2);
+    }
+}
+
+int main()
+{
+    TestEverySplitPoint();
+    TestRandomChunks();
+    TestPduListing();
+    TestCmgr();
+    TestParserState();
+    return TestSupport::Finish("SmsListingParserTests");
+}
@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------
+名称：PDU 编解码基准
+说明：单线程连续编码与解码一组典型短信，报告每秒条数与每条耗时
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为循环次数，默认一百万
+------------------------------------------------------------------------*/
+#include "SmsPdu.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const std::vector<std::string> corpus{
+        "Your verification code is 482913. It expires in 5 minutes.",
+        "您的验证码是 482913，5 分钟内有效。",
+        "Meeting moved to 15:30 in room B; bring the Q3 report.",
+        std::string(300, 'k')};
+    SmsPduOptions options;
+    std::vector<SmsPduPart> parts;
+
+    std::size_t bytes = 0;
+    auto started = Clock::now();
+    for (long i = 0; i < rounds; ++i)
+    {
+        EncodeSmsSubmit("+8613800000000", corpus[static_cast<std::size_t>(i) % corpus.size()], options, parts);
+        bytes += parts[0].hex.size();
+    }
+    const double encodeSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::vector<std::string> encoded;
+    for (const auto& text : corpus)
+    {
+        EncodeSmsDeliver("+8613800000000", text, "26/10/16,12:00:00+32", options, parts);
+        encoded.push_back(parts[0].hex);
+    }
+    std::size_t characters = 0;
+    started = Clock::now();
+    for (long i = 0; i < rounds; ++i)
+    {
+        if (const auto message = DecodeSmsPdu(encoded[static_cast<std::size_t>(i) % encoded.size()]))
+        {
+            characters += message->text.size();
+        }
+    }
+    const double decodeSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::printf("encode: %.0f k messages/s (%.0f ns/message)\n", rounds / encodeSeconds / 1e3, encodeSeconds / rounds * 1e9);
+    std::printf("decode: %.0f k PDUs/s (%.0f ns/PDU)\n", rounds / decodeSeconds / 1e3, decodeSeconds / rounds * 1e9);
+    std::printf("checksum %zu %zu\n", bytes, characters);
+    return 0;
+}
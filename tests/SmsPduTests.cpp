@@ -0,0 +1,201 @@
+/*------------------------------------------------------------------------
+名称：PDU 编解码测试
+说明：已知向量、编码后再解码的往返测试，以及对解码器的随机输入测试
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：随机输入使用固定种子，可重复；以 ATHELPER_SANITIZE 构建时越界读写会被直接报告
+------------------------------------------------------------------------*/
+#include "SmsPdu.h"
+#include "TestSupport.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// <summary>编码为 SUBMIT 与 DELIVER 后逐段解码，检查号码、编码、分段信息与文本都能还原。</summary>
+    void RoundTrip(const std::string& number, const std::string& text, SmsEncoding encoding, std::size_t expectedParts)
+    {
+        SmsPduOptions options;
+        options.concatReference = 42;
+        std::vector<SmsPduPart> parts;
+        CHECK(EncodeSmsSubmit(number, text, options, parts));
+        CHECK(parts.size() == expectedParts);
+        std::string joined;
+        for (std::size_t i = 0; i < parts.size(); ++i)
+        {
+            const auto message = DecodeSmsPdu(parts[i].hex);
+            CHECK(message.has_value());
+            if (!message)
+            {
+                return;
+            }
+            CHECK(!message->deliver);
+            CHECK(message->address == number);
+            CHECK(message->encoding == encoding);
+            CHECK(static_cast<int>(parts[i].hex.size() / 2) - 1 == parts[i].tpduLength);
+            if (parts.size() > 1)
+            {
+                CHECK(message->concat.total == parts.size());
+                CHECK(message->concat.sequence == i + 1);
+                CHECK(message->concat.reference == 42);
+            }
+            else
+            {
+                CHECK(message->concat.total == 0);
+            }
+            CHECK(message->text == text.substr(parts[i].textOffset, parts[i].textLength));
+            joined += message->text;
+        }
+        CHECK(joined == text);
+
+        std::vector<SmsPduPart> delivered;
+        CHECK(EncodeSmsDeliver("+8613800000000", text, "26/10/16,12:34:56-08", options, delivered));
+        CHECK(delivered.size() == expectedParts);
+        joined.clear();
+        for (const auto& part : delivered)
+        {
+            const auto message = DecodeSmsPdu(part.hex);
+            CHECK(message && message->deliver && message->address == "+8613800000000");
+            CHECK(message && message->timestamp.year == 2026 && message->timestamp.second == 56 && message->timestamp.quarterHours == -8);
+            if (message)
+            {
+                joined += message->text;
+            }
+        }
+        CHECK(joined == text);
+    }
+
+    void TestKnownVectors()
+    {
+        std::vector<SmsPduPart> parts;
+        CHECK(EncodeSmsSubmit("+46708251358", "hellohello", SmsPduOptions{}, parts));
+        CHECK(parts.size() == 1 && parts[0].hex == "0011000B916407281553F80000A70AE8329BFD4697D9EC37");
+
+        const auto message = DecodeSmsPdu("07911326040000F0040B911346610089F60000208062917314080CC8F71D14969741F977FD07");
+        CHECK(message && message->text == "How are you?");
+        CHECK(message && message->address == "+31641600986" && message->serviceCenter == "+31624000000");
+
+        SmsPduOptions center;
+        center.serviceCenter = "+8613800100500";
+        CHECK(EncodeSmsSubmit("10086", "x", center, parts));
+        const auto withCenter = DecodeSmsPdu(parts[0].hex);
+        CHECK(withCenter && withCenter->serviceCenter == "+8613800100500");
+
+        std::vector<SmsPduPart> alphanumeric;
+        CHECK(EncodeSmsDeliver("Bank", "hi", "26/10/16,12:00:00+32", SmsPduOptions{}, alphanumeric));
+        const auto bank = DecodeSmsPdu(alphanumeric[0].hex);
+        CHECK(bank && bank->address == "Bank");
+    }
+
+    void TestRoundTrips()
+    {
+        RoundTrip("10086", "hello", SmsEncoding::Gsm7, 1);
+        RoundTrip("+8613800000000", "你好 world!", SmsEncoding::Ucs2, 1);
+        RoundTrip("10086", std::string(160, 'a'), SmsEncoding::Gsm7, 1);
+        RoundTrip("10086", std::string(161, 'a'), SmsEncoding::Gsm7, 2);
+        // 转义字符占两个七位组，不能被拆到两段。
+        RoundTrip("10086", std::string(152, 'a') + "[" + std::string(10, 'b'), SmsEncoding::Gsm7, 2);
+        RoundTrip("10086", "€{}[]~|^\\ £¥èéùìòÇØøÅåΔ_ΦΓΛΩΠΨΣΘΞÆæßÉ!\"#¤%&'()*+,-./:;<=>?¡ÄÖÑÜ§¿äöñüà@$\r\n", SmsEncoding::Gsm7, 1);
+        std::string chinese;
+        for (int i = 0; i < 100; ++i)
+        {
+            chinese += "中";
+        }
+        RoundTrip("10086", chinese, SmsEncoding::Ucs2, 2);
+        // 代理对不能被拆到两段。
+        std::string emoji;
+        for (int i = 0; i < 36; ++i)
+        {
+            emoji += "😀";
+        }
+        RoundTrip("10086", emoji, SmsEncoding::Ucs2, 2);
+        RoundTrip("10086", std::string(7, 'x'), SmsEncoding::Gsm7, 1);
+        RoundTrip("10086", "", SmsEncoding::Gsm7, 1);
+        RoundTrip("*100#", "x", SmsEncoding::Gsm7, 1);
+        RoundTrip("10086", std::string(153 * 255, 'z'), SmsEncoding::Gsm7, 255);
+
+        std::vector<SmsPduPart> parts;
+        CHECK(!EncodeSmsSubmit("10086", std::string(153 * 255 + 1, 'z'), SmsPduOptions{}, parts));
+        CHECK(!EncodeSmsSubmit("abc", "x", SmsPduOptions{}, parts));
+        std::size_t count = 0;
+        CHECK(ChooseSmsEncoding(chinese, &count) == SmsEncoding::Ucs2 && count == 2);
+    }
+
+    void TestMalformed()
+    {
+        CHECK(!DecodeSmsPdu(""));
+        CHECK(!DecodeSmsPdu("00"));
+        CHECK(!DecodeSmsPdu("zz"));
+        CHECK(!DecodeSmsPdu("0011000B91"));
+        // 服务中心长度字节超出实际数据或合理范围（串口上的残行）。
+        CHECK(!DecodeSmsPdu("FF"));
+        CHECK(!DecodeSmsPdu("FF91" + std::string(40, '0')));
+        CHECK(!DecodeSmsPdu("0D91" + std::string(24, '1') + "040B911346610089F60000208062917314080CC8F71D14969741F977FD07"));
+    }
+
+    /// <summary>随机十六进制与合法 PDU 的随机变异：解码器只能返回空或一条消息，不得越界。</summary>
+    void TestRandomInput()
+    {
+        std::mt19937 random(20261016);
+        const char* digits = "0123456789ABCDEF";
+        std::vector<std::string> seeds;
+        std::vector<SmsPduPart> parts;
+        for (const auto* text : {"hello", "你好 world!", "Your verification code is 482913."})
+        {
+            EncodeSmsDeliver("+8613800000000", text, "26/10/16,12:00:00+32", SmsPduOptions{}, parts);
+            seeds.push_back(parts[0].hex);
+            EncodeSmsSubmit("10086", text, SmsPduOptions{}, parts);
+            seeds.push_back(parts[0].hex);
+        }
+        EncodeSmsDeliver("+8613800000000", std::string(300, 'k'), "26/10/16,12:00:00+32", SmsPduOptions{}, parts);
+        seeds.push_back(parts[1].hex);
+
+        std::size_t decoded = 0;
+        std::string hex;
+        for (int round = 0; round < 200000; ++round)
+        {
+            if (round % 2 == 0)
+            {
+                hex.assign(random() % 400, '0');
+                for (auto& ch : hex)
+                {
+                    ch = digits[random() % 16];
+                }
+            }
+            else
+            {
+                hex = seeds[random() % seeds.size()];
+                const int mutations = 1 + static_cast<int>(random() % 4);
+                for (int i = 0; i < mutations && !hex.empty(); ++i)
+                {
+                    hex[random() % hex.size()] = digits[random() % 16];
+                }
+                if (random() % 4 == 0)
+                {
+                    hex.resize(random() % (hex.size() + 1));
+                }
+            }
+            if (const auto message = DecodeSmsPdu(hex))
+            {
+                ++decoded;
+                CHECK(message->address.size() <= 20);
+                CHECK(message->serviceCenter.size() <= 21);
+                // 每个输入字节至多解出一个字符，UTF-8 每字符至多 4 字节。
+                CHECK(message->text.size() <= hex.size() * 4);
+            }
+        }
+        std::printf("random input: %zu of 200000 decoded\n", decoded);
+    }
+}
+
+int main()
+{
+    TestKnownVectors();
+    TestRoundTrips();
+    TestMalformed();
+    TestRandomInput();
+    return TestSupport::Finish("SmsPduTests");
+}
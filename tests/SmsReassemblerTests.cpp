@@ -0,0 +1,266 @@
+/*------------------------------------------------------------------------
+名称：长短信拼接测试
+说明：十万条交错到达的长短信回放（含重复段与缺段），检查拼接结果与缓存上限；以及无新段时的超时交出
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：回放使用固定种子与模拟时钟，可重复；会话部分接到进程内虚拟模块
+------------------------------------------------------------------------*/
+#include "AtSession.h"
+#include "SmsPdu.h"
+#include "SmsReassembler.h"
+#include "TestSupport.h"
+#include "VirtualModemTransport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    /// <summary>回放中一条尚未交完的长短信。</summary>
+    struct OpenMessage
+    {
+        std::size_t id = 0;
+        std::string sender;
+        std::vector<std::string> parts;
+        /// <summary>各段的到达顺序，缺段时少一项。</summary>
+        std::vector<int> order;
+        std::size_t next = 0;
+    };
+
+    struct ReplayResult
+    {
+        std::size_t intact = 0;
+        std::size_t corrupted = 0;
+        std::size_t incomplete = 0;
+        std::size_t maxPendingBytes = 0;
+        std::size_t maxPendingMessages = 0;
+        SmsReassemblyStatistics statistics;
+    };
+
+    /// <summary>
+    /// 同时保持 window 条长短信在途，随机挑一条交入其下一段，模拟时钟每段前进 1 ms。
+    /// dropRate 的长短信缺最后到达的一段，dupRate 的段会重复交入。
+    /// </summary>
+    ReplayResult Replay(std::size_t window, double dropRate, double dupRate, const SmsReassemblyPolicy& policy)
+    {
+        constexpr std::size_t kMessages = 100000;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        SmsReassembler reassembler(policy);
+        ReplayResult result;
+        std::unordered_map<std::string, std::string> expected;
+        const auto handler = [&](const ReceivedSms& sms)
+        {
+            if (!sms.complete)
+            {
+                ++result.incomplete;
+                return;
+            }
+            const auto found = expected.find(std::string(sms.header));
+            if (found != expected.end() && found->second == sms.body)
+            {
+                ++result.intact;
+                expected.erase(found);
+            }
+            else
+            {
+                ++result.corrupted;
+            }
+        };
+
+        std::vector<OpenMessage> open;
+        std::size_t made = 0;
+        auto now = SmsReassembler::Clock::time_point{};
+        while (made < kMessages || !open.empty())
+        {
+            while (made < kMessages && open.size() < window)
+            {
+                OpenMessage message;
+                message.id = made;
+                message.sender = "+86138" + std::to_string(random() % 100000);
+                const int count = 2 + static_cast<int>(random() % 5);
+                std::string full;
+                for (int i = 0; i < count; ++i)
+                {
+                    message.parts.emplace_back(60 + random() % 100, static_cast<char>('a' + (made + i) % 26));
+                    full += message.parts.back();
+                    message.order.push_back(i);
+                }
+                std::shuffle(message.order.begin(), message.order.end(), random);
+                if (chance(random) < dropRate)
+                {
+                    message.order.pop_back();
+                }
+                expected.emplace("H" + std::to_string(made), std::move(full));
+                open.push_back(std::move(message));
+                ++made;
+            }
+            const std::size_t slot = random() % open.size();
+            auto& message = open[slot];
+            const int sequence = message.order[message.next++];
+            // ReceivedSms 只引用文本，头部须活到交入结束。
+            const std::string header = "H" + std::to_string(message.id);
+            ReceivedSms part;
+            part.sender = message.sender;
+            part.header = header;
+            part.body = message.parts[static_cast<std::size_t>(sequence)];
+            SmsConcatInfo concat;
+            concat.reference = static_cast<std::uint16_t>(message.id);
+            concat.total = static_cast<std::uint8_t>(message.parts.size());
+            concat.sequence = static_cast<std::uint8_t>(sequence + 1);
+            now += std::chrono::milliseconds(1);
+            reassembler.Add(part, concat, now, handler);
+            if (message.next < message.order.size() && chance(random) < dupRate)
+            {
+                reassembler.Add(part, concat, now, handler);
+            }
+            const auto statistics = reassembler.GetStatistics();
+            result.maxPendingBytes = std::max(result.maxPendingBytes, statistics.pendingBytes);
+            result.maxPendingMessages = std::max(result.maxPendingMessages, statistics.pendingMessages);
+            if (message.next == message.order.size())
+            {
+                open[slot] = std::move(open.back());
+                open.pop_back();
+            }
+        }
+        reassembler.Flush(handler);
+        result.statistics = reassembler.GetStatistics();
+        return result;
+    }
+
+    void TestUnderCap()
+    {
+        const auto result = Replay(32, 0.0, 0.02, SmsReassemblyPolicy{});
+        CHECK(result.intact == 100000);
+        CHECK(result.corrupted == 0 && result.incomplete == 0);
+        CHECK(result.statistics.duplicateParts > 0);
+        CHECK(result.statistics.pendingMessages == 0 && result.statistics.pendingBytes == 0);
+    }
+
+    void TestMessageCap()
+    {
+        const SmsReassemblyPolicy policy;
+        const auto result = Replay(1000, 0.0, 0.02, policy);
+        CHECK(result.maxPendingMessages <= policy.maxMessages);
+        CHECK(result.maxPendingBytes <= policy.maxBytes);
+        CHECK(result.statistics.evicted > 0);
+        CHECK(result.corrupted == 0);
+        CHECK(result.intact > 0);
+    }
+
+    void TestByteCap()
+    {
+        SmsReassemblyPolicy policy;
+        policy.maxMessages = 100000;
+        policy.maxBytes = 64 * 1024;
+        const auto result = Replay(1000, 0.0, 0.02, policy);
+        CHECK(result.maxPendingBytes <= policy.maxBytes);
+        CHECK(result.statistics.evicted > 0);
+        CHECK(result.corrupted == 0);
+    }
+
+    void TestDroppedParts()
+    {
+        SmsReassemblyPolicy policy;
+        policy.timeout = std::chrono::milliseconds(2000);
+        policy.maxMessages = 100000;
+        policy.maxBytes = 1 << 30;
+        const auto result = Replay(32, 0.05, 0.0, policy);
+        CHECK(result.statistics.expired > 0);
+        CHECK(result.statistics.evicted == 0);
+        CHECK(result.corrupted == 0);
+        CHECK(result.intact + result.incomplete == 100000);
+        // 缺段的长短信最多等待 timeout，即 2000 段，缓存不随回放长度增长。
+        CHECK(result.maxPendingMessages < 2000);
+    }
+
+    void TestExpire()
+    {
+        SmsReassemblyPolicy policy;
+        policy.timeout = std::chrono::seconds(10);
+        SmsReassembler reassembler(policy);
+        std::vector<std::string> emitted;
+        bool complete = true;
+        const auto handler = [&emitted, &complete](const ReceivedSms& sms)
+        {
+            emitted.emplace_back(sms.body);
+            complete = sms.complete;
+        };
+        ReceivedSms part;
+        part.sender = "+8613800000000";
+        part.body = "first half";
+        SmsConcatInfo concat;
+        concat.reference = 7;
+        concat.total = 2;
+        concat.sequence = 1;
+        const auto start = SmsReassembler::Clock::time_point{} + std::chrono::hours(1);
+        reassembler.Add(part, concat, start, handler);
+        reassembler.Expire(start + std::chrono::seconds(9), handler);
+        CHECK(emitted.empty());
+        reassembler.Expire(start + std::chrono::seconds(10), handler);
+        CHECK(emitted.size() == 1 && !complete && emitted[0].starts_with("first half"));
+        CHECK(reassembler.GetStatistics().expired == 1 && reassembler.GetStatistics().pendingMessages == 0);
+    }
+
+    /// <summary>会话收到长短信的第一段后再无上报，例行清理须在超时后交出不完整的一条。</summary>
+    void TestSessionExpiresIdle()
+    {
+        const std::wstring portName = L"SIM9301";
+        auto modem = VirtualModemTransport::SharedModem(portName);
+        AtSession session;
+        SmsReassemblyPolicy policy;
+        policy.timeout = std::chrono::milliseconds(300);
+        session.SetSmsReassemblyPolicy(policy);
+        std::atomic<int> incomplete{0};
+        session.SetSmsCallback([&incomplete](const ReceivedSms& sms)
+        {
+            if (!sms.complete)
+            {
+                ++incomplete;
+            }
+            return true;
+        });
+        CHECK(session.Connect(portName, 115200));
+        // 等初始化与模块探测都结束，短信格式已确定后再上报。
+        const auto ready = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!session.GetModemIdentity() && std::chrono::steady_clock::now() < ready)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        session.SendCommand(L"AT").Wait();
+
+        std::vector<SmsPduPart> parts;
+        CHECK(EncodeSmsDeliver("+8613800000000", std::string(200, 'q'), "26/10/16,12:00:00+32", SmsPduOptions{}, parts));
+        CHECK(parts.size() == 2);
+        if (parts.size() == 2)
+        {
+            modem->EmitUrc("+CMT: ," + std::to_string(parts[0].tpduLength));
+            modem->EmitUrc(parts[0].hex);
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (incomplete.load() == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        CHECK(incomplete.load() == 1);
+        CHECK(session.GetSmsReassemblyStatistics().expired == 1);
+        session.Disconnect();
+    }
+}
+
+int main()
+{
+    TestUnderCap();
+    TestMessageCap();
+    TestByteCap();
+    TestDroppedParts();
+    TestExpire();
+    TestSessionExpiresIdle();
+    return TestSupport::Finish("SmsReassemblerTests");
+}
@@ -0,0 +1,38 @@
+/*------------------------------------------------------------------------
+名称：测试辅助
+说明：各测试程序共用的断言宏与失败计数
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：不依赖测试框架；每个测试程序以失败数作为退出码，由 CTest 判定
+------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdio>
+
+namespace TestSupport
+{
+    inline int& Failures() noexcept
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    /// <summary>打印汇总并返回进程退出码。</summary>
+    inline int Finish(const char* name)
+    {
+        std::printf("%s: %d failure(s)\n", name, Failures());
+        return Failures() == 0 ? 0 : 1;
+    }
+}
+
+/// <summary>条件不成立时记录失败并继续执行，便于一次看到全部失败。</summary>
+#define CHECK(condition)                                                                  \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(condition))                                                                 \
+        {                                                                                 \
+            std::printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition);              \
+            ++TestSupport::Failures();                                                    \
+        }                                                                                 \
+    } while (false)
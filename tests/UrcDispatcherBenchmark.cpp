@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------
+名称：主动上报分发基准
+说明：对上报与普通应答混合的行反复识别与分发，报告每秒行数；并与逐条比较前缀的做法对照
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：以 Release 或 RelWithDebInfo 构建后运行；参数为重复次数，默认两千
+------------------------------------------------------------------------*/
+#include "UrcDispatcher.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::array<std::string_view, 25> kPrefixes{
+        "+CMTI:", "+CMT:", "+CDSI:", "+CDS:", "+CBM:", "+CREG:", "+CEREG:", "+CGREG:", "+C5GREG:", "RING", "+CLIP:", "+CRING:", "+CUSD:",
+        "+CIEV:", "+CPIN:", "+CTZV:", "+CTZE:", "+CGEV:", "+CFUN:", "+QIURC:", "+QIND:", "+QUSIM:", "RDY", "SMS DONE", "PB DONE"};
+
+    /// <summary>逐条比较前缀，作为对照。</summary>
+    bool LinearIsUrc(std::string_view line) noexcept
+    {
+        for (const auto prefix : kPrefixes)
+        {
+            if (prefix.back() == ':' ? line.substr(0, prefix.size()) == prefix : line == prefix)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    const long rounds = argc > 1 ? std::atol(argv[1]) : 2000;
+    const std::vector<std::string> lines{
+        "+CMTI: \"SM\",3", "+CREG: 1,\"1A2B\",\"01C3\"", "+CSQ: 23,99", "OK", "+CMGL: 1,\"REC READ\",\"+8613800000000\",,\"26/10/16,12:00:00+32\"",
+        "Meeting moved to 15:30 in room B", "+QIND: \"csq\",23,99", "RING", "+CLIP: \"+8613800000000\",145", "+CEREG: 5", "ERROR",
+        "+CUSD: 0,\"Balance 12.30\",15", "+CGEV: NW DETACH", "+CMGS: 17", "SMS DONE", "+C5GREG: 1"};
+    std::vector<std::string> corpus;
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        corpus.push_back(lines[(i * 7) % lines.size()]);
+    }
+
+    UrcDispatcher dispatcher;
+    std::size_t delivered = 0;
+    for (std::size_t kind = 1; kind < static_cast<std::size_t>(UrcKind::Count); ++kind)
+    {
+        dispatcher.Subscribe(static_cast<UrcKind>(kind), [&delivered](const UrcEvent& event)
+        {
+            delivered += event.payload.size();
+        });
+    }
+
+    const auto measure = [&](const char* name, auto&& classify)
+    {
+        std::size_t matched = 0;
+        const auto started = Clock::now();
+        for (long round = 0; round < rounds; ++round)
+        {
+            for (const auto& line : corpus)
+            {
+                matched += classify(line) ? 1 : 0;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        const double total = static_cast<double>(rounds) * static_cast<double>(corpus.size());
+        std::printf("%-22s %7.1f M lines/s, %5.1f ns/line (%zu matched)\n", name, total / seconds / 1e6, seconds / total * 1e9, matched);
+    };
+    measure("trie match", [](const std::string& line)
+    {
+        return UrcDispatcher::Match(line) != UrcKind::None;
+    });
+    measure("linear prefix scan", [](const std::string& line)
+    {
+        return LinearIsUrc(line);
+    });
+    measure("match and dispatch", [&dispatcher](const std::string& line)
+    {
+        return dispatcher.Dispatch(line) != UrcKind::None;
+    });
+    std::printf("checksum %zu\n", delivered);
+    return 0;
+}
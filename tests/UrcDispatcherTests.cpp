@@ -0,0 +1,245 @@
+/*------------------------------------------------------------------------
+名称：主动上报分发测试
+说明：检查前缀树匹配（与逐条比较的参照实现对照）、参数偏移，以及分发期间的订阅与退订
+作者：Lion
+邮箱：chengbin@3578.cn
+日期：2026-10-16
+备注：分发在快照上进行：回调中订阅或退订只影响之后的分发
+------------------------------------------------------------------------*/
+#include "TestSupport.h"
+#include "UrcDispatcher.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Expectation
+    {
+        std::string_view line;
+        UrcKind kind;
+        std::string_view payload;
+    };
+
+    /// <summary>参照实现：逐条比较全部前缀，取最长的匹配。</summary>
+    UrcKind LinearMatch(std::string_view line)
+    {
+        static const std::vector<std::pair<std::string_view, UrcKind>> prefixes{
+            {"+CMTI:", UrcKind::Cmti}, {"+CMT:", UrcKind::Cmt}, {"+CDSI:", UrcKind::Cdsi}, {"+CDS:", UrcKind::Cds},
+            {"+CBM:", UrcKind::Cbm}, {"+CREG:", UrcKind::Creg}, {"+CEREG:", UrcKind::Cereg}, {"+CGREG:", UrcKind::Cgreg},
+            {"+C5GREG:", UrcKind::C5greg}, {"RING", UrcKind::Ring}, {"+CLIP:", UrcKind::Clip}, {"+CRING:", UrcKind::Cring},
+            {"+CUSD:", UrcKind::Cusd}, {"+CIEV:", UrcKind::Ciev}, {"+CPIN:", UrcKind::Cpin}, {"+CTZV:", UrcKind::Ctzv},
+            {"+CTZE:", UrcKind::Ctze}, {"+CGEV:", UrcKind::Cgev}, {"+CFUN:", UrcKind::Cfun}, {"+QIURC:", UrcKind::Qiurc},
+            {"+QIND:", UrcKind::Qind}, {"+QUSIM:", UrcKind::Qusim}, {"RDY", UrcKind::Rdy}, {"SMS DONE", UrcKind::SmsDone},
+            {"PB DONE", UrcKind::PbDone}};
+        UrcKind found = UrcKind::None;
+        std::size_t longest = 0;
+        for (const auto& [prefix, kind] : prefixes)
+        {
+            const bool exact = prefix.back() != ':';
+            const bool matches = exact ? line == prefix : line.substr(0, prefix.size()) == prefix;
+            if (matches && prefix.size() > longest)
+            {
+                found = kind;
+                longest = prefix.size();
+            }
+        }
+        return found;
+    }
+
+    void TestMatch()
+    {
+        const std::vector<Expectation> cases{
+            {"+CMTI: \"SM\",3", UrcKind::Cmti, "\"SM\",3"},
+            {"+CMT: \"+8613800000000\",,\"26/10/16,12:00:00+32\"", UrcKind::Cmt, "\"+8613800000000\",,\"26/10/16,12:00:00+32\""},
+            {"+CMT:,24", UrcKind::Cmt, ",24"},
+            {"+CMTI:", UrcKind::Cmti, ""},
+            {"+CMTI:   \"ME\",1", UrcKind::Cmti, "\"ME\",1"},
+            {"+CDSI: \"SR\",2", UrcKind::Cdsi, "\"SR\",2"},
+            {"+CREG: 1,\"1A2B\",\"01C3\"", UrcKind::Creg, "1,\"1A2B\",\"01C3\""},
+            {"+CEREG: 5", UrcKind::Cereg, "5"},
+            {"+C5GREG: 1", UrcKind::C5greg, "1"},
+            {"RING", UrcKind::Ring, ""},
+            {"+CRING: VOICE", UrcKind::Cring, "VOICE"},
+            {"RDY", UrcKind::Rdy, ""},
+            {"SMS DONE", UrcKind::SmsDone, ""},
+            {"PB DONE", UrcKind::PbDone, ""},
+            {"+QIND: \"csq\",23,99", UrcKind::Qind, "\"csq\",23,99"},
+            // 不以冒号结尾的前缀须与整行相同；缺冒号、小写与普通应答都不是上报。
+            {"RINGING", UrcKind::None, ""},
+            {"RING ", UrcKind::None, ""},
+            {"SMS DONE!", UrcKind::None, ""},
+            {"+CMT", UrcKind::None, ""},
+            {"+CMTX: 1", UrcKind::None, ""},
+            {"+cmti: \"SM\",3", UrcKind::None, ""},
+            {"+CSQ: 23,99", UrcKind::None, ""},
+            {"OK", UrcKind::None, ""},
+            {"", UrcKind::None, ""},
+            {" +CMTI: \"SM\",3", UrcKind::None, ""}};
+        for (const auto& expected : cases)
+        {
+            std::size_t offset = 0;
+            const auto kind = UrcDispatcher::Match(expected.line, &offset);
+            CHECK(kind == expected.kind);
+            CHECK(kind == LinearMatch(expected.line));
+            if (kind != UrcKind::None)
+            {
+                CHECK(expected.line.substr(offset) == expected.payload);
+            }
+        }
+        CHECK(UrcDispatcher::Match("+CMTI: \"SM\",3") == UrcKind::Cmti);
+    }
+
+    /// <summary>随机拼接前缀片段与干扰字节，与参照实现逐行对照。</summary>
+    void TestMatchAgainstReference()
+    {
+        const std::vector<std::string> fragments{"+C", "+CM", "+CMT", "+CMTI", ":", " ", "RING", "RDY", "SMS", " DONE", "PB",
+                                                 "+CREG", "+CEREG", "+C5GREG", "+QI", "URC", "ND", "E", "G", "1", ",", "\"", "x", "\xE4\xBD\xA0"};
+        std::mt19937 random(14);
+        std::size_t urcs = 0;
+        for (int i = 0; i < 200000; ++i)
+        {
+            std::string line;
+            const auto pieces = 1 + random() % 5;
+            for (std::size_t piece = 0; piece < pieces; ++piece)
+            {
+                line += fragments[random() % fragments.size()];
+            }
+            const auto kind = UrcDispatcher::Match(line);
+            CHECK(kind == LinearMatch(line));
+            urcs += kind != UrcKind::None ? 1 : 0;
+        }
+        // 语料须覆盖匹配与不匹配两种情况才有意义。
+        CHECK(urcs > 1000 && urcs < 190000);
+    }
+
+    void TestDispatch()
+    {
+        UrcDispatcher dispatcher;
+        std::vector<std::string> calls;
+        dispatcher.Subscribe(UrcKind::Cmti, [&calls](const UrcEvent& event)
+        {
+            calls.push_back("first " + std::string(event.payload));
+        });
+        dispatcher.Subscribe(UrcKind::Cmti, [&calls](const UrcEvent& event)
+        {
+            calls.push_back("second " + std::string(event.line));
+        });
+        dispatcher.Subscribe(UrcKind::Ring, [&calls](const UrcEvent& event)
+        {
+            calls.push_back(event.kind == UrcKind::Ring ? "ring" : "wrong kind");
+        });
+
+        CHECK(dispatcher.Dispatch("+CMTI: \"SM\",3") == UrcKind::Cmti);
+        CHECK(calls == std::vector<std::string>({"first \"SM\",3", "second +CMTI: \"SM\",3"}));
+        calls.clear();
+        // 没有订阅者的上报照常返回类型；不是上报的行不分发。
+        CHECK(dispatcher.Dispatch("+CREG: 1") == UrcKind::Creg);
+        CHECK(dispatcher.Dispatch("OK") == UrcKind::None);
+        CHECK(dispatcher.Dispatch("RING") == UrcKind::Ring);
+        CHECK(calls == std::vector<std::string>({"ring"}));
+    }
+
+    /// <summary>回调中订阅、退订其他订阅与退订自身。</summary>
+    void TestSubscribeDuringDispatch()
+    {
+        UrcDispatcher dispatcher;
+        int early = 0;
+        int late = 0;
+        int added = 0;
+        int once = 0;
+        UrcDispatcher::SubscriptionId lateId = 0;
+        UrcDispatcher::SubscriptionId onceId = 0;
+        bool subscribed = false;
+        dispatcher.Subscribe(UrcKind::Cmti, [&](const UrcEvent&)
+        {
+            ++early;
+            if (!subscribed)
+            {
+                subscribed = true;
+                dispatcher.Subscribe(UrcKind::Cmti, [&added](const UrcEvent&)
+                {
+                    ++added;
+                });
+                dispatcher.Unsubscribe(lateId);
+            }
+        });
+        lateId = dispatcher.Subscribe(UrcKind::Cmti, [&late](const UrcEvent&)
+        {
+            ++late;
+        });
+        onceId = dispatcher.Subscribe(UrcKind::Cmti, [&](const UrcEvent&)
+        {
+            ++once;
+            dispatcher.Unsubscribe(onceId);
+        });
+
+        // 第一次分发使用开始时的快照：被退订的仍会收到这一次，新订阅从下一次开始。
+        dispatcher.Dispatch("+CMTI: \"SM\",1");
+        CHECK(early == 1 && late == 1 && once == 1 && added == 0);
+        dispatcher.Dispatch("+CMTI: \"SM\",2");
+        CHECK(early == 2 && late == 1 && once == 1 && added == 1);
+
+        // 退订不存在或已退订的编号没有效果。
+        dispatcher.Unsubscribe(lateId);
+        dispatcher.Unsubscribe(9999);
+        dispatcher.Dispatch("+CMTI: \"SM\",3");
+        CHECK(early == 3 && late == 1 && once == 1 && added == 2);
+    }
+
+    /// <summary>一个线程持续分发，另一个线程反复订阅与退订；退订返回后开始的分发不再调用它。</summary>
+    void TestConcurrentSubscription()
+    {
+        UrcDispatcher dispatcher;
+        std::atomic<bool> stop(false);
+        std::atomic<long> stable(0);
+        dispatcher.Subscribe(UrcKind::Cmti, [&stable](const UrcEvent&)
+        {
+            stable.fetch_add(1, std::memory_order_relaxed);
+        });
+        std::thread dispatching([&]
+        {
+            while (!stop.load())
+            {
+                dispatcher.Dispatch("+CMTI: \"SM\",1");
+            }
+        });
+
+        // 退订时另一线程可能正有一次分发在执行，因此只检查本线程在退订返回后发起的分发。
+        const auto self = std::this_thread::get_id();
+        int violations = 0;
+        for (int i = 0; i < 2000; ++i)
+        {
+            auto ownCalls = std::make_shared<std::atomic<int>>(0);
+            const auto id = dispatcher.Subscribe(UrcKind::Cmti, [ownCalls, self](const UrcEvent&)
+            {
+                if (std::this_thread::get_id() == self)
+                {
+                    ownCalls->fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            std::this_thread::yield();
+            dispatcher.Unsubscribe(id);
+            dispatcher.Dispatch("+CMTI: \"SM\",2");
+            violations += ownCalls->load() != 0 ? 1 : 0;
+        }
+        stop = true;
+        dispatching.join();
+        CHECK(violations == 0);
+        CHECK(stable.load() > 0);
+    }
+}
+
+int main()
+{
+    TestMatch();
+    TestMatchAgainstReference();
+    TestDispatch();
+    TestSubscribeDuringDispatch();
+    TestConcurrentSubscription();
+    return TestSupport::Finish("UrcDispatcherTests");
+}